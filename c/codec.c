@@ -303,6 +303,76 @@ Zf(trim_i8_decode)(
 	return in_len;
 }
 
+/*
+ * The compressed format is a bit stream, most significant bit first.
+ * Each coefficient is a sign bit, the low 7 bits of its absolute value,
+ * then the high bits of the absolute value in unary (as many zeros,
+ * followed by a one). The encoder and decoder below work on a 64-bit
+ * window of that stream, so that most coefficients are handled with a
+ * few shifts and one leading-zero count instead of a loop over bits.
+ */
+
+/*
+ * Number of leading zeros of a non-zero 64-bit value.
+ */
+static inline unsigned
+comp_clz64(uint64_t x)
+{
+#if defined __GNUC__ || defined __clang__
+	return (unsigned)__builtin_clzll(x);
+#else
+	unsigned r;
+
+	r = 0;
+	if ((x >> 32) == 0) {
+		r += 32;
+		x <<= 32;
+	}
+	if ((x >> 48) == 0) {
+		r += 16;
+		x <<= 16;
+	}
+	if ((x >> 56) == 0) {
+		r += 8;
+		x <<= 8;
+	}
+	if ((x >> 60) == 0) {
+		r += 4;
+		x <<= 4;
+	}
+	if ((x >> 62) == 0) {
+		r += 2;
+		x <<= 2;
+	}
+	if ((x >> 63) == 0) {
+		r ++;
+	}
+	return r;
+#endif
+}
+
+static inline uint64_t
+comp_dec64be(const uint8_t *buf)
+{
+	return ((uint64_t)buf[0] << 56)
+		| ((uint64_t)buf[1] << 48)
+		| ((uint64_t)buf[2] << 40)
+		| ((uint64_t)buf[3] << 32)
+		| ((uint64_t)buf[4] << 24)
+		| ((uint64_t)buf[5] << 16)
+		| ((uint64_t)buf[6] << 8)
+		| (uint64_t)buf[7];
+}
+
+static inline void
+comp_enc32be(uint8_t *buf, uint32_t x)
+{
+	buf[0] = (uint8_t)(x >> 24);
+	buf[1] = (uint8_t)(x >> 16);
+	buf[2] = (uint8_t)(x >> 8);
+	buf[3] = (uint8_t)x;
+}
+
 /* see inner.h */
 size_t
 Zf(comp_encode)(
@@ -311,7 +381,7 @@ Zf(comp_encode)(
 {
 	uint8_t *buf;
 	size_t n, u, v;
-	uint32_t acc;
+	uint64_t acc;
 	unsigned acc_len;
 
 	n = (size_t)1 << logn;
@@ -326,73 +396,63 @@ Zf(comp_encode)(
 		}
 	}
 
+	/*
+	 * Bits are accumulated in acc (acc_len of them, in the low bits);
+	 * whole 32-bit words are written out as soon as they are
+	 * complete.
+	 */
 	acc = 0;
 	acc_len = 0;
 	v = 0;
 	for (u = 0; u < n; u ++) {
 		int t;
 		unsigned w;
+		uint32_t s;
 
 		/*
-		 * Get sign and absolute value of next integer; push the
-		 * sign bit.
+		 * Sign bit and low 7 bits of the absolute value, then
+		 * (w >> 7) zeros and a one. The absolute value is at most
+		 * 2047, so this is at most 24 bits; with at most 31 bits
+		 * pending, this fits in the accumulator.
 		 */
-		acc <<= 1;
 		t = x[u];
-		if (t < 0) {
-			t = -t;
-			acc |= 1;
-		}
-		w = (unsigned)t;
-
-		/*
-		 * Push the low 7 bits of the absolute value.
-		 */
-		acc <<= 7;
-		acc |= w & 127u;
-		w >>= 7;
-
-		/*
-		 * We pushed exactly 8 bits.
-		 */
-		acc_len += 8;
-
-		/*
-		 * Push as many zeros as necessary, then a one. Since the
-		 * absolute value is at most 2047, w can only range up to
-		 * 15 at this point, thus we will add at most 16 bits
-		 * here. With the 8 bits above and possibly up to 7 bits
-		 * from previous iterations, we may go up to 31 bits, which
-		 * will fit in the accumulator, which is an uint32_t.
-		 */
-		acc <<= (w + 1);
-		acc |= 1;
-		acc_len += w + 1;
-
-		/*
-		 * Produce all full bytes.
-		 */
-		while (acc_len >= 8) {
-			acc_len -= 8;
+		s = (uint32_t)t >> 31;
+		w = (unsigned)(s ? -t : t);
+		acc = (acc << 8) | (s << 7) | (w & 127u);
+		acc = (acc << ((w >> 7) + 1)) | 1;
+		acc_len += 8 + (w >> 7) + 1;
+
+		if (acc_len >= 32) {
+			acc_len -= 32;
 			if (buf != NULL) {
-				if (v >= max_out_len) {
+				if (max_out_len - v < 4) {
 					return 0;
 				}
-				buf[v] = (uint8_t)(acc >> acc_len);
+				comp_enc32be(buf + v, (uint32_t)(acc >> acc_len));
 			}
-			v ++;
+			v += 4;
 		}
 	}
 
 	/*
-	 * Flush remaining bits (if any).
+	 * Flush remaining bits (if any), padding the last byte with
+	 * zeros.
 	 */
-	if (acc_len > 0) {
+	while (acc_len > 0) {
+		uint32_t b;
+
+		if (acc_len >= 8) {
+			acc_len -= 8;
+			b = (uint32_t)(acc >> acc_len);
+		} else {
+			b = (uint32_t)(acc << (8 - acc_len));
+			acc_len = 0;
+		}
 		if (buf != NULL) {
 			if (v >= max_out_len) {
 				return 0;
 			}
-			buf[v] = (uint8_t)(acc << (8 - acc_len));
+			buf[v] = (uint8_t)b;
 		}
 		v ++;
 	}
@@ -400,6 +460,48 @@ Zf(comp_encode)(
 	return v;
 }
 
+/*
+ * Decode one coefficient from the top of the window *w (*wl valid
+ * bits, the bits below them being zero) into *x. Returned value is 1 on
+ * success, 0 on error.
+ */
+static inline int
+comp_decode_one(int16_t *x, uint64_t *w, unsigned *wl)
+{
+	uint64_t t;
+	unsigned s, m, k;
+
+	if (*wl < 8) {
+		return 0;
+	}
+
+	/*
+	 * Sign and low bits, then the unary part. Bits past the window
+	 * are zeros (the OR'ed sentinel stops the count), so 16 or more
+	 * leading zeros mean either a value above 2047 or a truncated
+	 * input.
+	 */
+	t = *w;
+	k = comp_clz64((t << 8) | 1);
+	if (k >= 16) {
+		return 0;
+	}
+	s = (unsigned)(t >> 63);
+	m = ((unsigned)(t >> 56) & 127u) | (k << 7);
+
+	/*
+	 * "-0" is forbidden.
+	 */
+	if (s != 0 && m == 0) {
+		return 0;
+	}
+
+	*w = t << (9 + k);
+	*wl -= 9 + k;
+	*x = (int16_t)((m ^ -s) + s);
+	return 1;
+}
+
 /* see inner.h */
 size_t
 Zf(comp_decode)(
@@ -408,68 +510,62 @@ Zf(comp_decode)(
 {
 	const uint8_t *buf;
 	size_t n, u, v;
-	uint32_t acc;
-	unsigned acc_len;
+	uint64_t w;
+	unsigned wl, pad;
 
 	n = (size_t)1 << logn;
 	buf = in;
-	acc = 0;
-	acc_len = 0;
-	v = 0;
-	for (u = 0; u < n; u ++) {
-		unsigned b, s, m;
 
-		/*
-		 * Get next eight bits: sign and low seven bits of the
-		 * absolute value.
-		 */
-		if (v >= max_in_len) {
+	/*
+	 * The window w holds the next wl bits of the stream in its top
+	 * bits; the bits below them are zero. v is the number of bytes
+	 * loaded into the window so far.
+	 *
+	 * While at least eight bytes remain, the window is refilled with
+	 * one 64-bit load to at least 56 bits, which covers two
+	 * coefficients (at most 24 bits each).
+	 */
+	w = 0;
+	wl = 0;
+	v = 0;
+	u = 0;
+	while (n - u >= 2 && max_in_len - v >= 8) {
+		w |= comp_dec64be(buf + v) >> wl;
+		v += (63 - wl) >> 3;
+		wl |= 56;
+		w &= ~(uint64_t)0 << (64 - wl);
+		if (!comp_decode_one(x + u, &w, &wl)
+			|| !comp_decode_one(x + u + 1, &w, &wl))
+		{
 			return 0;
 		}
-		acc = (acc << 8) | (uint32_t)buf[v ++];
-		b = acc >> acc_len;
-		s = b & 128;
-		m = b & 127;
+		u += 2;
+	}
 
-		/*
-		 * Get next bits until a 1 is reached.
-		 */
-		for (;;) {
-			if (acc_len == 0) {
-				if (v >= max_in_len) {
-					return 0;
-				}
-				acc = (acc << 8) | (uint32_t)buf[v ++];
-				acc_len = 8;
-			}
-			acc_len --;
-			if (((acc >> acc_len) & 1) != 0) {
-				break;
-			}
-			m += 128;
-			if (m > 2047) {
-				return 0;
-			}
+	/*
+	 * Last coefficients, and near the end of the input: refill byte
+	 * by byte.
+	 */
+	for (; u < n; u ++) {
+		while (wl <= 56 && v < max_in_len) {
+			w |= (uint64_t)buf[v ++] << (56 - wl);
+			wl += 8;
 		}
-
-		/*
-		 * "-0" is forbidden.
-		 */
-		if (s && m == 0) {
+		if (!comp_decode_one(x + u, &w, &wl)) {
 			return 0;
 		}
-
-		x[u] = (int16_t)(s ? -(int)m : (int)m);
 	}
 
 	/*
-	 * Unused bits in the last byte must be zero.
+	 * Unused bits in the last byte must be zero; that byte has been
+	 * loaded, so these bits are at the top of the window.
 	 */
-	if ((acc & ((1u << acc_len) - 1u)) != 0) {
+	pad = wl & 7;
+	if (pad != 0 && (w >> (64 - pad)) != 0) {
 		return 0;
 	}
 
-	return v;
+	return v - (wl >> 3);
 }
 
 /*
@@ -29,8 +29,25 @@
  * @author   Thomas Pornin <thomas.pornin@nccgroup.com>
  */
 
+#include "falcon.h"
 #include "inner.h"
 
+/* see inner.h */
+const int Zf(core_impl) =
+#if FALCON_AVX2
+	FALCON_IMPL_AVX2;
+#elif FALCON_NEON
+	FALCON_IMPL_NEON;
+#else
+	FALCON_IMPL_GENERIC;
+#endif
+
+/*
+ * Number of 16-bit samples extracted per PRNG call in hash-to-point.
+ * 136 samples (272 bytes) are exactly two SHAKE256 output blocks.
+ */
+#define HTP_CHUNK   136
+
 /* see inner.h */
 void
 Zf(hash_to_point_vartime)(
@@ -49,23 +66,280 @@ Zf(hash_to_point_vartime)(
 	 */
 	size_t n;
 
+	/*
+	 * Samples are extracted in bulk, HTP_CHUNK at a time. Since each
+	 * sample yields at most one output value, we never ask for more
+	 * samples than there are missing values: this consumes exactly
+	 * the same bytes as extracting the samples one by one, and leaves
+	 * the context in the same state.
+	 */
 	n = (size_t)1 << logn;
 	while (n > 0) {
-		uint8_t buf[2];
-		uint32_t w;
-
-		inner_prng_extract(sc, (void *)buf, sizeof buf);
-		w = ((unsigned)buf[0] << 8) | (unsigned)buf[1];
-		if (w < 61445) {
-			while (w >= 12289) {
-				w -= 12289;
+		uint8_t buf[HTP_CHUNK << 1];
+		size_t m, u;
+
+		m = n < HTP_CHUNK ? n : HTP_CHUNK;
+		inner_prng_extract(sc, (void *)buf, m << 1);
+		for (u = 0; u < m; u ++) {
+			uint32_t w;
+
+			w = ((unsigned)buf[u << 1] << 8)
+				| (unsigned)buf[(u << 1) + 1];
+			if (w < 61445) {
+				while (w >= 12289) {
+					w -= 12289;
+				}
+				*x ++ = (uint16_t)w;
+				n --;
 			}
-			*x ++ = (uint16_t)w;
-			n --;
 		}
 	}
 }
 
+/*
+ * Oversampling in hash_to_point_ct(), indexed by logn (see the comment
+ * in that function).
+ */
+static const uint16_t htp_overtab[] = {
+	0, /* unused */
+	65,
+	67,
+	71,
+	77,
+	86,
+	100,
+	122,
+	154,
+	205,
+	287
+};
+
+#if FALCON_AVX2 || FALCON_NEON
+
+/*
+ * Largest oversampled candidate count (n + over for logn = 10, see
+ * hash_to_point_ct()), rounded up to a whole number of vectors, and
+ * the extra room for reading candidates up to 256 slots (the largest
+ * pass step) past the end.
+ */
+#define HTP_CT_MAX   (((1024 + 287) + 15) & ~15)
+#define HTP_CT_PAD   256
+
+/*
+ * Vector implementation of hash_to_point_ct(): m candidates are kept
+ * in a single array, 16 lanes at a time (8 with NEON), and the same
+ * compaction passes are applied in two branchless sweeps each:
+ *
+ *   1. The number j of invalid candidates before each slot is
+ *      computed as a running prefix sum; valid candidates whose j has
+ *      bit p set are tagged (bit 14, free since valid values are
+ *      below q < 2^14; rejected values are 0xFFFF).
+ *
+ *   2. Tagged candidates move down by p slots. As noted in the
+ *      scalar code, the destination always holds a rejected value,
+ *      so the sequential swaps amount to: slot i receives the value
+ *      from slot i+p if that one is tagged, becomes 0xFFFF if its own
+ *      value is tagged, and is unchanged otherwise.
+ *
+ * The result is identical to that of the scalar code, and the same
+ * PRNG bytes are consumed.
+ */
+#if FALCON_AVX2 // yyyAVX2+1
+
+/*
+ * Broadcast lane 15 of a 16x16 vector.
+ */
+TARGET_AVX2
+static inline __m256i
+htp_bcast15(__m256i x)
+{
+	return _mm256_shuffle_epi8(_mm256_permute4x64_epi64(x, 0xFF),
+		_mm256_set1_epi16(0x0F0E));
+}
+
+/*
+ * Inclusive prefix sum of 16 lanes of 16 bits.
+ */
+TARGET_AVX2
+static inline __m256i
+htp_prefix16(__m256i x)
+{
+	__m256i t;
+
+	x = _mm256_add_epi16(x, _mm256_slli_si256(x, 2));
+	x = _mm256_add_epi16(x, _mm256_slli_si256(x, 4));
+	x = _mm256_add_epi16(x, _mm256_slli_si256(x, 8));
+	t = _mm256_permute2x128_si256(x, x, 0x08);
+	t = _mm256_shuffle_epi8(t, _mm256_set1_epi16(0x0F0E));
+	return _mm256_add_epi16(x, t);
+}
+
+TARGET_AVX2
+static void
+hash_to_point_ct_vec(inner_prng_context *sc, uint16_t *x, unsigned logn)
+{
+	uint16_t buf[HTP_CT_MAX + HTP_CT_PAD];
+	unsigned n, m, mp, over, u, p;
+	__m256i bswap, b61445, b24578, b12289, ff, tagm, tag, vmask;
+
+	n = 1U << logn;
+	over = htp_overtab[logn];
+	m = n + over;
+	mp = (m + 15) & ~15U;
+
+	/*
+	 * Raw samples are decoded in place. Slots past m are set to
+	 * 0xFFFF beforehand, which decodes to a rejected value (0xFFFF
+	 * again): they never move and never receive a value.
+	 */
+	memset(buf + m, 0xFF, (HTP_CT_MAX + HTP_CT_PAD - m) * sizeof *buf);
+	inner_prng_extract(sc, (void *)buf, (size_t)m << 1);
+	bswap = _mm256_setr_epi8(
+		1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+		1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+	b61445 = _mm256_set1_epi16((short)61445);
+	b24578 = _mm256_set1_epi16(24578);
+	b12289 = _mm256_set1_epi16(12289);
+	ff = _mm256_set1_epi16(-1);
+	for (u = 0; u < mp; u += 16) {
+		__m256i w, wr, bad;
+
+		w = _mm256_shuffle_epi8(
+			_mm256_loadu_si256((__m256i *)(buf + u)), bswap);
+		wr = _mm256_min_epu16(w, _mm256_sub_epi16(w, b24578));
+		wr = _mm256_min_epu16(wr, _mm256_sub_epi16(wr, b24578));
+		wr = _mm256_min_epu16(wr, _mm256_sub_epi16(wr, b12289));
+		bad = _mm256_cmpeq_epi16(_mm256_max_epu16(w, b61445), w);
+		_mm256_storeu_si256((__m256i *)(buf + u),
+			_mm256_or_si256(wr, bad));
+	}
+
+	tagm = _mm256_set1_epi16((short)0xC000);
+	tag = _mm256_set1_epi16(0x4000);
+	vmask = _mm256_set1_epi16(0x3FFF);
+	for (p = 1; p <= over; p <<= 1) {
+		__m256i carry, bp;
+
+		carry = _mm256_setzero_si256();
+		bp = _mm256_set1_epi16((short)p);
+		for (u = 0; u < mp; u += 16) {
+			__m256i v, bad, c, s, j, mv;
+
+			v = _mm256_loadu_si256((__m256i *)(buf + u));
+			bad = _mm256_cmpeq_epi16(v, ff);
+			c = _mm256_srli_epi16(bad, 15);
+			s = _mm256_add_epi16(htp_prefix16(c), carry);
+			j = _mm256_sub_epi16(s, c);
+			mv = _mm256_andnot_si256(bad, _mm256_cmpeq_epi16(
+				_mm256_and_si256(j, bp), bp));
+			_mm256_storeu_si256((__m256i *)(buf + u),
+				_mm256_or_si256(v, _mm256_and_si256(mv, tag)));
+			carry = htp_bcast15(s);
+		}
+		for (u = 0; u < mp; u += 16) {
+			__m256i a, b, ta, tb, r;
+
+			a = _mm256_loadu_si256((__m256i *)(buf + u));
+			b = _mm256_loadu_si256((__m256i *)(buf + u + p));
+			ta = _mm256_cmpeq_epi16(_mm256_and_si256(a, tagm), tag);
+			tb = _mm256_cmpeq_epi16(_mm256_and_si256(b, tagm), tag);
+			r = _mm256_or_si256(a, ta);
+			r = _mm256_blendv_epi8(r, _mm256_and_si256(b, vmask), tb);
+			_mm256_storeu_si256((__m256i *)(buf + u), r);
+		}
+	}
+	memcpy(x, buf, n * sizeof *x);
+}
+
+#elif FALCON_NEON
+
+/*
+ * Inclusive prefix sum of 8 lanes of 16 bits.
+ */
+static inline uint16x8_t
+htp_prefix8(uint16x8_t x)
+{
+	uint16x8_t z;
+
+	z = vdupq_n_u16(0);
+	x = vaddq_u16(x, vextq_u16(z, x, 7));
+	x = vaddq_u16(x, vextq_u16(z, x, 6));
+	x = vaddq_u16(x, vextq_u16(z, x, 4));
+	return x;
+}
+
+static void
+hash_to_point_ct_vec(inner_prng_context *sc, uint16_t *x, unsigned logn)
+{
+	uint16_t buf[HTP_CT_MAX + HTP_CT_PAD];
+	unsigned n, m, mp, over, u, p;
+	uint16x8_t b61445, b24578, b12289, ff, tagm, tag, vmask;
+
+	n = 1U << logn;
+	over = htp_overtab[logn];
+	m = n + over;
+	mp = (m + 7) & ~7U;
+
+	/*
+	 * Same layout and padding as in the AVX2 code.
+	 */
+	memset(buf + m, 0xFF, (HTP_CT_MAX + HTP_CT_PAD - m) * sizeof *buf);
+	inner_prng_extract(sc, (void *)buf, (size_t)m << 1);
+	b61445 = vdupq_n_u16(61445);
+	b24578 = vdupq_n_u16(24578);
+	b12289 = vdupq_n_u16(12289);
+	ff = vdupq_n_u16(0xFFFF);
+	for (u = 0; u < mp; u += 8) {
+		uint16x8_t w, wr, bad;
+
+		w = vreinterpretq_u16_u8(vrev16q_u8(
+			vld1q_u8((const uint8_t *)(buf + u))));
+		wr = vminq_u16(w, vsubq_u16(w, b24578));
+		wr = vminq_u16(wr, vsubq_u16(wr, b24578));
+		wr = vminq_u16(wr, vsubq_u16(wr, b12289));
+		bad = vcgeq_u16(w, b61445);
+		vst1q_u16(buf + u, vorrq_u16(wr, bad));
+	}
+
+	tagm = vdupq_n_u16(0xC000);
+	tag = vdupq_n_u16(0x4000);
+	vmask = vdupq_n_u16(0x3FFF);
+	for (p = 1; p <= over; p <<= 1) {
+		uint16x8_t carry, bp;
+
+		carry = vdupq_n_u16(0);
+		bp = vdupq_n_u16((uint16_t)p);
+		for (u = 0; u < mp; u += 8) {
+			uint16x8_t v, bad, c, s, j, mv;
+
+			v = vld1q_u16(buf + u);
+			bad = vceqq_u16(v, ff);
+			c = vshrq_n_u16(bad, 15);
+			s = vaddq_u16(htp_prefix8(c), carry);
+			j = vsubq_u16(s, c);
+			mv = vbicq_u16(vtstq_u16(j, bp), bad);
+			vst1q_u16(buf + u, vorrq_u16(v, vandq_u16(mv, tag)));
+			carry = vdupq_laneq_u16(s, 7);
+		}
+		for (u = 0; u < mp; u += 8) {
+			uint16x8_t a, b, ta, tb, r;
+
+			a = vld1q_u16(buf + u);
+			b = vld1q_u16(buf + u + p);
+			ta = vceqq_u16(vandq_u16(a, tagm), tag);
+			tb = vceqq_u16(vandq_u16(b, tagm), tag);
+			r = vorrq_u16(a, ta);
+			r = vbslq_u16(tb, vandq_u16(b, vmask), r);
+			vst1q_u16(buf + u, r);
+		}
+	}
+	memcpy(x, buf, n * sizeof *x);
+}
+
+#endif // yyyAVX2-
+
+#endif
+
 /* see inner.h */
 void
 Zf(hash_to_point_ct)(
@@ -100,23 +374,15 @@ Zf(hash_to_point_ct)(
 	 * (i.e. 126 bytes) for the values that do not fit in tmp[].
 	 */
 
-	static const uint16_t overtab[] = {
-		0, /* unused */
-		65,
-		67,
-		71,
-		77,
-		86,
-		100,
-		122,
-		154,
-		205,
-		287
-	};
-
 	unsigned n, n2, u, m, p, over;
 	uint16_t *tt1, tt2[63];
 
+#if FALCON_AVX2 || FALCON_NEON
+	(void)tmp;
+	hash_to_point_ct_vec(sc, x, logn);
+	return;
+#endif
+
 	/*
 	 * We first generate m 16-bit value. Values 0..n-1 go to x[].
 	 * Values n..2*n-1 go to tt1[]. Values 2*n and later go to tt2[].
@@ -125,25 +391,38 @@ Zf(hash_to_point_ct)(
 	 */
 	n = 1U << logn;
 	n2 = n << 1;
-	over = overtab[logn];
+	over = htp_overtab[logn];
 	m = n + over;
 	tt1 = (uint16_t *)tmp;
-	for (u = 0; u < m; u ++) {
-		uint8_t buf[2];
-		uint32_t w, wr;
-
-		inner_prng_extract(sc, buf, sizeof buf);
-		w = ((uint32_t)buf[0] << 8) | (uint32_t)buf[1];
-		wr = w - ((uint32_t)24578 & (((w - 24578) >> 31) - 1));
-		wr = wr - ((uint32_t)24578 & (((wr - 24578) >> 31) - 1));
-		wr = wr - ((uint32_t)12289 & (((wr - 12289) >> 31) - 1));
-		wr |= ((w - 61445) >> 31) - 1;
-		if (u < n) {
-			x[u] = (uint16_t)wr;
-		} else if (u < n2) {
-			tt1[u - n] = (uint16_t)wr;
-		} else {
-			tt2[u - n2] = (uint16_t)wr;
+	for (u = 0; u < m;) {
+		uint8_t buf[HTP_CHUNK << 1];
+		unsigned k, r;
+
+		/*
+		 * The number of samples is fixed, so they can be extracted
+		 * in bulk without changing which bytes are consumed.
+		 */
+		r = m - u;
+		if (r > HTP_CHUNK) {
+			r = HTP_CHUNK;
+		}
+		inner_prng_extract(sc, buf, (size_t)r << 1);
+		for (k = 0; k < r; k ++, u ++) {
+			uint32_t w, wr;
+
+			w = ((uint32_t)buf[k << 1] << 8)
+				| (uint32_t)buf[(k << 1) + 1];
+			wr = w - ((uint32_t)24578 & (((w - 24578) >> 31) - 1));
+			wr = wr - ((uint32_t)24578 & (((wr - 24578) >> 31) - 1));
+			wr = wr - ((uint32_t)12289 & (((wr - 12289) >> 31) - 1));
+			wr |= ((w - 61445) >> 31) - 1;
+			if (u < n) {
+				x[u] = (uint16_t)wr;
+			} else if (u < n2) {
+				tt1[u - n] = (uint16_t)wr;
+			} else {
+				tt2[u - n2] = (uint16_t)wr;
+			}
 		}
 	}
 
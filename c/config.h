@@ -88,6 +88,19 @@
 #define FALCON_FPEMU   1
  */
 
+/*
+ * With emulated floating-point, use 64x64->128 multiplications
+ * (unsigned __int128) and native 64-bit shifts instead of 32-bit limbs.
+ * Results are bit-for-bit identical; this is faster on 64-bit targets,
+ * but it is constant-time only if the 64-bit multiplication (including
+ * the high half) and 64-bit shifts are constant-time. By default, it is
+ * enabled on x86_64 and AArch64 when the compiler supports the
+ * unsigned __int128 type. It has no effect with FALCON_FPNATIVE or with
+ * the Cortex-M4 assembly.
+ *
+#define FALCON_FPEMU_WIDE   1
+ */
+
 /*
  * Enable use of assembly for ARM Cortex-M4 CPU. By default, such
  * support will be used based on some autodection on the compiler
@@ -117,6 +130,7 @@
  * (tested with GCC 7.4.0, Clang 6.0.0, and MSVC 2015, both in 32-bit
  * and 64-bit modes), and run only on systems that offer the AVX2
  * opcodes. Some operations leverage AVX2 for better performance.
+ * This option (like FALCON_FMA) is ignored with FALCON_FPEMU.
  *
 #define FALCON_AVX2   1
  */
@@ -171,6 +185,44 @@
 #define FALCON_KG_CHACHA20   1
  */
 
+/*
+ * Enable per-phase profiling counters (see falcon_profile_get() in
+ * falcon.h). Signing and verification then read the cycle counter (or
+ * the monotonic clock) around each phase and accumulate the results in
+ * thread-local storage. When disabled (the default), the instrumentation
+ * compiles to nothing.
+ *
+#define FALCON_PROFILE   1
+ */
+
+/*
+ * Compile the FFT and NTT a second time with logn fixed to 9 and 10
+ * (Falcon-512 and Falcon-1024), so that the compiler can unroll the
+ * loops over layers; other degrees use the generic code. This is
+ * enabled by default; setting it to 0 makes the object code smaller.
+ * See also falcon_set_specialized() in falcon.h.
+ *
+#define FALCON_SPECIALIZE   0
+ */
+
+/*
+ * Support for multi-threaded key pair generation (see
+ * falcon_keygen_make_mt() in falcon.h), with POSIX threads. This is
+ * enabled by default on Unix-like systems; linking then requires the
+ * pthread library on some of them (-lpthread). When disabled,
+ * falcon_keygen_make_mt() runs on the calling thread only.
+ *
+#define FALCON_KEYGEN_MT   0
+ */
+
+/*
+ * Huge page backing for the arenas of falcon_ctx_new() (see falcon.h),
+ * with mmap(). This is enabled by default on Linux; when disabled, the
+ * FALCON_CTX_HUGEPAGES flag is ignored and arenas use malloc().
+ *
+#define FALCON_HUGEPAGES   0
+ */
+
 /*
  * Use Keccak256-based PRNG implementation. The PRNG will use Keccak256
  * in counter mode, with domain separation byte 0x1F. This implementation
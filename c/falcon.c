@@ -32,6 +32,263 @@
 #include "falcon.h"
 #include "inner.h"
 
+#include <stdlib.h>
+#if FALCON_HUGEPAGES
+#include <sys/mman.h>
+#endif
+
+/*
+ * Runtime implementation selection.
+ *
+ * When FALCON_DISPATCH is set, the core is linked twice: once as the
+ * generic build (symbol prefix FALCON_PREFIX) and once as the vector
+ * build (symbol prefix FALCON_PREFIX_AVX2), compiled with FALCON_AVX2
+ * and FALCON_FMA on x86, or with FALCON_NEON on AArch64. The vector
+ * build is then used when the CPU and OS support it, for the
+ * floating-point code (keygen, private key expansion and signing) and
+ * the arithmetic modulo q (NTT-based verification and public key
+ * computation). Encoding and hash-to-point have no vector code and
+ * always use the generic build.
+ */
+#ifndef FALCON_DISPATCH
+#define FALCON_DISPATCH   0
+#endif
+
+#if FALCON_DISPATCH
+
+#ifndef FALCON_PREFIX_AVX2
+#define FALCON_PREFIX_AVX2   falcon_inner_avx2
+#endif
+#define Zv(name)   Zf_(FALCON_PREFIX_AVX2, name)
+
+void Zv(keygen)(inner_prng_context *rng,
+	int8_t *f, int8_t *g, int8_t *F, int8_t *G, uint16_t *h,
+	unsigned logn, uint8_t *tmp);
+void Zv(keygen_mt)(inner_prng_context *rng,
+	int8_t *f, int8_t *g, int8_t *F, int8_t *G, uint16_t *h,
+	unsigned logn, uint8_t *tmp, unsigned nthreads, uint32_t *ttmp);
+void Zv(expand_privkey)(fpr *restrict expanded_key,
+	const int8_t *f, const int8_t *g, const int8_t *F, const int8_t *G,
+	unsigned logn, int seq, uint8_t *restrict tmp);
+void Zv(expand_privkey_compact)(fpr *restrict compact_key,
+	const int8_t *f, const int8_t *g, const int8_t *F, const int8_t *G,
+	unsigned logn, unsigned levels, uint8_t *restrict tmp);
+void Zv(sign_tree)(int16_t *sig, inner_prng_context *rng,
+	const sampler_context *pre,
+	const fpr *restrict expanded_key, int seq,
+	const uint16_t *hm, unsigned logn, uint8_t *tmp, sign_stats *stats);
+void Zv(sign_tree_compact)(int16_t *sig, inner_prng_context *rng,
+	const sampler_context *pre,
+	const fpr *restrict compact_key, unsigned levels,
+	const uint16_t *hm, unsigned logn, uint8_t *tmp, sign_stats *stats);
+void Zv(sign_dyn)(int16_t *sig, inner_prng_context *rng,
+	const sampler_context *pre,
+	const int8_t *restrict f, const int8_t *restrict g,
+	const int8_t *restrict F, const int8_t *restrict G,
+	const uint16_t *hm, unsigned logn, uint8_t *tmp, sign_stats *stats);
+void Zv(sampler_init)(sampler_context *sc,
+	inner_prng_context *src, unsigned logn);
+void Zv(hash_to_point_ct)(inner_prng_context *sc,
+	uint16_t *x, unsigned logn, uint8_t *tmp);
+void Zv(to_ntt_monty)(uint16_t *h, unsigned logn);
+void Zv(to_ntt)(uint16_t *h, unsigned logn);
+void Zv(ntt_to_monty)(uint16_t *h, unsigned logn);
+int Zv(verify_raw)(const uint16_t *c0, const int16_t *s2,
+	const uint16_t *h, unsigned logn, uint8_t *tmp);
+int Zv(compute_public)(uint16_t *h,
+	const int8_t *f, const int8_t *g, unsigned logn, uint8_t *tmp);
+int Zv(complete_private)(int8_t *G,
+	const int8_t *f, const int8_t *g, const int8_t *F,
+	unsigned logn, uint8_t *tmp);
+extern const int Zv(core_impl);
+
+#if (defined __x86_64__ || defined __i386__) \
+	&& (defined __GNUC__ || defined __clang__)
+#include <cpuid.h>
+
+/*
+ * Tell whether AVX2 and FMA can be used: the CPU must report AVX2
+ * (leaf 7), FMA and OSXSAVE (leaf 1), and the OS must have enabled the
+ * XMM and YMM register state (XCR0 bits 1 and 2).
+ */
+static int
+cpu_has_avx2_fma(void)
+{
+	unsigned a, b, c, d;
+	uint32_t xcr0;
+
+	if (!__get_cpuid(1, &a, &b, &c, &d)) {
+		return 0;
+	}
+	if ((c & bit_FMA) == 0 || (c & bit_OSXSAVE) == 0) {
+		return 0;
+	}
+	__asm__ __volatile__ ("xgetbv" : "=a" (xcr0) : "c" (0) : "edx");
+	if ((xcr0 & 6) != 6) {
+		return 0;
+	}
+	if (__get_cpuid_max(0, NULL) < 7) {
+		return 0;
+	}
+	__cpuid_count(7, 0, a, b, c, d);
+	return (b & bit_AVX2) != 0;
+}
+#endif
+
+/*
+ * Implementation provided by the vector build, if the CPU can run it:
+ * AVX2+FMA on x86, NEON on AArch64 (where it is part of the base
+ * architecture). FALCON_IMPL_GENERIC means that there is none, e.g.
+ * when the vector build was compiled with FALCON_FPEMU, which disables
+ * the vector code.
+ */
+static int
+cpu_vector_impl(void)
+{
+	switch (Zv(core_impl)) {
+#if (defined __x86_64__ || defined __i386__) \
+	&& (defined __GNUC__ || defined __clang__)
+	case FALCON_IMPL_AVX2:
+		return cpu_has_avx2_fma()
+			? FALCON_IMPL_AVX2 : FALCON_IMPL_GENERIC;
+#endif
+#if defined __aarch64__ || defined _M_ARM64
+	case FALCON_IMPL_NEON:
+		return FALCON_IMPL_NEON;
+#endif
+	default:
+		return FALCON_IMPL_GENERIC;
+	}
+}
+
+/*
+ * Implementation used until falcon_set_impl() is called: the vector
+ * build if the CPU can run it, except for NEON. The NEON code has not
+ * been tested on AArch64 hardware yet, so it is used only when selected
+ * explicitly with falcon_set_impl(FALCON_IMPL_NEON).
+ */
+static int
+default_impl(void)
+{
+	int impl;
+
+	impl = cpu_vector_impl();
+	return impl == FALCON_IMPL_NEON ? FALCON_IMPL_GENERIC : impl;
+}
+
+/*
+ * Selected implementation, or -1 if not chosen yet. Concurrent first
+ * calls may all run the CPU check; they store the same value.
+ */
+static volatile int falcon_impl = -1;
+
+static int
+get_impl(void)
+{
+	int impl;
+
+	impl = falcon_impl;
+	if (impl < 0) {
+		impl = default_impl();
+		falcon_impl = impl;
+	}
+	return impl;
+}
+
+#define Zd(name)   (get_impl() != FALCON_IMPL_GENERIC ? Zv(name) : Zf(name))
+
+#else
+
+#define Zd(name)   Zf(name)
+
+#endif
+
+/* see falcon.h */
+int
+falcon_get_impl(void)
+{
+#if FALCON_DISPATCH
+	return get_impl();
+#elif FALCON_AVX2
+	return FALCON_IMPL_AVX2;
+#elif FALCON_NEON
+	return FALCON_IMPL_NEON;
+#else
+	return FALCON_IMPL_GENERIC;
+#endif
+}
+
+/* see falcon.h */
+int
+falcon_set_impl(int impl)
+{
+	switch (impl) {
+	case FALCON_IMPL_GENERIC:
+	case FALCON_IMPL_AVX2:
+	case FALCON_IMPL_NEON:
+		break;
+	default:
+		return FALCON_ERR_BADARG;
+	}
+#if FALCON_DISPATCH
+	if (impl != FALCON_IMPL_GENERIC && impl != cpu_vector_impl()) {
+		return FALCON_ERR_BADARG;
+	}
+	falcon_impl = impl;
+	return 0;
+#else
+	return impl == falcon_get_impl() ? 0 : FALCON_ERR_BADARG;
+#endif
+}
+
+#if FALCON_SPECIALIZE
+/* see inner.h */
+volatile int falcon_specialize = 1;
+#endif
+
+/* see falcon.h */
+int
+falcon_set_specialized(int enable)
+{
+#if FALCON_SPECIALIZE
+	int old;
+
+	old = falcon_specialize;
+	falcon_specialize = (enable != 0);
+	return old;
+#else
+	(void)enable;
+	return 0;
+#endif
+}
+
+#if FALCON_PROFILE
+/* see inner.h */
+__thread falcon_prof_state falcon_prof_tls;
+#endif
+
+/* see falcon.h */
+int
+falcon_profile_get(falcon_profile *prof)
+{
+#if FALCON_PROFILE
+	*prof = falcon_prof_tls.acc;
+	return FALCON_PROF_UNIT;
+#else
+	memset(prof, 0, sizeof *prof);
+	return FALCON_PROF_UNIT_NONE;
+#endif
+}
+
+/* see falcon.h */
+void
+falcon_profile_reset(void)
+{
+#if FALCON_PROFILE
+	memset(&falcon_prof_tls.acc, 0, sizeof falcon_prof_tls.acc);
+#endif
+}
+
 /* see falcon.h */
 int prng_type() {
 	#if FALCON_PRNG_KECCAK256
@@ -77,6 +334,7 @@ prng_init_prng_from_seed(prng_context *sc,
 {
 	prng_init(sc);
 	prng_inject(sc, seed, seed_len);
+	prng_flip(sc);
 }
 
 /* see falcon.h */
@@ -90,6 +348,8 @@ prng_init_prng_from_system(prng_context *sc)
 	}
 	prng_init(sc);
 	prng_inject(sc, seed, sizeof seed);
+	prng_flip(sc);
+	memset(seed, 0, sizeof seed);
 	return 0;
 }
 
@@ -133,18 +393,22 @@ align_fpr(void *tmp)
 	return (fpr *)atmp;
 }
 
-/* see falcon.h */
-int
-falcon_keygen_make(
+/*
+ * Key pair generation with nthreads threads; nthreads = 1 is the serial
+ * falcon_keygen_make(). The scratch areas of the extra threads follow
+ * the FALCON_TMPSIZE_KEYGEN(logn) bytes of the serial code in tmp[].
+ */
+static int
+keygen_make_inner(
 	prng_context *rng,
 	unsigned logn,
 	void *privkey, size_t privkey_len,
 	void *pubkey, size_t pubkey_len,
-	void *tmp, size_t tmp_len)
+	void *tmp, size_t tmp_len, unsigned nthreads)
 {
 	int8_t *f, *g, *F;
 	uint16_t *h;
-	uint8_t *atmp;
+	uint8_t *atmp, *ttmp;
 	size_t n, u, v, sk_len, pk_len;
 	uint8_t *sk, *pk;
 	unsigned oldcw;
@@ -152,12 +416,14 @@ falcon_keygen_make(
 	/*
 	 * Check parameters.
 	 */
-	if (logn < 1 || logn > 10) {
+	if (logn < 1 || logn > 10
+		|| nthreads < 1 || nthreads > FALCON_KEYGEN_MAX_THREADS)
+	{
 		return FALCON_ERR_BADARG;
 	}
 	if (privkey_len < FALCON_PRIVKEY_SIZE(logn)
 		|| (pubkey != NULL && pubkey_len < FALCON_PUBKEY_SIZE(logn))
-		|| tmp_len < FALCON_TMPSIZE_KEYGEN(logn))
+		|| tmp_len < FALCON_TMPSIZE_KEYGEN_MT(logn, nthreads))
 	{
 		return FALCON_ERR_SIZE;
 	}
@@ -171,8 +437,16 @@ falcon_keygen_make(
 	F = g + n;
 	atmp = align_u64(F + n);
 	oldcw = set_fpu_cw(2);
-	Zf(keygen)((inner_prng_context *)rng,
-		f, g, F, NULL, NULL, logn, atmp);
+	if (nthreads > 1) {
+		ttmp = (uint8_t *)tmp + FALCON_TMPSIZE_KEYGEN(logn);
+		ttmp += (64u - ((uintptr_t)ttmp & 63u)) & 63u;
+		Zd(keygen_mt)((inner_prng_context *)rng,
+			f, g, F, NULL, NULL, logn, atmp,
+			nthreads, (uint32_t *)ttmp);
+	} else {
+		Zd(keygen)((inner_prng_context *)rng,
+			f, g, F, NULL, NULL, logn, atmp);
+	}
 	set_fpu_cw(oldcw);
 
 	/*
@@ -210,7 +484,7 @@ falcon_keygen_make(
 	if (pubkey != NULL) {
 		h = (uint16_t *)align_u16(g + n);
 		atmp = (uint8_t *)(h + n);
-		if (!Zf(compute_public)(h, f, g, logn, atmp)) {
+		if (!Zd(compute_public)(h, f, g, logn, atmp)) {
 			return FALCON_ERR_INTERNAL;
 		}
 		pk = pubkey;
@@ -225,6 +499,32 @@ falcon_keygen_make(
 	return 0;
 }
 
+/* see falcon.h */
+int
+falcon_keygen_make(
+	prng_context *rng,
+	unsigned logn,
+	void *privkey, size_t privkey_len,
+	void *pubkey, size_t pubkey_len,
+	void *tmp, size_t tmp_len)
+{
+	return keygen_make_inner(rng, logn, privkey, privkey_len,
+		pubkey, pubkey_len, tmp, tmp_len, 1);
+}
+
+/* see falcon.h */
+int
+falcon_keygen_make_mt(
+	prng_context *rng,
+	unsigned logn,
+	void *privkey, size_t privkey_len,
+	void *pubkey, size_t pubkey_len,
+	void *tmp, size_t tmp_len, unsigned nthreads)
+{
+	return keygen_make_inner(rng, logn, privkey, privkey_len,
+		pubkey, pubkey_len, tmp, tmp_len, nthreads);
+}
+
 /* see falcon.h */
 int
 falcon_make_public(
@@ -287,7 +587,7 @@ falcon_make_public(
 	 */
 	h = (uint16_t *)align_u16(g + n);
 	atmp = (uint8_t *)(h + n);
-	if (!Zf(compute_public)(h, f, g, logn, atmp)) {
+	if (!Zd(compute_public)(h, f, g, logn, atmp)) {
 		return FALCON_ERR_FORMAT;
 	}
 
@@ -339,6 +639,21 @@ falcon_sign_dyn_finish(prng_context *rng,
 	const void *privkey, size_t privkey_len,
 	prng_context *hash_data, const void *nonce,
 	void *tmp, size_t tmp_len)
+{
+	return falcon_sign_dyn_finish_ex(rng, sig, sig_len, sig_type,
+		privkey, privkey_len, hash_data, nonce, tmp, tmp_len, NULL);
+}
+
+/*
+ * Finish a signature with a raw private key; if pre is not NULL, the
+ * first attempt uses that sampler context (see Zf(sign_dyn)()).
+ */
+static int
+sign_dyn_finish_inner(prng_context *rng, const sampler_context *pre,
+	void *sig, size_t *sig_len, int sig_type,
+	const void *privkey, size_t privkey_len,
+	prng_context *hash_data, const void *nonce,
+	void *tmp, size_t tmp_len, falcon_sign_stats *stats)
 {
 	unsigned logn;
 	const uint8_t *sk;
@@ -350,6 +665,8 @@ falcon_sign_dyn_finish(prng_context *rng,
 	size_t u, v, n, es_len;
 	unsigned oldcw;
 	inner_prng_context sav_hash_data;
+	sign_stats st;
+	uint32_t retries;
 
 	/*
 	 * Get degree from private key header byte, and check
@@ -426,7 +743,7 @@ falcon_sign_dyn_finish(prng_context *rng,
 	if (u != privkey_len) {
 		return FALCON_ERR_FORMAT;
 	}
-	if (!Zf(complete_private)(G, f, g, F, logn, atmp)) {
+	if (!Zd(complete_private)(G, f, g, F, logn, atmp)) {
 		return FALCON_ERR_FORMAT;
 	}
 
@@ -435,6 +752,9 @@ falcon_sign_dyn_finish(prng_context *rng,
 	 */
 	prng_flip(hash_data);
 	sav_hash_data = *(inner_prng_context *)hash_data;
+	st.attempts = 0;
+	st.rejections = 0;
+	retries = 0;
 
 	/*
 	 * Compute and encode signature.
@@ -448,8 +768,9 @@ falcon_sign_dyn_finish(prng_context *rng,
 		 * to save some RAM).
 		 */
 		*(inner_prng_context *)hash_data = sav_hash_data;
+		PROF_BEGIN(FALCON_PROF_HASH);
 		if (sig_type == FALCON_SIG_CT) {
-			Zf(hash_to_point_ct)(
+			Zd(hash_to_point_ct)(
 				(inner_prng_context *)hash_data,
 				hm, logn, atmp);
 		} else {
@@ -457,10 +778,15 @@ falcon_sign_dyn_finish(prng_context *rng,
 				(inner_prng_context *)hash_data,
 				hm, logn);
 		}
+		PROF_END(FALCON_PROF_HASH);
+		PROF_BEGIN(FALCON_PROF_SIGN);
 		oldcw = set_fpu_cw(2);
-		Zf(sign_dyn)(sv, (inner_prng_context *)rng,
-			f, g, F, G, hm, logn, atmp);
+		Zd(sign_dyn)(sv, (inner_prng_context *)rng, pre,
+			f, g, F, G, hm, logn, atmp, &st);
+		pre = NULL;
 		set_fpu_cw(oldcw);
+		PROF_END(FALCON_PROF_SIGN);
+		PROF_BEGIN(FALCON_PROF_ENCODE);
 		es = sig;
 		es_len = *sig_len;
 		memcpy(es + 1, nonce, 40);
@@ -483,6 +809,8 @@ falcon_sign_dyn_finish(prng_context *rng,
 				/*
 				 * Signature does not fit, loop.
 				 */
+				PROF_END(FALCON_PROF_ENCODE);
+				retries ++;
 				continue;
 			}
 			if (u + v < tu) {
@@ -499,15 +827,37 @@ falcon_sign_dyn_finish(prng_context *rng,
 			}
 			break;
 		}
+		PROF_END(FALCON_PROF_ENCODE);
 		*sig_len = u + v;
+		if (stats != NULL) {
+			stats->attempts = st.attempts;
+			stats->sampler_rejections = st.rejections;
+			stats->encode_retries = retries;
+		}
 		return 0;
 	}
 }
 
 /* see falcon.h */
 int
-falcon_expand_privkey(void *expanded_key, size_t expanded_key_len,
+falcon_sign_dyn_finish_ex(prng_context *rng,
+	void *sig, size_t *sig_len, int sig_type,
 	const void *privkey, size_t privkey_len,
+	prng_context *hash_data, const void *nonce,
+	void *tmp, size_t tmp_len, falcon_sign_stats *stats)
+{
+	return sign_dyn_finish_inner(rng, NULL, sig, sig_len, sig_type,
+		privkey, privkey_len, hash_data, nonce, tmp, tmp_len, stats);
+}
+
+/*
+ * Private key expansion: full expanded key (levels = 0) with the tree
+ * in the given layout, or compact expanded key with 'levels' stored
+ * tree levels.
+ */
+static int
+expand_privkey_inner(void *expanded_key, size_t expanded_key_len,
+	int layout, unsigned levels, const void *privkey, size_t privkey_len,
 	void *tmp, size_t tmp_len)
 {
 	unsigned logn;
@@ -536,10 +886,21 @@ falcon_expand_privkey(void *expanded_key, size_t expanded_key_len,
 	if (privkey_len != FALCON_PRIVKEY_SIZE(logn)) {
 		return FALCON_ERR_FORMAT;
 	}
-	if (expanded_key_len < FALCON_EXPANDEDKEY_SIZE(logn)
-		|| tmp_len < FALCON_TMPSIZE_EXPANDPRIV(logn))
-	{
-		return FALCON_ERR_SIZE;
+	if (levels == 0) {
+		if (expanded_key_len < FALCON_EXPANDEDKEY_SIZE(logn)
+			|| tmp_len < FALCON_TMPSIZE_EXPANDPRIV(logn))
+		{
+			return FALCON_ERR_SIZE;
+		}
+	} else {
+		if (levels + 2 > logn) {
+			return FALCON_ERR_BADARG;
+		}
+		if (expanded_key_len < FALCON_COMPACTKEY_SIZE(logn, levels)
+			|| tmp_len < FALCON_TMPSIZE_EXPANDCOMPACT(logn))
+		{
+			return FALCON_ERR_SIZE;
+		}
 	}
 
 	/*
@@ -573,21 +934,72 @@ falcon_expand_privkey(void *expanded_key, size_t expanded_key_len,
 	if (u != privkey_len) {
 		return FALCON_ERR_FORMAT;
 	}
-	if (!Zf(complete_private)(G, f, g, F, logn, atmp)) {
+	if (!Zd(complete_private)(G, f, g, F, logn, atmp)) {
 		return FALCON_ERR_FORMAT;
 	}
 
 	/*
-	 * Expand private key.
+	 * Expand private key. The high nibble of the header byte is the
+	 * tree layout (0 or 1) of a full expanded key; for a compact
+	 * expanded key, it is 5 + levels (0x6 to 0xD), distinct from the
+	 * high nibble of the header of an encoded private key (0x5).
 	 */
-	*(uint8_t *)expanded_key = logn;
+	*(uint8_t *)expanded_key = (uint8_t)(levels == 0
+		? (layout << 4) + logn : ((levels + 5) << 4) + logn);
 	expkey = align_fpr((uint8_t *)expanded_key + 1);
 	oldcw = set_fpu_cw(2);
-	Zf(expand_privkey)(expkey, f, g, F, G, logn, atmp);
+	if (levels == 0) {
+		Zd(expand_privkey)(expkey, f, g, F, G, logn,
+			layout == FALCON_EXPKEY_SEQUENTIAL, atmp);
+	} else {
+		Zd(expand_privkey_compact)(expkey,
+			f, g, F, G, logn, levels, atmp);
+	}
 	set_fpu_cw(oldcw);
 	return 0;
 }
 
+/* see falcon.h */
+int
+falcon_expand_privkey(void *expanded_key, size_t expanded_key_len,
+	const void *privkey, size_t privkey_len,
+	void *tmp, size_t tmp_len)
+{
+	return expand_privkey_inner(expanded_key, expanded_key_len,
+		FALCON_EXPKEY_RECURSIVE, 0,
+		privkey, privkey_len, tmp, tmp_len);
+}
+
+/* see falcon.h */
+int
+falcon_expand_privkey_layout(void *expanded_key, size_t expanded_key_len,
+	int layout, const void *privkey, size_t privkey_len,
+	void *tmp, size_t tmp_len)
+{
+	if (layout != FALCON_EXPKEY_RECURSIVE
+		&& layout != FALCON_EXPKEY_SEQUENTIAL)
+	{
+		return FALCON_ERR_BADARG;
+	}
+	return expand_privkey_inner(expanded_key, expanded_key_len,
+		layout, 0, privkey, privkey_len, tmp, tmp_len);
+}
+
+/* see falcon.h */
+int
+falcon_expand_privkey_compact(void *expanded_key,
+	size_t expanded_key_len, unsigned levels,
+	const void *privkey, size_t privkey_len,
+	void *tmp, size_t tmp_len)
+{
+	if (levels == 0) {
+		return FALCON_ERR_BADARG;
+	}
+	return expand_privkey_inner(expanded_key, expanded_key_len,
+		FALCON_EXPKEY_RECURSIVE, levels,
+		privkey, privkey_len, tmp, tmp_len);
+}
+
 /* see falcon.h */
 int
 falcon_sign_tree_finish(prng_context *rng,
@@ -596,7 +1008,62 @@ falcon_sign_tree_finish(prng_context *rng,
 	prng_context *hash_data, const void *nonce,
 	void *tmp, size_t tmp_len)
 {
-	unsigned logn;
+	return falcon_sign_tree_finish_ex(rng, sig, sig_len, sig_type,
+		expanded_key, hash_data, nonce, tmp, tmp_len, NULL);
+}
+
+/*
+ * Get the degree, and the tree layout or number of stored tree levels
+ * (for a compact key), from an expanded private key header byte, and
+ * check the temporary buffer size. Returned value: 0 on success, or a
+ * negative error code.
+ */
+static int
+sign_tree_key(const void *expanded_key, size_t tmp_len,
+	unsigned *logn, int *seq, unsigned *levels)
+{
+	unsigned hdr;
+
+	hdr = *(const uint8_t *)expanded_key;
+	*logn = hdr & 0x0F;
+	if (*logn < 1 || *logn > 10) {
+		return FALCON_ERR_FORMAT;
+	}
+	*seq = 0;
+	*levels = 0;
+	switch (hdr >> 4) {
+	case FALCON_EXPKEY_RECURSIVE:
+		break;
+	case FALCON_EXPKEY_SEQUENTIAL:
+		*seq = 1;
+		break;
+	default:
+		if ((hdr >> 4) < 6 || (hdr >> 4) - 5 + 2 > *logn) {
+			return FALCON_ERR_FORMAT;
+		}
+		*levels = (hdr >> 4) - 5;
+		break;
+	}
+	if (tmp_len < (*levels == 0 ? FALCON_TMPSIZE_SIGNTREE(*logn)
+		: FALCON_TMPSIZE_SIGNCOMPACT(*logn)))
+	{
+		return FALCON_ERR_SIZE;
+	}
+	return 0;
+}
+
+/*
+ * Finish a signature with an expanded private key whose header was
+ * decoded with sign_tree_key(); if pre is not NULL, the first attempt
+ * uses that sampler context (see Zf(sign_tree)()).
+ */
+static int
+sign_tree_finish_inner(prng_context *rng, const sampler_context *pre,
+	void *sig, size_t *sig_len, int sig_type,
+	const void *expanded_key, unsigned logn, int seq, unsigned levels,
+	prng_context *hash_data, const void *nonce,
+	void *tmp, falcon_sign_stats *stats)
+{
 	uint8_t *es;
 	const fpr *expkey;
 	uint16_t *hm;
@@ -605,18 +1072,9 @@ falcon_sign_tree_finish(prng_context *rng,
 	size_t u, v, n, es_len;
 	unsigned oldcw;
 	inner_prng_context sav_hash_data;
+	sign_stats st;
+	uint32_t retries;
 
-	/*
-	 * Get degree from private key header byte, and check
-	 * parameters.
-	 */
-	logn = *(const uint8_t *)expanded_key;
-	if (logn < 1 || logn > 10) {
-		return FALCON_ERR_FORMAT;
-	}
-	if (tmp_len < FALCON_TMPSIZE_SIGNTREE(logn)) {
-		return FALCON_ERR_SIZE;
-	}
 	es_len = *sig_len;
 	if (es_len < 41) {
 		return FALCON_ERR_SIZE;
@@ -649,6 +1107,9 @@ falcon_sign_tree_finish(prng_context *rng,
 	 */
 	prng_flip(hash_data);
 	sav_hash_data = *(inner_prng_context *)hash_data;
+	st.attempts = 0;
+	st.rejections = 0;
+	retries = 0;
 
 	/*
 	 * Compute and encode signature.
@@ -662,8 +1123,9 @@ falcon_sign_tree_finish(prng_context *rng,
 		 * to save some RAM).
 		 */
 		*(inner_prng_context *)hash_data = sav_hash_data;
+		PROF_BEGIN(FALCON_PROF_HASH);
 		if (sig_type == FALCON_SIG_CT) {
-			Zf(hash_to_point_ct)(
+			Zd(hash_to_point_ct)(
 				(inner_prng_context *)hash_data,
 				hm, logn, atmp);
 		} else {
@@ -671,10 +1133,20 @@ falcon_sign_tree_finish(prng_context *rng,
 				(inner_prng_context *)hash_data,
 				hm, logn);
 		}
+		PROF_END(FALCON_PROF_HASH);
+		PROF_BEGIN(FALCON_PROF_SIGN);
 		oldcw = set_fpu_cw(2);
-		Zf(sign_tree)(sv, (inner_prng_context *)rng,
-			expkey, hm, logn, atmp);
+		if (levels == 0) {
+			Zd(sign_tree)(sv, (inner_prng_context *)rng, pre,
+				expkey, seq, hm, logn, atmp, &st);
+		} else {
+			Zd(sign_tree_compact)(sv, (inner_prng_context *)rng,
+				pre, expkey, levels, hm, logn, atmp, &st);
+		}
+		pre = NULL;
 		set_fpu_cw(oldcw);
+		PROF_END(FALCON_PROF_SIGN);
+		PROF_BEGIN(FALCON_PROF_ENCODE);
 		es = sig;
 		es_len = *sig_len;
 		memcpy(es + 1, nonce, 40);
@@ -697,6 +1169,8 @@ falcon_sign_tree_finish(prng_context *rng,
 				/*
 				 * Signature does not fit, loop.
 				 */
+				PROF_END(FALCON_PROF_ENCODE);
+				retries ++;
 				continue;
 			}
 			if (u + v < tu) {
@@ -713,11 +1187,36 @@ falcon_sign_tree_finish(prng_context *rng,
 			}
 			break;
 		}
+		PROF_END(FALCON_PROF_ENCODE);
 		*sig_len = u + v;
+		if (stats != NULL) {
+			stats->attempts = st.attempts;
+			stats->sampler_rejections = st.rejections;
+			stats->encode_retries = retries;
+		}
 		return 0;
 	}
 }
 
+/* see falcon.h */
+int
+falcon_sign_tree_finish_ex(prng_context *rng,
+	void *sig, size_t *sig_len, int sig_type,
+	const void *expanded_key,
+	prng_context *hash_data, const void *nonce,
+	void *tmp, size_t tmp_len, falcon_sign_stats *stats)
+{
+	unsigned logn, levels;
+	int seq, r;
+
+	r = sign_tree_key(expanded_key, tmp_len, &logn, &seq, &levels);
+	if (r != 0) {
+		return r;
+	}
+	return sign_tree_finish_inner(rng, NULL, sig, sig_len, sig_type,
+		expanded_key, logn, seq, levels, hash_data, nonce, tmp, stats);
+}
+
 /* see falcon.h */
 int
 falcon_sign_dyn(prng_context *rng,
@@ -725,6 +1224,18 @@ falcon_sign_dyn(prng_context *rng,
 	const void *privkey, size_t privkey_len,
 	const void *data, size_t data_len,
 	void *tmp, size_t tmp_len)
+{
+	return falcon_sign_dyn_ex(rng, sig, sig_len, sig_type,
+		privkey, privkey_len, data, data_len, tmp, tmp_len, NULL);
+}
+
+/* see falcon.h */
+int
+falcon_sign_dyn_ex(prng_context *rng,
+	void *sig, size_t *sig_len, int sig_type,
+	const void *privkey, size_t privkey_len,
+	const void *data, size_t data_len,
+	void *tmp, size_t tmp_len, falcon_sign_stats *stats)
 {
 	prng_context hd;
 	uint8_t nonce[40];
@@ -735,8 +1246,8 @@ falcon_sign_dyn(prng_context *rng,
 		return r;
 	}
 	prng_inject(&hd, data, data_len);
-	return falcon_sign_dyn_finish(rng, sig, sig_len, sig_type,
-		privkey, privkey_len, &hd, nonce, tmp, tmp_len);
+	return falcon_sign_dyn_finish_ex(rng, sig, sig_len, sig_type,
+		privkey, privkey_len, &hd, nonce, tmp, tmp_len, stats);
 }
 
 /* see falcon.h */
@@ -746,6 +1257,18 @@ falcon_sign_tree(prng_context *rng,
 	const void *expanded_key,
 	const void *data, size_t data_len,
 	void *tmp, size_t tmp_len)
+{
+	return falcon_sign_tree_ex(rng, sig, sig_len, sig_type,
+		expanded_key, data, data_len, tmp, tmp_len, NULL);
+}
+
+/* see falcon.h */
+int
+falcon_sign_tree_ex(prng_context *rng,
+	void *sig, size_t *sig_len, int sig_type,
+	const void *expanded_key,
+	const void *data, size_t data_len,
+	void *tmp, size_t tmp_len, falcon_sign_stats *stats)
 {
 	prng_context hd;
 	uint8_t nonce[40];
@@ -756,58 +1279,409 @@ falcon_sign_tree(prng_context *rng,
 		return r;
 	}
 	prng_inject(&hd, data, data_len);
-	return falcon_sign_tree_finish(rng, sig, sig_len, sig_type,
-		expanded_key, &hd, nonce, tmp, tmp_len);
+	return falcon_sign_tree_finish_ex(rng, sig, sig_len, sig_type,
+		expanded_key, &hd, nonce, tmp, tmp_len, stats);
 }
 
 /* see falcon.h */
 int
-falcon_verify_start(prng_context *hash_data,
-	const void *sig, size_t sig_len)
+falcon_sign_tree_batch(prng_context *rng, size_t num,
+	void *const *sig, size_t *sig_len, int sig_type,
+	const void *expanded_key,
+	const void *const *data, const size_t *data_len,
+	int *results, void *tmp, size_t tmp_len, falcon_sign_stats *stats)
 {
-	if (sig_len < 41) {
-		return FALCON_ERR_FORMAT;
+	prng_context hd;
+	uint8_t nonce[40];
+	unsigned logn, levels;
+	size_t u;
+	int seq, r, first;
+
+	/*
+	 * The key header and buffer size are checked once; each item
+	 * then goes through the same steps as falcon_sign_tree_ex(), in
+	 * order, so that the PRNG is used exactly as with num separate
+	 * calls.
+	 */
+	r = sign_tree_key(expanded_key, tmp_len, &logn, &seq, &levels);
+	first = 0;
+	for (u = 0; u < num; u ++) {
+		if (r == 0) {
+			falcon_sign_start(rng, nonce, &hd);
+			prng_inject(&hd, data[u], data_len[u]);
+			results[u] = sign_tree_finish_inner(rng, NULL,
+				sig[u], &sig_len[u], sig_type,
+				expanded_key, logn, seq, levels,
+				&hd, nonce, tmp,
+				stats == NULL ? NULL : &stats[u]);
+		} else {
+			results[u] = r;
+		}
+		if (first == 0) {
+			first = results[u];
+		}
 	}
-	prng_init(hash_data);
-	prng_inject(hash_data, (const uint8_t *)sig + 1, 40);
-	return 0;
+	return first;
 }
 
-/* see falcon.h */
+/*
+ * Contents of a falcon_presign record; logn is 0 in a cleared record.
+ */
+typedef struct {
+	sampler_context spc;
+	uint8_t nonce[40];
+	unsigned logn;
+} presign_state;
+
+/*
+ * Compile-time check that falcon_presign can hold a presign_state.
+ */
+typedef char presign_size_check[
+	sizeof(presign_state) <= sizeof(falcon_presign) ? 1 : -1];
+
+/* see falcon.h */
 int
-falcon_verify_finish(const void *sig, size_t sig_len, int sig_type,
-	const void *pubkey, size_t pubkey_len,
-	prng_context *hash_data,
-	void *tmp, size_t tmp_len)
+falcon_presign_make(prng_context *rng, unsigned logn, falcon_presign *ps)
 {
-	unsigned logn;
-	uint8_t *atmp;
-	const uint8_t *pk, *es;
-	size_t u, v, n;
-	uint16_t *h, *hm;
-	int16_t *sv;
-	int ct;
+	presign_state *st;
+
+	if (logn < 1 || logn > 10) {
+		return FALCON_ERR_BADARG;
+	}
 
 	/*
-	 * Get Falcon degree from public key; verify consistency with
-	 * signature value, and check parameters.
+	 * Same PRNG use as falcon_sign_start() followed by the sampler
+	 * setup of the first signature attempt.
+	 */
+	st = (presign_state *)(void *)ps;
+	prng_extract(rng, st->nonce, 40);
+	Zd(sampler_init)(&st->spc, (inner_prng_context *)rng, logn);
+	st->logn = logn;
+	return 0;
+}
+
+/* see falcon.h */
+void
+falcon_presign_clear(falcon_presign *ps)
+{
+	volatile uint8_t *p;
+	size_t u;
+
+	/*
+	 * A volatile pointer keeps the compiler from removing the
+	 * clearing of a record that is not read afterwards.
+	 */
+	p = (volatile uint8_t *)ps;
+	for (u = 0; u < sizeof *ps; u ++) {
+		p[u] = 0;
+	}
+}
+
+/*
+ * Start hashing the message with the nonce of a precomputed record.
+ */
+static void
+presign_hash(prng_context *hd, const presign_state *st,
+	const void *data, size_t data_len)
+{
+	prng_init(hd);
+	prng_inject(hd, st->nonce, 40);
+	prng_inject(hd, data, data_len);
+}
+
+/* see falcon.h */
+int
+falcon_sign_tree_pre(prng_context *rng, falcon_presign *ps,
+	void *sig, size_t *sig_len, int sig_type,
+	const void *expanded_key,
+	const void *data, size_t data_len,
+	void *tmp, size_t tmp_len, falcon_sign_stats *stats)
+{
+	presign_state *st;
+	prng_context hd;
+	unsigned logn, levels;
+	int seq, r;
+
+	st = (presign_state *)(void *)ps;
+	r = sign_tree_key(expanded_key, tmp_len, &logn, &seq, &levels);
+	if (r == 0 && st->logn != logn) {
+		r = FALCON_ERR_BADARG;
+	}
+	if (r == 0) {
+		presign_hash(&hd, st, data, data_len);
+		r = sign_tree_finish_inner(rng, &st->spc,
+			sig, sig_len, sig_type,
+			expanded_key, logn, seq, levels,
+			&hd, st->nonce, tmp, stats);
+	}
+	falcon_presign_clear(ps);
+	return r;
+}
+
+/* see falcon.h */
+int
+falcon_sign_dyn_pre(prng_context *rng, falcon_presign *ps,
+	void *sig, size_t *sig_len, int sig_type,
+	const void *privkey, size_t privkey_len,
+	const void *data, size_t data_len,
+	void *tmp, size_t tmp_len, falcon_sign_stats *stats)
+{
+	presign_state *st;
+	prng_context hd;
+	int r;
+
+	/*
+	 * The private key itself is checked by sign_dyn_finish_inner().
+	 */
+	st = (presign_state *)(void *)ps;
+	if (privkey_len == 0) {
+		r = FALCON_ERR_FORMAT;
+	} else if ((*(const uint8_t *)privkey & 0x0F) != st->logn
+		|| st->logn == 0)
+	{
+		r = FALCON_ERR_BADARG;
+	} else {
+		presign_hash(&hd, st, data, data_len);
+		r = sign_dyn_finish_inner(rng, &st->spc,
+			sig, sig_len, sig_type, privkey, privkey_len,
+			&hd, st->nonce, tmp, tmp_len, stats);
+	}
+	falcon_presign_clear(ps);
+	return r;
+}
+
+static const uint8_t expkey_magic[8] = {
+	'F', 'L', 'C', 'N', 'E', 'X', 'P', 'K'
+};
+
+/*
+ * Record format version for the recursive tree layout; the sequential
+ * layout uses the next version number.
+ */
+#define EXPKEY_VERSION   1
+
+/*
+ * Checksum of a stored expanded key record: header bytes 0..31, then
+ * the expanded key, read as little-endian 64-bit words spread over four
+ * lanes. It detects accidental corruption (it is not a MAC) and runs at
+ * memory speed, so that checking a key costs much less than expanding
+ * it again.
+ */
+static uint64_t
+expkey_checksum(const uint8_t *rec, size_t eklen)
+{
+	uint64_t h[4], x;
+	size_t u, num;
+
+	h[0] = 0x243F6A8885A308D3;
+	h[1] = 0x13198A2E03707344;
+	h[2] = 0xA4093822299F31D0;
+	h[3] = 0x082EFA98EC4E6C89;
+	num = 4 + (eklen >> 3);
+	for (u = 0; u < num; u ++) {
+		const uint8_t *buf;
+		uint64_t w;
+
+		buf = u < 4 ? rec + (u << 3) : rec + 64 + ((u - 4) << 3);
+#if FALCON_LE && FALCON_UNALIGNED  // yyyLEU+1
+		w = *(const uint64_t *)buf;
+#else  // yyyLEU+0
+		w = (uint64_t)buf[0]
+			| ((uint64_t)buf[1] << 8)
+			| ((uint64_t)buf[2] << 16)
+			| ((uint64_t)buf[3] << 24)
+			| ((uint64_t)buf[4] << 32)
+			| ((uint64_t)buf[5] << 40)
+			| ((uint64_t)buf[6] << 48)
+			| ((uint64_t)buf[7] << 56);
+#endif  // yyyLEU-
+		x = (h[u & 3] ^ w) * 0x9E3779B97F4A7C15;
+		h[u & 3] = (x << 31) | (x >> 33);
+	}
+
+	/*
+	 * Fold the lanes and finalize (MurmurHash3 mixer).
+	 */
+	x = h[0] ^ ((h[1] << 16) | (h[1] >> 48))
+		^ ((h[2] << 32) | (h[2] >> 32))
+		^ ((h[3] << 48) | (h[3] >> 16)) ^ (uint64_t)num;
+	x ^= x >> 33;
+	x *= 0xFF51AFD7ED558CCD;
+	x ^= x >> 33;
+	x *= 0xC4CEB9FE1A85EC53;
+	x ^= x >> 33;
+	return x;
+}
+
+/*
+ * Encode / decode a 64-bit value in little-endian order.
+ */
+static void
+expkey_enc64le(uint8_t *buf, uint64_t x)
+{
+	unsigned u;
+
+	for (u = 0; u < 8; u ++) {
+		buf[u] = (uint8_t)(x >> (8 * u));
+	}
+}
+
+static uint64_t
+expkey_dec64le(const uint8_t *buf)
+{
+	uint64_t x;
+	unsigned u;
+
+	x = 0;
+	for (u = 0; u < 8; u ++) {
+		x |= (uint64_t)buf[u] << (8 * u);
+	}
+	return x;
+}
+
+/* see falcon.h */
+int
+falcon_store_expanded_key(void *out, size_t out_len,
+	const void *expanded_key)
+{
+	uint8_t *rec;
+	unsigned hdr, logn;
+	size_t eklen, reclen;
+
+	/*
+	 * Compact expanded keys (high nibble of the header above 1) have
+	 * no record format.
 	 */
-	if (sig_len < 41 || pubkey_len == 0) {
+	hdr = *(const uint8_t *)expanded_key;
+	logn = hdr & 0x0F;
+	if (logn < 1 || logn > 10 || (hdr >> 4) > FALCON_EXPKEY_SEQUENTIAL) {
 		return FALCON_ERR_FORMAT;
 	}
-	es = sig;
-	pk = pubkey;
-	if ((pk[0] & 0xF0) != 0x00) {
+	eklen = FALCON_EXPANDEDKEY_SIZE(logn);
+	reclen = FALCON_STORED_EXPANDEDKEY_SIZE(logn);
+	if (out_len < reclen) {
+		return FALCON_ERR_SIZE;
+	}
+	rec = out;
+	if (((uintptr_t)rec & 7u) != 0) {
+		return FALCON_ERR_BADARG;
+	}
+
+	/*
+	 * Expanded key in its canonical position: the record is 8-byte
+	 * aligned, so the tree lands at offset 8 of the key.
+	 */
+	memset(rec, 0, reclen);
+	rec[64] = hdr;
+	memcpy(rec + 72, align_fpr((uint8_t *)expanded_key + 1), eklen - 8);
+
+	memcpy(rec, expkey_magic, sizeof expkey_magic);
+	rec[8] = EXPKEY_VERSION + (hdr >> 4);
+	rec[9] = logn;
+	expkey_enc64le(rec + 16, eklen);
+	memcpy(rec + 24, &fpr_inv_log2, 8);
+	expkey_enc64le(rec + 32, expkey_checksum(rec, eklen));
+	return 0;
+}
+
+/* see falcon.h */
+int
+falcon_open_expanded_key(const void **expanded_key,
+	const void *stored, size_t stored_len)
+{
+	const uint8_t *rec;
+	unsigned logn, u;
+
+	rec = stored;
+	if (((uintptr_t)rec & 7u) != 0) {
+		return FALCON_ERR_BADARG;
+	}
+	if (stored_len < 64) {
+		return FALCON_ERR_SIZE;
+	}
+	if (memcmp(rec, expkey_magic, sizeof expkey_magic) != 0
+		|| rec[8] < EXPKEY_VERSION
+		|| rec[8] > EXPKEY_VERSION + FALCON_EXPKEY_SEQUENTIAL)
+	{
 		return FALCON_ERR_FORMAT;
 	}
-	logn = pk[0] & 0x0F;
+	logn = rec[9];
 	if (logn < 1 || logn > 10) {
 		return FALCON_ERR_FORMAT;
 	}
+	for (u = 10; u < 64; u ++) {
+		if (rec[u] != 0 && (u < 16 || u >= 40)) {
+			return FALCON_ERR_FORMAT;
+		}
+	}
+	if (expkey_dec64le(rec + 16) != FALCON_EXPANDEDKEY_SIZE(logn)
+		|| memcmp(rec + 24, &fpr_inv_log2, 8) != 0)
+	{
+		return FALCON_ERR_FORMAT;
+	}
+	if (stored_len < FALCON_STORED_EXPANDEDKEY_SIZE(logn)) {
+		return FALCON_ERR_SIZE;
+	}
+
+	/*
+	 * The key header byte must match the version (tree layout).
+	 */
+	if (rec[64] != ((rec[8] - EXPKEY_VERSION) << 4) + logn) {
+		return FALCON_ERR_FORMAT;
+	}
+	*expanded_key = rec + 64;
+	return (int)FALCON_STORED_EXPANDEDKEY_SIZE(logn);
+}
+
+/* see falcon.h */
+int
+falcon_check_expanded_key(const void *stored, size_t stored_len)
+{
+	const uint8_t *rec;
+	const void *ek;
+	unsigned logn;
+	int r;
+
+	r = falcon_open_expanded_key(&ek, stored, stored_len);
+	if (r < 0) {
+		return r;
+	}
+	rec = stored;
+	logn = rec[9];
+	if (expkey_checksum(rec, FALCON_EXPANDEDKEY_SIZE(logn))
+		!= expkey_dec64le(rec + 32))
+	{
+		return FALCON_ERR_FORMAT;
+	}
+	return 0;
+}
+
+/* see falcon.h */
+int
+falcon_verify_start(prng_context *hash_data,
+	const void *sig, size_t sig_len)
+{
+	if (sig_len < 41) {
+		return FALCON_ERR_FORMAT;
+	}
+	prng_init(hash_data);
+	prng_inject(hash_data, (const uint8_t *)sig + 1, 40);
+	return 0;
+}
+
+/*
+ * Check the signature header byte and length against the expected
+ * degree and signature type. On success, *ct is set to 1 if the
+ * signature uses the CT format, 0 otherwise.
+ */
+static int
+check_sig_format(const uint8_t *es, size_t sig_len, int sig_type,
+	unsigned logn, int *ct)
+{
 	if ((es[0] & 0x0F) != logn) {
 		return FALCON_ERR_BADSIG;
 	}
-	ct = 0;
+	*ct = 0;
 	switch (sig_type) {
 	case 0:
 		switch (es[0] & 0xF0) {
@@ -817,7 +1691,7 @@ falcon_verify_finish(const void *sig, size_t sig_len, int sig_type,
 			if (sig_len != FALCON_SIG_CT_SIZE(logn)) {
 				return FALCON_ERR_FORMAT;
 			}
-			ct = 1;
+			*ct = 1;
 			break;
 		default:
 			return FALCON_ERR_BADSIG;
@@ -843,43 +1717,41 @@ falcon_verify_finish(const void *sig, size_t sig_len, int sig_type,
 		if (sig_len != FALCON_SIG_CT_SIZE(logn)) {
 			return FALCON_ERR_FORMAT;
 		}
-		ct = 1;
+		*ct = 1;
 		break;
 	default:
 		return FALCON_ERR_BADARG;
 	}
-	if (pubkey_len != FALCON_PUBKEY_SIZE(logn)) {
-		return FALCON_ERR_FORMAT;
-	}
-	if (tmp_len < FALCON_TMPSIZE_VERIFY(logn)) {
-		return FALCON_ERR_SIZE;
-	}
-
-	n = (size_t)1 << logn;
-	h = (uint16_t *)align_u16(tmp);
-	hm = h + n;
-	sv = (int16_t *)(hm + n);
-	atmp = (uint8_t *)(sv + n);
+	return 0;
+}
 
-	/*
-	 * Decode public key.
-	 */
-	if (Zf(modq_decode)(h, logn, pk + 1, pubkey_len - 1)
-		!= pubkey_len - 1)
-	{
-		return FALCON_ERR_FORMAT;
-	}
+/*
+ * Decode the signature value, hash the message to a point and verify
+ * the signature against the public key h[] (in NTT + Montgomery
+ * representation). The signature format must have been checked with
+ * check_sig_format(). hm[], sv[] and atmp[] are temporaries of 2*2^logn
+ * bytes each, with 16-bit alignment.
+ */
+static int
+verify_finish_inner(const uint8_t *es, size_t sig_len, int sig_type,
+	int ct, const uint16_t *h, unsigned logn,
+	prng_context *hash_data, uint16_t *hm, int16_t *sv, uint8_t *atmp)
+{
+	size_t u, v;
+	int r;
 
 	/*
 	 * Decode signature value.
 	 */
 	u = 41;
+	PROF_BEGIN(FALCON_PROF_DECODE);
 	if (ct) {
 		v = Zf(trim_i16_decode)(sv, logn,
 			Zf(max_sig_bits)[logn], es + u, sig_len - u);
 	} else {
 		v = Zf(comp_decode)(sv, logn, es + u, sig_len - u);
 	}
+	PROF_END(FALCON_PROF_DECODE);
 	if (v == 0) {
 		return FALCON_ERR_FORMAT;
 	}
@@ -905,40 +1777,890 @@ falcon_verify_finish(const void *sig, size_t sig_len, int sig_type,
 	/*
 	 * Hash message to point.
 	 */
+	PROF_BEGIN(FALCON_PROF_HASH);
 	prng_flip(hash_data);
 	if (ct) {
-		Zf(hash_to_point_ct)(
+		Zd(hash_to_point_ct)(
 			(inner_prng_context *)hash_data, hm, logn, atmp);
 	} else {
 		Zf(hash_to_point_vartime)(
 			(inner_prng_context *)hash_data, hm, logn);
 	}
+	PROF_END(FALCON_PROF_HASH);
 
 	/*
 	 * Verify signature.
 	 */
-	Zf(to_ntt_monty)(h, logn);
-	if (!Zf(verify_raw)(hm, sv, h, logn, atmp)) {
+	PROF_BEGIN(FALCON_PROF_VERIFY);
+	r = Zd(verify_raw)(hm, sv, h, logn, atmp);
+	PROF_END(FALCON_PROF_VERIFY);
+	if (!r) {
 		return FALCON_ERR_BADSIG;
 	}
 	return 0;
 }
 
-/* see falcon.h */
-int
-falcon_verify(const void *sig, size_t sig_len, int sig_type,
-	const void *pubkey, size_t pubkey_len,
-	const void *data, size_t data_len,
+/*
+ * Get the degree of an encoded public key, and check its length. The
+ * encoding is written in *kind: 0 for the normal encoding, or
+ * 1 + FALCON_NTTPUB_PLAIN / FALCON_NTTPUB_MONTY for a key in NTT
+ * representation. Returned value is logn, or a negative error code.
+ */
+static int
+get_pubkey_logn(const void *pubkey, size_t pubkey_len, int *kind)
+{
+	const uint8_t *pk;
+	unsigned logn;
+
+	if (pubkey_len == 0) {
+		return FALCON_ERR_FORMAT;
+	}
+	pk = pubkey;
+	if ((pk[0] >> 4) > 1 + FALCON_NTTPUB_MONTY) {
+		return FALCON_ERR_FORMAT;
+	}
+	logn = pk[0] & 0x0F;
+	if (logn < 1 || logn > 10 || pubkey_len != FALCON_PUBKEY_SIZE(logn)) {
+		return FALCON_ERR_FORMAT;
+	}
+	*kind = pk[0] >> 4;
+	return (int)logn;
+}
+
+/*
+ * Decode an encoded public key (of the kind returned by
+ * get_pubkey_logn()) into h[], in NTT + Montgomery representation.
+ * Returned value: 0 on success, or a negative error code.
+ */
+static int
+decode_pubkey(uint16_t *h, unsigned logn, int kind,
+	const void *pubkey, size_t pubkey_len)
+{
+	if (Zf(modq_decode)(h, logn, (const uint8_t *)pubkey + 1,
+		pubkey_len - 1) != pubkey_len - 1)
+	{
+		return FALCON_ERR_FORMAT;
+	}
+	switch (kind) {
+	case 0:
+		Zd(to_ntt_monty)(h, logn);
+		break;
+	case 1 + FALCON_NTTPUB_PLAIN:
+		Zd(ntt_to_monty)(h, logn);
+		break;
+	}
+	return 0;
+}
+
+/*
+ * Finish a verification with an encoded public key, which must be of
+ * the given kind (0 for the normal encoding, nonzero for either NTT
+ * representation).
+ */
+static int
+verify_finish_pubkey(const void *sig, size_t sig_len, int sig_type,
+	int ntt, const void *pubkey, size_t pubkey_len,
+	prng_context *hash_data,
 	void *tmp, size_t tmp_len)
 {
-	prng_context hd;
-	int r;
+	size_t n;
+	uint16_t *h, *hm;
+	int16_t *sv;
+	int logn, kind, ct, r;
 
-	r = falcon_verify_start(&hd, sig, sig_len);
-	if (r < 0) {
+	/*
+	 * Get Falcon degree from public key; verify consistency with
+	 * signature value, and check parameters.
+	 */
+	if (sig_len < 41) {
+		return FALCON_ERR_FORMAT;
+	}
+	logn = get_pubkey_logn(pubkey, pubkey_len, &kind);
+	if (logn < 0) {
+		return logn;
+	}
+	if ((kind != 0) != (ntt != 0)) {
+		return FALCON_ERR_FORMAT;
+	}
+	r = check_sig_format(sig, sig_len, sig_type, logn, &ct);
+	if (r != 0) {
 		return r;
 	}
-	prng_inject(&hd, data, data_len);
-	return falcon_verify_finish(sig, sig_len, sig_type,
-		pubkey, pubkey_len, &hd, tmp, tmp_len);
+	if (tmp_len < FALCON_TMPSIZE_VERIFY(logn)) {
+		return FALCON_ERR_SIZE;
+	}
+
+	n = (size_t)1 << logn;
+	h = (uint16_t *)align_u16(tmp);
+	hm = h + n;
+	sv = (int16_t *)(hm + n);
+
+	/*
+	 * Decode public key.
+	 */
+	r = decode_pubkey(h, logn, kind, pubkey, pubkey_len);
+	if (r != 0) {
+		return r;
+	}
+
+	return verify_finish_inner(sig, sig_len, sig_type, ct, h, logn,
+		hash_data, hm, sv, (uint8_t *)(sv + n));
+}
+
+/* see falcon.h */
+int
+falcon_verify_finish(const void *sig, size_t sig_len, int sig_type,
+	const void *pubkey, size_t pubkey_len,
+	prng_context *hash_data,
+	void *tmp, size_t tmp_len)
+{
+	return verify_finish_pubkey(sig, sig_len, sig_type, 0,
+		pubkey, pubkey_len, hash_data, tmp, tmp_len);
+}
+
+/* see falcon.h */
+int
+falcon_expand_pubkey(void *expanded_pubkey, size_t expanded_pubkey_len,
+	const void *pubkey, size_t pubkey_len)
+{
+	uint16_t *h;
+	int logn, kind, r;
+
+	logn = get_pubkey_logn(pubkey, pubkey_len, &kind);
+	if (logn < 0) {
+		return logn;
+	}
+	if (expanded_pubkey_len < FALCON_EXPANDEDPUBKEY_SIZE(logn)) {
+		return FALCON_ERR_SIZE;
+	}
+
+	h = (uint16_t *)align_u16((uint8_t *)expanded_pubkey + 1);
+	r = decode_pubkey(h, logn, kind, pubkey, pubkey_len);
+	if (r != 0) {
+		return r;
+	}
+	*(uint8_t *)expanded_pubkey = logn;
+	return 0;
+}
+
+/* see falcon.h */
+int
+falcon_encode_ntt_pubkey(void *ntt_pubkey, size_t ntt_pubkey_len,
+	int form, const void *pubkey, size_t pubkey_len,
+	void *tmp, size_t tmp_len)
+{
+	uint8_t *npk;
+	uint16_t *h;
+	int logn, kind;
+
+	if (form != FALCON_NTTPUB_PLAIN && form != FALCON_NTTPUB_MONTY) {
+		return FALCON_ERR_BADARG;
+	}
+	logn = get_pubkey_logn(pubkey, pubkey_len, &kind);
+	if (logn < 0) {
+		return logn;
+	}
+	if (kind != 0) {
+		return FALCON_ERR_FORMAT;
+	}
+	if (ntt_pubkey_len < FALCON_NTTPUBKEY_SIZE(logn)) {
+		return FALCON_ERR_SIZE;
+	}
+	if (tmp_len < FALCON_TMPSIZE_NTTPUB(logn)) {
+		return FALCON_ERR_SIZE;
+	}
+
+	h = (uint16_t *)align_u16(tmp);
+	if (Zf(modq_decode)(h, logn, (const uint8_t *)pubkey + 1,
+		pubkey_len - 1) != pubkey_len - 1)
+	{
+		return FALCON_ERR_FORMAT;
+	}
+	if (form == FALCON_NTTPUB_MONTY) {
+		Zd(to_ntt_monty)(h, logn);
+	} else {
+		Zd(to_ntt)(h, logn);
+	}
+	npk = ntt_pubkey;
+	npk[0] = ((1 + form) << 4) + logn;
+	if (Zf(modq_encode)(npk + 1, FALCON_NTTPUBKEY_SIZE(logn) - 1, h, logn)
+		!= FALCON_NTTPUBKEY_SIZE(logn) - 1)
+	{
+		return FALCON_ERR_INTERNAL;
+	}
+	return 0;
+}
+
+/* see falcon.h */
+int
+falcon_verify_ntt_pubkey_finish(const void *sig, size_t sig_len,
+	int sig_type, const void *ntt_pubkey, size_t ntt_pubkey_len,
+	prng_context *hash_data,
+	void *tmp, size_t tmp_len)
+{
+	return verify_finish_pubkey(sig, sig_len, sig_type, 1,
+		ntt_pubkey, ntt_pubkey_len, hash_data, tmp, tmp_len);
+}
+
+/* see falcon.h */
+int
+falcon_verify_expanded_finish(const void *sig, size_t sig_len,
+	int sig_type, const void *expanded_pubkey,
+	prng_context *hash_data,
+	void *tmp, size_t tmp_len)
+{
+	unsigned logn;
+	const uint16_t *h;
+	size_t n;
+	uint16_t *hm;
+	int16_t *sv;
+	int ct, r;
+
+	if (sig_len < 41) {
+		return FALCON_ERR_FORMAT;
+	}
+	logn = *(const uint8_t *)expanded_pubkey;
+	if (logn < 1 || logn > 10) {
+		return FALCON_ERR_FORMAT;
+	}
+	r = check_sig_format(sig, sig_len, sig_type, logn, &ct);
+	if (r != 0) {
+		return r;
+	}
+	if (tmp_len < FALCON_TMPSIZE_VERIFY(logn)) {
+		return FALCON_ERR_SIZE;
+	}
+
+	n = (size_t)1 << logn;
+	h = (const uint16_t *)align_u16((uint8_t *)expanded_pubkey + 1);
+	hm = (uint16_t *)align_u16(tmp);
+	sv = (int16_t *)(hm + n);
+	return verify_finish_inner(sig, sig_len, sig_type, ct, h, logn,
+		hash_data, hm, sv, (uint8_t *)(sv + n));
+}
+
+/* see falcon.h */
+int
+falcon_verify(const void *sig, size_t sig_len, int sig_type,
+	const void *pubkey, size_t pubkey_len,
+	const void *data, size_t data_len,
+	void *tmp, size_t tmp_len)
+{
+	prng_context hd;
+	int r;
+
+	r = falcon_verify_start(&hd, sig, sig_len);
+	if (r < 0) {
+		return r;
+	}
+	prng_inject(&hd, data, data_len);
+	return falcon_verify_finish(sig, sig_len, sig_type,
+		pubkey, pubkey_len, &hd, tmp, tmp_len);
+}
+
+/* see falcon.h */
+int
+falcon_verify_expanded(const void *sig, size_t sig_len, int sig_type,
+	const void *expanded_pubkey,
+	const void *data, size_t data_len,
+	void *tmp, size_t tmp_len)
+{
+	prng_context hd;
+	int r;
+
+	r = falcon_verify_start(&hd, sig, sig_len);
+	if (r < 0) {
+		return r;
+	}
+	prng_inject(&hd, data, data_len);
+	return falcon_verify_expanded_finish(sig, sig_len, sig_type,
+		expanded_pubkey, &hd, tmp, tmp_len);
+}
+
+/* see falcon.h */
+int
+falcon_verify_ntt_pubkey(const void *sig, size_t sig_len, int sig_type,
+	const void *ntt_pubkey, size_t ntt_pubkey_len,
+	const void *data, size_t data_len,
+	void *tmp, size_t tmp_len)
+{
+	prng_context hd;
+	int r;
+
+	r = falcon_verify_start(&hd, sig, sig_len);
+	if (r < 0) {
+		return r;
+	}
+	prng_inject(&hd, data, data_len);
+	return falcon_verify_ntt_pubkey_finish(sig, sig_len, sig_type,
+		ntt_pubkey, ntt_pubkey_len, &hd, tmp, tmp_len);
+}
+
+/* see falcon.h */
+int
+falcon_verify_batch(size_t num,
+	const void *const *sig, const size_t *sig_len, int sig_type,
+	const void *const *pubkey, const size_t *pubkey_len,
+	const void *const *data, const size_t *data_len,
+	int *results, void *tmp, size_t tmp_len)
+{
+	uint8_t *epk, *vtmp;
+	size_t u, epk_len, vtmp_len;
+	const void *cur_pk;
+	size_t cur_pk_len;
+	unsigned max_logn;
+	int bad;
+
+	/*
+	 * The start of tmp[] holds the expanded form of the current
+	 * public key (sized for the largest degree that fits), and the
+	 * rest is the verification temporary.
+	 */
+	for (max_logn = 10; max_logn >= 1; max_logn --) {
+		if (tmp_len >= FALCON_TMPSIZE_VERIFYBATCH(max_logn)) {
+			break;
+		}
+	}
+	epk = tmp;
+	epk_len = max_logn == 0 ? 0 : FALCON_EXPANDEDPUBKEY_SIZE(max_logn);
+	vtmp = epk + epk_len;
+	vtmp_len = tmp_len - epk_len;
+
+	cur_pk = NULL;
+	cur_pk_len = 0;
+	bad = 0;
+	for (u = 0; u < num; u ++) {
+		int r, logn;
+
+		if (max_logn == 0) {
+			results[u] = FALCON_ERR_SIZE;
+			bad = 1;
+			continue;
+		}
+
+		/*
+		 * Expand the public key, unless it is the same as the
+		 * one used for the previous item.
+		 */
+		if (cur_pk == NULL || pubkey_len[u] != cur_pk_len
+			|| (pubkey[u] != cur_pk
+			&& memcmp(pubkey[u], cur_pk, cur_pk_len) != 0))
+		{
+			cur_pk = NULL;
+			logn = falcon_get_logn((void *)pubkey[u], pubkey_len[u]);
+			if (logn > (int)max_logn) {
+				results[u] = FALCON_ERR_SIZE;
+				bad = 1;
+				continue;
+			}
+			r = falcon_expand_pubkey(epk, epk_len,
+				pubkey[u], pubkey_len[u]);
+			if (r != 0) {
+				results[u] = r;
+				bad = 1;
+				continue;
+			}
+			cur_pk = pubkey[u];
+			cur_pk_len = pubkey_len[u];
+		}
+
+		r = falcon_verify_expanded(sig[u], sig_len[u], sig_type,
+			epk, data[u], data_len[u], vtmp, vtmp_len);
+		results[u] = r;
+		if (r != 0) {
+			bad = 1;
+		}
+	}
+	return bad ? FALCON_ERR_BADSIG : 0;
+}
+
+/* ==================================================================== */
+/*
+ * Reusable contexts.
+ */
+
+struct falcon_ctx_ {
+	uint8_t *tmp;
+	size_t tmp_len;
+	void *base;
+	size_t base_len;
+	int backing;
+};
+
+#define CTX_HUGEPAGE_SIZE   ((size_t)2 << 20)
+
+/*
+ * Get the arena size for a context; 0 on invalid parameters.
+ */
+static size_t
+ctx_tmp_len(unsigned max_logn, unsigned nthreads)
+{
+	if (max_logn < 1 || max_logn > 10
+		|| nthreads > FALCON_KEYGEN_MAX_THREADS)
+	{
+		return 0;
+	}
+	return FALCON_CTX_SIZE(max_logn, nthreads) - 128u;
+}
+
+/*
+ * Set up a context header and its arena within buf[] (of length len
+ * bytes, which includes the 128 extra bytes of FALCON_CTX_SIZE(): the
+ * header, and the alignment of the header and arena). The arena is
+ * aligned on a cache line.
+ */
+static falcon_ctx *
+ctx_setup(void *buf, size_t len, size_t tmp_len, int backing)
+{
+	falcon_ctx *ctx;
+	uintptr_t a;
+
+	a = ((uintptr_t)buf + 15) & ~(uintptr_t)15;
+	ctx = (falcon_ctx *)a;
+	a = ((uintptr_t)(ctx + 1) + 63) & ~(uintptr_t)63;
+	if (a + tmp_len > (uintptr_t)buf + len) {
+		return NULL;
+	}
+	ctx->tmp = (uint8_t *)a;
+	ctx->tmp_len = tmp_len;
+	ctx->base = buf;
+	ctx->base_len = len;
+	ctx->backing = backing;
+	return ctx;
+}
+
+/* see falcon.h */
+falcon_ctx *
+falcon_ctx_new(unsigned max_logn, unsigned nthreads, unsigned flags)
+{
+	size_t tmp_len, len;
+	void *buf;
+	falcon_ctx *ctx;
+
+	tmp_len = ctx_tmp_len(max_logn, nthreads);
+	if (tmp_len == 0 || (flags & ~(unsigned)FALCON_CTX_HUGEPAGES) != 0) {
+		return NULL;
+	}
+	len = tmp_len + 128u;
+
+#if FALCON_HUGEPAGES
+	if ((flags & FALCON_CTX_HUGEPAGES) != 0) {
+		size_t hlen;
+
+		/*
+		 * An explicit huge page is used if some are reserved;
+		 * otherwise, a region aligned on a huge page boundary
+		 * is mapped and advised for a transparent huge page.
+		 */
+		hlen = (len + CTX_HUGEPAGE_SIZE - 1)
+			& ~(CTX_HUGEPAGE_SIZE - 1);
+#ifdef MAP_HUGETLB
+		buf = mmap(NULL, hlen, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (buf != MAP_FAILED) {
+			return ctx_setup(buf, hlen, tmp_len,
+				FALCON_CTX_HUGETLB);
+		}
+#endif
+#ifdef MADV_HUGEPAGE
+		buf = mmap(NULL, hlen + CTX_HUGEPAGE_SIZE,
+			PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (buf != MAP_FAILED) {
+			uint8_t *b, *e, *a;
+
+			/*
+			 * Trim the mapping to the aligned region.
+			 */
+			b = buf;
+			e = b + hlen + CTX_HUGEPAGE_SIZE;
+			a = (uint8_t *)(((uintptr_t)b + CTX_HUGEPAGE_SIZE - 1)
+				& ~(uintptr_t)(CTX_HUGEPAGE_SIZE - 1));
+			if (a > b) {
+				munmap(b, (size_t)(a - b));
+			}
+			if (a + hlen < e) {
+				munmap(a + hlen, (size_t)(e - (a + hlen)));
+			}
+			if (madvise(a, hlen, MADV_HUGEPAGE) == 0) {
+				return ctx_setup(a, hlen, tmp_len,
+					FALCON_CTX_THP);
+			}
+			munmap(a, hlen);
+		}
+#endif
+	}
+#endif
+
+	buf = malloc(len);
+	if (buf == NULL) {
+		return NULL;
+	}
+	ctx = ctx_setup(buf, len, tmp_len, FALCON_CTX_HEAP);
+	if (ctx == NULL) {
+		free(buf);
+	}
+	return ctx;
+}
+
+/* see falcon.h */
+falcon_ctx *
+falcon_ctx_init(void *buf, size_t len, unsigned max_logn, unsigned nthreads)
+{
+	size_t tmp_len;
+
+	tmp_len = ctx_tmp_len(max_logn, nthreads);
+	if (buf == NULL || tmp_len == 0 || len < tmp_len + 128u) {
+		return NULL;
+	}
+	return ctx_setup(buf, len, tmp_len, FALCON_CTX_CALLER);
+}
+
+/* see falcon.h */
+void
+falcon_ctx_free(falcon_ctx *ctx)
+{
+	volatile uint8_t *p;
+	void *base;
+	size_t u, len;
+	int backing;
+
+	if (ctx == NULL) {
+		return;
+	}
+
+	/*
+	 * Clear the arena (through a volatile pointer, so that the
+	 * compiler does not remove it), then release the memory.
+	 */
+	p = ctx->tmp;
+	for (u = 0; u < ctx->tmp_len; u ++) {
+		p[u] = 0;
+	}
+	base = ctx->base;
+	len = ctx->base_len;
+	backing = ctx->backing;
+	switch (backing) {
+	case FALCON_CTX_HEAP:
+		free(base);
+		break;
+#if FALCON_HUGEPAGES
+	case FALCON_CTX_HUGETLB:
+	case FALCON_CTX_THP:
+		munmap(base, len);
+		break;
+#endif
+	default:
+		(void)len;
+		break;
+	}
+}
+
+/* see falcon.h */
+int
+falcon_ctx_backing(const falcon_ctx *ctx)
+{
+	return ctx->backing;
+}
+
+/* see falcon.h */
+void *
+falcon_ctx_tmp(falcon_ctx *ctx, size_t *len)
+{
+	if (len != NULL) {
+		*len = ctx->tmp_len;
+	}
+	return ctx->tmp;
+}
+
+/* see falcon.h */
+int
+falcon_keygen_make_ctx(falcon_ctx *ctx,
+	prng_context *rng, unsigned logn,
+	void *privkey, size_t privkey_len,
+	void *pubkey, size_t pubkey_len)
+{
+	return falcon_keygen_make(rng, logn, privkey, privkey_len,
+		pubkey, pubkey_len, ctx->tmp, ctx->tmp_len);
+}
+
+/* see falcon.h */
+int
+falcon_keygen_make_mt_ctx(falcon_ctx *ctx,
+	prng_context *rng, unsigned logn,
+	void *privkey, size_t privkey_len,
+	void *pubkey, size_t pubkey_len,
+	unsigned nthreads)
+{
+	return falcon_keygen_make_mt(rng, logn, privkey, privkey_len,
+		pubkey, pubkey_len, ctx->tmp, ctx->tmp_len, nthreads);
+}
+
+/* see falcon.h */
+int
+falcon_make_public_ctx(falcon_ctx *ctx,
+	void *pubkey, size_t pubkey_len,
+	const void *privkey, size_t privkey_len)
+{
+	return falcon_make_public(pubkey, pubkey_len, privkey,
+		privkey_len, ctx->tmp, ctx->tmp_len);
+}
+
+/* see falcon.h */
+int
+falcon_sign_dyn_ctx(falcon_ctx *ctx, prng_context *rng,
+	void *sig, size_t *sig_len, int sig_type,
+	const void *privkey, size_t privkey_len,
+	const void *data, size_t data_len)
+{
+	return falcon_sign_dyn(rng, sig, sig_len, sig_type, privkey,
+		privkey_len, data, data_len, ctx->tmp, ctx->tmp_len);
+}
+
+/* see falcon.h */
+int
+falcon_sign_dyn_ex_ctx(falcon_ctx *ctx, prng_context *rng,
+	void *sig, size_t *sig_len, int sig_type,
+	const void *privkey, size_t privkey_len,
+	const void *data, size_t data_len, falcon_sign_stats *stats)
+{
+	return falcon_sign_dyn_ex(rng, sig, sig_len, sig_type, privkey,
+		privkey_len, data, data_len, ctx->tmp, ctx->tmp_len,
+		stats);
+}
+
+/* see falcon.h */
+int
+falcon_sign_dyn_finish_ctx(falcon_ctx *ctx, prng_context *rng,
+	void *sig, size_t *sig_len, int sig_type,
+	const void *privkey, size_t privkey_len,
+	prng_context *hash_data, const void *nonce)
+{
+	return falcon_sign_dyn_finish(rng, sig, sig_len, sig_type,
+		privkey, privkey_len, hash_data, nonce,
+		ctx->tmp, ctx->tmp_len);
+}
+
+/* see falcon.h */
+int
+falcon_sign_dyn_finish_ex_ctx(falcon_ctx *ctx, prng_context *rng,
+	void *sig, size_t *sig_len, int sig_type,
+	const void *privkey, size_t privkey_len,
+	prng_context *hash_data, const void *nonce,
+	falcon_sign_stats *stats)
+{
+	return falcon_sign_dyn_finish_ex(rng, sig, sig_len, sig_type,
+		privkey, privkey_len, hash_data, nonce,
+		ctx->tmp, ctx->tmp_len, stats);
+}
+
+/* see falcon.h */
+int
+falcon_expand_privkey_ctx(falcon_ctx *ctx,
+	void *expanded_key, size_t expanded_key_len,
+	const void *privkey, size_t privkey_len)
+{
+	return falcon_expand_privkey(expanded_key, expanded_key_len,
+		privkey, privkey_len, ctx->tmp, ctx->tmp_len);
+}
+
+/* see falcon.h */
+int
+falcon_expand_privkey_layout_ctx(falcon_ctx *ctx,
+	void *expanded_key, size_t expanded_key_len,
+	int layout, const void *privkey, size_t privkey_len)
+{
+	return falcon_expand_privkey_layout(expanded_key,
+		expanded_key_len, layout, privkey, privkey_len,
+		ctx->tmp, ctx->tmp_len);
+}
+
+/* see falcon.h */
+int
+falcon_expand_privkey_compact_ctx(falcon_ctx *ctx,
+	void *expanded_key, size_t expanded_key_len, unsigned levels,
+	const void *privkey, size_t privkey_len)
+{
+	return falcon_expand_privkey_compact(expanded_key,
+		expanded_key_len, levels, privkey, privkey_len,
+		ctx->tmp, ctx->tmp_len);
+}
+
+/* see falcon.h */
+int
+falcon_sign_tree_ctx(falcon_ctx *ctx, prng_context *rng,
+	void *sig, size_t *sig_len, int sig_type,
+	const void *expanded_key,
+	const void *data, size_t data_len)
+{
+	return falcon_sign_tree(rng, sig, sig_len, sig_type,
+		expanded_key, data, data_len, ctx->tmp, ctx->tmp_len);
+}
+
+/* see falcon.h */
+int
+falcon_sign_tree_ex_ctx(falcon_ctx *ctx, prng_context *rng,
+	void *sig, size_t *sig_len, int sig_type,
+	const void *expanded_key,
+	const void *data, size_t data_len, falcon_sign_stats *stats)
+{
+	return falcon_sign_tree_ex(rng, sig, sig_len, sig_type,
+		expanded_key, data, data_len, ctx->tmp, ctx->tmp_len,
+		stats);
+}
+
+/* see falcon.h */
+int
+falcon_sign_tree_finish_ctx(falcon_ctx *ctx, prng_context *rng,
+	void *sig, size_t *sig_len, int sig_type,
+	const void *expanded_key,
+	prng_context *hash_data, const void *nonce)
+{
+	return falcon_sign_tree_finish(rng, sig, sig_len, sig_type,
+		expanded_key, hash_data, nonce, ctx->tmp, ctx->tmp_len);
+}
+
+/* see falcon.h */
+int
+falcon_sign_tree_finish_ex_ctx(falcon_ctx *ctx, prng_context *rng,
+	void *sig, size_t *sig_len, int sig_type,
+	const void *expanded_key,
+	prng_context *hash_data, const void *nonce,
+	falcon_sign_stats *stats)
+{
+	return falcon_sign_tree_finish_ex(rng, sig, sig_len, sig_type,
+		expanded_key, hash_data, nonce, ctx->tmp, ctx->tmp_len,
+		stats);
+}
+
+/* see falcon.h */
+int
+falcon_sign_tree_batch_ctx(falcon_ctx *ctx,
+	prng_context *rng, size_t num,
+	void *const *sig, size_t *sig_len, int sig_type,
+	const void *expanded_key,
+	const void *const *data, const size_t *data_len,
+	int *results, falcon_sign_stats *stats)
+{
+	return falcon_sign_tree_batch(rng, num, sig, sig_len, sig_type,
+		expanded_key, data, data_len, results,
+		ctx->tmp, ctx->tmp_len, stats);
+}
+
+/* see falcon.h */
+int
+falcon_sign_tree_pre_ctx(falcon_ctx *ctx,
+	prng_context *rng, falcon_presign *ps,
+	void *sig, size_t *sig_len, int sig_type,
+	const void *expanded_key,
+	const void *data, size_t data_len, falcon_sign_stats *stats)
+{
+	return falcon_sign_tree_pre(rng, ps, sig, sig_len, sig_type,
+		expanded_key, data, data_len,
+		ctx->tmp, ctx->tmp_len, stats);
+}
+
+/* see falcon.h */
+int
+falcon_sign_dyn_pre_ctx(falcon_ctx *ctx,
+	prng_context *rng, falcon_presign *ps,
+	void *sig, size_t *sig_len, int sig_type,
+	const void *privkey, size_t privkey_len,
+	const void *data, size_t data_len, falcon_sign_stats *stats)
+{
+	return falcon_sign_dyn_pre(rng, ps, sig, sig_len, sig_type,
+		privkey, privkey_len, data, data_len,
+		ctx->tmp, ctx->tmp_len, stats);
+}
+
+/* see falcon.h */
+int
+falcon_verify_ctx(falcon_ctx *ctx,
+	const void *sig, size_t sig_len, int sig_type,
+	const void *pubkey, size_t pubkey_len,
+	const void *data, size_t data_len)
+{
+	return falcon_verify(sig, sig_len, sig_type, pubkey, pubkey_len,
+		data, data_len, ctx->tmp, ctx->tmp_len);
+}
+
+/* see falcon.h */
+int
+falcon_verify_finish_ctx(falcon_ctx *ctx,
+	const void *sig, size_t sig_len, int sig_type,
+	const void *pubkey, size_t pubkey_len,
+	prng_context *hash_data)
+{
+	return falcon_verify_finish(sig, sig_len, sig_type, pubkey,
+		pubkey_len, hash_data, ctx->tmp, ctx->tmp_len);
+}
+
+/* see falcon.h */
+int
+falcon_verify_expanded_ctx(falcon_ctx *ctx,
+	const void *sig, size_t sig_len, int sig_type,
+	const void *expanded_pubkey,
+	const void *data, size_t data_len)
+{
+	return falcon_verify_expanded(sig, sig_len, sig_type,
+		expanded_pubkey, data, data_len,
+		ctx->tmp, ctx->tmp_len);
+}
+
+/* see falcon.h */
+int
+falcon_verify_expanded_finish_ctx(falcon_ctx *ctx,
+	const void *sig, size_t sig_len, int sig_type,
+	const void *expanded_pubkey,
+	prng_context *hash_data)
+{
+	return falcon_verify_expanded_finish(sig, sig_len, sig_type,
+		expanded_pubkey, hash_data, ctx->tmp, ctx->tmp_len);
+}
+
+/* see falcon.h */
+int
+falcon_encode_ntt_pubkey_ctx(falcon_ctx *ctx,
+	void *ntt_pubkey, size_t ntt_pubkey_len,
+	int form, const void *pubkey, size_t pubkey_len)
+{
+	return falcon_encode_ntt_pubkey(ntt_pubkey, ntt_pubkey_len,
+		form, pubkey, pubkey_len, ctx->tmp, ctx->tmp_len);
+}
+
+/* see falcon.h */
+int
+falcon_verify_ntt_pubkey_ctx(falcon_ctx *ctx,
+	const void *sig, size_t sig_len, int sig_type,
+	const void *ntt_pubkey, size_t ntt_pubkey_len,
+	const void *data, size_t data_len)
+{
+	return falcon_verify_ntt_pubkey(sig, sig_len, sig_type,
+		ntt_pubkey, ntt_pubkey_len, data, data_len,
+		ctx->tmp, ctx->tmp_len);
+}
+
+/* see falcon.h */
+int
+falcon_verify_ntt_pubkey_finish_ctx(falcon_ctx *ctx,
+	const void *sig, size_t sig_len, int sig_type,
+	const void *ntt_pubkey, size_t ntt_pubkey_len,
+	prng_context *hash_data)
+{
+	return falcon_verify_ntt_pubkey_finish(sig, sig_len, sig_type,
+		ntt_pubkey, ntt_pubkey_len, hash_data,
+		ctx->tmp, ctx->tmp_len);
+}
+
+/* see falcon.h */
+int
+falcon_verify_batch_ctx(falcon_ctx *ctx, size_t num,
+	const void *const *sig, const size_t *sig_len, int sig_type,
+	const void *const *pubkey, const size_t *pubkey_len,
+	const void *const *data, const size_t *data_len,
+	int *results)
+{
+	return falcon_verify_batch(num, sig, sig_len, sig_type, pubkey,
+		pubkey_len, data, data_len, results,
+		ctx->tmp, ctx->tmp_len);
 }
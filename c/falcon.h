@@ -349,6 +349,16 @@ extern "C" {
 #define FALCON_TMPSIZE_KEYGEN(logn) \
 	(((logn) <= 3 ? 272u : (28u << (logn))) + (3u << (logn)) + 7)
 
+/*
+ * Temporary buffer size for key pair generation with nthreads threads
+ * (falcon_keygen_make_mt()): each thread beyond the first needs a
+ * scratch area of 24*2^logn bytes. For nthreads = 1, this is
+ * FALCON_TMPSIZE_KEYGEN(logn).
+ */
+#define FALCON_TMPSIZE_KEYGEN_MT(logn, nthreads) \
+	(FALCON_TMPSIZE_KEYGEN(logn) + ((nthreads) > 1 \
+		? ((nthreads) - 1) * (24u << (logn)) + 63 : 0u))
+
 /*
  * Temporary buffer size for computing the pubic key from the private key.
  */
@@ -380,12 +390,186 @@ extern "C" {
 #define FALCON_EXPANDEDKEY_SIZE(logn) \
 	(((8u * (logn) + 40) << (logn)) + 8)
 
+/*
+ * Size of a compact expanded private key, with 'levels' stored levels
+ * of the LDL tree (see falcon_expand_privkey_compact()).
+ */
+#define FALCON_COMPACTKEY_SIZE(logn, levels) \
+	(((8u * (levels) + 20) << (logn)) + 8)
+
+/*
+ * Temporary buffer size for expanding a private key into a compact
+ * expanded key.
+ */
+#define FALCON_TMPSIZE_EXPANDCOMPACT(logn) \
+	((84u << (logn)) + 7)
+
+/*
+ * Temporary buffer size for generating a signature with a compact
+ * expanded key (falcon_sign_tree() and variants).
+ */
+#define FALCON_TMPSIZE_SIGNCOMPACT(logn) \
+	(((4u * (logn) + 94) << (logn)) + 7)
+
+/*
+ * Size of a stored expanded private key record (see
+ * falcon_store_expanded_key()): a 64-byte header followed by the
+ * expanded key, padded to a multiple of 64 bytes.
+ */
+#define FALCON_STORED_EXPANDEDKEY_SIZE(logn) \
+	(64u + ((FALCON_EXPANDEDKEY_SIZE(logn) + 63u) & ~(size_t)63))
+
+/*
+ * Size of an expanded public key (public key decoded and converted to
+ * NTT + Montgomery representation, see falcon_expand_pubkey()).
+ */
+#define FALCON_EXPANDEDPUBKEY_SIZE(logn) \
+	((2u << (logn)) + 2)
+
+/*
+ * Size of a public key in NTT representation (see
+ * falcon_encode_ntt_pubkey()); this is the size of the public key.
+ */
+#define FALCON_NTTPUBKEY_SIZE(logn)   FALCON_PUBKEY_SIZE(logn)
+
+/*
+ * Temporary buffer size for converting a public key to NTT
+ * representation.
+ */
+#define FALCON_TMPSIZE_NTTPUB(logn) \
+	((2u << (logn)) + 1)
+
 /*
  * Temporary buffer size for verifying a signature.
  */
 #define FALCON_TMPSIZE_VERIFY(logn) \
 	((8u << (logn)) + 1)
 
+/*
+ * Temporary buffer size for verifying a batch of signatures (see
+ * falcon_verify_batch()); 'logn' is the largest degree in the batch.
+ */
+#define FALCON_TMPSIZE_VERIFYBATCH(logn) \
+	(FALCON_EXPANDEDPUBKEY_SIZE(logn) + FALCON_TMPSIZE_VERIFY(logn))
+
+/*
+ * Temporary buffer size that is enough for all operations on keys of
+ * degree up to 2^logn (except multi-threaded key pair generation):
+ * signing with a compact key needs the most, except for the smallest
+ * degrees, where key pair generation does.
+ */
+#define FALCON_TMPSIZE_MAX(logn) \
+	(FALCON_TMPSIZE_KEYGEN(logn) > FALCON_TMPSIZE_SIGNCOMPACT(logn) \
+		? FALCON_TMPSIZE_KEYGEN(logn) : FALCON_TMPSIZE_SIGNCOMPACT(logn))
+
+/*
+ * Size of a caller-provided buffer for falcon_ctx_init(), for degrees
+ * up to 2^max_logn and key pair generation with up to nthreads threads
+ * (0 or 1 for the single-threaded functions only).
+ */
+#define FALCON_CTX_SIZE(max_logn, nthreads) \
+	(128u + (FALCON_TMPSIZE_MAX(max_logn) \
+		> FALCON_TMPSIZE_KEYGEN_MT(max_logn, nthreads) \
+		? FALCON_TMPSIZE_MAX(max_logn) \
+		: FALCON_TMPSIZE_KEYGEN_MT(max_logn, nthreads)))
+
+/* ==================================================================== */
+/*
+ * Implementation selection.
+ *
+ * Key pair generation, private key expansion and signing use
+ * floating-point code that has a generic version and a vector version:
+ * AVX2+FMA on x86, NEON on AArch64. When the library is built with
+ * FALCON_DISPATCH (both versions linked in), the AVX2 version is
+ * selected at runtime if the CPU supports it; the NEON version has not
+ * been tested on AArch64 hardware yet, and is used only if selected
+ * with falcon_set_impl(). Without FALCON_DISPATCH, the version is the
+ * one chosen at compile time with FALCON_AVX2 or FALCON_NEON. All
+ * versions produce interoperable keys and signatures. With FMA,
+ * expanded private keys may differ slightly between versions; an
+ * expanded key should be used with the version that produced it. The
+ * NEON version computes the same values as the generic one.
+ */
+
+#define FALCON_IMPL_GENERIC   0
+#define FALCON_IMPL_AVX2      1
+#define FALCON_IMPL_NEON      2
+
+/*
+ * Get the implementation in use (one of the FALCON_IMPL_* values).
+ */
+int falcon_get_impl(void);
+
+/*
+ * Force the implementation to use. This is meant for tests and
+ * benchmarks, and for opting in to the NEON version; it should be
+ * called before any other Falcon function.
+ * Returned value is 0 on success, or FALCON_ERR_BADARG if the requested
+ * implementation is unknown, not linked in, or not supported by the CPU.
+ */
+int falcon_set_impl(int impl);
+
+/*
+ * Enable or disable the degree-specialized code paths. The FFT and NTT
+ * are compiled a second time with the degree fixed to 512 and 1024
+ * (logn = 9 and 10), and those versions are used for these degrees;
+ * other degrees always use the generic code. Both compute exactly the
+ * same values. Like falcon_set_impl(), this is meant for tests and
+ * benchmarks. Returned value is the previous setting (1 if enabled);
+ * when the library is built with FALCON_SPECIALIZE=0, this function
+ * does nothing and returns 0.
+ */
+int falcon_set_specialized(int enable);
+
+/* ==================================================================== */
+/*
+ * Profiling counters.
+ *
+ * When the library is compiled with FALCON_PROFILE=1 (see config.h),
+ * signing and verification accumulate, per thread, the time spent in
+ * each of the phases below and the number of times each phase ran.
+ * Time is counted in TSC cycles on x86, and in nanoseconds (monotonic
+ * clock) on other platforms. Without FALCON_PROFILE, nothing is
+ * measured and the counters read as zero.
+ *
+ * The SAMPLE and NORM phases are nested in SIGN, and run once per
+ * signing attempt: count[FALCON_PROF_SAMPLE] - count[FALCON_PROF_SIGN]
+ * is the number of attempts rejected because (s1,s2) was not short
+ * enough. HASH runs again (and count[FALCON_PROF_SIGN] grows) when a
+ * padded signature does not fit and signing restarts.
+ */
+
+#define FALCON_PROF_HASH      0   /* hash-to-point (sign and verify) */
+#define FALCON_PROF_SIGN      1   /* core signing, including retries */
+#define FALCON_PROF_SAMPLE    2   /* ffSampling, per attempt */
+#define FALCON_PROF_NORM      3   /* rounding and norm check, per attempt */
+#define FALCON_PROF_ENCODE    4   /* signature encoding */
+#define FALCON_PROF_DECODE    5   /* signature decoding */
+#define FALCON_PROF_VERIFY    6   /* verify_raw (NTT and norm check) */
+#define FALCON_PROF_NUM       7
+
+#define FALCON_PROF_UNIT_NONE     0
+#define FALCON_PROF_UNIT_CYCLES   1
+#define FALCON_PROF_UNIT_NS       2
+
+typedef struct {
+	uint64_t ticks[FALCON_PROF_NUM];
+	uint64_t count[FALCON_PROF_NUM];
+} falcon_profile;
+
+/*
+ * Copy the calling thread's counters into *prof. Returned value is the
+ * tick unit (FALCON_PROF_UNIT_CYCLES or FALCON_PROF_UNIT_NS), or
+ * FALCON_PROF_UNIT_NONE (with *prof cleared) if the library was built
+ * without FALCON_PROFILE.
+ */
+int falcon_profile_get(falcon_profile *prof);
+
+/*
+ * Clear the calling thread's counters.
+ */
+void falcon_profile_reset(void);
+
 /* ==================================================================== */
 /*
  * prng. Instantiated with either SHAKE256 or Keccak256.
@@ -404,9 +588,10 @@ typedef struct {
 	uint64_t opaque_contents[26];
 } prng_context;
 #else
-// inner_keccak256_prng_ctx struct uses 135 bytes
+// inner_keccak256_prng_ctx struct uses 62 words (496 bytes) on 64-bit
+// platforms; two words of slack are kept for padding on other ABIs
 typedef struct {
-	uint64_t opaque_contents[135];
+	uint64_t opaque_contents[64];
 } prng_context;
 #endif
 
@@ -512,6 +697,36 @@ int falcon_keygen_make(
 	void *pubkey, size_t pubkey_len,
 	void *tmp, size_t tmp_len);
 
+/*
+ * Maximum number of threads for falcon_keygen_make_mt().
+ */
+#define FALCON_KEYGEN_MAX_THREADS   64
+
+/*
+ * Generate a new keypair like falcon_keygen_make(), with the solving of
+ * the NTRU equation (most of the key generation time) spread over
+ * nthreads threads: the calling thread, and nthreads-1 threads started
+ * for the duration of the call. The work for each small prime of the
+ * RNS representation is independent, and is split between the threads.
+ * The key pair is the same as the one falcon_keygen_make() returns for
+ * the same RNG state, whatever the number of threads.
+ *
+ * nthreads must be between 1 and FALCON_KEYGEN_MAX_THREADS; otherwise,
+ * FALCON_ERR_BADARG is returned. The tmp[] buffer must be at least
+ * FALCON_TMPSIZE_KEYGEN_MT(logn, nthreads) bytes; it holds the scratch
+ * areas of the extra threads. If the library is built without thread
+ * support (FALCON_KEYGEN_MT=0, see config.h), or if a thread cannot be
+ * created, the calling thread does that share of the work.
+ *
+ * Returned value: 0 on success, or a negative error code.
+ */
+int falcon_keygen_make_mt(
+	prng_context *rng,
+	unsigned logn,
+	void *privkey, size_t privkey_len,
+	void *pubkey, size_t pubkey_len,
+	void *tmp, size_t tmp_len, unsigned nthreads);
+
 /*
  * Recompute the public key from the private key.
  *
@@ -537,9 +752,9 @@ int falcon_make_public(
 	void *tmp, size_t tmp_len);
 
 /*
- * Get the Falcon degree from an encoded private key, public key or
- * signature. Returned value is the logarithm of the degree (1 to 10),
- * or a negative error code.
+ * Get the Falcon degree from an encoded private key, public key (in
+ * normal or NTT representation) or signature. Returned value is the
+ * logarithm of the degree (1 to 10), or a negative error code.
  */
 int falcon_get_logn(void *obj, size_t len);
 
@@ -602,6 +817,34 @@ int falcon_expand_privkey(void *expanded_key, size_t expanded_key_len,
 	const void *privkey, size_t privkey_len,
 	void *tmp, size_t tmp_len);
 
+/*
+ * Layouts of the LDL tree in an expanded private key. The recursive
+ * layout (the one of falcon_expand_privkey()) stores each tree node
+ * before its two subtrees. In the sequential layout, the tree is stored
+ * in the order in which signing reads it, so that a signature walks
+ * through the expanded key by increasing addresses, and fetches next
+ * tree parts ahead; this keeps the signing working set small and
+ * predictable for the hardware prefetchers, which helps when caches are
+ * shared with other workloads. Both layouts have the same size and
+ * yield the same signatures; the layout is recorded in the expanded
+ * key and in stored records (format version 2).
+ */
+#define FALCON_EXPKEY_RECURSIVE    0
+#define FALCON_EXPKEY_SEQUENTIAL   1
+
+/*
+ * Expand a private key, as falcon_expand_privkey(), with the LDL tree
+ * in the specified layout (FALCON_EXPKEY_RECURSIVE or
+ * FALCON_EXPKEY_SEQUENTIAL). Sizes are the same as with
+ * falcon_expand_privkey().
+ *
+ * Returned value: 0 on success, or a negative error code
+ * (FALCON_ERR_BADARG for an unknown layout).
+ */
+int falcon_expand_privkey_layout(void *expanded_key, size_t expanded_key_len,
+	int layout, const void *privkey, size_t privkey_len,
+	void *tmp, size_t tmp_len);
+
 /*
  * Sign the data provided in buffer data[] (of length data_len bytes),
  * using the expanded private key held in expanded_key[], as generated
@@ -627,7 +870,9 @@ int falcon_expand_privkey(void *expanded_key, size_t expanded_key_len,
  * from timing-related side channels.
  *
  * The tmp[] buffer is used to hold temporary values. Its size tmp_len
- * MUST be at least FALCON_TMPSIZE_SIGNTREE(logn) bytes.
+ * MUST be at least FALCON_TMPSIZE_SIGNTREE(logn) bytes, or
+ * FALCON_TMPSIZE_SIGNCOMPACT(logn) bytes with a compact expanded key
+ * (see falcon_expand_privkey_compact()).
  *
  * Returned value: 0 on success, or a negative error code.
  */
@@ -637,6 +882,121 @@ int falcon_sign_tree(prng_context *rng,
 	const void *data, size_t data_len,
 	void *tmp, size_t tmp_len);
 
+/*
+ * Expand a private key into a compact expanded key. A full expanded key
+ * (falcon_expand_privkey()) holds the B0 basis and the whole LDL tree,
+ * about (logn+5)*2^logn floating-point values; the compact form keeps
+ * the private key elements instead of the basis, and only the 'levels'
+ * upper levels of the tree; the subtrees below are rebuilt when
+ * signing, from saved data of 16*2^logn bytes. 'levels' ranges from
+ * 1 to logn-2 (so logn must be at least 3); more levels make larger
+ * keys and faster signatures:
+ *
+ *   levels   key size (bytes)          signing cost
+ *     1      28*2^logn + 8             close to falcon_sign_dyn()
+ *   logn-2   (8*logn+4)*2^logn + 8     close to a full expanded key
+ *
+ * For Falcon-1024, the full expanded key has 122888 bytes, the compact
+ * one 28680 bytes (levels = 1) to 86024 bytes (levels = 8).
+ *
+ * The expanded_key[] buffer has size expanded_key_len, which MUST be at
+ * least FALCON_COMPACTKEY_SIZE(logn, levels) bytes. A compact key is
+ * used like a full expanded key, with falcon_sign_tree() and its
+ * variants, which then need a temporary buffer of at least
+ * FALCON_TMPSIZE_SIGNCOMPACT(logn) bytes; signatures are the same as
+ * with the full expanded key, for the same random source. Compact keys
+ * cannot be written as stored records (falcon_store_expanded_key()).
+ * The alignment rules of full expanded keys apply.
+ *
+ * The tmp[] buffer is used to hold temporary values. Its size tmp_len
+ * MUST be at least FALCON_TMPSIZE_EXPANDCOMPACT(logn) bytes.
+ *
+ * Returned value: 0 on success, or a negative error code
+ * (FALCON_ERR_BADARG if levels is out of range).
+ */
+int falcon_expand_privkey_compact(void *expanded_key,
+	size_t expanded_key_len, unsigned levels,
+	const void *privkey, size_t privkey_len,
+	void *tmp, size_t tmp_len);
+
+/* ==================================================================== */
+/*
+ * Stored expanded private keys.
+ *
+ * An expanded private key can be written into a stored record, meant to
+ * be saved in a file and later used in place (e.g. from a read-only
+ * memory mapping) without calling falcon_expand_privkey() again. A
+ * record has size FALCON_STORED_EXPANDEDKEY_SIZE(logn) and consists of:
+ *
+ *   offset  size  contents
+ *      0      8   magic "FLCNEXPK"
+ *      8      1   format version (1, or 2 for the sequential layout)
+ *      9      1   logn
+ *     10      6   zero
+ *     16      8   expanded key length (little-endian)
+ *     24      8   floating-point format tag
+ *     32      8   checksum of bytes 0..31 and of the expanded key
+ *     40     24   zero
+ *     64      -   expanded key, with the tree at offset 72
+ *
+ * The floating-point format tag is a fixed constant in the in-memory
+ * representation of the library floating-point type; it differs when
+ * the record was made on a system with another byte order or
+ * floating-point format, in which case the record is rejected. The
+ * checksum (little-endian) detects accidental corruption; it is not a
+ * cryptographic digest, and a stored key must be protected like the
+ * private key itself. Records are padded with zeros to a multiple of
+ * 64 bytes, so that records stored back to back in a file keep their
+ * alignment.
+ *
+ * Records MUST be 8-byte aligned in memory (a memory mapping of a file
+ * of back-to-back records is); the expanded key then does not depend on
+ * where the record is read from.
+ */
+
+/*
+ * Write the expanded private key held in expanded_key[] (as obtained
+ * from falcon_expand_privkey()) into the record out[], of size out_len
+ * bytes, which MUST be at least FALCON_STORED_EXPANDEDKEY_SIZE(logn).
+ * out[] MUST be 8-byte aligned; otherwise, FALCON_ERR_BADARG is
+ * returned.
+ *
+ * Returned value: 0 on success, or a negative error code
+ * (FALCON_ERR_FORMAT for a compact or invalid expanded key,
+ * FALCON_ERR_SIZE when out_len is too short, FALCON_ERR_BADARG when
+ * out[] is not 8-byte aligned).
+ */
+int falcon_store_expanded_key(void *out, size_t out_len,
+	const void *expanded_key);
+
+/*
+ * Check the header of the stored record held in stored[] (of length
+ * stored_len bytes) and set *expanded_key to the expanded private key
+ * inside the record, suitable for falcon_sign_tree() for as long as the
+ * record stays in place. Only the header is read: the expanded key is
+ * not copied, and its checksum is not verified (see
+ * falcon_check_expanded_key()). On success, the record length
+ * (FALCON_STORED_EXPANDEDKEY_SIZE(logn)) is returned; stored_len may be
+ * larger, so that records can be walked through in a file.
+ *
+ * Returned value: the record length on success, or a negative error
+ * code (FALCON_ERR_FORMAT for a record that is invalid or was made for
+ * another floating-point format, FALCON_ERR_SIZE when stored_len is
+ * too short, FALCON_ERR_BADARG when stored[] is not 8-byte aligned).
+ */
+int falcon_open_expanded_key(const void **expanded_key,
+	const void *stored, size_t stored_len);
+
+/*
+ * Check the header and verify the checksum of the stored record held
+ * in stored[] (of length stored_len bytes). This reads the whole
+ * expanded key.
+ *
+ * Returned value: 0 on success, or a negative error code
+ * (FALCON_ERR_FORMAT when the checksum does not match).
+ */
+int falcon_check_expanded_key(const void *stored, size_t stored_len);
+
 /* ==================================================================== */
 /*
  * Signature generation, streamed API.
@@ -739,7 +1099,9 @@ int falcon_sign_dyn_finish(prng_context *rng,
  * from timing-related side channels.
  *
  * The tmp[] buffer is used to hold temporary values. Its size tmp_len
- * MUST be at least FALCON_TMPSIZE_SIGNTREE(logn) bytes.
+ * MUST be at least FALCON_TMPSIZE_SIGNTREE(logn) bytes, or
+ * FALCON_TMPSIZE_SIGNCOMPACT(logn) bytes with a compact expanded key
+ * (see falcon_expand_privkey_compact()).
  *
  * Returned value: 0 on success, or a negative error code.
  */
@@ -749,6 +1111,162 @@ int falcon_sign_tree_finish(prng_context *rng,
 	prng_context *hash_data, const void *nonce,
 	void *tmp, size_t tmp_len);
 
+/* ==================================================================== */
+/*
+ * Signature generation with rejection statistics.
+ *
+ * Signing is a rejection loop: a candidate vector is sampled, and the
+ * process restarts if it is not short enough; the Gaussian sampler
+ * itself rejects and redraws values. The _ex variants below behave
+ * exactly like the functions without the suffix, and additionally fill
+ * *stats (if stats is not NULL) with the counts for the signature they
+ * produced, which makes it possible to monitor the sources of signing
+ * tail latency. The sampler is designed so that its rejection rate does
+ * not depend on the private key; these counts reveal nothing that the
+ * signing time does not already show.
+ */
+
+typedef struct {
+	/*
+	 * Number of candidate vectors computed; the last one passed the
+	 * norm bound (1 if no candidate was rejected).
+	 */
+	uint32_t attempts;
+
+	/*
+	 * Number of values rejected by the Gaussian sampler, over all
+	 * attempts.
+	 */
+	uint32_t sampler_rejections;
+
+	/*
+	 * Number of times signing restarted because a padded signature
+	 * did not fit (FALCON_SIG_PADDED only).
+	 */
+	uint32_t encode_retries;
+} falcon_sign_stats;
+
+int falcon_sign_dyn_ex(prng_context *rng,
+	void *sig, size_t *sig_len, int sig_type,
+	const void *privkey, size_t privkey_len,
+	const void *data, size_t data_len,
+	void *tmp, size_t tmp_len, falcon_sign_stats *stats);
+
+int falcon_sign_tree_ex(prng_context *rng,
+	void *sig, size_t *sig_len, int sig_type,
+	const void *expanded_key,
+	const void *data, size_t data_len,
+	void *tmp, size_t tmp_len, falcon_sign_stats *stats);
+
+/*
+ * Sign num messages with the same expanded private key. For each index
+ * i (0 to num-1), message data[i] (of length data_len[i] bytes) is
+ * signed into sig[i]; on input, sig_len[i] is the size of that buffer,
+ * and on output it is set to the signature length. The outcome of each
+ * item (0 or a negative error code) is written in results[i], and, if
+ * stats is not NULL, its statistics in stats[i]. All signatures use
+ * the same sig_type, with the same meaning as for falcon_sign_tree().
+ *
+ * Items are signed in order, and the result is exactly that of num
+ * calls to falcon_sign_tree() with the same PRNG; the key is decoded
+ * and checked once, and all items share the tmp[] buffer. Expanded keys
+ * of any layout, including compact keys, are accepted.
+ *
+ * The tmp[] buffer is used to hold temporary values. Its size tmp_len
+ * MUST be at least FALCON_TMPSIZE_SIGNTREE(logn) bytes
+ * (FALCON_TMPSIZE_SIGNCOMPACT(logn) with a compact key).
+ *
+ * Returned value: 0 if all items were signed, or the error code of the
+ * first item that failed (see results[] for details).
+ */
+int falcon_sign_tree_batch(prng_context *rng, size_t num,
+	void *const *sig, size_t *sig_len, int sig_type,
+	const void *expanded_key,
+	const void *const *data, const size_t *data_len,
+	int *results, void *tmp, size_t tmp_len, falcon_sign_stats *stats);
+
+int falcon_sign_dyn_finish_ex(prng_context *rng,
+	void *sig, size_t *sig_len, int sig_type,
+	const void *privkey, size_t privkey_len,
+	prng_context *hash_data, const void *nonce,
+	void *tmp, size_t tmp_len, falcon_sign_stats *stats);
+
+int falcon_sign_tree_finish_ex(prng_context *rng,
+	void *sig, size_t *sig_len, int sig_type,
+	const void *expanded_key,
+	prng_context *hash_data, const void *nonce,
+	void *tmp, size_t tmp_len, falcon_sign_stats *stats);
+
+/* ==================================================================== */
+/*
+ * Precomputed signing material.
+ *
+ * The start of a signature does not depend on the message: a 40-byte
+ * nonce is drawn from the PRNG, then the Gaussian sampler is seeded
+ * from it (ChaCha20 key setup, first output buffer and first batch of
+ * base samples). falcon_presign_make() performs these steps ahead of
+ * time and stores the result in a falcon_presign record;
+ * falcon_sign_tree_pre() and falcon_sign_dyn_pre() then start directly
+ * with hashing the message. With the same PRNG, falcon_presign_make()
+ * followed by falcon_sign_tree_pre() yields exactly the signature of
+ * falcon_sign_tree_ex() (and likewise for falcon_sign_dyn_ex()).
+ *
+ * A record is secret (it determines the signature randomness) and
+ * MUST be used for a single signature: signing clears it, whatever the
+ * outcome, and a cleared record is rejected. Records can be made in
+ * any thread, e.g. to keep a queue of them ready for a signer, as long
+ * as each one is handed to one signing call only. Contents are pure
+ * data with no pointer, like prng_context.
+ */
+
+typedef struct {
+	uint64_t opaque_contents[120];
+} falcon_presign;
+
+/*
+ * Fill *ps with a nonce and sampler state for one signature of degree
+ * 2^logn, drawn from rng (which must be in output mode, see
+ * prng_init_prng_from_seed()).
+ *
+ * Returned value: 0 on success, or a negative error code.
+ */
+int falcon_presign_make(prng_context *rng, unsigned logn,
+	falcon_presign *ps);
+
+/*
+ * Clear a record that will not be used.
+ */
+void falcon_presign_clear(falcon_presign *ps);
+
+/*
+ * Sign data[] (of length data_len bytes) with the expanded private key,
+ * as falcon_sign_tree_ex(), but with the nonce and first sampler state
+ * taken from *ps, which must have been made for the degree of the key.
+ * The rng is used only if more than one attempt is needed. *ps is
+ * cleared on return.
+ *
+ * The tmp[] buffer is as for falcon_sign_tree().
+ *
+ * Returned value: 0 on success, or a negative error code;
+ * FALCON_ERR_BADARG if *ps was not made for this degree, or was
+ * already used.
+ */
+int falcon_sign_tree_pre(prng_context *rng, falcon_presign *ps,
+	void *sig, size_t *sig_len, int sig_type,
+	const void *expanded_key,
+	const void *data, size_t data_len,
+	void *tmp, size_t tmp_len, falcon_sign_stats *stats);
+
+/*
+ * Same as falcon_sign_tree_pre(), with a raw private key, as
+ * falcon_sign_dyn_ex(). The tmp[] buffer is as for falcon_sign_dyn().
+ */
+int falcon_sign_dyn_pre(prng_context *rng, falcon_presign *ps,
+	void *sig, size_t *sig_len, int sig_type,
+	const void *privkey, size_t privkey_len,
+	const void *data, size_t data_len,
+	void *tmp, size_t tmp_len, falcon_sign_stats *stats);
+
 /* ==================================================================== */
 /*
  * Signature verification.
@@ -816,6 +1334,362 @@ int falcon_verify_finish(const void *sig, size_t sig_len, int sig_type,
 	prng_context *hash_data,
 	void *tmp, size_t tmp_len);
 
+/* ==================================================================== */
+/*
+ * Signature verification with an expanded public key.
+ *
+ * falcon_verify() decodes the public key and converts it to NTT
+ * representation for every signature. When many signatures are verified
+ * against the same public key, that work can be done once with
+ * falcon_expand_pubkey(), and the expanded public key then used with
+ * falcon_verify_expanded() or falcon_verify_expanded_finish(). Results
+ * are identical to those of falcon_verify() and falcon_verify_finish().
+ */
+
+/*
+ * Expand a public key. The provided Falcon public key (pubkey, of size
+ * pubkey_len bytes) is decoded and converted to NTT + Montgomery
+ * representation into expanded_pubkey[]. The public key may also be
+ * in NTT representation (see falcon_encode_ntt_pubkey()).
+ *
+ * The expanded_pubkey[] buffer has size expanded_pubkey_len, which MUST
+ * be at least FALCON_EXPANDEDPUBKEY_SIZE(logn) bytes (where 'logn'
+ * qualifies the Falcon degree encoded in the public key and can be
+ * obtained with falcon_get_logn()). Expanded public key contents have an
+ * internal, implementation-specific format. Expanded public keys may be
+ * moved in RAM only if their 2-byte alignment remains unchanged.
+ *
+ * Returned value: 0 on success, or a negative error code.
+ */
+int falcon_expand_pubkey(void *expanded_pubkey, size_t expanded_pubkey_len,
+	const void *pubkey, size_t pubkey_len);
+
+/*
+ * Verify the signature sig[] (of length sig_len bytes) with regards to
+ * the expanded public key expanded_pubkey[] (as obtained from
+ * falcon_expand_pubkey()) and the message data[] (of length data_len
+ * bytes). The sig_type parameter has the same meaning as for
+ * falcon_verify().
+ *
+ * The tmp[] buffer is used to hold temporary values. Its size tmp_len
+ * MUST be at least FALCON_TMPSIZE_VERIFY(logn) bytes.
+ *
+ * Returned value: 0 on success, or a negative error code.
+ */
+int falcon_verify_expanded(const void *sig, size_t sig_len, int sig_type,
+	const void *expanded_pubkey,
+	const void *data, size_t data_len,
+	void *tmp, size_t tmp_len);
+
+/*
+ * Finish a streamed signature verification with an expanded public key
+ * (as obtained from falcon_expand_pubkey()). This is identical to
+ * falcon_verify_finish(), except for the public key representation.
+ *
+ * The tmp[] buffer is used to hold temporary values. Its size tmp_len
+ * MUST be at least FALCON_TMPSIZE_VERIFY(logn) bytes.
+ *
+ * Returned value: 0 on success, or a negative error code.
+ */
+int falcon_verify_expanded_finish(const void *sig, size_t sig_len,
+	int sig_type, const void *expanded_pubkey,
+	prng_context *hash_data,
+	void *tmp, size_t tmp_len);
+
+/* ==================================================================== */
+/*
+ * Public keys in NTT representation.
+ *
+ * Verifiers implemented outside of this library (e.g. in a smart
+ * contract) spend most of their work on NTTs; one of them converts the
+ * public key h and can be skipped if the public key is published in
+ * NTT representation. Such a key is encoded as:
+ *
+ *   - one header byte: 0x10 + logn (FALCON_NTTPUB_PLAIN) or
+ *     0x20 + logn (FALCON_NTTPUB_MONTY); falcon_get_logn() works on it;
+ *   - the n = 2^logn values ntt[0] .. ntt[n-1], modulo q = 12289,
+ *     14 bits each, packed as the values of a normal public key.
+ *
+ * With g = 7^(1024/n) mod q (a primitive 2n-th root of 1), the value
+ * ntt[i] is h(g^(2*rev(i)+1)) mod q, where rev() reverses the order of
+ * the logn low bits of i. In the FALCON_NTTPUB_MONTY form, each value
+ * is further multiplied by 2^16 mod q (Montgomery representation).
+ *
+ * Conversion does not change the key size. A key in either form can
+ * be verified against with falcon_verify_ntt_pubkey(), and expanded
+ * with falcon_expand_pubkey().
+ */
+
+#define FALCON_NTTPUB_PLAIN   0
+#define FALCON_NTTPUB_MONTY   1
+
+/*
+ * Convert the public key pubkey[] (of size pubkey_len bytes) to NTT
+ * representation, with the given form (FALCON_NTTPUB_PLAIN or
+ * FALCON_NTTPUB_MONTY). The output buffer ntt_pubkey[] has size
+ * ntt_pubkey_len, which MUST be at least FALCON_NTTPUBKEY_SIZE(logn)
+ * bytes.
+ *
+ * The tmp[] buffer is used to hold temporary values. Its size tmp_len
+ * MUST be at least FALCON_TMPSIZE_NTTPUB(logn) bytes.
+ *
+ * Returned value: 0 on success, or a negative error code.
+ */
+int falcon_encode_ntt_pubkey(void *ntt_pubkey, size_t ntt_pubkey_len,
+	int form, const void *pubkey, size_t pubkey_len,
+	void *tmp, size_t tmp_len);
+
+/*
+ * Verify the signature sig[] (of length sig_len bytes) with regards to
+ * the public key in NTT representation ntt_pubkey[] (of length
+ * ntt_pubkey_len bytes, as obtained from falcon_encode_ntt_pubkey())
+ * and the message data[] (of length data_len bytes). This is identical
+ * to falcon_verify(), except for the public key representation; keys
+ * in the normal encoding are rejected with FALCON_ERR_FORMAT.
+ *
+ * The tmp[] buffer is used to hold temporary values. Its size tmp_len
+ * MUST be at least FALCON_TMPSIZE_VERIFY(logn) bytes.
+ *
+ * Returned value: 0 on success, or a negative error code.
+ */
+int falcon_verify_ntt_pubkey(const void *sig, size_t sig_len, int sig_type,
+	const void *ntt_pubkey, size_t ntt_pubkey_len,
+	const void *data, size_t data_len,
+	void *tmp, size_t tmp_len);
+
+/*
+ * Finish a streamed signature verification with a public key in NTT
+ * representation. This is identical to falcon_verify_finish(), except
+ * for the public key representation.
+ *
+ * The tmp[] buffer is used to hold temporary values. Its size tmp_len
+ * MUST be at least FALCON_TMPSIZE_VERIFY(logn) bytes.
+ *
+ * Returned value: 0 on success, or a negative error code.
+ */
+int falcon_verify_ntt_pubkey_finish(const void *sig, size_t sig_len,
+	int sig_type, const void *ntt_pubkey, size_t ntt_pubkey_len,
+	prng_context *hash_data,
+	void *tmp, size_t tmp_len);
+
+/* ==================================================================== */
+/*
+ * Batch signature verification.
+ */
+
+/*
+ * Verify num signatures in one call. For each index i (0 to num-1),
+ * signature sig[i] (of length sig_len[i] bytes) is verified with regards
+ * to public key pubkey[i] (of length pubkey_len[i] bytes) and message
+ * data[i] (of length data_len[i] bytes), exactly as falcon_verify() would
+ * do; the outcome (0 or a negative error code) is written in results[i].
+ * All signatures use the same sig_type, with the same meaning as for
+ * falcon_verify().
+ *
+ * The same temporary buffer is used for all items; consecutive items
+ * with the same public key decode that key only once, so callers should
+ * group items by signer when possible. Items may use different degrees,
+ * and public keys may be in NTT representation.
+ *
+ * The tmp[] buffer is used to hold temporary values. Its size tmp_len
+ * MUST be at least FALCON_TMPSIZE_VERIFYBATCH(logn) bytes, where logn is
+ * the largest degree in the batch; items with a larger degree are
+ * reported with FALCON_ERR_SIZE.
+ *
+ * Returned value: 0 if all signatures are valid, FALCON_ERR_BADSIG if at
+ * least one item failed (see results[] for details).
+ */
+int falcon_verify_batch(size_t num,
+	const void *const *sig, const size_t *sig_len, int sig_type,
+	const void *const *pubkey, const size_t *pubkey_len,
+	const void *const *data, const size_t *data_len,
+	int *results, void *tmp, size_t tmp_len);
+
+/* ==================================================================== */
+/*
+ * Reusable contexts.
+ *
+ * A falcon_ctx owns one temporary buffer (arena), sized for all
+ * operations on degrees up to a given maximum. Each function of this
+ * API that takes a tmp[] buffer has a _ctx variant, which takes a
+ * context as first parameter instead of tmp[] and tmp_len, and is
+ * otherwise identical; e.g. falcon_sign_tree_ctx(ctx, rng, sig, ...)
+ * is falcon_sign_tree(rng, sig, ..., tmp, tmp_len) with the arena of
+ * ctx as tmp[]. A context is meant to be created once per thread and
+ * reused for all calls of that thread; it must not be used by two
+ * threads at the same time.
+ *
+ * The arena contains secret temporary values after signing or key
+ * generation; it is cleared when the context is released.
+ */
+
+typedef struct falcon_ctx_ falcon_ctx;
+
+/*
+ * Flags for falcon_ctx_new().
+ *
+ * FALCON_CTX_HUGEPAGES requests that the arena be backed by a 2 MB huge
+ * page, so that the working set of signing and key generation (about
+ * 80 to 140 kB for Falcon-1024) uses a single TLB entry. Explicit huge
+ * pages (hugetlbfs) are tried first, then transparent huge pages; if
+ * neither is available, the arena is allocated normally. This is
+ * supported on Linux only, and costs a full 2 MB of memory per context.
+ */
+#define FALCON_CTX_HUGEPAGES   1
+
+/*
+ * Arena backing, as reported by falcon_ctx_backing().
+ */
+#define FALCON_CTX_HEAP        0   /* malloc() */
+#define FALCON_CTX_CALLER      1   /* caller buffer (falcon_ctx_init()) */
+#define FALCON_CTX_HUGETLB     2   /* explicit huge page */
+#define FALCON_CTX_THP         3   /* transparent huge page, advised */
+
+/*
+ * Create a context for degrees up to 2^max_logn (1 to 10), and key pair
+ * generation with up to nthreads threads (0 or 1 if multi-threaded key
+ * pair generation is not used). flags is 0 or FALCON_CTX_HUGEPAGES.
+ * Returned value is the new context, or NULL on invalid parameters or
+ * memory allocation failure. The context must be released with
+ * falcon_ctx_free().
+ */
+falcon_ctx *falcon_ctx_new(unsigned max_logn, unsigned nthreads,
+	unsigned flags);
+
+/*
+ * Create a context in the caller-provided buffer buf[], of size len
+ * bytes, which MUST be at least FALCON_CTX_SIZE(max_logn, nthreads)
+ * bytes. This allows using memory with specific properties (e.g.
+ * allocated on the local NUMA node of the thread, or locked). The
+ * buffer must remain valid while the context is used; it has no
+ * alignment requirement. Returned value is the context (which is
+ * within buf[]), or NULL on invalid parameters. falcon_ctx_free() may
+ * be called to clear the arena; it does not release buf[].
+ */
+falcon_ctx *falcon_ctx_init(void *buf, size_t len,
+	unsigned max_logn, unsigned nthreads);
+
+/*
+ * Clear and release a context. ctx may be NULL.
+ */
+void falcon_ctx_free(falcon_ctx *ctx);
+
+/*
+ * Get the arena backing of a context (FALCON_CTX_HEAP,
+ * FALCON_CTX_CALLER, FALCON_CTX_HUGETLB or FALCON_CTX_THP).
+ */
+int falcon_ctx_backing(const falcon_ctx *ctx);
+
+/*
+ * Get the arena of a context and its size, e.g. for temporary buffers
+ * of other code running between Falcon calls on the same thread.
+ */
+void *falcon_ctx_tmp(falcon_ctx *ctx, size_t *len);
+
+int falcon_keygen_make_ctx(falcon_ctx *ctx,
+	prng_context *rng, unsigned logn,
+	void *privkey, size_t privkey_len,
+	void *pubkey, size_t pubkey_len);
+int falcon_keygen_make_mt_ctx(falcon_ctx *ctx,
+	prng_context *rng, unsigned logn,
+	void *privkey, size_t privkey_len,
+	void *pubkey, size_t pubkey_len,
+	unsigned nthreads);
+int falcon_make_public_ctx(falcon_ctx *ctx,
+	void *pubkey, size_t pubkey_len,
+	const void *privkey, size_t privkey_len);
+int falcon_sign_dyn_ctx(falcon_ctx *ctx, prng_context *rng,
+	void *sig, size_t *sig_len, int sig_type,
+	const void *privkey, size_t privkey_len,
+	const void *data, size_t data_len);
+int falcon_sign_dyn_ex_ctx(falcon_ctx *ctx, prng_context *rng,
+	void *sig, size_t *sig_len, int sig_type,
+	const void *privkey, size_t privkey_len,
+	const void *data, size_t data_len, falcon_sign_stats *stats);
+int falcon_sign_dyn_finish_ctx(falcon_ctx *ctx, prng_context *rng,
+	void *sig, size_t *sig_len, int sig_type,
+	const void *privkey, size_t privkey_len,
+	prng_context *hash_data, const void *nonce);
+int falcon_sign_dyn_finish_ex_ctx(falcon_ctx *ctx, prng_context *rng,
+	void *sig, size_t *sig_len, int sig_type,
+	const void *privkey, size_t privkey_len,
+	prng_context *hash_data, const void *nonce,
+	falcon_sign_stats *stats);
+int falcon_expand_privkey_ctx(falcon_ctx *ctx,
+	void *expanded_key, size_t expanded_key_len,
+	const void *privkey, size_t privkey_len);
+int falcon_expand_privkey_layout_ctx(falcon_ctx *ctx,
+	void *expanded_key, size_t expanded_key_len,
+	int layout, const void *privkey, size_t privkey_len);
+int falcon_expand_privkey_compact_ctx(falcon_ctx *ctx,
+	void *expanded_key, size_t expanded_key_len, unsigned levels,
+	const void *privkey, size_t privkey_len);
+int falcon_sign_tree_ctx(falcon_ctx *ctx, prng_context *rng,
+	void *sig, size_t *sig_len, int sig_type,
+	const void *expanded_key,
+	const void *data, size_t data_len);
+int falcon_sign_tree_ex_ctx(falcon_ctx *ctx, prng_context *rng,
+	void *sig, size_t *sig_len, int sig_type,
+	const void *expanded_key,
+	const void *data, size_t data_len, falcon_sign_stats *stats);
+int falcon_sign_tree_finish_ctx(falcon_ctx *ctx, prng_context *rng,
+	void *sig, size_t *sig_len, int sig_type,
+	const void *expanded_key,
+	prng_context *hash_data, const void *nonce);
+int falcon_sign_tree_finish_ex_ctx(falcon_ctx *ctx, prng_context *rng,
+	void *sig, size_t *sig_len, int sig_type,
+	const void *expanded_key,
+	prng_context *hash_data, const void *nonce,
+	falcon_sign_stats *stats);
+int falcon_sign_tree_batch_ctx(falcon_ctx *ctx,
+	prng_context *rng, size_t num,
+	void *const *sig, size_t *sig_len, int sig_type,
+	const void *expanded_key,
+	const void *const *data, const size_t *data_len,
+	int *results, falcon_sign_stats *stats);
+int falcon_sign_tree_pre_ctx(falcon_ctx *ctx,
+	prng_context *rng, falcon_presign *ps,
+	void *sig, size_t *sig_len, int sig_type,
+	const void *expanded_key,
+	const void *data, size_t data_len, falcon_sign_stats *stats);
+int falcon_sign_dyn_pre_ctx(falcon_ctx *ctx,
+	prng_context *rng, falcon_presign *ps,
+	void *sig, size_t *sig_len, int sig_type,
+	const void *privkey, size_t privkey_len,
+	const void *data, size_t data_len, falcon_sign_stats *stats);
+int falcon_verify_ctx(falcon_ctx *ctx,
+	const void *sig, size_t sig_len, int sig_type,
+	const void *pubkey, size_t pubkey_len,
+	const void *data, size_t data_len);
+int falcon_verify_finish_ctx(falcon_ctx *ctx,
+	const void *sig, size_t sig_len, int sig_type,
+	const void *pubkey, size_t pubkey_len,
+	prng_context *hash_data);
+int falcon_verify_expanded_ctx(falcon_ctx *ctx,
+	const void *sig, size_t sig_len, int sig_type,
+	const void *expanded_pubkey,
+	const void *data, size_t data_len);
+int falcon_verify_expanded_finish_ctx(falcon_ctx *ctx,
+	const void *sig, size_t sig_len, int sig_type,
+	const void *expanded_pubkey,
+	prng_context *hash_data);
+int falcon_encode_ntt_pubkey_ctx(falcon_ctx *ctx,
+	void *ntt_pubkey, size_t ntt_pubkey_len,
+	int form, const void *pubkey, size_t pubkey_len);
+int falcon_verify_ntt_pubkey_ctx(falcon_ctx *ctx,
+	const void *sig, size_t sig_len, int sig_type,
+	const void *ntt_pubkey, size_t ntt_pubkey_len,
+	const void *data, size_t data_len);
+int falcon_verify_ntt_pubkey_finish_ctx(falcon_ctx *ctx,
+	const void *sig, size_t sig_len, int sig_type,
+	const void *ntt_pubkey, size_t ntt_pubkey_len,
+	prng_context *hash_data);
+int falcon_verify_batch_ctx(falcon_ctx *ctx, size_t num,
+	const void *const *sig, const size_t *sig_len, int sig_type,
+	const void *const *pubkey, const size_t *pubkey_len,
+	const void *const *data, const size_t *data_len,
+	int *results);
+
 /* ==================================================================== */
 
 #ifdef __cplusplus
@@ -166,10 +166,12 @@
  * (Note that rev(j) is even for j < N/2.)
  */
 
-/* see inner.h */
+/*
+ * Body of Zf(FFT)(), instantiated per degree (see SPECIALIZED_LOGN()).
+ */
 TARGET_AVX2
-void
-Zf(FFT)(fpr *f, unsigned logn)
+static FALCON_INLINE void
+fft_body(fpr *f, unsigned logn)
 {
 	/*
 	 * FFT algorithm in bit-reversal order uses the following
@@ -258,6 +260,55 @@ Zf(FFT)(fpr *f, unsigned logn)
 			} else {
 				fpr s_re, s_im;
 
+				s_re = fpr_gm_tab[((m + i1) << 1) + 0];
+				s_im = fpr_gm_tab[((m + i1) << 1) + 1];
+				for (j = j1; j < j2; j ++) {
+					fpr x_re, x_im, y_re, y_im;
+
+					x_re = f[j];
+					x_im = f[j + hn];
+					y_re = f[j + ht];
+					y_im = f[j + ht + hn];
+					FPC_MUL(y_re, y_im,
+						y_re, y_im, s_re, s_im);
+					FPC_ADD(f[j], f[j + hn],
+						x_re, x_im, y_re, y_im);
+					FPC_SUB(f[j + ht], f[j + ht + hn],
+						x_re, x_im, y_re, y_im);
+				}
+			}
+#elif FALCON_NEON
+			if (ht >= 2) {
+				float64x2_t s_re, s_im;
+
+				s_re = vdupq_n_f64(
+					fpr_gm_tab[((m + i1) << 1) + 0].v);
+				s_im = vdupq_n_f64(
+					fpr_gm_tab[((m + i1) << 1) + 1].v);
+				for (j = j1; j < j2; j += 2) {
+					float64x2_t x_re, x_im, y_re, y_im;
+					float64x2_t z_re, z_im;
+
+					x_re = vld1q_f64(&f[j].v);
+					x_im = vld1q_f64(&f[j + hn].v);
+					z_re = vld1q_f64(&f[j + ht].v);
+					z_im = vld1q_f64(&f[j + ht + hn].v);
+					y_re = vsubq_f64(vmulq_f64(z_re, s_re),
+						vmulq_f64(z_im, s_im));
+					y_im = vaddq_f64(vmulq_f64(z_re, s_im),
+						vmulq_f64(z_im, s_re));
+					vst1q_f64(&f[j].v,
+						vaddq_f64(x_re, y_re));
+					vst1q_f64(&f[j + hn].v,
+						vaddq_f64(x_im, y_im));
+					vst1q_f64(&f[j + ht].v,
+						vsubq_f64(x_re, y_re));
+					vst1q_f64(&f[j + ht + hn].v,
+						vsubq_f64(x_im, y_im));
+				}
+			} else {
+				fpr s_re, s_im;
+
 				s_re = fpr_gm_tab[((m + i1) << 1) + 0];
 				s_im = fpr_gm_tab[((m + i1) << 1) + 1];
 				for (j = j1; j < j2; j ++) {
@@ -302,7 +353,27 @@ Zf(FFT)(fpr *f, unsigned logn)
 /* see inner.h */
 TARGET_AVX2
 void
-Zf(iFFT)(fpr *f, unsigned logn)
+Zf(FFT)(fpr *f, unsigned logn)
+{
+	switch (SPECIALIZED_LOGN(logn)) {
+	case 9:
+		fft_body(f, 9);
+		break;
+	case 10:
+		fft_body(f, 10);
+		break;
+	default:
+		fft_body(f, logn);
+		break;
+	}
+}
+
+/*
+ * Body of Zf(iFFT)(), instantiated per degree (see SPECIALIZED_LOGN()).
+ */
+TARGET_AVX2
+static FALCON_INLINE void
+ifft_body(fpr *f, unsigned logn)
 {
 	/*
 	 * Inverse FFT algorithm in bit-reversal order uses the following
@@ -393,6 +464,58 @@ Zf(iFFT)(fpr *f, unsigned logn)
 			} else {
 				fpr s_re, s_im;
 
+				s_re = fpr_gm_tab[((hm + i1) << 1)+0];
+				s_im = fpr_neg(fpr_gm_tab[((hm + i1) << 1)+1]);
+				for (j = j1; j < j2; j ++) {
+					fpr x_re, x_im, y_re, y_im;
+
+					x_re = f[j];
+					x_im = f[j + hn];
+					y_re = f[j + t];
+					y_im = f[j + t + hn];
+					FPC_ADD(f[j], f[j + hn],
+						x_re, x_im, y_re, y_im);
+					FPC_SUB(x_re, x_im,
+						x_re, x_im, y_re, y_im);
+					FPC_MUL(f[j + t], f[j + t + hn],
+						x_re, x_im, s_re, s_im);
+				}
+			}
+#elif FALCON_NEON
+			if (t >= 2) {
+				float64x2_t s_re, s_im;
+
+				/*
+				 * s = conj(GM[hm + i1]); the negation of the
+				 * imaginary part is folded into the products.
+				 */
+				s_re = vdupq_n_f64(
+					fpr_gm_tab[((hm + i1) << 1) + 0].v);
+				s_im = vdupq_n_f64(
+					fpr_gm_tab[((hm + i1) << 1) + 1].v);
+				for (j = j1; j < j2; j += 2) {
+					float64x2_t x_re, x_im, y_re, y_im;
+
+					x_re = vld1q_f64(&f[j].v);
+					x_im = vld1q_f64(&f[j + hn].v);
+					y_re = vld1q_f64(&f[j + t].v);
+					y_im = vld1q_f64(&f[j + t + hn].v);
+					vst1q_f64(&f[j].v,
+						vaddq_f64(x_re, y_re));
+					vst1q_f64(&f[j + hn].v,
+						vaddq_f64(x_im, y_im));
+					x_re = vsubq_f64(x_re, y_re);
+					x_im = vsubq_f64(x_im, y_im);
+					vst1q_f64(&f[j + t].v, vaddq_f64(
+						vmulq_f64(x_re, s_re),
+						vmulq_f64(x_im, s_im)));
+					vst1q_f64(&f[j + t + hn].v, vsubq_f64(
+						vmulq_f64(x_im, s_re),
+						vmulq_f64(x_re, s_im)));
+				}
+			} else {
+				fpr s_re, s_im;
+
 				s_re = fpr_gm_tab[((hm + i1) << 1)+0];
 				s_im = fpr_neg(fpr_gm_tab[((hm + i1) << 1)+1]);
 				for (j = j1; j < j2; j ++) {
@@ -448,6 +571,24 @@ Zf(iFFT)(fpr *f, unsigned logn)
 	}
 }
 
+/* see inner.h */
+TARGET_AVX2
+void
+Zf(iFFT)(fpr *f, unsigned logn)
+{
+	switch (SPECIALIZED_LOGN(logn)) {
+	case 9:
+		ifft_body(f, 9);
+		break;
+	case 10:
+		ifft_body(f, 10);
+		break;
+	default:
+		ifft_body(f, logn);
+		break;
+	}
+}
+
 /* see inner.h */
 TARGET_AVX2
 void
@@ -470,6 +611,19 @@ Zf(poly_add)(
 			a[u] = fpr_add(a[u], b[u]);
 		}
 	}
+#elif FALCON_NEON
+	if (n >= 2) {
+		for (u = 0; u < n; u += 2) {
+			vst1q_f64(&a[u].v,
+				vaddq_f64(
+					vld1q_f64(&a[u].v),
+					vld1q_f64(&b[u].v)));
+		}
+	} else {
+		for (u = 0; u < n; u ++) {
+			a[u] = fpr_add(a[u], b[u]);
+		}
+	}
 #else // yyyAVX2+0
 	for (u = 0; u < n; u ++) {
 		a[u] = fpr_add(a[u], b[u]);
@@ -499,6 +653,19 @@ Zf(poly_sub)(
 			a[u] = fpr_sub(a[u], b[u]);
 		}
 	}
+#elif FALCON_NEON
+	if (n >= 2) {
+		for (u = 0; u < n; u += 2) {
+			vst1q_f64(&a[u].v,
+				vsubq_f64(
+					vld1q_f64(&a[u].v),
+					vld1q_f64(&b[u].v)));
+		}
+	} else {
+		for (u = 0; u < n; u ++) {
+			a[u] = fpr_sub(a[u], b[u]);
+		}
+	}
 #else // yyyAVX2+0
 	for (u = 0; u < n; u ++) {
 		a[u] = fpr_sub(a[u], b[u]);
@@ -528,6 +695,16 @@ Zf(poly_neg)(fpr *a, unsigned logn)
 			a[u] = fpr_neg(a[u]);
 		}
 	}
+#elif FALCON_NEON
+	if (n >= 2) {
+		for (u = 0; u < n; u += 2) {
+			vst1q_f64(&a[u].v, vnegq_f64(vld1q_f64(&a[u].v)));
+		}
+	} else {
+		for (u = 0; u < n; u ++) {
+			a[u] = fpr_neg(a[u]);
+		}
+	}
 #else // yyyAVX2+0
 	for (u = 0; u < n; u ++) {
 		a[u] = fpr_neg(a[u]);
@@ -557,6 +734,16 @@ Zf(poly_adj_fft)(fpr *a, unsigned logn)
 			a[u] = fpr_neg(a[u]);
 		}
 	}
+#elif FALCON_NEON
+	if (n >= 4) {
+		for (u = (n >> 1); u < n; u += 2) {
+			vst1q_f64(&a[u].v, vnegq_f64(vld1q_f64(&a[u].v)));
+		}
+	} else {
+		for (u = (n >> 1); u < n; u ++) {
+			a[u] = fpr_neg(a[u]);
+		}
+	}
 #else // yyyAVX2+0
 	for (u = (n >> 1); u < n; u ++) {
 		a[u] = fpr_neg(a[u]);
@@ -594,6 +781,33 @@ Zf(poly_mul_fft)(
 		for (u = 0; u < hn; u ++) {
 			fpr a_re, a_im, b_re, b_im;
 
+			a_re = a[u];
+			a_im = a[u + hn];
+			b_re = b[u];
+			b_im = b[u + hn];
+			FPC_MUL(a[u], a[u + hn], a_re, a_im, b_re, b_im);
+		}
+	}
+#elif FALCON_NEON
+	if (n >= 4) {
+		for (u = 0; u < hn; u += 2) {
+			float64x2_t a_re, a_im, b_re, b_im, c_re, c_im;
+
+			a_re = vld1q_f64(&a[u].v);
+			a_im = vld1q_f64(&a[u + hn].v);
+			b_re = vld1q_f64(&b[u].v);
+			b_im = vld1q_f64(&b[u + hn].v);
+			c_re = vsubq_f64(
+				vmulq_f64(a_re, b_re), vmulq_f64(a_im, b_im));
+			c_im = vaddq_f64(
+				vmulq_f64(a_re, b_im), vmulq_f64(a_im, b_re));
+			vst1q_f64(&a[u].v, c_re);
+			vst1q_f64(&a[u + hn].v, c_im);
+		}
+	} else {
+		for (u = 0; u < hn; u ++) {
+			fpr a_re, a_im, b_re, b_im;
+
 			a_re = a[u];
 			a_im = a[u + hn];
 			b_re = b[u];
@@ -644,6 +858,33 @@ Zf(poly_muladj_fft)(
 		for (u = 0; u < hn; u ++) {
 			fpr a_re, a_im, b_re, b_im;
 
+			a_re = a[u];
+			a_im = a[u + hn];
+			b_re = b[u];
+			b_im = fpr_neg(b[u + hn]);
+			FPC_MUL(a[u], a[u + hn], a_re, a_im, b_re, b_im);
+		}
+	}
+#elif FALCON_NEON
+	if (n >= 4) {
+		for (u = 0; u < hn; u += 2) {
+			float64x2_t a_re, a_im, b_re, b_im, c_re, c_im;
+
+			a_re = vld1q_f64(&a[u].v);
+			a_im = vld1q_f64(&a[u + hn].v);
+			b_re = vld1q_f64(&b[u].v);
+			b_im = vld1q_f64(&b[u + hn].v);
+			c_re = vaddq_f64(
+				vmulq_f64(a_re, b_re), vmulq_f64(a_im, b_im));
+			c_im = vsubq_f64(
+				vmulq_f64(a_im, b_re), vmulq_f64(a_re, b_im));
+			vst1q_f64(&a[u].v, c_re);
+			vst1q_f64(&a[u + hn].v, c_im);
+		}
+	} else {
+		for (u = 0; u < hn; u ++) {
+			fpr a_re, a_im, b_re, b_im;
+
 			a_re = a[u];
 			a_im = a[u + hn];
 			b_re = b[u];
@@ -696,6 +937,30 @@ Zf(poly_mulselfadj_fft)(fpr *a, unsigned logn)
 		for (u = 0; u < hn; u ++) {
 			fpr a_re, a_im;
 
+			a_re = a[u];
+			a_im = a[u + hn];
+			a[u] = fpr_add(fpr_sqr(a_re), fpr_sqr(a_im));
+			a[u + hn] = fpr_zero;
+		}
+	}
+#elif FALCON_NEON
+	if (n >= 4) {
+		float64x2_t zero;
+
+		zero = vdupq_n_f64(0.0);
+		for (u = 0; u < hn; u += 2) {
+			float64x2_t a_re, a_im;
+
+			a_re = vld1q_f64(&a[u].v);
+			a_im = vld1q_f64(&a[u + hn].v);
+			vst1q_f64(&a[u].v, vaddq_f64(
+				vmulq_f64(a_re, a_re), vmulq_f64(a_im, a_im)));
+			vst1q_f64(&a[u + hn].v, zero);
+		}
+	} else {
+		for (u = 0; u < hn; u ++) {
+			fpr a_re, a_im;
+
 			a_re = a[u];
 			a_im = a[u + hn];
 			a[u] = fpr_add(fpr_sqr(a_re), fpr_sqr(a_im));
@@ -736,6 +1001,20 @@ Zf(poly_mulconst)(fpr *a, fpr x, unsigned logn)
 			a[u] = fpr_mul(a[u], x);
 		}
 	}
+#elif FALCON_NEON
+	if (n >= 2) {
+		float64x2_t x2;
+
+		x2 = vdupq_n_f64(x.v);
+		for (u = 0; u < n; u += 2) {
+			vst1q_f64(&a[u].v,
+				vmulq_f64(x2, vld1q_f64(&a[u].v)));
+		}
+	} else {
+		for (u = 0; u < n; u ++) {
+			a[u] = fpr_mul(a[u], x);
+		}
+	}
 #else // yyyAVX2+0
 	for (u = 0; u < n; u ++) {
 		a[u] = fpr_mul(a[u], x);
@@ -916,6 +1195,54 @@ Zf(poly_add_muladj_fft)(fpr *restrict d,
 			g_re = g[u];
 			g_im = g[u + hn];
 
+			FPC_MUL(a_re, a_im, F_re, F_im, f_re, fpr_neg(f_im));
+			FPC_MUL(b_re, b_im, G_re, G_im, g_re, fpr_neg(g_im));
+			d[u] = fpr_add(a_re, b_re);
+			d[u + hn] = fpr_add(a_im, b_im);
+		}
+	}
+#elif FALCON_NEON
+	if (n >= 4) {
+		for (u = 0; u < hn; u += 2) {
+			float64x2_t F_re, F_im, G_re, G_im;
+			float64x2_t f_re, f_im, g_re, g_im;
+			float64x2_t a_re, a_im, b_re, b_im;
+
+			F_re = vld1q_f64(&F[u].v);
+			F_im = vld1q_f64(&F[u + hn].v);
+			G_re = vld1q_f64(&G[u].v);
+			G_im = vld1q_f64(&G[u + hn].v);
+			f_re = vld1q_f64(&f[u].v);
+			f_im = vld1q_f64(&f[u + hn].v);
+			g_re = vld1q_f64(&g[u].v);
+			g_im = vld1q_f64(&g[u + hn].v);
+
+			a_re = vaddq_f64(vmulq_f64(F_re, f_re),
+				vmulq_f64(F_im, f_im));
+			a_im = vsubq_f64(vmulq_f64(F_im, f_re),
+				vmulq_f64(F_re, f_im));
+			b_re = vaddq_f64(vmulq_f64(G_re, g_re),
+				vmulq_f64(G_im, g_im));
+			b_im = vsubq_f64(vmulq_f64(G_im, g_re),
+				vmulq_f64(G_re, g_im));
+			vst1q_f64(&d[u].v, vaddq_f64(a_re, b_re));
+			vst1q_f64(&d[u + hn].v, vaddq_f64(a_im, b_im));
+		}
+	} else {
+		for (u = 0; u < hn; u ++) {
+			fpr F_re, F_im, G_re, G_im;
+			fpr f_re, f_im, g_re, g_im;
+			fpr a_re, a_im, b_re, b_im;
+
+			F_re = F[u];
+			F_im = F[u + hn];
+			G_re = G[u];
+			G_im = G[u + hn];
+			f_re = f[u];
+			f_im = f[u + hn];
+			g_re = g[u];
+			g_im = g[u + hn];
+
 			FPC_MUL(a_re, a_im, F_re, F_im, f_re, fpr_neg(f_im));
 			FPC_MUL(b_re, b_im, G_re, G_im, g_re, fpr_neg(g_im));
 			d[u] = fpr_add(a_re, b_re);
@@ -974,6 +1301,23 @@ Zf(poly_mul_autoadj_fft)(
 			a[u + hn] = fpr_mul(a[u + hn], b[u]);
 		}
 	}
+#elif FALCON_NEON
+	if (n >= 4) {
+		for (u = 0; u < hn; u += 2) {
+			float64x2_t bv;
+
+			bv = vld1q_f64(&b[u].v);
+			vst1q_f64(&a[u].v,
+				vmulq_f64(vld1q_f64(&a[u].v), bv));
+			vst1q_f64(&a[u + hn].v,
+				vmulq_f64(vld1q_f64(&a[u + hn].v), bv));
+		}
+	} else {
+		for (u = 0; u < hn; u ++) {
+			a[u] = fpr_mul(a[u], b[u]);
+			a[u + hn] = fpr_mul(a[u + hn], b[u]);
+		}
+	}
 #else // yyyAVX2+0
 	for (u = 0; u < hn; u ++) {
 		a[u] = fpr_mul(a[u], b[u]);
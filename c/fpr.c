@@ -42,7 +42,21 @@
  * (i.e. if the value was left-shifted by n bits, then n is subtracted
  * from e). If source m is 0, then it remains 0, but e is altered.
  * Both m and e must be simple variables (no expressions allowed).
+ *
+ * With FALCON_FPEMU_WIDE, on AArch64 (CLZ) and on x86 with LZCNT, the
+ * shift count is obtained with a count-leading-zeros opcode, which is
+ * constant-time on these platforms; m|1 gives the same result as the
+ * generic code when m = 0 (e is decreased by 63).
  */
+#if FALCON_FPEMU_WIDE && (defined __aarch64__ || defined __LZCNT__)
+#define FPR_NORM64(m, e)   do { \
+		int nz; \
+ \
+		nz = __builtin_clzll((m) | 1); \
+		(m) <<= nz; \
+		(e) -= nz; \
+	} while (0)
+#else
 #define FPR_NORM64(m, e)   do { \
 		uint32_t nt; \
  \
@@ -77,6 +91,7 @@
 		(m) ^= ((m) ^ ((m) <<  1)) & ((uint64_t)nt - 1); \
 		(e) += (int)(nt); \
 	} while (0)
+#endif
 
 #if FALCON_ASM_CORTEXM4 // yyyASM_CORTEXM4+1
 
@@ -706,7 +721,9 @@ fpr
 fpr_mul(fpr x, fpr y)
 {
 	uint64_t xu, yu, w, zu, zv;
+#if !FALCON_FPEMU_WIDE
 	uint32_t x0, x1, y0, y1, z0, z1, z2;
+#endif
 	int ex, ey, d, e, s;
 
 	/*
@@ -716,6 +733,21 @@ fpr_mul(fpr x, fpr y)
 	xu = (x & (((uint64_t)1 << 52) - 1)) | ((uint64_t)1 << 52);
 	yu = (y & (((uint64_t)1 << 52) - 1)) | ((uint64_t)1 << 52);
 
+#if FALCON_FPEMU_WIDE
+	{
+		unsigned __int128 z;
+
+		/*
+		 * Same computation as below, with a single 128-bit
+		 * product: the top part (zu) is the product divided
+		 * by 2^50, and the low 50 bits are used for stickiness.
+		 */
+		z = (unsigned __int128)xu * yu;
+		zu = (uint64_t)(z >> 50);
+		w = (uint64_t)z & (((uint64_t)1 << 50) - 1);
+		zu |= (w + (((uint64_t)1 << 50) - 1)) >> 50;
+	}
+#else
 	/*
 	 * We have two 53-bit integers to multiply; we need to split
 	 * each into a lower half and a upper half. Moreover, we
@@ -750,6 +782,7 @@ fpr_mul(fpr x, fpr y)
 	 * (This is the reason why we chose 25-bit limbs above.)
 	 */
 	zu |= ((z0 | z1) + 0x01FFFFFF) >> 25;
+#endif
 
 	/*
 	 * We normalize zu to the 2^54..s^55-1 range: it could be one
@@ -1317,8 +1350,10 @@ fpr_expm_p63(fpr x, fpr ccs)
 
 	uint64_t z, y;
 	unsigned u;
+#if !FALCON_FPEMU_WIDE
 	uint32_t z0, z1, y0, y1;
 	uint64_t a, b;
+#endif
 
 	y = C[0];
 	z = (uint64_t)fpr_trunc(fpr_mul(x, fpr_ptwo63)) << 1;
@@ -1327,15 +1362,15 @@ fpr_expm_p63(fpr x, fpr ccs)
 		 * Compute product z * y over 128 bits, but keep only
 		 * the top 64 bits.
 		 *
-		 * TODO: On some architectures/compilers we could use
-		 * some intrinsics (__umulh() on MSVC) or other compiler
-		 * extensions (unsigned __int128 on GCC / Clang) for
-		 * improved speed; however, most 64-bit architectures
-		 * also have appropriate IEEE754 floating-point support,
-		 * which is better.
+		 * With FALCON_FPEMU_WIDE, this uses the unsigned __int128
+		 * type of GCC / Clang (the result is the same). An MSVC
+		 * version could use __umulh().
 		 */
 		uint64_t c;
 
+#if FALCON_FPEMU_WIDE
+		c = (uint64_t)(((unsigned __int128)z * y) >> 64);
+#else
 		z0 = (uint32_t)z;
 		z1 = (uint32_t)(z >> 32);
 		y0 = (uint32_t)y;
@@ -1346,6 +1381,7 @@ fpr_expm_p63(fpr x, fpr ccs)
 		c = (a >> 32) + (b >> 32);
 		c += (((uint64_t)(uint32_t)a + (uint64_t)(uint32_t)b) >> 32);
 		c += (uint64_t)z1 * (uint64_t)y1;
+#endif
 		y = C[u] - c;
 	}
 
@@ -1355,6 +1391,9 @@ fpr_expm_p63(fpr x, fpr ccs)
 	 * same format, and do an extra integer multiplication.
 	 */
 	z = (uint64_t)fpr_trunc(fpr_mul(ccs, fpr_ptwo63)) << 1;
+#if FALCON_FPEMU_WIDE
+	y = (uint64_t)(((unsigned __int128)z * y) >> 64);
+#else
 	z0 = (uint32_t)z;
 	z1 = (uint32_t)(z >> 32);
 	y0 = (uint32_t)y;
@@ -1365,6 +1404,7 @@ fpr_expm_p63(fpr x, fpr ccs)
 	y = (a >> 32) + (b >> 32);
 	y += (((uint64_t)(uint32_t)a + (uint64_t)(uint32_t)b) >> 32);
 	y += (uint64_t)z1 * (uint64_t)y1;
+#endif
 
 	return y;
 }
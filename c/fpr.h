@@ -120,15 +120,20 @@ typedef uint64_t fpr;
  * We assumed that the underlying architecture had a barrel shifter for
  * 32-bit shifts, but for 64-bit shifts on a 32-bit system, this will
  * typically invoke a software routine that is not necessarily
- * constant-time; hence the function below.
+ * constant-time; hence the function below. With FALCON_FPEMU_WIDE, the
+ * native 64-bit shift is used.
  *
  * Shift count n MUST be in the 0..63 range.
  */
 static inline uint64_t
 fpr_ursh(uint64_t x, int n)
 {
+#if FALCON_FPEMU_WIDE
+	return x >> n;
+#else
 	x ^= (x ^ (x >> 32)) & -(uint64_t)(n >> 5);
 	return x >> (n & 31);
+#endif
 }
 
 /*
@@ -140,8 +145,12 @@ fpr_ursh(uint64_t x, int n)
 static inline int64_t
 fpr_irsh(int64_t x, int n)
 {
+#if FALCON_FPEMU_WIDE
+	return x >> n;
+#else
 	x ^= (x ^ (x >> 32)) & -(int64_t)(n >> 5);
 	return x >> (n & 31);
+#endif
 }
 
 /*
@@ -153,8 +162,12 @@ fpr_irsh(int64_t x, int n)
 static inline uint64_t
 fpr_ulsh(uint64_t x, int n)
 {
+#if FALCON_FPEMU_WIDE
+	return x << n;
+#else
 	x ^= (x ^ (x << 32)) & -(uint64_t)(n >> 5);
 	return x << (n & 31);
+#endif
 }
 
 /*
@@ -84,6 +84,21 @@
 #include <stdlib.h>
 #include <string.h>
 
+/*
+ * The AVX2, FMA and NEON code works on the native 'double' type; with
+ * emulated floating-point, these options are ignored, so that a core
+ * built with vector flags (see falcon.c) is then plain generic code.
+ */
+#if (defined FALCON_FPEMU && FALCON_FPEMU) \
+	|| (defined FALCON_FPNATIVE && !FALCON_FPNATIVE)
+#undef FALCON_AVX2
+#define FALCON_AVX2   0
+#undef FALCON_FMA
+#define FALCON_FMA   0
+#undef FALCON_NEON
+#define FALCON_NEON   0
+#endif
+
 #if defined FALCON_AVX2 && FALCON_AVX2 // yyyAVX2+1
 /*
  * This implementation uses AVX2 and optionally FMA intrinsics.
@@ -113,6 +128,16 @@
 #endif
 #endif // yyyAVX2-
 
+#if defined FALCON_NEON && FALCON_NEON
+/*
+ * This implementation uses AArch64 NEON intrinsics. NEON is part of the
+ * base AArch64 architecture, so no target attribute is needed. Products
+ * and sums are not fused, so that results are identical to those of
+ * the generic code.
+ */
+#include <arm_neon.h>
+#endif
+
 // yyyNIST+0 yyyPQCLEAN+0
 /*
  * On MSVC, disable warning about applying unary minus on an unsigned
@@ -222,6 +247,37 @@
 #error Exactly one of FALCON_FPEMU and FALCON_FPNATIVE must be selected
 #endif
 
+/*
+ * Emulated floating-point with 128-bit products (see config.h). The
+ * MUL/MULX and UMULH opcodes of x86_64 and AArch64 CPUs have a fixed
+ * latency, and so do their 64-bit shifts; other 64-bit platforms are
+ * not enabled by default.
+ */
+#ifndef FALCON_FPEMU_WIDE
+#if defined __SIZEOF_INT128__ \
+	&& (defined __x86_64__ || defined __aarch64__) \
+	&& !FALCON_ASM_CORTEXM4
+#define FALCON_FPEMU_WIDE   1
+#else
+#define FALCON_FPEMU_WIDE   0
+#endif
+#endif
+
+/*
+ * On AArch64, Keccak-f[1600] can use the ARMv8.2 SHA3 instructions
+ * (EOR3, RAX1, XAR, BCAX). That code is compiled with a target
+ * attribute and selected at runtime when the CPU reports the extension
+ * (see cpu_has_sha3() below); if the compiler already targets SHA3, it
+ * is used unconditionally. The target attribute needs GCC 8+ or Clang
+ * 16+ (older Clang versions only define the intrinsics when SHA3 is
+ * enabled for the whole file). This code has not been tested on SHA3
+ * hardware yet, so it is opt-in: compile with FALCON_KECCAK_SHA3=1, on
+ * AArch64 Linux or macOS (or with SHA3 enabled for the whole build).
+ */
+#ifndef FALCON_KECCAK_SHA3
+#define FALCON_KECCAK_SHA3   0
+#endif
+
 // yyySUPERCOP+0
 /*
  * For seed generation from the operating system:
@@ -258,6 +314,19 @@
 #endif
 #endif
 
+/*
+ * Huge page backing of falcon_ctx arenas (falcon_ctx_new() with
+ * FALCON_CTX_HUGEPAGES): explicit huge pages (MAP_HUGETLB) or
+ * transparent huge pages (MADV_HUGEPAGE) with mmap(), on Linux.
+ */
+#ifndef FALCON_HUGEPAGES
+#if defined __linux__
+#define FALCON_HUGEPAGES   1
+#else
+#define FALCON_HUGEPAGES   0
+#endif
+#endif
+
 #ifndef FALCON_RAND_WIN32
 #if defined _WIN32 || defined _WIN64
 #define FALCON_RAND_WIN32   1
@@ -277,9 +346,25 @@
 #ifndef FALCON_FMA
 #define FALCON_FMA   0
 #endif
+#ifndef FALCON_NEON
+#define FALCON_NEON   0
+#endif
 #ifndef FALCON_KG_CHACHA20
 #define FALCON_KG_CHACHA20   0
 #endif
+#ifndef FALCON_PROFILE
+#define FALCON_PROFILE   0
+#endif
+#ifndef FALCON_SPECIALIZE
+#define FALCON_SPECIALIZE   1
+#endif
+#ifndef FALCON_KEYGEN_MT
+#if defined __unix__ || defined __APPLE__
+#define FALCON_KEYGEN_MT   1
+#else
+#define FALCON_KEYGEN_MT   0
+#endif
+#endif
 // yyyNIST- yyyPQCLEAN-
 
 // yyyPQCLEAN+0 yyySUPERCOP+0
@@ -295,6 +380,87 @@
 #define Zf__(prefix, name)   prefix ## _ ## name  
 // yyyPQCLEAN- yyySUPERCOP-
 
+/*
+ * Profiling instrumentation (FALCON_PROFILE). A phase is bracketed with
+ * PROF_BEGIN(phase) and PROF_END(phase), with phase one of the
+ * FALCON_PROF_* constants from falcon.h; phases of the same kind must
+ * not nest. The state is thread-local and defined once, in falcon.c,
+ * for all builds of the core. Without FALCON_PROFILE the macros expand
+ * to nothing.
+ */
+#if FALCON_PROFILE
+#include "falcon.h"
+
+typedef struct {
+	falcon_profile acc;
+	uint64_t start[FALCON_PROF_NUM];
+} falcon_prof_state;
+
+extern __thread falcon_prof_state falcon_prof_tls;
+
+#if defined __x86_64__ || defined __i386__
+#include <x86intrin.h>
+#define FALCON_PROF_UNIT   FALCON_PROF_UNIT_CYCLES
+static inline uint64_t
+falcon_prof_now(void)
+{
+	return __rdtsc();
+}
+#else
+#include <time.h>
+#define FALCON_PROF_UNIT   FALCON_PROF_UNIT_NS
+static inline uint64_t
+falcon_prof_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+#endif
+
+#define PROF_BEGIN(phase)   (falcon_prof_tls.start[phase] = falcon_prof_now())
+#define PROF_END(phase)   do { \
+		falcon_prof_tls.acc.ticks[phase] += \
+			falcon_prof_now() - falcon_prof_tls.start[phase]; \
+		falcon_prof_tls.acc.count[phase] ++; \
+	} while (0)
+#else
+#define PROF_BEGIN(phase)   ((void)0)
+#define PROF_END(phase)     ((void)0)
+#endif
+
+/*
+ * Degree specialization (FALCON_SPECIALIZE). The FFT and NTT bodies are
+ * static inline functions of logn, which the exported functions
+ * instantiate with logn fixed to 9 and 10 (Falcon-512 and Falcon-1024):
+ * the compiler can then unroll the loops over layers and turn the
+ * twiddle offsets into constants. SPECIALIZED_LOGN(logn) is the degree
+ * to switch on, 0 selecting the generic instance. falcon_specialize is
+ * defined once, in falcon.c, for all builds of the core; see
+ * falcon_set_specialized().
+ */
+#if defined __GNUC__ || defined __clang__
+#define FALCON_INLINE   inline __attribute__((always_inline))
+#else
+#define FALCON_INLINE   inline
+#endif
+
+#if FALCON_SPECIALIZE
+extern volatile int falcon_specialize;
+#define SPECIALIZED_LOGN(logn)   (falcon_specialize ? (logn) : 0u)
+#else
+#define SPECIALIZED_LOGN(logn)   0u
+#endif
+
+/*
+ * Vector code compiled into this build of the core, as one of the
+ * FALCON_IMPL_* values of falcon.h (FALCON_IMPL_GENERIC if none, e.g.
+ * with FALCON_FPEMU). Defined in common.c; falcon.c reads it from the
+ * vector build before dispatching to it.
+ */
+extern const int Zf(core_impl);
+
 // yyyAVX2+1
 /*
  * We use the TARGET_AVX2 macro to tag some functions which, in some
@@ -406,15 +572,15 @@ set_fpu_cw(unsigned x)
 /* ==================================================================== */
 /* Keccak256 PRNG implementation */
 
+#include "keccak256.h"
+
 #define KECCAK256_OUTPUT 32
-#define MAX_BUFFER_SIZE 1024  // Adjust based on your needs
 
 /**
  * Context structure for Keccak256 PRNG
  */
 typedef struct {
-    uint8_t buffer[MAX_BUFFER_SIZE];  // Input buffer
-    size_t buffer_len;                // Length of data in input buffer
+    SHA3_CTX absorb;                  // Running Keccak-256 over the input
     uint8_t state[KECCAK256_OUTPUT];  // Current state
     uint64_t counter;                 // Output counter
     int finalized;                    // Flag indicating if state is finalized
@@ -463,6 +629,69 @@ void Zf(i_shake256_flip)(
 void Zf(i_shake256_extract)(
 	inner_shake256_context *sc, uint8_t *out, size_t len);
 
+#if FALCON_KECCAK_SHA3
+/*
+ * Keccak-f[1600] with the ARMv8.2 SHA3 instructions (see
+ * FALCON_KECCAK_SHA3 above). shake.c uses it for SHAKE256 when
+ * cpu_has_sha3() returns 1, and so does the Keccak256 PRNG.
+ */
+#include <arm_neon.h>
+#if defined __ARM_FEATURE_SHA3
+#define TARGET_SHA3
+#elif defined __clang__
+#define TARGET_SHA3   __attribute__((target("sha3")))
+#else
+#define TARGET_SHA3   __attribute__((target("arch=armv8.2-a+sha3")))
+#endif
+
+#if !defined __ARM_FEATURE_SHA3 && defined __linux__
+#include <sys/auxv.h>
+#ifndef HWCAP_SHA3
+#define HWCAP_SHA3   (1UL << 17)
+#endif
+#elif !defined __ARM_FEATURE_SHA3
+#include <sys/sysctl.h>
+#endif
+
+/*
+ * Tell whether the SHA3 instructions can be used. The answer is cached;
+ * concurrent first calls may all run the check and store the same value.
+ */
+static inline int
+cpu_has_sha3(void)
+{
+#if defined __ARM_FEATURE_SHA3
+	return 1;
+#else
+	static volatile int has_sha3 = -1;
+	int r;
+
+	r = has_sha3;
+	if (r < 0) {
+#if defined __linux__
+		r = (getauxval(AT_HWCAP) & HWCAP_SHA3) != 0;
+#else
+		int v;
+		size_t len;
+
+		v = 0;
+		len = sizeof v;
+		r = sysctlbyname("hw.optional.armv8_2_sha3",
+			&v, &len, NULL, 0) == 0 && v != 0;
+#endif
+		has_sha3 = r;
+	}
+	return r;
+#endif
+}
+
+/*
+ * Apply Keccak-f[1600] to two independent states; lane i of state k is
+ * st[i][k]. This must be called only if cpu_has_sha3() returned 1.
+ */
+void Zf(keccak_f1600_x2_sha3)(uint64_t st[25][2]);
+#endif
+
 /*
 // yyyPQCLEAN+1
 
@@ -507,7 +736,6 @@ typedef inner_shake256_context inner_prng_context;
 
 #endif /* FALCON_PRNG_KECCAK256 */
 
-
 /* ==================================================================== */
 /*
  * Encoding/decoding functions (codec.c).
@@ -637,6 +865,18 @@ int Zf(is_short_half)(uint32_t sqn, const int16_t *s2, unsigned logn);
  */
 void Zf(to_ntt_monty)(uint16_t *h, unsigned logn);
 
+/*
+ * Convert a public key to NTT format (without the Montgomery factor).
+ * Conversion is done in place.
+ */
+void Zf(to_ntt)(uint16_t *h, unsigned logn);
+
+/*
+ * Convert a polynomial in NTT format to NTT + Montgomery format.
+ * Conversion is done in place.
+ */
+void Zf(ntt_to_monty)(uint16_t *h, unsigned logn);
+
 /*
  * Internal signature verification code:
  *   c0[]      contains the hashed nonce+message
@@ -1130,6 +1370,23 @@ void Zf(keygen)(inner_prng_context *rng,
 	int8_t *f, int8_t *g, int8_t *F, int8_t *G, uint16_t *h,
 	unsigned logn, uint8_t *tmp);
 
+/*
+ * Multi-threaded key pair generation (FALCON_KEYGEN_MT). This computes
+ * the same key pair as Zf(keygen)() from the same RNG state, but the
+ * per-prime work of the NTRU solver is spread over nthreads threads
+ * (calling thread included, at most KEYGEN_MAX_THREADS). Each extra
+ * thread uses KEYGEN_MT_WORDS(logn) 32-bit words of scratch: ttmp[]
+ * holds nthreads-1 such areas, and must be 32-bit aligned. Without
+ * FALCON_KEYGEN_MT, or if some threads cannot be started, the calling
+ * thread does the remaining work itself.
+ */
+#define KEYGEN_MAX_THREADS      64
+#define KEYGEN_MT_WORDS(logn)   ((size_t)6 << (logn))
+
+void Zf(keygen_mt)(inner_prng_context *rng,
+	int8_t *f, int8_t *g, int8_t *F, int8_t *G, uint16_t *h,
+	unsigned logn, uint8_t *tmp, unsigned nthreads, uint32_t *ttmp);
+
 /* ==================================================================== */
 /*
  * Signature generation.
@@ -1138,7 +1395,10 @@ void Zf(keygen)(inner_prng_context *rng,
 /*
  * Expand a private key into the B0 matrix in FFT representation and
  * the LDL tree. All the values are written in 'expanded_key', for
- * a total of (8*logn+40)*2^logn bytes.
+ * a total of (8*logn+40)*2^logn bytes. The tree is in the recursive
+ * layout (seq = 0) or in the sequential layout (seq = 1), in which
+ * signing reads it by increasing addresses; both layouts yield the
+ * same signatures.
  *
  * The tmp[] array must have room for at least 48*2^logn bytes.
  *
@@ -1147,12 +1407,103 @@ void Zf(keygen)(inner_prng_context *rng,
  */
 void Zf(expand_privkey)(fpr *restrict expanded_key,
 	const int8_t *f, const int8_t *g, const int8_t *F, const int8_t *G,
-	unsigned logn, uint8_t *restrict tmp);
+	unsigned logn, int seq, uint8_t *restrict tmp);
+
+/*
+ * Expand a private key into a compact form: the ffLDL tree is stored
+ * only for its 'levels' upper levels (1 <= levels <= logn - 2); each
+ * node below keeps instead the row of its Gram matrix, from which
+ * signing rebuilds the subtree. The B0 matrix is not stored: the
+ * private key elements follow the tree, and signing recomputes B0 from
+ * them. Values are written in 'compact_key', for a total of
+ * (8*levels+20)*2^logn bytes.
+ *
+ * The tmp[] array must have room for at least 80*2^logn bytes.
+ *
+ * tmp[] must have 64-bit alignment.
+ * This function uses floating-point rounding (see set_fpu_cw()).
+ */
+void Zf(expand_privkey_compact)(fpr *restrict compact_key,
+	const int8_t *f, const int8_t *g, const int8_t *F, const int8_t *G,
+	unsigned logn, unsigned levels, uint8_t *restrict tmp);
+
+/*
+ * Internal sampler engine. Exported for tests.
+ *
+ * sampler_context wraps around a source of random numbers (PRNG) and
+ * the sigma_min value (nominally dependent on the degree). The sampler
+ * increments its rejections counter for each rejected candidate.
+ * sampler_init() initializes a context from a SHAKE/Keccak context for
+ * the given degree.
+ *
+ * Each sampler iteration normally consumes exactly SAMPLER_STRIDE PRNG
+ * bytes (9 for the base sample, 1 for the sign bit, 1 for BerExp), so
+ * the base samples of the following iterations sit at known offsets in
+ * the PRNG buffer. The context keeps a batch of them, computed at once
+ * by gaussian0_batch(); z0[z0_idx] is the base sample at offset z0_pos.
+ * When BerExp needs more than one byte the offsets no longer match and
+ * the batch is recomputed from the current position. The PRNG output
+ * is consumed exactly as with one gaussian0_sampler() call per
+ * iteration, so signatures are unchanged.
+ *
+ * sampler() takes as parameters:
+ *   ctx      pointer to the sampler_context structure
+ *   mu       center for the distribution
+ *   isigma   inverse of the distribution standard deviation
+ * It returns an integer sampled along the Gaussian distribution centered
+ * on mu and of standard deviation sigma = 1/isigma.
+ *
+ * gaussian0_sampler() takes as parameter a pointer to a PRNG, and
+ * returns an integer sampled along a half-Gaussian with standard
+ * deviation sigma0 = 1.8205 (center is 0, returned value is
+ * nonnegative).
+ *
+ * gaussian0_batch() writes into z0[] the num values that
+ * gaussian0_sampler() would return with p->ptr set to pos,
+ * pos + SAMPLER_STRIDE, pos + 2*SAMPLER_STRIDE... All these offsets
+ * must be lower than (sizeof p->buf.d) - 9; p is not modified.
+ */
+
+#define SAMPLER_STRIDE   11
+#define SAMPLER_BATCH    ((512 - 9 + SAMPLER_STRIDE - 1) / SAMPLER_STRIDE)
+
+typedef struct {
+	prng p;
+	fpr sigma_min;
+	uint32_t rejections;
+	size_t z0_pos;
+	unsigned z0_idx, z0_num;
+	uint8_t z0[SAMPLER_BATCH];
+} sampler_context;
+
+void Zf(sampler_init)(sampler_context *sc,
+	inner_prng_context *src, unsigned logn);
+
+TARGET_AVX2
+int Zf(sampler)(void *ctx, fpr mu, fpr isigma);
+
+TARGET_AVX2
+int Zf(gaussian0_sampler)(prng *p);
+
+TARGET_AVX2
+void Zf(gaussian0_batch)(uint8_t *z0, prng *p, size_t pos, size_t num);
+
+/*
+ * Rejection counters for one signature: attempts is the number of
+ * candidate vectors computed (the last one passed the norm bound),
+ * rejections the number of values rejected by the Gaussian sampler
+ * (BerExp) over all attempts.
+ */
+typedef struct {
+	uint32_t attempts;
+	uint32_t rejections;
+} sign_stats;
 
 /*
  * Compute a signature over the provided hashed message (hm); the
  * signature value is one short vector. This function uses an
- * expanded key (as generated by Zf(expand_privkey)()).
+ * expanded key (as generated by Zf(expand_privkey)() with the same
+ * seq).
  *
  * The sig[] and hm[] buffers may overlap.
  *
@@ -1161,12 +1512,46 @@ void Zf(expand_privkey)(fpr *restrict expanded_key,
  *
  * The minimal size (in bytes) of tmp[] is 48*2^logn bytes.
  *
+ * If stats is not NULL, the number of attempts and of sampler
+ * rejections made for this signature are added to it.
+ *
+ * If pre is not NULL, the first attempt uses a copy of *pre (obtained
+ * with Zf(sampler_init)() for the same degree) as sampler, instead of a
+ * new one seeded from rng; later attempts, if any, seed theirs from
+ * rng. The caller must not use the same *pre for two signatures.
+ *
  * tmp[] must have 64-bit alignment.
  * This function uses floating-point rounding (see set_fpu_cw()).
  */
 void Zf(sign_tree)(int16_t *sig, inner_prng_context *rng,
-	const fpr *restrict expanded_key,
-	const uint16_t *hm, unsigned logn, uint8_t *tmp);
+	const sampler_context *pre,
+	const fpr *restrict expanded_key, int seq,
+	const uint16_t *hm, unsigned logn, uint8_t *tmp, sign_stats *stats);
+
+/*
+ * Compute a signature over the provided hashed message (hm), with a
+ * compact expanded key (as generated by Zf(expand_privkey_compact)()
+ * with the same 'levels'). The signature is the same as the one
+ * obtained with Zf(sign_tree)() and the full expanded key, for the
+ * same rng state; the subtrees below the stored levels are rebuilt for
+ * each attempt.
+ *
+ * The sig[] and hm[] buffers may overlap.
+ *
+ * On successful output, the start of the tmp[] buffer contains the s1
+ * vector (as int16_t elements).
+ *
+ * The minimal size (in bytes) of tmp[] is (4*logn+92)*2^logn bytes.
+ *
+ * stats and pre are handled as in Zf(sign_tree)().
+ *
+ * tmp[] must have 64-bit alignment.
+ * This function uses floating-point rounding (see set_fpu_cw()).
+ */
+void Zf(sign_tree_compact)(int16_t *sig, inner_prng_context *rng,
+	const sampler_context *pre,
+	const fpr *restrict compact_key, unsigned levels,
+	const uint16_t *hm, unsigned logn, uint8_t *tmp, sign_stats *stats);
 
 /*
  * Compute a signature over the provided hashed message (hm); the
@@ -1182,43 +1567,16 @@ void Zf(sign_tree)(int16_t *sig, inner_prng_context *rng,
  *
  * The minimal size (in bytes) of tmp[] is 72*2^logn bytes.
  *
+ * stats and pre are handled as in Zf(sign_tree)().
+ *
  * tmp[] must have 64-bit alignment.
  * This function uses floating-point rounding (see set_fpu_cw()).
  */
 void Zf(sign_dyn)(int16_t *sig, inner_prng_context *rng,
+	const sampler_context *pre,
 	const int8_t *restrict f, const int8_t *restrict g,
 	const int8_t *restrict F, const int8_t *restrict G,
-	const uint16_t *hm, unsigned logn, uint8_t *tmp);
-
-/*
- * Internal sampler engine. Exported for tests.
- *
- * sampler_context wraps around a source of random numbers (PRNG) and
- * the sigma_min value (nominally dependent on the degree).
- *
- * sampler() takes as parameters:
- *   ctx      pointer to the sampler_context structure
- *   mu       center for the distribution
- *   isigma   inverse of the distribution standard deviation
- * It returns an integer sampled along the Gaussian distribution centered
- * on mu and of standard deviation sigma = 1/isigma.
- *
- * gaussian0_sampler() takes as parameter a pointer to a PRNG, and
- * returns an integer sampled along a half-Gaussian with standard
- * deviation sigma0 = 1.8205 (center is 0, returned value is
- * nonnegative).
- */
-
-typedef struct {
-	prng p;
-	fpr sigma_min;
-} sampler_context;
-
-TARGET_AVX2
-int Zf(sampler)(void *ctx, fpr mu, fpr isigma);
-
-TARGET_AVX2
-int Zf(gaussian0_sampler)(prng *p);
+	const uint16_t *hm, unsigned logn, uint8_t *tmp, sign_stats *stats);
 
 /* ==================================================================== */
 
@@ -178,16 +178,16 @@ static void sha3_process_block(uint64_t hash[25], const uint64_t *block) {
  * @param msg message chunk
  * @param size length of the message chunk
  */
-void keccak_update(SHA3_CTX *ctx, const unsigned char *msg, uint16_t size)
+void keccak_update(SHA3_CTX *ctx, const unsigned char *msg, size_t size)
 {
-    uint16_t idx = (uint16_t)ctx->rest;
+    size_t idx = ctx->rest;
 
     //if (ctx->rest & SHA3_FINALIZED) return; /* too late for additional input */
-    ctx->rest = (unsigned)((ctx->rest + size) % BLOCK_SIZE);
+    ctx->rest = (uint16_t)((idx + size) % BLOCK_SIZE);
 
     /* fill partial block */
     if (idx) {
-        uint16_t left = BLOCK_SIZE - idx;
+        size_t left = BLOCK_SIZE - idx;
         memcpy((char*)ctx->message + idx, msg, (size < left ? size : left));
         if (size < left) return;
 
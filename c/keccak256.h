@@ -20,6 +20,7 @@
 #ifndef __KECCAK256_H_
 #define __KECCAK256_H_
 
+#include <stddef.h>
 #include <stdint.h>
 
 #define sha3_max_permutation_size 25
@@ -43,7 +44,7 @@ extern "C" {
 
 
 void keccak_init(SHA3_CTX *ctx);
-void keccak_update(SHA3_CTX *ctx, const unsigned char *msg, uint16_t size);
+void keccak_update(SHA3_CTX *ctx, const unsigned char *msg, size_t size);
 void keccak_final(SHA3_CTX *ctx, unsigned char* result);
 
 
@@ -11,22 +11,26 @@
  * 1. State Management:
  *    - Maintains a 32-byte state derived from input data
  *    - Uses a 64-bit counter for expandable output
- *    - Includes a buffer for accumulating input before finalization
+ *    - Absorbs input incrementally into a running Keccak-256 context, so
+ *      inputs of any length use constant memory
  *    - Maintains an output buffer to store unused random bytes
  *
  * 2. Operation Phases:
  *    a) Input Phase (before finalization):
- *       - Accumulate arbitrary input data into buffer
+ *       - Absorb arbitrary input data as it arrives
  *       - Can receive multiple inputs through inject function
  *
  *    b) Finalization Phase:
- *       - Processes all input using Keccak-256 to create initial state
+ *       - Pads the absorbed input; the Keccak-256 digest becomes the state
  *       - Locks further input
  *
  *    c) Output Phase (after finalization):
  *       - Uses buffered output when available to reduce hash operations
  *       - Generates new blocks using counter mode when buffer is empty
  *       - Each block combines state and counter through Keccak-256
+ *       - Blocks are computed several at a time with interleaved
+ *         Keccak-f[1600] permutations (four-way with AVX2, selected
+ *         at runtime on x86)
  */
 
 #include <stdint.h>
@@ -34,15 +38,41 @@
 #include "inner.h"
 #include "keccak256.h"
 
+/*
+ * On x86 with GCC or Clang, the four-way AVX2 Keccak-f[1600] is always
+ * compiled (with a target attribute) and used when the CPU supports
+ * AVX2 (see cpu_has_avx2() below); this file is built only once, with
+ * the generic flags.
+ */
+#ifndef FALCON_KECCAK_AVX2
+#if (defined __x86_64__ || defined __i386__) \
+	&& (defined __GNUC__ || defined __clang__)
+#define FALCON_KECCAK_AVX2   1
+#else
+#define FALCON_KECCAK_AVX2   0
+#endif
+#endif
+
+#if FALCON_KECCAK_AVX2
+#include <immintrin.h>
+#include <cpuid.h>
+#endif
+
+/*
+ * The public prng_context (falcon.h) must be large enough to hold this
+ * context; compilation fails here if it is not.
+ */
+typedef char keccak256_prng_ctx_fits[
+    (sizeof(inner_keccak256_prng_ctx) <= 64 * sizeof(uint64_t)) ? 1 : -1];
+
 /**
  * Initialize a Keccak256 PRNG context.
  */
 int inner_keccak256_init(inner_keccak256_prng_ctx *sc) {
     if (!sc) return -1;
     
-    memset(sc->buffer, 0, MAX_BUFFER_SIZE);
+    keccak_init(&sc->absorb);
     memset(sc->state, 0, KECCAK256_OUTPUT);
-    sc->buffer_len = 0;
     sc->counter = 0;
     sc->finalized = 0;
     
@@ -57,17 +87,12 @@ int inner_keccak256_init(inner_keccak256_prng_ctx *sc) {
  * Inject (absorb) data into the PRNG state.
  */
 int inner_keccak256_inject(inner_keccak256_prng_ctx *sc, const uint8_t *in, size_t len) {
-    if (!sc || !in) return -1;
+    if (!sc || (!in && len)) return -1;
     if (sc->finalized) return -2;
 
-    // Check if we have enough space in buffer
-    if (sc->buffer_len + len > MAX_BUFFER_SIZE) {
-        return -3;  // Buffer would overflow
+    if (len) {
+        keccak_update(&sc->absorb, in, len);
     }
-
-    // Append new data to buffer
-    memcpy(sc->buffer + sc->buffer_len, in, len);
-    sc->buffer_len += len;
     return 0;
 }
 
@@ -78,10 +103,10 @@ int inner_keccak256_flip(inner_keccak256_prng_ctx *sc) {
     if (!sc) return -1;
     if (sc->finalized) return -2;
 
-    SHA3_CTX keccak_ctx;
-    keccak_init(&keccak_ctx);
-    keccak_update(&keccak_ctx, sc->buffer, sc->buffer_len);
-    keccak_final(&keccak_ctx, sc->state);
+    keccak_final(&sc->absorb, sc->state);
+    // The absorb context is not needed after this point; clear the input
+    // it may still hold
+    keccak_init(&sc->absorb);
 
     sc->finalized = 1;
     
@@ -92,6 +117,261 @@ int inner_keccak256_flip(inner_keccak256_prng_ctx *sc) {
     return 0;
 }
 
+/*
+ * Multi-way Keccak-f[1600] for counter-mode output.
+ *
+ * Every output block is Keccak256(state || counter), a 40-byte input
+ * that fits in a single rate block, so it costs one permutation of a
+ * fixed initial state. The blocks for successive counter values are
+ * independent; we compute KECCAK_PRNG_WAYS of them at once with
+ * interleaved permutations: four-way with AVX2, two-way otherwise
+ * (the portable code is written so that the compiler can map the two
+ * instances to 128-bit SIMD registers; on AArch64 CPUs with the SHA3
+ * extension, with FALCON_KECCAK_SHA3, the two-way permutation from
+ * shake.c is used instead).
+ *
+ * Lanes are stored lane-major: lane i of instance k is st[i][k].
+ */
+
+static const uint64_t keccakf_rc[24] = {
+    0x0000000000000001ULL, 0x0000000000008082ULL,
+    0x800000000000808AULL, 0x8000000080008000ULL,
+    0x000000000000808BULL, 0x0000000080000001ULL,
+    0x8000000080008081ULL, 0x8000000000008009ULL,
+    0x000000000000008AULL, 0x0000000000000088ULL,
+    0x0000000080008009ULL, 0x000000008000000AULL,
+    0x000000008000808BULL, 0x800000000000008BULL,
+    0x8000000000008089ULL, 0x8000000000008003ULL,
+    0x8000000000008002ULL, 0x8000000000000080ULL,
+    0x000000000000800AULL, 0x800000008000000AULL,
+    0x8000000080008081ULL, 0x8000000000008080ULL,
+    0x0000000080000001ULL, 0x8000000080008008ULL
+};
+
+/* Rotation amounts of the combined rho/pi step, in pi lane order. */
+static const unsigned keccakf_rotc[24] = {
+    1, 3, 6, 10, 15, 21, 28, 36, 45, 55, 2, 14,
+    27, 41, 56, 8, 25, 43, 62, 18, 39, 61, 20, 44
+};
+
+static const unsigned keccakf_piln[24] = {
+    10, 7, 11, 17, 18, 3, 5, 16, 8, 21, 24, 4,
+    15, 23, 19, 13, 12, 2, 20, 14, 22, 9, 6, 1
+};
+
+#if FALCON_KECCAK_AVX2
+#define KECCAK_PRNG_WAYS   4
+#else
+#define KECCAK_PRNG_WAYS   2
+#endif
+
+#define KF_ROL(x, n)   (((x) << (n)) | ((x) >> (64 - (n))))
+
+/*
+ * KECCAK_PRNG_WAYS-way Keccak-f[1600] in portable C.
+ */
+static void keccak_f1600_xn(uint64_t st[25][KECCAK_PRNG_WAYS]) {
+    uint64_t bc[5][KECCAK_PRNG_WAYS], t[KECCAK_PRNG_WAYS];
+    int i, j, k, r;
+
+    for (r = 0; r < 24; r++) {
+        for (i = 0; i < 5; i++) {
+            for (k = 0; k < KECCAK_PRNG_WAYS; k++) {
+                bc[i][k] = st[i][k] ^ st[i + 5][k] ^ st[i + 10][k]
+                    ^ st[i + 15][k] ^ st[i + 20][k];
+            }
+        }
+        for (i = 0; i < 5; i++) {
+            for (k = 0; k < KECCAK_PRNG_WAYS; k++) {
+                t[k] = bc[(i + 4) % 5][k] ^ KF_ROL(bc[(i + 1) % 5][k], 1);
+            }
+            for (j = 0; j < 25; j += 5) {
+                for (k = 0; k < KECCAK_PRNG_WAYS; k++) {
+                    st[j + i][k] ^= t[k];
+                }
+            }
+        }
+        for (k = 0; k < KECCAK_PRNG_WAYS; k++) {
+            t[k] = st[1][k];
+        }
+        for (i = 0; i < 24; i++) {
+            j = keccakf_piln[i];
+            for (k = 0; k < KECCAK_PRNG_WAYS; k++) {
+                bc[0][k] = st[j][k];
+                st[j][k] = KF_ROL(t[k], keccakf_rotc[i]);
+                t[k] = bc[0][k];
+            }
+        }
+        for (j = 0; j < 25; j += 5) {
+            for (i = 0; i < 5; i++) {
+                for (k = 0; k < KECCAK_PRNG_WAYS; k++) {
+                    bc[i][k] = st[j + i][k];
+                }
+            }
+            for (i = 0; i < 5; i++) {
+                for (k = 0; k < KECCAK_PRNG_WAYS; k++) {
+                    st[j + i][k] ^= ~bc[(i + 1) % 5][k] & bc[(i + 2) % 5][k];
+                }
+            }
+        }
+        for (k = 0; k < KECCAK_PRNG_WAYS; k++) {
+            st[0][k] ^= keccakf_rc[r];
+        }
+    }
+}
+
+#undef KF_ROL
+
+#if FALCON_KECCAK_AVX2
+
+/*
+ * Tell whether AVX2 can be used: the CPU must report AVX2 (leaf 7) and
+ * OSXSAVE (leaf 1), and the OS must have enabled the XMM and YMM
+ * register state (XCR0 bits 1 and 2). The answer is cached; concurrent
+ * first calls may all run the check and store the same value.
+ */
+static int cpu_has_avx2(void) {
+    static volatile int has_avx2 = -1;
+    unsigned a, b, c, d;
+    uint32_t xcr0;
+    int r;
+
+    r = has_avx2;
+    if (r < 0) {
+        r = 0;
+        if (__get_cpuid(1, &a, &b, &c, &d) && (c & bit_OSXSAVE) != 0) {
+            __asm__ __volatile__ ("xgetbv"
+                : "=a" (xcr0) : "c" (0) : "edx");
+            if ((xcr0 & 6) == 6 && __get_cpuid_max(0, NULL) >= 7) {
+                __cpuid_count(7, 0, a, b, c, d);
+                r = (b & bit_AVX2) != 0;
+            }
+        }
+        has_avx2 = r;
+    }
+    return r;
+}
+
+#define KF_ROL(x, n)   _mm256_or_si256(_mm256_slli_epi64(x, (int)(n)), \
+                           _mm256_srli_epi64(x, 64 - (int)(n)))
+
+/*
+ * Four-way Keccak-f[1600]; instance k lives in the 64-bit slot k of
+ * each AVX2 register.
+ */
+__attribute__((target("avx2")))
+static void keccak_f1600_x4(uint64_t st[25][4]) {
+    __m256i a[25], bc[5], t;
+    int i, j, r;
+
+    for (i = 0; i < 25; i++) {
+        a[i] = _mm256_loadu_si256((const void *)st[i]);
+    }
+    for (r = 0; r < 24; r++) {
+        for (i = 0; i < 5; i++) {
+            bc[i] = _mm256_xor_si256(
+                _mm256_xor_si256(a[i], a[i + 5]),
+                _mm256_xor_si256(_mm256_xor_si256(a[i + 10], a[i + 15]),
+                    a[i + 20]));
+        }
+        for (i = 0; i < 5; i++) {
+            t = _mm256_xor_si256(bc[(i + 4) % 5], KF_ROL(bc[(i + 1) % 5], 1));
+            for (j = 0; j < 25; j += 5) {
+                a[j + i] = _mm256_xor_si256(a[j + i], t);
+            }
+        }
+        t = a[1];
+        for (i = 0; i < 24; i++) {
+            j = keccakf_piln[i];
+            bc[0] = a[j];
+            a[j] = KF_ROL(t, keccakf_rotc[i]);
+            t = bc[0];
+        }
+        for (j = 0; j < 25; j += 5) {
+            for (i = 0; i < 5; i++) {
+                bc[i] = a[j + i];
+            }
+            for (i = 0; i < 5; i++) {
+                a[j + i] = _mm256_xor_si256(a[j + i],
+                    _mm256_andnot_si256(bc[(i + 1) % 5], bc[(i + 2) % 5]));
+            }
+        }
+        a[0] = _mm256_xor_si256(a[0],
+            _mm256_set1_epi64x((long long)keccakf_rc[r]));
+    }
+    for (i = 0; i < 25; i++) {
+        _mm256_storeu_si256((void *)st[i], a[i]);
+    }
+}
+
+#undef KF_ROL
+
+#endif
+
+/**
+ * Compute num <= KECCAK_PRNG_WAYS consecutive counter-mode blocks,
+ * Keccak256(state || counter) with the counter in big-endian format,
+ * into out (32 bytes per block), and advance the counter.
+ */
+static void keccak256_counter_blocks(inner_keccak256_prng_ctx *sc,
+    uint8_t *out, size_t num) {
+    uint64_t st[25][KECCAK_PRNG_WAYS];
+    uint64_t key[4];
+    size_t i, k;
+
+    // Lanes are little-endian, as in keccak256.c
+    for (i = 0; i < 4; i++) {
+        key[i] = 0;
+        for (k = 0; k < 8; k++) {
+            key[i] |= (uint64_t)sc->state[(i << 3) + k] << (k << 3);
+        }
+    }
+
+    memset(st, 0, sizeof st);
+    for (k = 0; k < KECCAK_PRNG_WAYS; k++) {
+        uint64_t c, w;
+
+        for (i = 0; i < 4; i++) {
+            st[i][k] = key[i];
+        }
+
+        // Big-endian counter bytes, read as a little-endian lane
+        c = sc->counter + k;
+        w = 0;
+        for (i = 0; i < 8; i++) {
+            w |= ((c >> (56 - (i << 3))) & 0xFF) << (i << 3);
+        }
+        st[4][k] = w;
+
+        // Keccak padding of the 40-byte input in a 136-byte block
+        st[5][k] = 0x01;
+        st[16][k] = 0x8000000000000000ULL;
+    }
+
+#if FALCON_KECCAK_AVX2
+    if (cpu_has_avx2()) {
+        keccak_f1600_x4(st);
+    } else {
+        keccak_f1600_xn(st);
+    }
+#elif FALCON_KECCAK_SHA3
+    if (cpu_has_sha3()) {
+        Zf(keccak_f1600_x2_sha3)(st);
+    } else {
+        keccak_f1600_xn(st);
+    }
+#else
+    keccak_f1600_xn(st);
+#endif
+
+    for (k = 0; k < num; k++) {
+        for (i = 0; i < KECCAK256_OUTPUT; i++) {
+            out[(k << 5) + i] = (uint8_t)(st[i >> 3][k] >> ((i & 7) << 3));
+        }
+    }
+    sc->counter += num;
+}
+
 /**
  * Generate pseudorandom output from the PRNG.
  */
@@ -116,37 +396,27 @@ int inner_keccak256_extract(inner_keccak256_prng_ctx *sc, uint8_t *out, size_t l
         }
     }
 
-    // Generate additional blocks as needed
-    uint8_t block[KECCAK256_OUTPUT + 8];  // State + counter
-    SHA3_CTX keccak_ctx;
+    // Whole groups of blocks go straight to the caller
+    while (len - offset >= KECCAK_PRNG_WAYS * KECCAK256_OUTPUT) {
+        keccak256_counter_blocks(sc, out + offset, KECCAK_PRNG_WAYS);
+        offset += KECCAK_PRNG_WAYS * KECCAK256_OUTPUT;
+    }
 
-    while (offset < len) {
-        // Prepare input block: state || counter
-        memcpy(block, sc->state, KECCAK256_OUTPUT);
-        // Add counter in big-endian format
-        for (int i = 0; i < 8; i++) {
-            block[KECCAK256_OUTPUT + i] = (sc->counter >> (56 - i * 8)) & 0xFF;
-        }
+    // The last group, which may end with a partial block, is computed
+    // in one call; unused bytes of its last block stay in the output
+    // buffer
+    if (offset < len) {
+        uint8_t group[KECCAK_PRNG_WAYS * KECCAK256_OUTPUT];
+        size_t rest = len - offset;
+        size_t num = (rest + KECCAK256_OUTPUT - 1) / KECCAK256_OUTPUT;
 
-        // Generate next block using Keccak-256
-        keccak_init(&keccak_ctx);
-        keccak_update(&keccak_ctx, block, KECCAK256_OUTPUT + 8);
-        keccak_final(&keccak_ctx, sc->out_buffer);
-        
-        // Update buffer state
+        keccak256_counter_blocks(sc, group, num);
+        memcpy(out + offset, group, rest);
+        memcpy(sc->out_buffer, group + (num - 1) * KECCAK256_OUTPUT,
+            KECCAK256_OUTPUT);
         sc->out_buffer_len = KECCAK256_OUTPUT;
-        sc->out_buffer_pos = 0;
-
-        // Copy output
-        size_t remaining = len - offset;
-        size_t to_copy = (remaining < KECCAK256_OUTPUT) ? remaining : KECCAK256_OUTPUT;
-        
-        memcpy(out + offset, sc->out_buffer, to_copy);
-        sc->out_buffer_pos = to_copy;
-        offset += to_copy;
-        
-        sc->counter++;
+        sc->out_buffer_pos = rest - (num - 1) * KECCAK256_OUTPUT;
     }
-    
+
     return 0;
 }
\ No newline at end of file
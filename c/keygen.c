@@ -31,6 +31,10 @@
 
 #include "inner.h"
 
+#if FALCON_KEYGEN_MT
+#include <pthread.h>
+#endif
+
 #define MKN(logn)   ((size_t)1 << (logn))
 
 /* ==================================================================== */
@@ -924,6 +928,300 @@ static const uint16_t REV10[] = {
 	 255,  767,  511, 1023
 };
 
+#if FALCON_AVX2 // yyyAVX2+1
+
+/*
+ * AVX2 versions of the modp_*() functions, on 8 lanes of 32 bits. All
+ * lanes use the same prime: pp contains p in every lane, and p0 contains
+ * p0i. Lane values are in the 0..p-1 range and results are identical to
+ * those of the scalar functions.
+ */
+
+TARGET_AVX2
+static inline __m256i
+modp_add_x8(__m256i a, __m256i b, __m256i pp)
+{
+	__m256i d;
+
+	/*
+	 * a + b < 2*p < 2^32; if a + b < p, the subtraction of p wraps
+	 * around to a value of at least 2^32 - p, which is larger.
+	 */
+	d = _mm256_add_epi32(a, b);
+	return _mm256_min_epu32(d, _mm256_sub_epi32(d, pp));
+}
+
+TARGET_AVX2
+static inline __m256i
+modp_sub_x8(__m256i a, __m256i b, __m256i pp)
+{
+	__m256i d;
+
+	d = _mm256_sub_epi32(a, b);
+	return _mm256_min_epu32(d, _mm256_add_epi32(d, pp));
+}
+
+TARGET_AVX2
+static inline __m256i
+modp_montymul_x8(__m256i a, __m256i b, __m256i pp, __m256i p0)
+{
+	__m256i m31, ze, zo, we, wo, d;
+
+	/*
+	 * Even and odd lanes are processed separately, with 64-bit
+	 * products; _mm256_mul_epu32() only uses the low 32 bits of
+	 * each 64-bit lane, which is all we need for (z*p0i) mod 2^31.
+	 */
+	m31 = _mm256_set1_epi64x(0x7FFFFFFF);
+	ze = _mm256_mul_epu32(a, b);
+	zo = _mm256_mul_epu32(_mm256_srli_epi64(a, 32),
+		_mm256_srli_epi64(b, 32));
+	we = _mm256_mul_epu32(
+		_mm256_and_si256(_mm256_mul_epu32(ze, p0), m31), pp);
+	wo = _mm256_mul_epu32(
+		_mm256_and_si256(_mm256_mul_epu32(zo, p0), m31), pp);
+	ze = _mm256_srli_epi64(_mm256_add_epi64(ze, we), 31);
+	zo = _mm256_slli_epi64(_mm256_srli_epi64(
+		_mm256_add_epi64(zo, wo), 31), 32);
+	d = _mm256_blend_epi32(ze, zo, 0xAA);
+	return _mm256_min_epu32(d, _mm256_sub_epi32(d, pp));
+}
+
+/*
+ * Butterflies with a distance d < 8 stay within a block of 8 values;
+ * as in mq_NTT_avx2() (vrfy.c), each lane is swapped with its partner
+ * (lane index XOR d) and vm selects the lanes of the second halves.
+ */
+TARGET_AVX2
+static inline __m256i
+modp_swap4_x8(__m256i x)
+{
+	return _mm256_permute2x128_si256(x, x, 0x01);
+}
+
+TARGET_AVX2
+static inline __m256i
+modp_swap2_x8(__m256i x)
+{
+	return _mm256_shuffle_epi32(x, 0x4E);
+}
+
+TARGET_AVX2
+static inline __m256i
+modp_swap1_x8(__m256i x)
+{
+	return _mm256_shuffle_epi32(x, 0xB1);
+}
+
+TARGET_AVX2
+static inline __m256i
+modp_ntt_inreg_x8(__m256i x, __m256i y, __m256i vm, __m256i s,
+	__m256i pp, __m256i p0)
+{
+	__m256i u, v, w;
+
+	u = _mm256_blendv_epi8(x, y, vm);
+	v = _mm256_blendv_epi8(y, x, vm);
+	w = modp_montymul_x8(v, s, pp, p0);
+	return _mm256_blendv_epi8(modp_add_x8(u, w, pp),
+		modp_sub_x8(u, w, pp), vm);
+}
+
+TARGET_AVX2
+static inline __m256i
+modp_intt_inreg_x8(__m256i x, __m256i y, __m256i vm, __m256i s,
+	__m256i pp, __m256i p0)
+{
+	__m256i u, v;
+
+	u = _mm256_blendv_epi8(x, y, vm);
+	v = _mm256_blendv_epi8(y, x, vm);
+	return _mm256_blendv_epi8(modp_add_x8(u, v, pp),
+		modp_montymul_x8(modp_sub_x8(u, v, pp), s, pp, p0), vm);
+}
+
+/*
+ * Twiddle vectors for groups of 4 and 2 lanes, from consecutive table
+ * entries.
+ */
+TARGET_AVX2
+static inline __m256i
+modp_tw2_x8(const uint32_t *tab)
+{
+	return _mm256_inserti128_si256(
+		_mm256_castsi128_si256(_mm_set1_epi32((int)tab[0])),
+		_mm_set1_epi32((int)tab[1]), 1);
+}
+
+TARGET_AVX2
+static inline __m256i
+modp_tw4_x8(const uint32_t *tab)
+{
+	__m128i t;
+
+	t = _mm_loadu_si128((const __m128i *)tab);
+	return _mm256_inserti128_si256(
+		_mm256_castsi128_si256(_mm_unpacklo_epi32(t, t)),
+		_mm_unpackhi_epi32(t, t), 1);
+}
+
+/*
+ * NTT with AVX2 over consecutive elements (n >= 8): layers with a
+ * butterfly distance of at least 8 process 8 butterflies per step, and
+ * the last three layers run in registers on blocks of 8 values.
+ */
+TARGET_AVX2
+static void
+modp_NTT2_avx2(uint32_t *a, const uint32_t *gm, unsigned logn,
+	uint32_t p, uint32_t p0i)
+{
+	size_t n, t, m, k;
+	__m256i pp, p0, vm4, vm2, vm1;
+
+	n = (size_t)1 << logn;
+	pp = _mm256_set1_epi32((int)p);
+	p0 = _mm256_set1_epi32((int)p0i);
+	t = n;
+	for (m = 1; t > 8; m <<= 1) {
+		size_t ht, u, j1;
+
+		ht = t >> 1;
+		for (u = 0, j1 = 0; u < m; u ++, j1 += t) {
+			size_t j, j2;
+			__m256i s;
+
+			s = _mm256_set1_epi32((int)gm[m + u]);
+			j2 = j1 + ht;
+			for (j = j1; j < j2; j += 8) {
+				__m256i x, y;
+
+				x = _mm256_loadu_si256((__m256i *)(a + j));
+				y = _mm256_loadu_si256((__m256i *)(a + j + ht));
+				y = modp_montymul_x8(y, s, pp, p0);
+				_mm256_storeu_si256((__m256i *)(a + j),
+					modp_add_x8(x, y, pp));
+				_mm256_storeu_si256((__m256i *)(a + j + ht),
+					modp_sub_x8(x, y, pp));
+			}
+		}
+		t = ht;
+	}
+
+	/*
+	 * Here t = 8 and m = n/8.
+	 */
+	vm4 = _mm256_setr_epi32(0, 0, 0, 0, -1, -1, -1, -1);
+	vm2 = _mm256_setr_epi32(0, 0, -1, -1, 0, 0, -1, -1);
+	vm1 = _mm256_setr_epi32(0, -1, 0, -1, 0, -1, 0, -1);
+	for (k = 0; k < m; k ++) {
+		__m256i x;
+
+		x = _mm256_loadu_si256((__m256i *)(a + (k << 3)));
+		x = modp_ntt_inreg_x8(x, modp_swap4_x8(x), vm4,
+			_mm256_set1_epi32((int)gm[m + k]), pp, p0);
+		x = modp_ntt_inreg_x8(x, modp_swap2_x8(x), vm2,
+			modp_tw2_x8(&gm[(m << 1) + (k << 1)]), pp, p0);
+		x = modp_ntt_inreg_x8(x, modp_swap1_x8(x), vm1,
+			modp_tw4_x8(&gm[(m << 2) + (k << 2)]), pp, p0);
+		_mm256_storeu_si256((__m256i *)(a + (k << 3)), x);
+	}
+}
+
+/*
+ * Inverse NTT with AVX2 over consecutive elements (n >= 8), mirroring
+ * modp_NTT2_avx2(): the first three layers run in registers.
+ */
+TARGET_AVX2
+static void
+modp_iNTT2_avx2(uint32_t *a, const uint32_t *igm, unsigned logn,
+	uint32_t p, uint32_t p0i)
+{
+	size_t n, hn, t, m, k;
+	__m256i pp, p0, vm4, vm2, vm1, sn;
+
+	n = (size_t)1 << logn;
+	hn = n >> 1;
+	pp = _mm256_set1_epi32((int)p);
+	p0 = _mm256_set1_epi32((int)p0i);
+	vm4 = _mm256_setr_epi32(0, 0, 0, 0, -1, -1, -1, -1);
+	vm2 = _mm256_setr_epi32(0, 0, -1, -1, 0, 0, -1, -1);
+	vm1 = _mm256_setr_epi32(0, -1, 0, -1, 0, -1, 0, -1);
+	for (k = 0; k < (n >> 3); k ++) {
+		__m256i x;
+
+		x = _mm256_loadu_si256((__m256i *)(a + (k << 3)));
+		x = modp_intt_inreg_x8(x, modp_swap1_x8(x), vm1,
+			modp_tw4_x8(&igm[hn + (k << 2)]), pp, p0);
+		x = modp_intt_inreg_x8(x, modp_swap2_x8(x), vm2,
+			modp_tw2_x8(&igm[(hn >> 1) + (k << 1)]), pp, p0);
+		x = modp_intt_inreg_x8(x, modp_swap4_x8(x), vm4,
+			_mm256_set1_epi32((int)igm[(hn >> 2) + k]), pp, p0);
+		_mm256_storeu_si256((__m256i *)(a + (k << 3)), x);
+	}
+
+	t = 8;
+	for (m = n >> 3; m > 1; m >>= 1) {
+		size_t hm, dt, u, j1;
+
+		hm = m >> 1;
+		dt = t << 1;
+		for (u = 0, j1 = 0; u < hm; u ++, j1 += dt) {
+			size_t j, j2;
+			__m256i s;
+
+			s = _mm256_set1_epi32((int)igm[hm + u]);
+			j2 = j1 + t;
+			for (j = j1; j < j2; j += 8) {
+				__m256i x, y;
+
+				x = _mm256_loadu_si256((__m256i *)(a + j));
+				y = _mm256_loadu_si256((__m256i *)(a + j + t));
+				_mm256_storeu_si256((__m256i *)(a + j),
+					modp_add_x8(x, y, pp));
+				_mm256_storeu_si256((__m256i *)(a + j + t),
+					modp_montymul_x8(
+					modp_sub_x8(x, y, pp), s, pp, p0));
+			}
+		}
+		t = dt;
+	}
+
+	sn = _mm256_set1_epi32((int)((uint32_t)1 << (31 - logn)));
+	for (k = 0; k < n; k += 8) {
+		__m256i x;
+
+		x = _mm256_loadu_si256((__m256i *)(a + k));
+		_mm256_storeu_si256((__m256i *)(a + k),
+			modp_montymul_x8(x, sn, pp, p0));
+	}
+}
+
+/*
+ * Apply an AVX2 (i)NTT to elements a[0], a[stride], a[2*stride]...
+ * The elements are copied into a local buffer (4 kB on the stack at
+ * most) so that the transform works on consecutive values.
+ */
+TARGET_AVX2
+static void
+modp_ext_avx2(uint32_t *a, size_t stride, const uint32_t *gm, unsigned logn,
+	uint32_t p, uint32_t p0i,
+	void (*tr)(uint32_t *, const uint32_t *, unsigned, uint32_t, uint32_t))
+{
+	uint32_t buf[1024];
+	size_t n, u;
+
+	n = (size_t)1 << logn;
+	for (u = 0; u < n; u ++) {
+		buf[u] = a[u * stride];
+	}
+	tr(buf, gm, logn, p, p0i);
+	for (u = 0; u < n; u ++) {
+		a[u * stride] = buf[u];
+	}
+}
+
+#endif // yyyAVX2-
+
 /*
  * Compute the roots for NTT and inverse NTT (binary case). Input
  * parameter g is a primitive 2048-th root of 1 modulo p (i.e. g^1024 =
@@ -937,6 +1235,7 @@ static const uint16_t REV10[] = {
  *
  * p must be a prime such that p = 1 mod 2048.
  */
+TARGET_AVX2
 static void
 modp_mkgm2(uint32_t *restrict gm, uint32_t *restrict igm, unsigned logn,
 	uint32_t g, uint32_t p, uint32_t p0i)
@@ -960,7 +1259,66 @@ modp_mkgm2(uint32_t *restrict gm, uint32_t *restrict igm, unsigned logn,
 	ig = modp_div(R2, g, p, p0i, modp_R(p));
 	k = 10 - logn;
 	x1 = x2 = modp_R(p);
-	for (u = 0; u < n; u ++) {
+	u = 0;
+#if FALCON_AVX2 // yyyAVX2+1
+	/*
+	 * gm[8*q+j] = g^(rev(8*q+j)) = g^(rev(q)) * g^(rev3(j)*N/8),
+	 * where rev3() reverses the bits of j (three bits). We first
+	 * build the half-size table of g^(rev(q)) in gm[0..N/8-1] (and
+	 * likewise for igm), then expand each entry into 8 consecutive
+	 * words with a single vector multiplication. Going with
+	 * decreasing q guarantees that each small-table entry is read
+	 * before it gets overwritten. Values are in the 0..p-1 range, so
+	 * they are the same as with the sequential loop below.
+	 */
+	if (logn >= 3) {
+		static const unsigned char rev3[] = { 0, 4, 2, 6, 1, 5, 3, 7 };
+		union {
+			__m256i y;
+			uint32_t w[8];
+		} c1, c2;
+		uint32_t h1[8], h2[8], y1, y2;
+		__m256i pp, p0;
+		size_t q, j;
+
+		for (; u < (n >> 3); u ++) {
+			size_t v;
+
+			v = REV10[u << (k + 3)];
+			gm[v] = x1;
+			igm[v] = x2;
+			x1 = modp_montymul(x1, g, p, p0i);
+			x2 = modp_montymul(x2, ig, p, p0i);
+		}
+
+		/*
+		 * x1 and x2 are now g^(N/8) and 1/g^(N/8).
+		 */
+		h1[0] = h2[0] = modp_R(p);
+		for (j = 1; j < 8; j ++) {
+			h1[j] = modp_montymul(h1[j - 1], x1, p, p0i);
+			h2[j] = modp_montymul(h2[j - 1], x2, p, p0i);
+		}
+		for (j = 0; j < 8; j ++) {
+			c1.w[j] = h1[rev3[j]];
+			c2.w[j] = h2[rev3[j]];
+		}
+		pp = _mm256_set1_epi32((int)p);
+		p0 = _mm256_set1_epi32((int)p0i);
+		for (q = (n >> 3); q -- > 0;) {
+			y1 = gm[q];
+			y2 = igm[q];
+			_mm256_storeu_si256((__m256i *)(gm + (q << 3)),
+				modp_montymul_x8(_mm256_set1_epi32((int)y1),
+				c1.y, pp, p0));
+			_mm256_storeu_si256((__m256i *)(igm + (q << 3)),
+				modp_montymul_x8(_mm256_set1_epi32((int)y2),
+				c2.y, pp, p0));
+		}
+		return;
+	}
+#endif // yyyAVX2-
+	for (; u < n; u ++) {
 		size_t v;
 
 		v = REV10[u << k];
@@ -975,6 +1333,7 @@ modp_mkgm2(uint32_t *restrict gm, uint32_t *restrict igm, unsigned logn,
  * Compute the NTT over a polynomial (binary case). Polynomial elements
  * are a[0], a[stride], a[2 * stride]...
  */
+TARGET_AVX2
 static void
 modp_NTT2_ext(uint32_t *a, size_t stride, const uint32_t *gm, unsigned logn,
 	uint32_t p, uint32_t p0i)
@@ -984,6 +1343,17 @@ modp_NTT2_ext(uint32_t *a, size_t stride, const uint32_t *gm, unsigned logn,
 	if (logn == 0) {
 		return;
 	}
+#if FALCON_AVX2 // yyyAVX2+1
+	if (logn >= 3) {
+		if (stride == 1) {
+			modp_NTT2_avx2(a, gm, logn, p, p0i);
+		} else {
+			modp_ext_avx2(a, stride, gm, logn, p, p0i,
+				&modp_NTT2_avx2);
+		}
+		return;
+	}
+#endif // yyyAVX2-
 	n = (size_t)1 << logn;
 	t = n;
 	for (m = 1; m < n; m <<= 1) {
@@ -1014,6 +1384,7 @@ modp_NTT2_ext(uint32_t *a, size_t stride, const uint32_t *gm, unsigned logn,
 /*
  * Compute the inverse NTT over a polynomial (binary case).
  */
+TARGET_AVX2
 static void
 modp_iNTT2_ext(uint32_t *a, size_t stride, const uint32_t *igm, unsigned logn,
 	uint32_t p, uint32_t p0i)
@@ -1025,6 +1396,17 @@ modp_iNTT2_ext(uint32_t *a, size_t stride, const uint32_t *igm, unsigned logn,
 	if (logn == 0) {
 		return;
 	}
+#if FALCON_AVX2 // yyyAVX2+1
+	if (logn >= 3) {
+		if (stride == 1) {
+			modp_iNTT2_avx2(a, igm, logn, p, p0i);
+		} else {
+			modp_ext_avx2(a, stride, igm, logn, p, p0i,
+				&modp_iNTT2_avx2);
+		}
+		return;
+	}
+#endif // yyyAVX2-
 	n = (size_t)1 << logn;
 	t = 1;
 	for (m = n; m > 1; m >>= 1) {
@@ -1193,6 +1575,7 @@ zint_mul_small(uint32_t *m, size_t mlen, uint32_t x)
  *  p0i = -(1/p) mod 2^31
  *  R2 = 2^62 mod p
  */
+TARGET_AVX2
 static uint32_t
 zint_mod_small_unsigned(const uint32_t *d, size_t dlen,
 	uint32_t p, uint32_t p0i, uint32_t R2)
@@ -1208,6 +1591,41 @@ zint_mod_small_unsigned(const uint32_t *d, size_t dlen,
 	 */
 	x = 0;
 	u = dlen;
+#if FALCON_AVX2 // yyyAVX2+1
+	/*
+	 * For long integers, we first process the top words by blocks
+	 * of 8: lane j accumulates the words at index 8*i+j (relative to
+	 * the lowest processed word), multiplying by 2^(31*8) per block;
+	 * the 8 lanes are then merged like 8 words. The result is the
+	 * same residue as with the plain loop.
+	 */
+	if (dlen >= 16) {
+		__m256i pp, p0, m8, acc;
+		union {
+			__m256i y;
+			uint32_t w[8];
+		} r;
+		int j;
+
+		pp = _mm256_set1_epi32((int)p);
+		p0 = _mm256_set1_epi32((int)p0i);
+		m8 = _mm256_set1_epi32((int)modp_Rx(9, p, p0i, R2));
+		acc = _mm256_setzero_si256();
+		while (u >= 8) {
+			__m256i w;
+
+			u -= 8;
+			w = _mm256_loadu_si256((const __m256i *)(d + u));
+			acc = modp_montymul_x8(acc, m8, pp, p0);
+			acc = modp_add_x8(acc, modp_sub_x8(w, pp, pp), pp);
+		}
+		r.y = acc;
+		for (j = 7; j >= 0; j --) {
+			x = modp_montymul(x, R2, p, p0i);
+			x = modp_add(x, r.w[j], p);
+		}
+	}
+#endif // yyyAVX2-
 	while (u -- > 0) {
 		uint32_t w;
 
@@ -1237,6 +1655,95 @@ zint_mod_small_signed(const uint32_t *d, size_t dlen,
 	return z;
 }
 
+#if FALCON_AVX2 // yyyAVX2+1
+
+/*
+ * zint_mod_small_unsigned() on 8 integers at once: lane i processes
+ * the integer whose words are at d + idx[i] (idx[] contains word
+ * offsets). pp, p0 and r2 contain p, p0i and R2 in all lanes.
+ */
+TARGET_AVX2
+static inline __m256i
+zint_mod_small_unsigned_x8(const uint32_t *d, size_t dlen, __m256i idx,
+	__m256i pp, __m256i p0, __m256i r2)
+{
+	__m256i x;
+	size_t u;
+
+	x = _mm256_setzero_si256();
+	u = dlen;
+	while (u -- > 0) {
+		__m256i w;
+
+		w = _mm256_i32gather_epi32((const int *)(d + u), idx, 4);
+		x = modp_montymul_x8(x, r2, pp, p0);
+		x = modp_add_x8(x, modp_sub_x8(w, pp, pp), pp);
+	}
+	return x;
+}
+
+#endif // yyyAVX2-
+
+/*
+ * Apply zint_mod_small_signed() to num integers of dlen words each,
+ * located at d, d + dstride, d + 2*dstride...; the results are written
+ * in x[0], x[xstride], x[2*xstride]...
+ */
+TARGET_AVX2
+static void
+zint_mod_small_signed_ext(uint32_t *x, size_t xstride,
+	const uint32_t *d, size_t dlen, size_t dstride, size_t num,
+	uint32_t p, uint32_t p0i, uint32_t R2, uint32_t Rx)
+{
+	size_t v;
+
+	v = 0;
+#if FALCON_AVX2 // yyyAVX2+1
+	if (dlen > 0 && dstride <= 0x0FFFFFFF) {
+		__m256i idx, pp, p0, r2, rx;
+
+		idx = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+			_mm256_set1_epi32((int)dstride));
+		pp = _mm256_set1_epi32((int)p);
+		p0 = _mm256_set1_epi32((int)p0i);
+		r2 = _mm256_set1_epi32((int)R2);
+		rx = _mm256_set1_epi32((int)Rx);
+		for (; v + 8 <= num; v += 8) {
+			const uint32_t *dv;
+			__m256i z, t;
+			union {
+				__m256i y;
+				uint32_t w[8];
+			} r;
+			size_t k;
+
+			/*
+			 * Subtract 2^(31*dlen) for negative integers (bit 30
+			 * of the top word is their sign bit).
+			 */
+			dv = d + v * dstride;
+			z = zint_mod_small_unsigned_x8(dv, dlen, idx, pp, p0, r2);
+			t = _mm256_i32gather_epi32(
+				(const int *)(dv + dlen - 1), idx, 4);
+			t = _mm256_srai_epi32(_mm256_slli_epi32(t, 1), 31);
+			z = modp_sub_x8(z, _mm256_and_si256(rx, t), pp);
+			if (xstride == 1) {
+				_mm256_storeu_si256((__m256i *)(x + v), z);
+			} else {
+				r.y = z;
+				for (k = 0; k < 8; k ++) {
+					x[(v + k) * xstride] = r.w[k];
+				}
+			}
+		}
+	}
+#endif // yyyAVX2-
+	for (; v < num; v ++) {
+		x[v * xstride] = zint_mod_small_signed(
+			d + v * dstride, dlen, p, p0i, R2, Rx);
+	}
+}
+
 /*
  * Add y*s to x. x and y initially have length 'len' words; the new x
  * has length 'len+1' words. 's' must fit on 31 bits. x[] and y[] must
@@ -1315,6 +1822,104 @@ zint_norm_zero(uint32_t *restrict x, const uint32_t *restrict p, size_t len)
 	zint_sub(x, p, len, r >> 31);
 }
 
+#if FALCON_AVX2 // yyyAVX2+1
+
+/*
+ * Maximum integer length for zint_rebuild_CRT_x8().
+ */
+#define CRT_AVX2_MAXLEN   128
+
+/*
+ * zint_rebuild_CRT() (without the final normalization) on 8 integers
+ * with AVX2; xlen <= CRT_AVX2_MAXLEN. The integers are first copied into
+ * a local buffer, word-major (word k of integer i at buf[8*k+i]), so
+ * that each step works on 8 integers with plain vector loads and stores.
+ * On output, tmp[] contains the product of the xlen primes.
+ */
+TARGET_AVX2
+static void
+zint_rebuild_CRT_x8(uint32_t *restrict xx, size_t xlen, size_t xstride,
+	const small_prime *primes, uint32_t *restrict tmp)
+{
+	uint32_t buf[CRT_AVX2_MAXLEN * 8];
+	__m256i m31;
+	size_t u, k;
+
+	for (k = 0; k < xlen; k ++) {
+		for (u = 0; u < 8; u ++) {
+			buf[(k << 3) + u] = xx[u * xstride + k];
+		}
+	}
+
+	m31 = _mm256_set1_epi64x(0x7FFFFFFF);
+	tmp[0] = primes[0].p;
+	for (u = 1; u < xlen; u ++) {
+		uint32_t p, p0i, R2;
+		__m256i pp, p0, r2, xq, xr, xro, cce, cco;
+
+		p = primes[u].p;
+		p0i = modp_ninv31(p);
+		R2 = modp_R2(p, p0i);
+		pp = _mm256_set1_epi32((int)p);
+		p0 = _mm256_set1_epi32((int)p0i);
+		r2 = _mm256_set1_epi32((int)R2);
+
+		/*
+		 * xq = (x mod q) mod p, then xr = s * (xp - xq) mod p,
+		 * as in zint_rebuild_CRT().
+		 */
+		xq = _mm256_setzero_si256();
+		k = u;
+		while (k -- > 0) {
+			__m256i w;
+
+			w = _mm256_loadu_si256((__m256i *)(buf + (k << 3)));
+			xq = modp_montymul_x8(xq, r2, pp, p0);
+			xq = modp_add_x8(xq, modp_sub_x8(w, pp, pp), pp);
+		}
+		xr = _mm256_loadu_si256((__m256i *)(buf + (u << 3)));
+		xr = modp_montymul_x8(_mm256_set1_epi32((int)primes[u].s),
+			modp_sub_x8(xr, xq, pp), pp, p0);
+
+		/*
+		 * x <- x + q*xr (zint_add_mul_small()), with even and odd
+		 * lanes in separate 64-bit accumulators.
+		 */
+		xro = _mm256_srli_epi64(xr, 32);
+		cce = _mm256_setzero_si256();
+		cco = _mm256_setzero_si256();
+		for (k = 0; k < u; k ++) {
+			__m256i t, w, ze, zo;
+
+			t = _mm256_set1_epi32((int)tmp[k]);
+			w = _mm256_loadu_si256((__m256i *)(buf + (k << 3)));
+			ze = _mm256_add_epi64(_mm256_mul_epu32(t, xr),
+				_mm256_add_epi64(_mm256_and_si256(w,
+				_mm256_set1_epi64x(0xFFFFFFFF)), cce));
+			zo = _mm256_add_epi64(_mm256_mul_epu32(t, xro),
+				_mm256_add_epi64(_mm256_srli_epi64(w, 32), cco));
+			cce = _mm256_srli_epi64(ze, 31);
+			cco = _mm256_srli_epi64(zo, 31);
+			w = _mm256_blend_epi32(_mm256_and_si256(ze, m31),
+				_mm256_slli_epi64(_mm256_and_si256(zo, m31), 32),
+				0xAA);
+			_mm256_storeu_si256((__m256i *)(buf + (k << 3)), w);
+		}
+		_mm256_storeu_si256((__m256i *)(buf + (u << 3)),
+			_mm256_blend_epi32(cce, _mm256_slli_epi64(cco, 32), 0xAA));
+
+		tmp[u] = zint_mul_small(tmp, u, p);
+	}
+
+	for (k = 0; k < xlen; k ++) {
+		for (u = 0; u < 8; u ++) {
+			xx[u * xstride + k] = buf[(k << 3) + u];
+		}
+	}
+}
+
+#endif // yyyAVX2-
+
 /*
  * Rebuild integers from their RNS representation. There are 'num'
  * integers, and each consists in 'xlen' words. 'xx' points at that
@@ -1334,49 +1939,69 @@ zint_rebuild_CRT(uint32_t *restrict xx, size_t xlen, size_t xstride,
 	size_t num, const small_prime *primes, int normalize_signed,
 	uint32_t *restrict tmp)
 {
-	size_t u;
+	size_t u, v0;
 	uint32_t *x;
 
-	tmp[0] = primes[0].p;
-	for (u = 1; u < xlen; u ++) {
-		/*
-		 * At the entry of each loop iteration:
-		 *  - the first u words of each array have been
-		 *    reassembled;
-		 *  - the first u words of tmp[] contains the
-		 * product of the prime moduli processed so far.
-		 *
-		 * We call 'q' the product of all previous primes.
-		 */
-		uint32_t p, p0i, s, R2;
-		size_t v;
-
-		p = primes[u].p;
-		s = primes[u].s;
-		p0i = modp_ninv31(p);
-		R2 = modp_R2(p, p0i);
+	v0 = 0;
+#if FALCON_AVX2 // yyyAVX2+1
+	if (xlen <= CRT_AVX2_MAXLEN) {
+		for (; v0 + 8 <= num; v0 += 8) {
+			zint_rebuild_CRT_x8(xx + v0 * xstride, xlen, xstride,
+				primes, tmp);
+		}
+	}
+#endif // yyyAVX2-
 
-		for (v = 0, x = xx; v < num; v ++, x += xstride) {
-			uint32_t xp, xq, xr;
+	/*
+	 * Remaining integers. If all were processed above, then tmp[]
+	 * already contains the product of the primes.
+	 */
+	if (v0 == 0 || v0 < num) {
+		tmp[0] = primes[0].p;
+		for (u = 1; u < xlen; u ++) {
 			/*
-			 * xp = the integer x modulo the prime p for this
-			 *      iteration
-			 * xq = (x mod q) mod p
+			 * At the entry of each loop iteration:
+			 *  - the first u words of each array have been
+			 *    reassembled;
+			 *  - the first u words of tmp[] contains the
+			 * product of the prime moduli processed so far.
+			 *
+			 * We call 'q' the product of all previous primes.
 			 */
-			xp = x[u];
-			xq = zint_mod_small_unsigned(x, u, p, p0i, R2);
+			uint32_t p, p0i, s, R2;
+			size_t v;
+
+			p = primes[u].p;
+			s = primes[u].s;
+			p0i = modp_ninv31(p);
+			R2 = modp_R2(p, p0i);
+
+			for (v = v0, x = xx + v0 * xstride;
+				v < num; v ++, x += xstride)
+			{
+				uint32_t xp, xq, xr;
+				/*
+				 * xp = the integer x modulo the prime p for
+				 *      this iteration
+				 * xq = (x mod q) mod p
+				 */
+				xp = x[u];
+				xq = zint_mod_small_unsigned(x, u, p, p0i, R2);
+
+				/*
+				 * New value is
+				 *   (x mod q) + q * (s * (xp - xq) mod p)
+				 */
+				xr = modp_montymul(s,
+					modp_sub(xp, xq, p), p, p0i);
+				zint_add_mul_small(x, tmp, u, xr);
+			}
 
 			/*
-			 * New value is (x mod q) + q * (s * (xp - xq) mod p)
+			 * Update product of primes in tmp[].
 			 */
-			xr = modp_montymul(s, modp_sub(xp, xq, p), p, p0i);
-			zint_add_mul_small(x, tmp, u, xr);
+			tmp[u] = zint_mul_small(tmp, u, p);
 		}
-
-		/*
-		 * Update product of primes in tmp[].
-		 */
-		tmp[u] = zint_mul_small(tmp, u, p);
 	}
 
 	/*
@@ -1389,42 +2014,274 @@ zint_rebuild_CRT(uint32_t *restrict xx, size_t xlen, size_t xstride,
 	}
 }
 
+/* ==================================================================== */
 /*
- * Negate a big integer conditionally: value a is replaced with -a if
- * and only if ctl = 1. Control value ctl must be 0 or 1.
+ * Worker threads for key pair generation (see Zf(keygen_mt)()).
+ *
+ * Most of the work of solve_NTRU() is done separately for each small
+ * prime, or for each integer when rebuilding values with the CRT. Such
+ * a loop is written as a task over an index range; kg_run() splits the
+ * range into contiguous slices, one per thread, the calling thread
+ * taking the first slice. Slices write disjoint RNS columns or
+ * integers, so the result does not depend on the number of threads.
+ *
+ * Each thread has its own scratch area: the calling thread uses the
+ * area of the serial code, and worker i uses the i-th area of the pool
+ * (KEYGEN_MT_WORDS(logn) words, enough for every task). Tasks compute
+ * on integers only, so the workers need not share the floating-point
+ * setup of the calling thread.
  */
-static void
-zint_negate(uint32_t *a, size_t len, uint32_t ctl)
-{
-	size_t u;
-	uint32_t cc, m;
 
-	/*
-	 * If ctl = 1 then we flip the bits of a by XORing with
-	 * 0x7FFFFFFF, and we add 1 to the value. If ctl = 0 then we XOR
-	 * with 0 and add 0, which leaves the value unchanged.
-	 */
-	cc = ctl;
-	m = -ctl >> 1;
-	for (u = 0; u < len; u ++) {
-		uint32_t aw;
+typedef void (*kg_task)(void *ctx, size_t start, size_t end,
+	uint32_t *scratch);
 
-		aw = a[u];
-		aw = (aw ^ m) + cc;
-		a[u] = aw & 0x7FFFFFFF;
-		cc = aw >> 31;
-	}
-}
+typedef struct kg_pool_ kg_pool;
 
-/*
- * Replace a with (a*xa+b*xb)/(2^31) and b with (a*ya+b*yb)/(2^31).
- * The low bits are dropped (the caller should compute the coefficients
- * such that these dropped bits are all zeros). If either or both
- * yields a negative value, then the value is negated.
- *
- * Returned value is:
- *  0  both values were positive
- *  1  new a had to be negated
+#if FALCON_KEYGEN_MT
+
+typedef struct {
+	kg_pool *pool;
+	unsigned index;
+} kg_worker;
+
+struct kg_pool_ {
+	unsigned nthreads;
+	uint32_t *scratch;
+	size_t scratch_len;
+	pthread_mutex_t lock;
+	pthread_cond_t wake, done;
+	unsigned round, busy;
+	int stop;
+	kg_task task;
+	void *ctx;
+	size_t count;
+	pthread_t tid[KEYGEN_MAX_THREADS];
+	kg_worker workers[KEYGEN_MAX_THREADS];
+};
+
+static void *
+kg_worker_main(void *arg)
+{
+	kg_worker *w;
+	kg_pool *pool;
+	unsigned seen;
+
+	w = arg;
+	pool = w->pool;
+	seen = 0;
+	pthread_mutex_lock(&pool->lock);
+	for (;;) {
+		kg_task task;
+		void *ctx;
+		size_t count, start, end;
+
+		while (pool->round == seen && !pool->stop) {
+			pthread_cond_wait(&pool->wake, &pool->lock);
+		}
+		if (pool->stop) {
+			break;
+		}
+		seen = pool->round;
+		task = pool->task;
+		ctx = pool->ctx;
+		count = pool->count;
+		pthread_mutex_unlock(&pool->lock);
+
+		start = count * w->index / pool->nthreads;
+		end = count * (w->index + 1) / pool->nthreads;
+		if (start < end) {
+			task(ctx, start, end, pool->scratch
+				+ (size_t)(w->index - 1) * pool->scratch_len);
+		}
+
+		pthread_mutex_lock(&pool->lock);
+		if (-- pool->busy == 0) {
+			pthread_cond_signal(&pool->done);
+		}
+	}
+	pthread_mutex_unlock(&pool->lock);
+	return NULL;
+}
+
+/*
+ * Start nthreads-1 workers. If a thread cannot be created, the pool
+ * keeps the workers started so far.
+ */
+static void
+kg_pool_start(kg_pool *pool, unsigned nthreads,
+	uint32_t *scratch, size_t scratch_len)
+{
+	unsigned u;
+
+	if (nthreads > KEYGEN_MAX_THREADS) {
+		nthreads = KEYGEN_MAX_THREADS;
+	}
+	pool->scratch = scratch;
+	pool->scratch_len = scratch_len;
+	pool->round = 0;
+	pool->busy = 0;
+	pool->stop = 0;
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->wake, NULL);
+	pthread_cond_init(&pool->done, NULL);
+	for (u = 1; u < nthreads; u ++) {
+		pool->workers[u].pool = pool;
+		pool->workers[u].index = u;
+		if (pthread_create(&pool->tid[u], NULL,
+			kg_worker_main, &pool->workers[u]) != 0)
+		{
+			break;
+		}
+	}
+	pool->nthreads = u;
+}
+
+static void
+kg_pool_stop(kg_pool *pool)
+{
+	unsigned u;
+
+	pthread_mutex_lock(&pool->lock);
+	pool->stop = 1;
+	pthread_cond_broadcast(&pool->wake);
+	pthread_mutex_unlock(&pool->lock);
+	for (u = 1; u < pool->nthreads; u ++) {
+		pthread_join(pool->tid[u], NULL);
+	}
+	pthread_cond_destroy(&pool->done);
+	pthread_cond_destroy(&pool->wake);
+	pthread_mutex_destroy(&pool->lock);
+}
+
+#else
+
+struct kg_pool_ {
+	unsigned nthreads;
+};
+
+static void
+kg_pool_start(kg_pool *pool, unsigned nthreads,
+	uint32_t *scratch, size_t scratch_len)
+{
+	(void)nthreads;
+	(void)scratch;
+	(void)scratch_len;
+	pool->nthreads = 1;
+}
+
+static void
+kg_pool_stop(kg_pool *pool)
+{
+	(void)pool;
+}
+
+#endif
+
+/*
+ * Run task over indices 0 to count-1. With no pool (NULL) or a single
+ * thread, this is a plain call. scratch0[] is the scratch area of the
+ * calling thread.
+ */
+static void
+kg_run(kg_pool *pool, kg_task task, void *ctx, size_t count,
+	uint32_t *scratch0)
+{
+#if FALCON_KEYGEN_MT
+	if (pool != NULL && pool->nthreads > 1 && count > 1) {
+		pthread_mutex_lock(&pool->lock);
+		pool->task = task;
+		pool->ctx = ctx;
+		pool->count = count;
+		pool->busy = pool->nthreads - 1;
+		pool->round ++;
+		pthread_cond_broadcast(&pool->wake);
+		pthread_mutex_unlock(&pool->lock);
+
+		task(ctx, 0, count / pool->nthreads, scratch0);
+
+		pthread_mutex_lock(&pool->lock);
+		while (pool->busy > 0) {
+			pthread_cond_wait(&pool->done, &pool->lock);
+		}
+		pthread_mutex_unlock(&pool->lock);
+		return;
+	}
+#else
+	(void)pool;
+#endif
+	task(ctx, 0, count, scratch0);
+}
+
+typedef struct {
+	uint32_t *xx;
+	size_t xlen, xstride;
+	int normalize_signed;
+} rebuild_CRT_ctx;
+
+static void
+rebuild_CRT_task(void *ctx, size_t start, size_t end, uint32_t *scratch)
+{
+	rebuild_CRT_ctx *c;
+
+	c = ctx;
+	zint_rebuild_CRT(c->xx + start * c->xstride, c->xlen, c->xstride,
+		end - start, PRIMES, c->normalize_signed, scratch);
+}
+
+/*
+ * zint_rebuild_CRT() with the standard primes, the integers being split
+ * between the pool threads. tmp[] is the scratch area of the calling
+ * thread (xlen words).
+ */
+static void
+zint_rebuild_CRT_mt(kg_pool *pool, uint32_t *xx, size_t xlen,
+	size_t xstride, size_t num, int normalize_signed, uint32_t *tmp)
+{
+	rebuild_CRT_ctx c;
+
+	c.xx = xx;
+	c.xlen = xlen;
+	c.xstride = xstride;
+	c.normalize_signed = normalize_signed;
+	kg_run(pool, &rebuild_CRT_task, &c, num, tmp);
+}
+
+/*
+ * Negate a big integer conditionally: value a is replaced with -a if
+ * and only if ctl = 1. Control value ctl must be 0 or 1.
+ */
+static void
+zint_negate(uint32_t *a, size_t len, uint32_t ctl)
+{
+	size_t u;
+	uint32_t cc, m;
+
+	/*
+	 * If ctl = 1 then we flip the bits of a by XORing with
+	 * 0x7FFFFFFF, and we add 1 to the value. If ctl = 0 then we XOR
+	 * with 0 and add 0, which leaves the value unchanged.
+	 */
+	cc = ctl;
+	m = -ctl >> 1;
+	for (u = 0; u < len; u ++) {
+		uint32_t aw;
+
+		aw = a[u];
+		aw = (aw ^ m) + cc;
+		a[u] = aw & 0x7FFFFFFF;
+		cc = aw >> 31;
+	}
+}
+
+/*
+ * Replace a with (a*xa+b*xb)/(2^31) and b with (a*ya+b*yb)/(2^31).
+ * The low bits are dropped (the caller should compute the coefficients
+ * such that these dropped bits are all zeros). If either or both
+ * yields a negative value, then the value is negated.
+ *
+ * Returned value is:
+ *  0  both values were positive
+ *  1  new a had to be negated
  *  2  new b had to be negated
  *  3  both new a and new b had to be negated
  *
@@ -2093,6 +2950,138 @@ poly_big_to_small(int8_t *d, const uint32_t *s, int lim, unsigned logn)
 	return 1;
 }
 
+#if FALCON_AVX2 // yyyAVX2+1
+
+/*
+ * Maximum length of f for poly_sub_scaled_avx2(); the intermediate
+ * levels where poly_sub_scaled() is used have at most 106 words.
+ */
+#define SUB_SCALED_AVX2_MAXLEN   126
+
+/*
+ * poly_sub_scaled() with AVX2 (flen <= SUB_SCALED_AVX2_MAXLEN). For
+ * each coefficient of F, the sum c of the n products of a coefficient of
+ * k by a coefficient of f is first computed exactly, then c*2^sc is
+ * subtracted with zint_sub_scaled(). Each multiplier m of the sum is
+ * split into a low unsigned half ml and a high signed half mh (16 bits
+ * each); for every word index j, the products ml*f[j] and mh*f[j] are
+ * accumulated, four words at a time, in 64-bit lanes (n <= 32 products
+ * of at most 47 bits each cannot overflow). The accumulated values are
+ * then carried into 31-bit words. The result is the same as with the
+ * word-by-word loop, since both compute F - k*f*2^sc modulo 2^(31*Flen).
+ */
+TARGET_AVX2
+static void
+poly_sub_scaled_avx2(uint32_t *restrict F, size_t Flen, size_t Fstride,
+	const uint32_t *restrict f, size_t flen, size_t fstride,
+	const int32_t *restrict k, uint32_t sch, uint32_t scl, unsigned logn)
+{
+	int64_t al[SUB_SCALED_AVX2_MAXLEN + 2];
+	int64_t ah[SUB_SCALED_AVX2_MAXLEN + 2];
+	int32_t ml[32], mh[32];
+	uint32_t c[SUB_SCALED_AVX2_MAXLEN + 2];
+	size_t n, r, j, jv;
+
+	n = MKN(logn);
+	jv = flen & ~(size_t)7;
+	for (r = 0; r < n; r ++) {
+		size_t v;
+		int64_t cc;
+
+		/*
+		 * The coefficient r of k*f receives k[r-v]*f[v] if v <= r,
+		 * and -k[r-v+n]*f[v] otherwise (X^N = -1).
+		 */
+		for (v = 0; v < n; v ++) {
+			int32_t m;
+
+			if (v <= r) {
+				m = k[r - v];
+			} else {
+				m = -k[r - v + n];
+			}
+			ml[v] = (int32_t)((uint32_t)m & 0xFFFF);
+			mh[v] = (int32_t)(((int64_t)m - ml[v]) / 65536);
+		}
+
+		/*
+		 * Accumulate 8 words at a time, in registers.
+		 */
+		for (j = 0; j < jv; j += 8) {
+			__m256i l0, l1, h0, h1;
+
+			l0 = _mm256_setzero_si256();
+			l1 = _mm256_setzero_si256();
+			h0 = _mm256_setzero_si256();
+			h1 = _mm256_setzero_si256();
+			for (v = 0; v < n; v ++) {
+				const uint32_t *y;
+				__m256i vl, vh, w0, w1;
+
+				y = f + v * fstride + j;
+				vl = _mm256_set1_epi32(ml[v]);
+				vh = _mm256_set1_epi32(mh[v]);
+				w0 = _mm256_cvtepu32_epi64(
+					_mm_loadu_si128((const __m128i *)y));
+				w1 = _mm256_cvtepu32_epi64(
+					_mm_loadu_si128((const __m128i *)(y + 4)));
+				l0 = _mm256_add_epi64(l0, _mm256_mul_epi32(w0, vl));
+				l1 = _mm256_add_epi64(l1, _mm256_mul_epi32(w1, vl));
+				h0 = _mm256_add_epi64(h0, _mm256_mul_epi32(w0, vh));
+				h1 = _mm256_add_epi64(h1, _mm256_mul_epi32(w1, vh));
+			}
+			_mm256_storeu_si256((__m256i *)(al + j), l0);
+			_mm256_storeu_si256((__m256i *)(al + j + 4), l1);
+			_mm256_storeu_si256((__m256i *)(ah + j), h0);
+			_mm256_storeu_si256((__m256i *)(ah + j + 4), h1);
+		}
+		for (; j <= flen; j ++) {
+			al[j] = 0;
+			ah[j] = 0;
+		}
+		for (v = 0; v < n; v ++) {
+			const uint32_t *y;
+
+			y = f + v * fstride;
+			for (j = jv; j < flen; j ++) {
+				al[j] += (int64_t)ml[v] * (int64_t)y[j];
+				ah[j] += (int64_t)mh[v] * (int64_t)y[j];
+			}
+
+			/*
+			 * Negative f[v] is f[v] - 2^(31*flen) when its words
+			 * are read as unsigned.
+			 */
+			if ((y[flen - 1] >> 30) != 0) {
+				al[flen] -= ml[v];
+				ah[flen] -= mh[v];
+			}
+		}
+
+		/*
+		 * The sum is al + ah*2^16; ah[j]*2^16 is split into its
+		 * low 15 bits (shifted) for word j, and the rest for word
+		 * j+1. Result c has flen+2 words, in two's complement.
+		 */
+		cc = 0;
+		for (j = 0; j <= flen; j ++) {
+			int64_t t;
+
+			t = al[j] + ((ah[j] & 0x7FFF) << 16) + cc;
+			if (j > 0) {
+				t += ah[j - 1] >> 15;
+			}
+			c[j] = (uint32_t)t & 0x7FFFFFFF;
+			cc = t >> 31;
+		}
+		c[flen + 1] = (uint32_t)((ah[flen] >> 15) + cc) & 0x7FFFFFFF;
+
+		zint_sub_scaled(F + r * Fstride, Flen, c, flen + 2, sch, scl);
+	}
+}
+
+#endif // yyyAVX2-
+
 /*
  * Subtract k*f from F, where F, f and k are polynomials modulo X^N+1.
  * Coefficients of polynomial k are small integers (signed values in the
@@ -2110,6 +3099,13 @@ poly_sub_scaled(uint32_t *restrict F, size_t Flen, size_t Fstride,
 {
 	size_t n, u;
 
+#if FALCON_AVX2 // yyyAVX2+1
+	if (flen > 0 && flen <= SUB_SCALED_AVX2_MAXLEN && logn <= 5) {
+		poly_sub_scaled_avx2(F, Flen, Fstride,
+			f, flen, fstride, k, sch, scl, logn);
+		return;
+	}
+#endif // yyyAVX2-
 	n = MKN(logn);
 	for (u = 0; u < n; u ++) {
 		int32_t kf;
@@ -2134,66 +3130,99 @@ poly_sub_scaled(uint32_t *restrict F, size_t Flen, size_t Fstride,
 	}
 }
 
+typedef struct {
+	const uint32_t *f;
+	size_t flen, fstride;
+	const int32_t *k;
+	uint32_t *fk;
+	unsigned logn;
+} sub_scaled_ntt_ctx;
+
 /*
- * Subtract k*f from F. Coefficients of polynomial k are small integers
- * (signed values in the -2^31..2^31 range) scaled by 2^sc. This function
- * assumes that the degree is large, and integers relatively small.
- * The value sc is provided as sch = sc / 31 and scl = sc % 31.
+ * Compute k*f modulo the primes of index start to end-1, for
+ * poly_sub_scaled_ntt().
  */
 static void
-poly_sub_scaled_ntt(uint32_t *restrict F, size_t Flen, size_t Fstride,
-	const uint32_t *restrict f, size_t flen, size_t fstride,
-	const int32_t *restrict k, uint32_t sch, uint32_t scl, unsigned logn,
-	uint32_t *restrict tmp)
+sub_scaled_ntt_task(void *ctx, size_t start, size_t end, uint32_t *scratch)
 {
-	uint32_t *gm, *igm, *fk, *t1, *x;
-	const uint32_t *y;
+	sub_scaled_ntt_ctx *c;
+	uint32_t *gm, *igm, *t1, *x;
 	size_t n, u, tlen;
+	unsigned logn;
 	const small_prime *primes;
 
+	c = ctx;
+	logn = c->logn;
 	n = MKN(logn);
-	tlen = flen + 1;
-	gm = tmp;
+	tlen = c->flen + 1;
+	gm = scratch;
 	igm = gm + MKN(logn);
-	fk = igm + MKN(logn);
-	t1 = fk + n * tlen;
+	t1 = igm + MKN(logn);
 
 	primes = PRIMES;
 
-	/*
-	 * Compute k*f in fk[], in RNS notation.
-	 */
-	for (u = 0; u < tlen; u ++) {
+	for (u = start; u < end; u ++) {
 		uint32_t p, p0i, R2, Rx;
 		size_t v;
 
 		p = primes[u].p;
 		p0i = modp_ninv31(p);
 		R2 = modp_R2(p, p0i);
-		Rx = modp_Rx((unsigned)flen, p, p0i, R2);
+		Rx = modp_Rx((unsigned)c->flen, p, p0i, R2);
 		modp_mkgm2(gm, igm, logn, primes[u].g, p, p0i);
 
 		for (v = 0; v < n; v ++) {
-			t1[v] = modp_set(k[v], p);
+			t1[v] = modp_set(c->k[v], p);
 		}
 		modp_NTT2(t1, gm, logn, p, p0i);
-		for (v = 0, y = f, x = fk + u;
-			v < n; v ++, y += fstride, x += tlen)
-		{
-			*x = zint_mod_small_signed(y, flen, p, p0i, R2, Rx);
-		}
-		modp_NTT2_ext(fk + u, tlen, gm, logn, p, p0i);
-		for (v = 0, x = fk + u; v < n; v ++, x += tlen) {
+		zint_mod_small_signed_ext(c->fk + u, tlen,
+			c->f, c->flen, c->fstride, n, p, p0i, R2, Rx);
+		modp_NTT2_ext(c->fk + u, tlen, gm, logn, p, p0i);
+		for (v = 0, x = c->fk + u; v < n; v ++, x += tlen) {
 			*x = modp_montymul(
 				modp_montymul(t1[v], *x, p, p0i), R2, p, p0i);
 		}
-		modp_iNTT2_ext(fk + u, tlen, igm, logn, p, p0i);
+		modp_iNTT2_ext(c->fk + u, tlen, igm, logn, p, p0i);
 	}
+}
+
+/*
+ * Subtract k*f from F. Coefficients of polynomial k are small integers
+ * (signed values in the -2^31..2^31 range) scaled by 2^sc. This function
+ * assumes that the degree is large, and integers relatively small.
+ * The value sc is provided as sch = sc / 31 and scl = sc % 31.
+ */
+static void
+poly_sub_scaled_ntt(uint32_t *restrict F, size_t Flen, size_t Fstride,
+	const uint32_t *restrict f, size_t flen, size_t fstride,
+	const int32_t *restrict k, uint32_t sch, uint32_t scl, unsigned logn,
+	uint32_t *restrict tmp, kg_pool *pool)
+{
+	sub_scaled_ntt_ctx c;
+	uint32_t *fk, *t1, *x;
+	const uint32_t *y;
+	size_t n, u, tlen;
+
+	n = MKN(logn);
+	tlen = flen + 1;
+	fk = tmp;
+	t1 = fk + n * tlen;
+
+	/*
+	 * Compute k*f in fk[], in RNS notation.
+	 */
+	c.f = f;
+	c.flen = flen;
+	c.fstride = fstride;
+	c.k = k;
+	c.fk = fk;
+	c.logn = logn;
+	kg_run(pool, &sub_scaled_ntt_task, &c, tlen, t1);
 
 	/*
 	 * Rebuild k*f.
 	 */
-	zint_rebuild_CRT(fk, tlen, tlen, n, primes, 1, t1);
+	zint_rebuild_CRT_mt(pool, fk, tlen, tlen, n, 1, t1);
 
 	/*
 	 * Subtract k*f, scaled, from F.
@@ -2524,46 +3553,44 @@ poly_small_to_fp(fpr *x, const int8_t *f, unsigned logn)
 	}
 }
 
+typedef struct {
+	uint32_t *fd, *gd, *fs, *gs;
+	size_t slen, tlen;
+	unsigned logn;
+	int in_ntt, out_ntt;
+} make_fg_step_ctx;
+
 /*
- * Input: f,g of degree N = 2^logn; 'depth' is used only to get their
- * individual length.
- *
- * Output: f',g' of degree N/2, with the length for 'depth+1'.
- *
- * Values are in RNS; input and/or output may also be in NTT.
+ * First slen primes of make_fg_step(), indices start to end-1: we use
+ * the input values directly, and apply inverse NTT as we go.
  */
 static void
-make_fg_step(uint32_t *data, unsigned logn, unsigned depth,
-	int in_ntt, int out_ntt)
+make_fg_step_rns_task(void *ctx, size_t start, size_t end,
+	uint32_t *scratch)
 {
+	make_fg_step_ctx *c;
 	size_t n, hn, u;
 	size_t slen, tlen;
 	uint32_t *fd, *gd, *fs, *gs, *gm, *igm, *t1;
+	unsigned logn;
 	const small_prime *primes;
 
+	c = ctx;
+	logn = c->logn;
 	n = (size_t)1 << logn;
 	hn = n >> 1;
-	slen = MAX_BL_SMALL[depth];
-	tlen = MAX_BL_SMALL[depth + 1];
-	primes = PRIMES;
-
-	/*
-	 * Prepare room for the result.
-	 */
-	fd = data;
-	gd = fd + hn * tlen;
-	fs = gd + hn * tlen;
-	gs = fs + n * slen;
-	gm = gs + n * slen;
+	slen = c->slen;
+	tlen = c->tlen;
+	fd = c->fd;
+	gd = c->gd;
+	fs = c->fs;
+	gs = c->gs;
+	gm = scratch;
 	igm = gm + n;
 	t1 = igm + n;
-	memmove(fs, data, 2 * n * slen * sizeof *data);
+	primes = PRIMES;
 
-	/*
-	 * First slen words: we use the input values directly, and apply
-	 * inverse NTT as we go.
-	 */
-	for (u = 0; u < slen; u ++) {
+	for (u = start; u < end; u ++) {
 		uint32_t p, p0i, R2;
 		size_t v;
 		uint32_t *x;
@@ -2576,7 +3603,7 @@ make_fg_step(uint32_t *data, unsigned logn, unsigned depth,
 		for (v = 0, x = fs + u; v < n; v ++, x += slen) {
 			t1[v] = *x;
 		}
-		if (!in_ntt) {
+		if (!c->in_ntt) {
 			modp_NTT2(t1, gm, logn, p, p0i);
 		}
 		for (v = 0, x = fd + u; v < hn; v ++, x += tlen) {
@@ -2587,14 +3614,14 @@ make_fg_step(uint32_t *data, unsigned logn, unsigned depth,
 			*x = modp_montymul(
 				modp_montymul(w0, w1, p, p0i), R2, p, p0i);
 		}
-		if (in_ntt) {
+		if (c->in_ntt) {
 			modp_iNTT2_ext(fs + u, slen, igm, logn, p, p0i);
 		}
 
 		for (v = 0, x = gs + u; v < n; v ++, x += slen) {
 			t1[v] = *x;
 		}
-		if (!in_ntt) {
+		if (!c->in_ntt) {
 			modp_NTT2(t1, gm, logn, p, p0i);
 		}
 		for (v = 0, x = gd + u; v < hn; v ++, x += tlen) {
@@ -2605,27 +3632,48 @@ make_fg_step(uint32_t *data, unsigned logn, unsigned depth,
 			*x = modp_montymul(
 				modp_montymul(w0, w1, p, p0i), R2, p, p0i);
 		}
-		if (in_ntt) {
+		if (c->in_ntt) {
 			modp_iNTT2_ext(gs + u, slen, igm, logn, p, p0i);
 		}
 
-		if (!out_ntt) {
+		if (!c->out_ntt) {
 			modp_iNTT2_ext(fd + u, tlen, igm, logn - 1, p, p0i);
 			modp_iNTT2_ext(gd + u, tlen, igm, logn - 1, p, p0i);
 		}
 	}
+}
 
-	/*
-	 * Since the fs and gs words have been de-NTTized, we can use the
-	 * CRT to rebuild the values.
-	 */
-	zint_rebuild_CRT(fs, slen, slen, n, primes, 1, gm);
-	zint_rebuild_CRT(gs, slen, slen, n, primes, 1, gm);
+/*
+ * Remaining primes of make_fg_step(), indices slen+start to slen+end-1:
+ * we use modular reductions to extract the values.
+ */
+static void
+make_fg_step_mod_task(void *ctx, size_t start, size_t end,
+	uint32_t *scratch)
+{
+	make_fg_step_ctx *c;
+	size_t n, hn, u;
+	size_t slen, tlen;
+	uint32_t *fd, *gd, *fs, *gs, *gm, *igm, *t1;
+	unsigned logn;
+	const small_prime *primes;
 
-	/*
-	 * Remaining words: use modular reductions to extract the values.
-	 */
-	for (u = slen; u < tlen; u ++) {
+	c = ctx;
+	logn = c->logn;
+	n = (size_t)1 << logn;
+	hn = n >> 1;
+	slen = c->slen;
+	tlen = c->tlen;
+	fd = c->fd;
+	gd = c->gd;
+	fs = c->fs;
+	gs = c->gs;
+	gm = scratch;
+	igm = gm + n;
+	t1 = igm + n;
+	primes = PRIMES;
+
+	for (u = slen + start; u < slen + end; u ++) {
 		uint32_t p, p0i, R2, Rx;
 		size_t v;
 		uint32_t *x;
@@ -2635,9 +3683,8 @@ make_fg_step(uint32_t *data, unsigned logn, unsigned depth,
 		R2 = modp_R2(p, p0i);
 		Rx = modp_Rx((unsigned)slen, p, p0i, R2);
 		modp_mkgm2(gm, igm, logn, primes[u].g, p, p0i);
-		for (v = 0, x = fs; v < n; v ++, x += slen) {
-			t1[v] = zint_mod_small_signed(x, slen, p, p0i, R2, Rx);
-		}
+		zint_mod_small_signed_ext(t1, 1, fs, slen, slen, n,
+			p, p0i, R2, Rx);
 		modp_NTT2(t1, gm, logn, p, p0i);
 		for (v = 0, x = fd + u; v < hn; v ++, x += tlen) {
 			uint32_t w0, w1;
@@ -2647,9 +3694,8 @@ make_fg_step(uint32_t *data, unsigned logn, unsigned depth,
 			*x = modp_montymul(
 				modp_montymul(w0, w1, p, p0i), R2, p, p0i);
 		}
-		for (v = 0, x = gs; v < n; v ++, x += slen) {
-			t1[v] = zint_mod_small_signed(x, slen, p, p0i, R2, Rx);
-		}
+		zint_mod_small_signed_ext(t1, 1, gs, slen, slen, n,
+			p, p0i, R2, Rx);
 		modp_NTT2(t1, gm, logn, p, p0i);
 		for (v = 0, x = gd + u; v < hn; v ++, x += tlen) {
 			uint32_t w0, w1;
@@ -2660,13 +3706,74 @@ make_fg_step(uint32_t *data, unsigned logn, unsigned depth,
 				modp_montymul(w0, w1, p, p0i), R2, p, p0i);
 		}
 
-		if (!out_ntt) {
+		if (!c->out_ntt) {
 			modp_iNTT2_ext(fd + u, tlen, igm, logn - 1, p, p0i);
 			modp_iNTT2_ext(gd + u, tlen, igm, logn - 1, p, p0i);
 		}
 	}
 }
 
+/*
+ * Input: f,g of degree N = 2^logn; 'depth' is used only to get their
+ * individual length.
+ *
+ * Output: f',g' of degree N/2, with the length for 'depth+1'.
+ *
+ * Values are in RNS; input and/or output may also be in NTT.
+ */
+static void
+make_fg_step(uint32_t *data, unsigned logn, unsigned depth,
+	int in_ntt, int out_ntt, kg_pool *pool)
+{
+	make_fg_step_ctx c;
+	size_t n, hn;
+	size_t slen, tlen;
+	uint32_t *fd, *gd, *fs, *gs, *gm;
+
+	n = (size_t)1 << logn;
+	hn = n >> 1;
+	slen = MAX_BL_SMALL[depth];
+	tlen = MAX_BL_SMALL[depth + 1];
+
+	/*
+	 * Prepare room for the result.
+	 */
+	fd = data;
+	gd = fd + hn * tlen;
+	fs = gd + hn * tlen;
+	gs = fs + n * slen;
+	gm = gs + n * slen;
+	memmove(fs, data, 2 * n * slen * sizeof *data);
+
+	c.fd = fd;
+	c.gd = gd;
+	c.fs = fs;
+	c.gs = gs;
+	c.slen = slen;
+	c.tlen = tlen;
+	c.logn = logn;
+	c.in_ntt = in_ntt;
+	c.out_ntt = out_ntt;
+
+	/*
+	 * First slen words: we use the input values directly, and apply
+	 * inverse NTT as we go.
+	 */
+	kg_run(pool, &make_fg_step_rns_task, &c, slen, gm);
+
+	/*
+	 * Since the fs and gs words have been de-NTTized, we can use the
+	 * CRT to rebuild the values.
+	 */
+	zint_rebuild_CRT_mt(pool, fs, slen, slen, n, 1, gm);
+	zint_rebuild_CRT_mt(pool, gs, slen, slen, n, 1, gm);
+
+	/*
+	 * Remaining words: use modular reductions to extract the values.
+	 */
+	kg_run(pool, &make_fg_step_mod_task, &c, tlen - slen, gm);
+}
+
 /*
  * Compute f and g at a specific depth, in RNS notation.
  *
@@ -2680,7 +3787,7 @@ make_fg_step(uint32_t *data, unsigned logn, unsigned depth,
  */
 static void
 make_fg(uint32_t *data, const int8_t *f, const int8_t *g,
-	unsigned logn, unsigned depth, int out_ntt)
+	unsigned logn, unsigned depth, int out_ntt, kg_pool *pool)
 {
 	size_t n, u;
 	uint32_t *ft, *gt, p0;
@@ -2713,7 +3820,7 @@ make_fg(uint32_t *data, const int8_t *f, const int8_t *g,
 
 	for (d = 0; d < depth; d ++) {
 		make_fg_step(data, logn - d, d,
-			d != 0, (d + 1) < depth || out_ntt);
+			d != 0, (d + 1) < depth || out_ntt, pool);
 	}
 }
 
@@ -2726,7 +3833,7 @@ make_fg(uint32_t *data, const int8_t *f, const int8_t *g,
  */
 static int
 solve_NTRU_deepest(unsigned logn_top,
-	const int8_t *f, const int8_t *g, uint32_t *tmp)
+	const int8_t *f, const int8_t *g, uint32_t *tmp, kg_pool *pool)
 {
 	size_t len;
 	uint32_t *Fp, *Gp, *fp, *gp, *t1, q;
@@ -2741,7 +3848,7 @@ solve_NTRU_deepest(unsigned logn_top,
 	gp = fp + len;
 	t1 = gp + len;
 
-	make_fg(fp, f, g, logn_top, logn_top, 0);
+	make_fg(fp, f, g, logn_top, logn_top, 0, pool);
 
 	/*
 	 * We use the CRT to rebuild the resultants as big integers.
@@ -2779,6 +3886,184 @@ solve_NTRU_deepest(unsigned logn_top,
 	return 1;
 }
 
+typedef struct {
+	const uint32_t *Fd, *Gd;
+	uint32_t *Ft, *Gt;
+	size_t dlen, llen, hn;
+} reduce_FG_ctx;
+
+/*
+ * Reduce the deeper-level F and G (Fd and Gd, hn integers of dlen
+ * words each) modulo the primes of index start to end-1, into column
+ * u of Ft and Gt.
+ */
+static void
+reduce_FG_task(void *ctx, size_t start, size_t end, uint32_t *scratch)
+{
+	reduce_FG_ctx *c;
+	size_t u, dlen, llen;
+	const small_prime *primes;
+
+	(void)scratch;
+	c = ctx;
+	dlen = c->dlen;
+	llen = c->llen;
+	primes = PRIMES;
+	for (u = start; u < end; u ++) {
+		uint32_t p, p0i, R2, Rx;
+
+		p = primes[u].p;
+		p0i = modp_ninv31(p);
+		R2 = modp_R2(p, p0i);
+		Rx = modp_Rx((unsigned)dlen, p, p0i, R2);
+		zint_mod_small_signed_ext(c->Ft + u, llen, c->Fd, dlen, dlen,
+			c->hn, p, p0i, R2, Rx);
+		zint_mod_small_signed_ext(c->Gt + u, llen, c->Gd, dlen, dlen,
+			c->hn, p, p0i, R2, Rx);
+	}
+}
+
+typedef struct {
+	uint32_t *ft, *gt, *Ft, *Gt;
+	size_t slen, llen, base;
+	unsigned logn;
+} lift_FG_ctx;
+
+/*
+ * Compute the unreduced F and G of solve_NTRU_intermediate() modulo the
+ * primes of index base+start to base+end-1. For the first slen primes
+ * (base = 0), ft and gt are in RNS+NTT and get de-NTTized; for the
+ * other ones (base = slen), they have been rebuilt as big integers.
+ */
+static void
+lift_FG_task(void *ctx, size_t start, size_t end, uint32_t *scratch)
+{
+	lift_FG_ctx *c;
+	unsigned logn;
+	size_t n, hn, slen, llen, u;
+	uint32_t *ft, *gt, *Ft, *Gt, *x, *y;
+	const small_prime *primes;
+
+	c = ctx;
+	logn = c->logn;
+	n = (size_t)1 << logn;
+	hn = n >> 1;
+	slen = c->slen;
+	llen = c->llen;
+	ft = c->ft;
+	gt = c->gt;
+	Ft = c->Ft;
+	Gt = c->Gt;
+	primes = PRIMES;
+
+	for (u = c->base + start; u < c->base + end; u ++) {
+		uint32_t p, p0i, R2;
+		uint32_t *gm, *igm, *fx, *gx, *Fp, *Gp;
+		size_t v;
+
+		/*
+		 * All computations are done modulo p.
+		 */
+		p = primes[u].p;
+		p0i = modp_ninv31(p);
+		R2 = modp_R2(p, p0i);
+
+		gm = scratch;
+		igm = gm + n;
+		fx = igm + n;
+		gx = fx + n;
+
+		modp_mkgm2(gm, igm, logn, primes[u].g, p, p0i);
+
+		if (u < slen) {
+			for (v = 0, x = ft + u, y = gt + u;
+				v < n; v ++, x += slen, y += slen)
+			{
+				fx[v] = *x;
+				gx[v] = *y;
+			}
+			modp_iNTT2_ext(ft + u, slen, igm, logn, p, p0i);
+			modp_iNTT2_ext(gt + u, slen, igm, logn, p, p0i);
+		} else {
+			uint32_t Rx;
+
+			Rx = modp_Rx((unsigned)slen, p, p0i, R2);
+			zint_mod_small_signed_ext(fx, 1, ft, slen, slen, n,
+				p, p0i, R2, Rx);
+			zint_mod_small_signed_ext(gx, 1, gt, slen, slen, n,
+				p, p0i, R2, Rx);
+			modp_NTT2(fx, gm, logn, p, p0i);
+			modp_NTT2(gx, gm, logn, p, p0i);
+		}
+
+		/*
+		 * Get F' and G' modulo p and in NTT representation
+		 * (they have degree n/2). These values were computed in
+		 * a previous step, and stored in Ft and Gt.
+		 */
+		Fp = gx + n;
+		Gp = Fp + hn;
+		for (v = 0, x = Ft + u, y = Gt + u;
+			v < hn; v ++, x += llen, y += llen)
+		{
+			Fp[v] = *x;
+			Gp[v] = *y;
+		}
+		modp_NTT2(Fp, gm, logn - 1, p, p0i);
+		modp_NTT2(Gp, gm, logn - 1, p, p0i);
+
+		/*
+		 * Compute our F and G modulo p.
+		 *
+		 * General case:
+		 *
+		 *   we divide degree by d = 2 or 3
+		 *   f'(x^d) = N(f)(x^d) = f * adj(f)
+		 *   g'(x^d) = N(g)(x^d) = g * adj(g)
+		 *   f'*G' - g'*F' = q
+		 *   F = F'(x^d) * adj(g)
+		 *   G = G'(x^d) * adj(f)
+		 *
+		 * We compute things in the NTT. We group roots of phi
+		 * such that all roots x in a group share the same x^d.
+		 * If the roots in a group are x_1, x_2... x_d, then:
+		 *
+		 *   N(f)(x_1^d) = f(x_1)*f(x_2)*...*f(x_d)
+		 *
+		 * Thus, we have:
+		 *
+		 *   G(x_1) = f(x_2)*f(x_3)*...*f(x_d)*G'(x_1^d)
+		 *   G(x_2) = f(x_1)*f(x_3)*...*f(x_d)*G'(x_1^d)
+		 *   ...
+		 *   G(x_d) = f(x_1)*f(x_2)*...*f(x_{d-1})*G'(x_1^d)
+		 *
+		 * In all cases, we can thus compute F and G in NTT
+		 * representation by a few simple multiplications.
+		 * Moreover, in our chosen NTT representation, roots
+		 * from the same group are consecutive in RAM.
+		 */
+		for (v = 0, x = Ft + u, y = Gt + u; v < hn;
+			v ++, x += (llen << 1), y += (llen << 1))
+		{
+			uint32_t ftA, ftB, gtA, gtB;
+			uint32_t mFp, mGp;
+
+			ftA = fx[(v << 1) + 0];
+			ftB = fx[(v << 1) + 1];
+			gtA = gx[(v << 1) + 0];
+			gtB = gx[(v << 1) + 1];
+			mFp = modp_montymul(Fp[v], R2, p, p0i);
+			mGp = modp_montymul(Gp[v], R2, p, p0i);
+			x[0] = modp_montymul(gtB, mFp, p, p0i);
+			x[llen] = modp_montymul(gtA, mFp, p, p0i);
+			y[0] = modp_montymul(ftB, mGp, p, p0i);
+			y[llen] = modp_montymul(ftA, mGp, p, p0i);
+		}
+		modp_iNTT2_ext(Ft + u, llen, igm, logn, p, p0i);
+		modp_iNTT2_ext(Gt + u, llen, igm, logn, p, p0i);
+	}
+}
+
 /*
  * Solving the NTRU equation, intermediate level. Upon entry, the F and G
  * from the previous level should be in the tmp[] array.
@@ -2788,7 +4073,8 @@ solve_NTRU_deepest(unsigned logn_top,
  */
 static int
 solve_NTRU_intermediate(unsigned logn_top,
-	const int8_t *f, const int8_t *g, unsigned depth, uint32_t *tmp)
+	const int8_t *f, const int8_t *g, unsigned depth, uint32_t *tmp,
+	kg_pool *pool)
 {
 	/*
 	 * In this function, 'logn' is the log2 of the degree for
@@ -2800,11 +4086,12 @@ solve_NTRU_intermediate(unsigned logn_top,
 	unsigned logn;
 	size_t n, hn, slen, dlen, llen, rlen, FGlen, u;
 	uint32_t *Fd, *Gd, *Ft, *Gt, *ft, *gt, *t1;
+	reduce_FG_ctx rc;
+	lift_FG_ctx lc;
 	fpr *rt1, *rt2, *rt3, *rt4, *rt5;
 	int scale_fg, minbl_fg, maxbl_fg, maxbl_FG, scale_k;
 	uint32_t *x, *y;
 	int32_t *k;
-	const small_prime *primes;
 
 	logn = logn_top - depth;
 	n = (size_t)1 << logn;
@@ -2825,7 +4112,6 @@ solve_NTRU_intermediate(unsigned logn_top,
 	slen = MAX_BL_SMALL[depth];
 	dlen = MAX_BL_SMALL[depth + 1];
 	llen = MAX_BL_LARGE[depth];
-	primes = PRIMES;
 
 	/*
 	 * Fd and Gd are the F and G from the deeper level.
@@ -2838,7 +4124,7 @@ solve_NTRU_intermediate(unsigned logn_top,
 	 * and g in RNS + NTT representation.
 	 */
 	ft = Gd + dlen * hn;
-	make_fg(ft, f, g, logn_top, depth, 1);
+	make_fg(ft, f, g, logn_top, depth, 1, pool);
 
 	/*
 	 * Move the newly computed f and g to make room for our candidate
@@ -2859,160 +4145,48 @@ solve_NTRU_intermediate(unsigned logn_top,
 	Fd = t1;
 	Gd = Fd + hn * dlen;
 
-	/*
-	 * We reduce Fd and Gd modulo all the small primes we will need,
-	 * and store the values in Ft and Gt (only n/2 values in each).
-	 */
-	for (u = 0; u < llen; u ++) {
-		uint32_t p, p0i, R2, Rx;
-		size_t v;
-		uint32_t *xs, *ys, *xd, *yd;
-
-		p = primes[u].p;
-		p0i = modp_ninv31(p);
-		R2 = modp_R2(p, p0i);
-		Rx = modp_Rx((unsigned)dlen, p, p0i, R2);
-		for (v = 0, xs = Fd, ys = Gd, xd = Ft + u, yd = Gt + u;
-			v < hn;
-			v ++, xs += dlen, ys += dlen, xd += llen, yd += llen)
-		{
-			*xd = zint_mod_small_signed(xs, dlen, p, p0i, R2, Rx);
-			*yd = zint_mod_small_signed(ys, dlen, p, p0i, R2, Rx);
-		}
-	}
-
-	/*
-	 * We do not need Fd and Gd after that point.
-	 */
-
-	/*
-	 * Compute our F and G modulo sufficiently many small primes.
-	 */
-	for (u = 0; u < llen; u ++) {
-		uint32_t p, p0i, R2;
-		uint32_t *gm, *igm, *fx, *gx, *Fp, *Gp;
-		size_t v;
-
-		/*
-		 * All computations are done modulo p.
-		 */
-		p = primes[u].p;
-		p0i = modp_ninv31(p);
-		R2 = modp_R2(p, p0i);
-
-		/*
-		 * If we processed slen words, then f and g have been
-		 * de-NTTized, and are in RNS; we can rebuild them.
-		 */
-		if (u == slen) {
-			zint_rebuild_CRT(ft, slen, slen, n, primes, 1, t1);
-			zint_rebuild_CRT(gt, slen, slen, n, primes, 1, t1);
-		}
-
-		gm = t1;
-		igm = gm + n;
-		fx = igm + n;
-		gx = fx + n;
-
-		modp_mkgm2(gm, igm, logn, primes[u].g, p, p0i);
-
-		if (u < slen) {
-			for (v = 0, x = ft + u, y = gt + u;
-				v < n; v ++, x += slen, y += slen)
-			{
-				fx[v] = *x;
-				gx[v] = *y;
-			}
-			modp_iNTT2_ext(ft + u, slen, igm, logn, p, p0i);
-			modp_iNTT2_ext(gt + u, slen, igm, logn, p, p0i);
-		} else {
-			uint32_t Rx;
-
-			Rx = modp_Rx((unsigned)slen, p, p0i, R2);
-			for (v = 0, x = ft, y = gt;
-				v < n; v ++, x += slen, y += slen)
-			{
-				fx[v] = zint_mod_small_signed(x, slen,
-					p, p0i, R2, Rx);
-				gx[v] = zint_mod_small_signed(y, slen,
-					p, p0i, R2, Rx);
-			}
-			modp_NTT2(fx, gm, logn, p, p0i);
-			modp_NTT2(gx, gm, logn, p, p0i);
-		}
-
-		/*
-		 * Get F' and G' modulo p and in NTT representation
-		 * (they have degree n/2). These values were computed in
-		 * a previous step, and stored in Ft and Gt.
-		 */
-		Fp = gx + n;
-		Gp = Fp + hn;
-		for (v = 0, x = Ft + u, y = Gt + u;
-			v < hn; v ++, x += llen, y += llen)
-		{
-			Fp[v] = *x;
-			Gp[v] = *y;
-		}
-		modp_NTT2(Fp, gm, logn - 1, p, p0i);
-		modp_NTT2(Gp, gm, logn - 1, p, p0i);
-
-		/*
-		 * Compute our F and G modulo p.
-		 *
-		 * General case:
-		 *
-		 *   we divide degree by d = 2 or 3
-		 *   f'(x^d) = N(f)(x^d) = f * adj(f)
-		 *   g'(x^d) = N(g)(x^d) = g * adj(g)
-		 *   f'*G' - g'*F' = q
-		 *   F = F'(x^d) * adj(g)
-		 *   G = G'(x^d) * adj(f)
-		 *
-		 * We compute things in the NTT. We group roots of phi
-		 * such that all roots x in a group share the same x^d.
-		 * If the roots in a group are x_1, x_2... x_d, then:
-		 *
-		 *   N(f)(x_1^d) = f(x_1)*f(x_2)*...*f(x_d)
-		 *
-		 * Thus, we have:
-		 *
-		 *   G(x_1) = f(x_2)*f(x_3)*...*f(x_d)*G'(x_1^d)
-		 *   G(x_2) = f(x_1)*f(x_3)*...*f(x_d)*G'(x_1^d)
-		 *   ...
-		 *   G(x_d) = f(x_1)*f(x_2)*...*f(x_{d-1})*G'(x_1^d)
-		 *
-		 * In all cases, we can thus compute F and G in NTT
-		 * representation by a few simple multiplications.
-		 * Moreover, in our chosen NTT representation, roots
-		 * from the same group are consecutive in RAM.
-		 */
-		for (v = 0, x = Ft + u, y = Gt + u; v < hn;
-			v ++, x += (llen << 1), y += (llen << 1))
-		{
-			uint32_t ftA, ftB, gtA, gtB;
-			uint32_t mFp, mGp;
+	/*
+	 * We reduce Fd and Gd modulo all the small primes we will need,
+	 * and store the values in Ft and Gt (only n/2 values in each).
+	 */
+	rc.Fd = Fd;
+	rc.Gd = Gd;
+	rc.Ft = Ft;
+	rc.Gt = Gt;
+	rc.dlen = dlen;
+	rc.llen = llen;
+	rc.hn = hn;
+	kg_run(pool, &reduce_FG_task, &rc, llen, t1);
 
-			ftA = fx[(v << 1) + 0];
-			ftB = fx[(v << 1) + 1];
-			gtA = gx[(v << 1) + 0];
-			gtB = gx[(v << 1) + 1];
-			mFp = modp_montymul(Fp[v], R2, p, p0i);
-			mGp = modp_montymul(Gp[v], R2, p, p0i);
-			x[0] = modp_montymul(gtB, mFp, p, p0i);
-			x[llen] = modp_montymul(gtA, mFp, p, p0i);
-			y[0] = modp_montymul(ftB, mGp, p, p0i);
-			y[llen] = modp_montymul(ftA, mGp, p, p0i);
-		}
-		modp_iNTT2_ext(Ft + u, llen, igm, logn, p, p0i);
-		modp_iNTT2_ext(Gt + u, llen, igm, logn, p, p0i);
-	}
+	/*
+	 * We do not need Fd and Gd after that point.
+	 */
+
+	/*
+	 * Compute our F and G modulo sufficiently many small primes.
+	 * After the first slen primes, f and g have been de-NTTized,
+	 * and are in RNS; we rebuild them before processing the other
+	 * primes.
+	 */
+	lc.ft = ft;
+	lc.gt = gt;
+	lc.Ft = Ft;
+	lc.Gt = Gt;
+	lc.slen = slen;
+	lc.llen = llen;
+	lc.logn = logn;
+	lc.base = 0;
+	kg_run(pool, &lift_FG_task, &lc, slen, t1);
+	zint_rebuild_CRT_mt(pool, ft, slen, slen, n, 1, t1);
+	zint_rebuild_CRT_mt(pool, gt, slen, slen, n, 1, t1);
+	lc.base = slen;
+	kg_run(pool, &lift_FG_task, &lc, llen - slen, t1);
 
 	/*
 	 * Rebuild F and G with the CRT.
 	 */
-	zint_rebuild_CRT(Ft, llen, llen, n, primes, 1, t1);
-	zint_rebuild_CRT(Gt, llen, llen, n, primes, 1, t1);
+	zint_rebuild_CRT_mt(pool, Ft, llen, llen, n, 1, t1);
+	zint_rebuild_CRT_mt(pool, Gt, llen, llen, n, 1, t1);
 
 	/*
 	 * At that point, Ft, Gt, ft and gt are consecutive in RAM (in that
@@ -3260,9 +4434,9 @@ solve_NTRU_intermediate(unsigned logn_top,
 		scl = (uint32_t)(scale_k % 31);
 		if (depth <= DEPTH_INT_FG) {
 			poly_sub_scaled_ntt(Ft, FGlen, llen, ft, slen, slen,
-				k, sch, scl, logn, t1);
+				k, sch, scl, logn, t1, pool);
 			poly_sub_scaled_ntt(Gt, FGlen, llen, gt, slen, slen,
-				k, sch, scl, logn, t1);
+				k, sch, scl, logn, t1, pool);
 		} else {
 			poly_sub_scaled(Ft, FGlen, llen, ft, slen, slen,
 				k, sch, scl, logn);
@@ -3330,112 +4504,44 @@ solve_NTRU_intermediate(unsigned logn_top,
 	return 1;
 }
 
+typedef struct {
+	const int8_t *f, *g;
+	uint32_t *Ft, *Gt, *ft, *gt;
+	size_t slen, llen;
+	unsigned logn_top;
+} lift_FG_depth1_ctx;
+
 /*
- * Solving the NTRU equation, binary case, depth = 1. Upon entry, the
- * F and G from the previous level should be in the tmp[] array.
- *
- * Returned value: 1 on success, 0 on error.
+ * Compute the unreduced F and G of solve_NTRU_binary_depth1(), and the
+ * f and g of that depth, modulo the primes of index start to end-1.
  */
-static int
-solve_NTRU_binary_depth1(unsigned logn_top,
-	const int8_t *f, const int8_t *g, uint32_t *tmp)
+static void
+lift_FG_depth1_task(void *ctx, size_t start, size_t end, uint32_t *scratch)
 {
-	/*
-	 * The first half of this function is a copy of the corresponding
-	 * part in solve_NTRU_intermediate(), for the reconstruction of
-	 * the unreduced F and G. The second half (Babai reduction) is
-	 * done differently, because the unreduced F and G fit in 53 bits
-	 * of precision, allowing a much simpler process with lower RAM
-	 * usage.
-	 */
-	unsigned depth, logn;
-	size_t n_top, n, hn, slen, dlen, llen, u;
-	uint32_t *Fd, *Gd, *Ft, *Gt, *ft, *gt, *t1;
-	fpr *rt1, *rt2, *rt3, *rt4, *rt5, *rt6;
+	lift_FG_depth1_ctx *c;
+	unsigned depth, logn_top, logn;
+	size_t n_top, n, hn, slen, llen, u;
+	const int8_t *f, *g;
+	uint32_t *Ft, *Gt, *ft, *gt;
 	uint32_t *x, *y;
 
+	c = ctx;
 	depth = 1;
+	logn_top = c->logn_top;
 	n_top = (size_t)1 << logn_top;
 	logn = logn_top - depth;
 	n = (size_t)1 << logn;
 	hn = n >> 1;
-
-	/*
-	 * Equations are:
-	 *
-	 *   f' = f0^2 - X^2*f1^2
-	 *   g' = g0^2 - X^2*g1^2
-	 *   F' and G' are a solution to f'G' - g'F' = q (from deeper levels)
-	 *   F = F'*(g0 - X*g1)
-	 *   G = G'*(f0 - X*f1)
-	 *
-	 * f0, f1, g0, g1, f', g', F' and G' are all "compressed" to
-	 * degree N/2 (their odd-indexed coefficients are all zero).
-	 */
-
-	/*
-	 * slen = size for our input f and g; also size of the reduced
-	 *        F and G we return (degree N)
-	 *
-	 * dlen = size of the F and G obtained from the deeper level
-	 *        (degree N/2)
-	 *
-	 * llen = size for intermediary F and G before reduction (degree N)
-	 *
-	 * We build our non-reduced F and G as two independent halves each,
-	 * of degree N/2 (F = F0 + X*F1, G = G0 + X*G1).
-	 */
-	slen = MAX_BL_SMALL[depth];
-	dlen = MAX_BL_SMALL[depth + 1];
-	llen = MAX_BL_LARGE[depth];
-
-	/*
-	 * Fd and Gd are the F and G from the deeper level. Ft and Gt
-	 * are the destination arrays for the unreduced F and G.
-	 */
-	Fd = tmp;
-	Gd = Fd + dlen * hn;
-	Ft = Gd + dlen * hn;
-	Gt = Ft + llen * n;
-
-	/*
-	 * We reduce Fd and Gd modulo all the small primes we will need,
-	 * and store the values in Ft and Gt.
-	 */
-	for (u = 0; u < llen; u ++) {
-		uint32_t p, p0i, R2, Rx;
-		size_t v;
-		uint32_t *xs, *ys, *xd, *yd;
-
-		p = PRIMES[u].p;
-		p0i = modp_ninv31(p);
-		R2 = modp_R2(p, p0i);
-		Rx = modp_Rx((unsigned)dlen, p, p0i, R2);
-		for (v = 0, xs = Fd, ys = Gd, xd = Ft + u, yd = Gt + u;
-			v < hn;
-			v ++, xs += dlen, ys += dlen, xd += llen, yd += llen)
-		{
-			*xd = zint_mod_small_signed(xs, dlen, p, p0i, R2, Rx);
-			*yd = zint_mod_small_signed(ys, dlen, p, p0i, R2, Rx);
-		}
-	}
-
-	/*
-	 * Now Fd and Gd are not needed anymore; we can squeeze them out.
-	 */
-	memmove(tmp, Ft, llen * n * sizeof(uint32_t));
-	Ft = tmp;
-	memmove(Ft + llen * n, Gt, llen * n * sizeof(uint32_t));
-	Gt = Ft + llen * n;
-	ft = Gt + llen * n;
-	gt = ft + slen * n;
-
-	t1 = gt + slen * n;
-
-	/*
-	 * Compute our F and G modulo sufficiently many small primes.
-	 */
-	for (u = 0; u < llen; u ++) {
+	slen = c->slen;
+	llen = c->llen;
+	f = c->f;
+	g = c->g;
+	Ft = c->Ft;
+	Gt = c->Gt;
+	ft = c->ft;
+	gt = c->gt;
+
+	for (u = start; u < end; u ++) {
 		uint32_t p, p0i, R2;
 		uint32_t *gm, *igm, *fx, *gx, *Fp, *Gp;
 		unsigned e;
@@ -3456,7 +4562,7 @@ solve_NTRU_binary_depth1(unsigned logn_top,
 		 * into fx[]) but later code will overwrite these extra
 		 * elements.
 		 */
-		gm = t1;
+		gm = scratch;
 		igm = gm + n_top;
 		fx = igm + n;
 		gx = fx + n_top;
@@ -3580,14 +4686,122 @@ solve_NTRU_binary_depth1(unsigned logn_top,
 			}
 		}
 	}
+}
+
+/*
+ * Solving the NTRU equation, binary case, depth = 1. Upon entry, the
+ * F and G from the previous level should be in the tmp[] array.
+ *
+ * Returned value: 1 on success, 0 on error.
+ */
+static int
+solve_NTRU_binary_depth1(unsigned logn_top,
+	const int8_t *f, const int8_t *g, uint32_t *tmp, kg_pool *pool)
+{
+	/*
+	 * The first half of this function is a copy of the corresponding
+	 * part in solve_NTRU_intermediate(), for the reconstruction of
+	 * the unreduced F and G. The second half (Babai reduction) is
+	 * done differently, because the unreduced F and G fit in 53 bits
+	 * of precision, allowing a much simpler process with lower RAM
+	 * usage.
+	 */
+	unsigned depth, logn;
+	size_t n, hn, slen, dlen, llen, u;
+	uint32_t *Fd, *Gd, *Ft, *Gt, *ft, *gt, *t1;
+	fpr *rt1, *rt2, *rt3, *rt4, *rt5, *rt6;
+	reduce_FG_ctx rc;
+	lift_FG_depth1_ctx lc;
+
+	depth = 1;
+	logn = logn_top - depth;
+	n = (size_t)1 << logn;
+	hn = n >> 1;
+
+	/*
+	 * Equations are:
+	 *
+	 *   f' = f0^2 - X^2*f1^2
+	 *   g' = g0^2 - X^2*g1^2
+	 *   F' and G' are a solution to f'G' - g'F' = q (from deeper levels)
+	 *   F = F'*(g0 - X*g1)
+	 *   G = G'*(f0 - X*f1)
+	 *
+	 * f0, f1, g0, g1, f', g', F' and G' are all "compressed" to
+	 * degree N/2 (their odd-indexed coefficients are all zero).
+	 */
+
+	/*
+	 * slen = size for our input f and g; also size of the reduced
+	 *        F and G we return (degree N)
+	 *
+	 * dlen = size of the F and G obtained from the deeper level
+	 *        (degree N/2)
+	 *
+	 * llen = size for intermediary F and G before reduction (degree N)
+	 *
+	 * We build our non-reduced F and G as two independent halves each,
+	 * of degree N/2 (F = F0 + X*F1, G = G0 + X*G1).
+	 */
+	slen = MAX_BL_SMALL[depth];
+	dlen = MAX_BL_SMALL[depth + 1];
+	llen = MAX_BL_LARGE[depth];
+
+	/*
+	 * Fd and Gd are the F and G from the deeper level. Ft and Gt
+	 * are the destination arrays for the unreduced F and G.
+	 */
+	Fd = tmp;
+	Gd = Fd + dlen * hn;
+	Ft = Gd + dlen * hn;
+	Gt = Ft + llen * n;
+
+	/*
+	 * We reduce Fd and Gd modulo all the small primes we will need,
+	 * and store the values in Ft and Gt.
+	 */
+	rc.Fd = Fd;
+	rc.Gd = Gd;
+	rc.Ft = Ft;
+	rc.Gt = Gt;
+	rc.dlen = dlen;
+	rc.llen = llen;
+	rc.hn = hn;
+	kg_run(pool, &reduce_FG_task, &rc, llen, NULL);
+
+	/*
+	 * Now Fd and Gd are not needed anymore; we can squeeze them out.
+	 */
+	memmove(tmp, Ft, llen * n * sizeof(uint32_t));
+	Ft = tmp;
+	memmove(Ft + llen * n, Gt, llen * n * sizeof(uint32_t));
+	Gt = Ft + llen * n;
+	ft = Gt + llen * n;
+	gt = ft + slen * n;
+
+	t1 = gt + slen * n;
+
+	/*
+	 * Compute our F and G modulo sufficiently many small primes.
+	 */
+	lc.f = f;
+	lc.g = g;
+	lc.Ft = Ft;
+	lc.Gt = Gt;
+	lc.ft = ft;
+	lc.gt = gt;
+	lc.slen = slen;
+	lc.llen = llen;
+	lc.logn_top = logn_top;
+	kg_run(pool, &lift_FG_depth1_task, &lc, llen, t1);
 
 	/*
 	 * Rebuild f, g, F and G with the CRT. Note that the elements of F
 	 * and G are consecutive, and thus can be rebuilt in a single
 	 * loop; similarly, the elements of f and g are consecutive.
 	 */
-	zint_rebuild_CRT(Ft, llen, llen, n << 1, PRIMES, 1, t1);
-	zint_rebuild_CRT(ft, slen, slen, n << 1, PRIMES, 1, t1);
+	zint_rebuild_CRT_mt(pool, Ft, llen, llen, n << 1, 1, t1);
+	zint_rebuild_CRT_mt(pool, ft, slen, slen, n << 1, 1, t1);
 
 	/*
 	 * Here starts the Babai reduction, specialized for depth = 1.
@@ -3982,7 +5196,8 @@ solve_NTRU_binary_depth0(unsigned logn,
  */
 static int
 solve_NTRU(unsigned logn, int8_t *F, int8_t *G,
-	const int8_t *f, const int8_t *g, int lim, uint32_t *tmp)
+	const int8_t *f, const int8_t *g, int lim, uint32_t *tmp,
+	kg_pool *pool)
 {
 	size_t n, u;
 	uint32_t *ft, *gt, *Ft, *Gt, *gm;
@@ -3991,7 +5206,7 @@ solve_NTRU(unsigned logn, int8_t *F, int8_t *G,
 
 	n = MKN(logn);
 
-	if (!solve_NTRU_deepest(logn, f, g, tmp)) {
+	if (!solve_NTRU_deepest(logn, f, g, tmp, pool)) {
 		return 0;
 	}
 
@@ -4005,7 +5220,9 @@ solve_NTRU(unsigned logn, int8_t *F, int8_t *G,
 
 		depth = logn;
 		while (depth -- > 0) {
-			if (!solve_NTRU_intermediate(logn, f, g, depth, tmp)) {
+			if (!solve_NTRU_intermediate(logn, f, g, depth,
+				tmp, pool))
+			{
 				return 0;
 			}
 		}
@@ -4014,11 +5231,13 @@ solve_NTRU(unsigned logn, int8_t *F, int8_t *G,
 
 		depth = logn;
 		while (depth -- > 2) {
-			if (!solve_NTRU_intermediate(logn, f, g, depth, tmp)) {
+			if (!solve_NTRU_intermediate(logn, f, g, depth,
+				tmp, pool))
+			{
 				return 0;
 			}
 		}
-		if (!solve_NTRU_binary_depth1(logn, f, g, tmp)) {
+		if (!solve_NTRU_binary_depth1(logn, f, g, tmp, pool)) {
 			return 0;
 		}
 		if (!solve_NTRU_binary_depth0(logn, f, g, tmp)) {
@@ -4131,11 +5350,10 @@ poly_small_mkgauss(RNG_CONTEXT *rng, int8_t *f, unsigned logn)
 	}
 }
 
-/* see falcon.h */
-void
-Zf(keygen)(inner_prng_context *rng,
+static void
+keygen_inner(inner_prng_context *rng,
 	int8_t *f, int8_t *g, int8_t *F, int8_t *G, uint16_t *h,
-	unsigned logn, uint8_t *tmp)
+	unsigned logn, uint8_t *tmp, kg_pool *pool)
 {
 	/*
 	 * Algorithm is the following:
@@ -4289,7 +5507,9 @@ Zf(keygen)(inner_prng_context *rng,
 		 * Solve the NTRU equation to get F and G.
 		 */
 		lim = (1 << (Zf(max_FG_bits)[logn] - 1)) - 1;
-		if (!solve_NTRU(logn, F, G, f, g, lim, (uint32_t *)tmp)) {
+		if (!solve_NTRU(logn, F, G, f, g, lim,
+			(uint32_t *)tmp, pool))
+		{
 			continue;
 		}
 
@@ -4299,3 +5519,25 @@ Zf(keygen)(inner_prng_context *rng,
 		break;
 	}
 }
+
+/* see inner.h */
+void
+Zf(keygen)(inner_prng_context *rng,
+	int8_t *f, int8_t *g, int8_t *F, int8_t *G, uint16_t *h,
+	unsigned logn, uint8_t *tmp)
+{
+	keygen_inner(rng, f, g, F, G, h, logn, tmp, NULL);
+}
+
+/* see inner.h */
+void
+Zf(keygen_mt)(inner_prng_context *rng,
+	int8_t *f, int8_t *g, int8_t *F, int8_t *G, uint16_t *h,
+	unsigned logn, uint8_t *tmp, unsigned nthreads, uint32_t *ttmp)
+{
+	kg_pool pool;
+
+	kg_pool_start(&pool, nthreads, ttmp, KEYGEN_MT_WORDS(logn));
+	keygen_inner(rng, f, g, F, G, h, logn, tmp, &pool);
+	kg_pool_stop(&pool);
+}
@@ -638,6 +638,123 @@ static const uint64_t RC[] = {
 	0x0000000080000001, 0x8000000080008008
 };
 
+#if FALCON_KECCAK_SHA3
+
+/* see inner.h */
+TARGET_SHA3
+void
+Zf(keccak_f1600_x2_sha3)(uint64_t st[25][2])
+{
+	/*
+	 * Instance k lives in the 64-bit slot k of each register, with
+	 * the usual lane order a[x + 5*y]. Each round uses EOR3 for
+	 * the column parities, RAX1 for theta, XAR for theta+rho (the
+	 * rotation is to the right), and BCAX for chi; pi is the
+	 * renaming from a[] to b[].
+	 */
+	uint64x2_t a[25], b[25];
+	uint64x2_t c0, c1, c2, c3, c4, d0, d1, d2, d3, d4;
+	int i, j;
+
+	for (i = 0; i < 25; i ++) {
+		a[i] = vld1q_u64(st[i]);
+	}
+	for (j = 0; j < 24; j ++) {
+		c0 = veor3q_u64(veor3q_u64(a[0], a[5], a[10]),
+			a[15], a[20]);
+		c1 = veor3q_u64(veor3q_u64(a[1], a[6], a[11]),
+			a[16], a[21]);
+		c2 = veor3q_u64(veor3q_u64(a[2], a[7], a[12]),
+			a[17], a[22]);
+		c3 = veor3q_u64(veor3q_u64(a[3], a[8], a[13]),
+			a[18], a[23]);
+		c4 = veor3q_u64(veor3q_u64(a[4], a[9], a[14]),
+			a[19], a[24]);
+		d0 = vrax1q_u64(c4, c1);
+		d1 = vrax1q_u64(c0, c2);
+		d2 = vrax1q_u64(c1, c3);
+		d3 = vrax1q_u64(c2, c4);
+		d4 = vrax1q_u64(c3, c0);
+		b[0] = veorq_u64(a[0], d0);
+		b[10] = vxarq_u64(a[1], d1, 63);
+		b[20] = vxarq_u64(a[2], d2, 2);
+		b[5] = vxarq_u64(a[3], d3, 36);
+		b[15] = vxarq_u64(a[4], d4, 37);
+		b[16] = vxarq_u64(a[5], d0, 28);
+		b[1] = vxarq_u64(a[6], d1, 20);
+		b[11] = vxarq_u64(a[7], d2, 58);
+		b[21] = vxarq_u64(a[8], d3, 9);
+		b[6] = vxarq_u64(a[9], d4, 44);
+		b[7] = vxarq_u64(a[10], d0, 61);
+		b[17] = vxarq_u64(a[11], d1, 54);
+		b[2] = vxarq_u64(a[12], d2, 21);
+		b[12] = vxarq_u64(a[13], d3, 39);
+		b[22] = vxarq_u64(a[14], d4, 25);
+		b[23] = vxarq_u64(a[15], d0, 23);
+		b[8] = vxarq_u64(a[16], d1, 19);
+		b[18] = vxarq_u64(a[17], d2, 49);
+		b[3] = vxarq_u64(a[18], d3, 43);
+		b[13] = vxarq_u64(a[19], d4, 56);
+		b[14] = vxarq_u64(a[20], d0, 46);
+		b[24] = vxarq_u64(a[21], d1, 62);
+		b[9] = vxarq_u64(a[22], d2, 3);
+		b[19] = vxarq_u64(a[23], d3, 8);
+		b[4] = vxarq_u64(a[24], d4, 50);
+		a[0] = vbcaxq_u64(b[0], b[2], b[1]);
+		a[1] = vbcaxq_u64(b[1], b[3], b[2]);
+		a[2] = vbcaxq_u64(b[2], b[4], b[3]);
+		a[3] = vbcaxq_u64(b[3], b[0], b[4]);
+		a[4] = vbcaxq_u64(b[4], b[1], b[0]);
+		a[5] = vbcaxq_u64(b[5], b[7], b[6]);
+		a[6] = vbcaxq_u64(b[6], b[8], b[7]);
+		a[7] = vbcaxq_u64(b[7], b[9], b[8]);
+		a[8] = vbcaxq_u64(b[8], b[5], b[9]);
+		a[9] = vbcaxq_u64(b[9], b[6], b[5]);
+		a[10] = vbcaxq_u64(b[10], b[12], b[11]);
+		a[11] = vbcaxq_u64(b[11], b[13], b[12]);
+		a[12] = vbcaxq_u64(b[12], b[14], b[13]);
+		a[13] = vbcaxq_u64(b[13], b[10], b[14]);
+		a[14] = vbcaxq_u64(b[14], b[11], b[10]);
+		a[15] = vbcaxq_u64(b[15], b[17], b[16]);
+		a[16] = vbcaxq_u64(b[16], b[18], b[17]);
+		a[17] = vbcaxq_u64(b[17], b[19], b[18]);
+		a[18] = vbcaxq_u64(b[18], b[15], b[19]);
+		a[19] = vbcaxq_u64(b[19], b[16], b[15]);
+		a[20] = vbcaxq_u64(b[20], b[22], b[21]);
+		a[21] = vbcaxq_u64(b[21], b[23], b[22]);
+		a[22] = vbcaxq_u64(b[22], b[24], b[23]);
+		a[23] = vbcaxq_u64(b[23], b[20], b[24]);
+		a[24] = vbcaxq_u64(b[24], b[21], b[20]);
+
+		a[0] = veorq_u64(a[0], vdupq_n_u64(RC[j]));
+	}
+	for (i = 0; i < 25; i ++) {
+		vst1q_u64(st[i], a[i]);
+	}
+}
+
+/*
+ * Process the provided state with the SHA3 instructions; the second
+ * instance is a copy and is discarded.
+ */
+static void
+process_block_sha3(uint64_t *A)
+{
+	uint64_t st[25][2];
+	int i;
+
+	for (i = 0; i < 25; i ++) {
+		st[i][0] = A[i];
+		st[i][1] = A[i];
+	}
+	Zf(keccak_f1600_x2_sha3)(st);
+	for (i = 0; i < 25; i ++) {
+		A[i] = st[i][0];
+	}
+}
+
+#endif
+
 /*
  * Process the provided state.
  */
@@ -650,6 +767,13 @@ process_block(uint64_t *A)
 	uint64_t c0, c1, c2, c3, c4, bnn;
 	int j;
 
+#if FALCON_KECCAK_SHA3
+	if (cpu_has_sha3()) {
+		process_block_sha3(A);
+		return;
+	}
+#endif
+
 	/*
 	 * Invert some words (alternate internal representation, which
 	 * saves some operations).
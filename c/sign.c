@@ -64,6 +64,34 @@ ffLDL_treesize(unsigned logn)
 	return (logn + 1) << logn;
 }
 
+/*
+ * Tree layouts. In the recursive layout (seq = 0), a node is its L
+ * polynomial (2^logn elements), followed by the left subtree (tree0)
+ * and the right subtree (tree1). In the sequential layout (seq = 1), a
+ * node with logn >= 3 is the right subtree, then L, then the left
+ * subtree: this is the order in which ffSampling_fft() reads them, so
+ * that a signature walks through the tree by increasing addresses.
+ * Nodes with logn <= 2, which ffSampling_fft() processes inline, have
+ * the same layout in both cases.
+ */
+static inline size_t
+ffLDL_off_L(unsigned logn, int seq)
+{
+	return (seq && logn >= 3) ? ffLDL_treesize(logn - 1) : 0;
+}
+
+static inline size_t
+ffLDL_off_tree0(unsigned logn, int seq)
+{
+	return ffLDL_off_L(logn, seq) + MKN(logn);
+}
+
+static inline size_t
+ffLDL_off_tree1(unsigned logn, int seq)
+{
+	return (seq && logn >= 3) ? 0 : MKN(logn) + ffLDL_treesize(logn - 1);
+}
+
 /*
  * Inner function for ffLDL_fft(). It expects the matrix to be both
  * auto-adjoint and quasicyclic; also, it uses the source operands
@@ -73,7 +101,8 @@ ffLDL_treesize(unsigned logn)
  */
 static void
 ffLDL_fft_inner(fpr *restrict tree,
-	fpr *restrict g0, fpr *restrict g1, unsigned logn, fpr *restrict tmp)
+	fpr *restrict g0, fpr *restrict g1, unsigned logn, int seq,
+	fpr *restrict tmp)
 {
 	size_t n, hn;
 
@@ -89,7 +118,8 @@ ffLDL_fft_inner(fpr *restrict tree,
 	 * and the diagonal of D. Since d00 = g0, we just write d11
 	 * into tmp.
 	 */
-	Zf(poly_LDLmv_fft)(tmp, tree, g0, g1, g0, logn);
+	Zf(poly_LDLmv_fft)(tmp, tree + ffLDL_off_L(logn, seq),
+		g0, g1, g0, logn);
 
 	/*
 	 * Split d00 (currently in g0) and d11 (currently in tmp). We
@@ -104,10 +134,10 @@ ffLDL_fft_inner(fpr *restrict tree,
 	 * Each split result is the first row of a new auto-adjoint
 	 * quasicyclic matrix for the next recursive step.
 	 */
-	ffLDL_fft_inner(tree + n,
-		g1, g1 + hn, logn - 1, tmp);
-	ffLDL_fft_inner(tree + n + ffLDL_treesize(logn - 1),
-		g0, g0 + hn, logn - 1, tmp);
+	ffLDL_fft_inner(tree + ffLDL_off_tree0(logn, seq),
+		g1, g1 + hn, logn - 1, seq, tmp);
+	ffLDL_fft_inner(tree + ffLDL_off_tree1(logn, seq),
+		g0, g0 + hn, logn - 1, seq, tmp);
 }
 
 /*
@@ -115,7 +145,8 @@ ffLDL_fft_inner(fpr *restrict tree,
  * is provided as three polynomials (FFT representation).
  *
  * The "tree" array is filled with the computed tree, of size
- * (logn+1)*(2^logn) elements (see ffLDL_treesize()).
+ * (logn+1)*(2^logn) elements (see ffLDL_treesize()), in the recursive
+ * (seq = 0) or sequential (seq = 1) layout.
  *
  * Input arrays MUST NOT overlap, except possibly the three unmodified
  * arrays g00, g01 and g11. tmp[] should have room for at least three
@@ -124,7 +155,7 @@ ffLDL_fft_inner(fpr *restrict tree,
 static void
 ffLDL_fft(fpr *restrict tree, const fpr *restrict g00,
 	const fpr *restrict g01, const fpr *restrict g11,
-	unsigned logn, fpr *restrict tmp)
+	unsigned logn, int seq, fpr *restrict tmp)
 {
 	size_t n, hn;
 	fpr *d00, *d11;
@@ -140,15 +171,16 @@ ffLDL_fft(fpr *restrict tree, const fpr *restrict g00,
 	tmp += n << 1;
 
 	memcpy(d00, g00, n * sizeof *g00);
-	Zf(poly_LDLmv_fft)(d11, tree, g00, g01, g11, logn);
+	Zf(poly_LDLmv_fft)(d11, tree + ffLDL_off_L(logn, seq),
+		g00, g01, g11, logn);
 
 	Zf(poly_split_fft)(tmp, tmp + hn, d00, logn);
 	Zf(poly_split_fft)(d00, d00 + hn, d11, logn);
 	memcpy(d11, tmp, n * sizeof *tmp);
-	ffLDL_fft_inner(tree + n,
-		d11, d11 + hn, logn - 1, tmp);
-	ffLDL_fft_inner(tree + n + ffLDL_treesize(logn - 1),
-		d00, d00 + hn, logn - 1, tmp);
+	ffLDL_fft_inner(tree + ffLDL_off_tree0(logn, seq),
+		d11, d11 + hn, logn - 1, seq, tmp);
+	ffLDL_fft_inner(tree + ffLDL_off_tree1(logn, seq),
+		d00, d00 + hn, logn - 1, seq, tmp);
 }
 
 /*
@@ -156,7 +188,7 @@ ffLDL_fft(fpr *restrict tree, const fpr *restrict g00,
  * sigma / sqrt(x).
  */
 static void
-ffLDL_binary_normalize(fpr *tree, unsigned orig_logn, unsigned logn)
+ffLDL_binary_normalize(fpr *tree, unsigned orig_logn, unsigned logn, int seq)
 {
 	/*
 	 * TODO: make an iterative version.
@@ -172,12 +204,111 @@ ffLDL_binary_normalize(fpr *tree, unsigned orig_logn, unsigned logn)
 		 */
 		tree[0] = fpr_mul(fpr_sqrt(tree[0]), fpr_inv_sigma[orig_logn]);
 	} else {
-		ffLDL_binary_normalize(tree + n, orig_logn, logn - 1);
-		ffLDL_binary_normalize(tree + n + ffLDL_treesize(logn - 1),
-			orig_logn, logn - 1);
+		ffLDL_binary_normalize(tree + ffLDL_off_tree0(logn, seq),
+			orig_logn, logn - 1, seq);
+		ffLDL_binary_normalize(tree + ffLDL_off_tree1(logn, seq),
+			orig_logn, logn - 1, seq);
 	}
 }
 
+/*
+ * Get the size of a compact LDL tree (see Zf(expand_privkey_compact)())
+ * for an input with polynomials of size 2^logn, of which 'levels'
+ * levels are stored. The size is expressed in the number of elements.
+ */
+static inline size_t
+ffLDL_compact_treesize(unsigned logn, unsigned levels)
+{
+	/*
+	 * A node below the stored levels keeps the two polynomials of
+	 * its Gram matrix row (2*2^logn elements); otherwise, the
+	 * relation is the same as in ffLDL_treesize().
+	 */
+	return (size_t)(levels + 2) << logn;
+}
+
+/*
+ * Inner function for ffLDL_fft_compact(); this is ffLDL_fft_inner(),
+ * except that after 'levels' levels, the Gram matrix row (g0,g1) is
+ * saved instead of the subtree.
+ */
+static void
+ffLDL_fft_compact_inner(fpr *restrict tree,
+	fpr *restrict g0, fpr *restrict g1, unsigned logn, unsigned levels,
+	fpr *restrict tmp)
+{
+	size_t n, hn;
+
+	n = MKN(logn);
+	if (levels == 0) {
+		memcpy(tree, g0, n * sizeof *g0);
+		memcpy(tree + n, g1, n * sizeof *g1);
+		return;
+	}
+	hn = n >> 1;
+
+	Zf(poly_LDLmv_fft)(tmp, tree, g0, g1, g0, logn);
+	Zf(poly_split_fft)(g1, g1 + hn, g0, logn);
+	Zf(poly_split_fft)(g0, g0 + hn, tmp, logn);
+	ffLDL_fft_compact_inner(tree + n,
+		g1, g1 + hn, logn - 1, levels - 1, tmp);
+	ffLDL_fft_compact_inner(
+		tree + n + ffLDL_compact_treesize(logn - 1, levels - 1),
+		g0, g0 + hn, logn - 1, levels - 1, tmp);
+}
+
+/*
+ * Compute the compact ffLDL tree of an auto-adjoint matrix G, with
+ * 'levels' stored levels (1 <= levels <= logn - 2). Parameters are as
+ * in ffLDL_fft(); the tree has ffLDL_compact_treesize(logn, levels)
+ * elements. The values are the same as in the full tree; since leaves
+ * are not stored, the tree needs no normalization.
+ */
+static void
+ffLDL_fft_compact(fpr *restrict tree, const fpr *restrict g00,
+	const fpr *restrict g01, const fpr *restrict g11,
+	unsigned logn, unsigned levels, fpr *restrict tmp)
+{
+	size_t n, hn;
+	fpr *d00, *d11;
+
+	n = MKN(logn);
+	hn = n >> 1;
+	d00 = tmp;
+	d11 = tmp + n;
+	tmp += n << 1;
+
+	memcpy(d00, g00, n * sizeof *g00);
+	Zf(poly_LDLmv_fft)(d11, tree, g00, g01, g11, logn);
+
+	Zf(poly_split_fft)(tmp, tmp + hn, d00, logn);
+	Zf(poly_split_fft)(d00, d00 + hn, d11, logn);
+	memcpy(d11, tmp, n * sizeof *tmp);
+	ffLDL_fft_compact_inner(tree + n,
+		d11, d11 + hn, logn - 1, levels - 1, tmp);
+	ffLDL_fft_compact_inner(
+		tree + n + ffLDL_compact_treesize(logn - 1, levels - 1),
+		d00, d00 + hn, logn - 1, levels - 1, tmp);
+}
+
+/*
+ * Rebuild the normalized ffLDL tree of a node from its Gram matrix row,
+ * as saved in a compact tree (gram[], 2*2^logn elements, unmodified).
+ * This yields exactly the corresponding subtree of the full tree.
+ * tmp[] must have room for three polynomials.
+ */
+static void
+ffLDL_rebuild(fpr *restrict tree, const fpr *restrict gram,
+	unsigned orig_logn, unsigned logn, fpr *restrict tmp)
+{
+	size_t n;
+
+	n = MKN(logn);
+	memcpy(tmp, gram, 2 * n * sizeof *gram);
+	ffLDL_fft_inner(tree, tmp, tmp + n, logn, 0, tmp + (n << 1));
+	ffLDL_binary_normalize(tree, orig_logn, logn, 0);
+}
+
 /* =================================================================== */
 
 /*
@@ -232,49 +363,43 @@ skoff_tree(unsigned logn)
 	return 4 * MKN(logn);
 }
 
-/* see inner.h */
-void
-Zf(expand_privkey)(fpr *restrict expanded_key,
+/*
+ * Load the private key elements into the B0 matrix, in FFT
+ * representation: B0 = [[g, -f], [G, -F]].
+ */
+static void
+load_basis_fft(fpr *restrict b00, fpr *restrict b01,
+	fpr *restrict b10, fpr *restrict b11,
 	const int8_t *f, const int8_t *g,
-	const int8_t *F, const int8_t *G,
-	unsigned logn, uint8_t *restrict tmp)
+	const int8_t *F, const int8_t *G, unsigned logn)
 {
-	size_t n;
-	fpr *rf, *rg, *rF, *rG;
-	fpr *b00, *b01, *b10, *b11;
-	fpr *g00, *g01, *g11, *gxx;
-	fpr *tree;
-
-	n = MKN(logn);
-	b00 = expanded_key + skoff_b00(logn);
-	b01 = expanded_key + skoff_b01(logn);
-	b10 = expanded_key + skoff_b10(logn);
-	b11 = expanded_key + skoff_b11(logn);
-	tree = expanded_key + skoff_tree(logn);
-
-	/*
-	 * We load the private key elements directly into the B0 matrix,
-	 * since B0 = [[g, -f], [G, -F]].
-	 */
-	rf = b01;
-	rg = b00;
-	rF = b11;
-	rG = b10;
-
-	smallints_to_fpr(rf, f, logn);
-	smallints_to_fpr(rg, g, logn);
-	smallints_to_fpr(rF, F, logn);
-	smallints_to_fpr(rG, G, logn);
+	smallints_to_fpr(b01, f, logn);
+	smallints_to_fpr(b00, g, logn);
+	smallints_to_fpr(b11, F, logn);
+	smallints_to_fpr(b10, G, logn);
 
 	/*
 	 * Compute the FFT for the key elements, and negate f and F.
 	 */
-	Zf(FFT)(rf, logn);
-	Zf(FFT)(rg, logn);
-	Zf(FFT)(rF, logn);
-	Zf(FFT)(rG, logn);
-	Zf(poly_neg)(rf, logn);
-	Zf(poly_neg)(rF, logn);
+	Zf(FFT)(b01, logn);
+	Zf(FFT)(b00, logn);
+	Zf(FFT)(b11, logn);
+	Zf(FFT)(b10, logn);
+	Zf(poly_neg)(b01, logn);
+	Zf(poly_neg)(b11, logn);
+}
+
+/*
+ * Compute the Gram matrix G = B·B* (upper triangle g00, g01, g11) of
+ * the B0 matrix. gxx[] must have room for one polynomial.
+ */
+static void
+basis_to_gram(fpr *restrict g00, fpr *restrict g01, fpr *restrict g11,
+	const fpr *restrict b00, const fpr *restrict b01,
+	const fpr *restrict b10, const fpr *restrict b11,
+	unsigned logn, fpr *restrict gxx)
+{
+	size_t n;
 
 	/*
 	 * The Gram matrix is G = B·B*. Formulas are:
@@ -286,11 +411,7 @@ Zf(expand_privkey)(fpr *restrict expanded_key,
 	 * For historical reasons, this implementation uses
 	 * g00, g01 and g11 (upper triangle).
 	 */
-	g00 = (fpr *)tmp;
-	g01 = g00 + n;
-	g11 = g01 + n;
-	gxx = g11 + n;
-
+	n = MKN(logn);
 	memcpy(g00, b00, n * sizeof *b00);
 	Zf(poly_mulselfadj_fft)(g00, logn);
 	memcpy(gxx, b01, n * sizeof *b01);
@@ -308,16 +429,84 @@ Zf(expand_privkey)(fpr *restrict expanded_key,
 	memcpy(gxx, b11, n * sizeof *b11);
 	Zf(poly_mulselfadj_fft)(gxx, logn);
 	Zf(poly_add)(g11, gxx, logn);
+}
+
+/* see inner.h */
+void
+Zf(expand_privkey)(fpr *restrict expanded_key,
+	const int8_t *f, const int8_t *g,
+	const int8_t *F, const int8_t *G,
+	unsigned logn, int seq, uint8_t *restrict tmp)
+{
+	size_t n;
+	fpr *b00, *b01, *b10, *b11;
+	fpr *g00, *g01, *g11, *gxx;
+	fpr *tree;
+
+	n = MKN(logn);
+	b00 = expanded_key + skoff_b00(logn);
+	b01 = expanded_key + skoff_b01(logn);
+	b10 = expanded_key + skoff_b10(logn);
+	b11 = expanded_key + skoff_b11(logn);
+	tree = expanded_key + skoff_tree(logn);
+
+	/*
+	 * We load the private key elements directly into the B0 matrix.
+	 */
+	load_basis_fft(b00, b01, b10, b11, f, g, F, G, logn);
+
+	g00 = (fpr *)tmp;
+	g01 = g00 + n;
+	g11 = g01 + n;
+	gxx = g11 + n;
+	basis_to_gram(g00, g01, g11, b00, b01, b10, b11, logn, gxx);
 
 	/*
 	 * Compute the Falcon tree.
 	 */
-	ffLDL_fft(tree, g00, g01, g11, logn, gxx);
+	ffLDL_fft(tree, g00, g01, g11, logn, seq, gxx);
 
 	/*
 	 * Normalize tree.
 	 */
-	ffLDL_binary_normalize(tree, logn, logn);
+	ffLDL_binary_normalize(tree, logn, logn, seq);
+}
+
+/* see inner.h */
+void
+Zf(expand_privkey_compact)(fpr *restrict compact_key,
+	const int8_t *f, const int8_t *g,
+	const int8_t *F, const int8_t *G,
+	unsigned logn, unsigned levels, uint8_t *restrict tmp)
+{
+	size_t n;
+	fpr *b00, *b01, *b10, *b11;
+	fpr *g00, *g01, *g11, *gxx;
+	int8_t *sk;
+
+	/*
+	 * The B0 matrix is not kept; it goes to tmp[], followed by the
+	 * Gram matrix.
+	 */
+	n = MKN(logn);
+	b00 = (fpr *)tmp;
+	b01 = b00 + n;
+	b10 = b01 + n;
+	b11 = b10 + n;
+	load_basis_fft(b00, b01, b10, b11, f, g, F, G, logn);
+
+	g00 = b11 + n;
+	g01 = g00 + n;
+	g11 = g01 + n;
+	gxx = g11 + n;
+	basis_to_gram(g00, g01, g11, b00, b01, b10, b11, logn, gxx);
+	ffLDL_fft_compact(compact_key, g00, g01, g11, logn, levels, gxx);
+
+	sk = (int8_t *)(compact_key + ffLDL_compact_treesize(logn, levels));
+	memcpy(sk, f, n);
+	memcpy(sk + n, g, n);
+	memcpy(sk + 2 * n, F, n);
+	memcpy(sk + 3 * n, G, n);
 }
 
 typedef int (*samplerZ)(void *ctx, fpr mu, fpr sigma);
@@ -418,7 +607,17 @@ ffSampling_fft_dyntree(samplerZ samp, void *samp_ctx,
 }
 
 /*
- * Perform Fast Fourier Sampling for target vector t and LDL tree T.
+ * Prefetch hint, for the tree walk in ffSampling_fft().
+ */
+#if defined __GNUC__ || defined __clang__
+#define PREFETCH(p)   __builtin_prefetch(p)
+#else
+#define PREFETCH(p)   ((void)(p))
+#endif
+
+/*
+ * Perform Fast Fourier Sampling for target vector t and LDL tree T,
+ * in the recursive (seq = 0) or sequential (seq = 1) layout.
  * tmp[] must have size for at least two polynomials of size 2^logn.
  */
 TARGET_AVX2
@@ -427,7 +626,7 @@ ffSampling_fft(samplerZ samp, void *samp_ctx,
 	fpr *restrict z0, fpr *restrict z1,
 	const fpr *restrict tree,
 	const fpr *restrict t0, const fpr *restrict t1, unsigned logn,
-	fpr *restrict tmp)
+	int seq, fpr *restrict tmp)
 {
 	size_t n, hn;
 	const fpr *tree0, *tree1;
@@ -732,8 +931,8 @@ ffSampling_fft(samplerZ samp, void *samp_ctx,
 
 	n = (size_t)1 << logn;
 	hn = n >> 1;
-	tree0 = tree + n;
-	tree1 = tree + n + ffLDL_treesize(logn - 1);
+	tree0 = tree + ffLDL_off_tree0(logn, seq);
+	tree1 = tree + ffLDL_off_tree1(logn, seq);
 
 	/*
 	 * We split t1 into z1 (reused as temporary storage), then do
@@ -742,15 +941,25 @@ ffSampling_fft(samplerZ samp, void *samp_ctx,
 	 */
 	Zf(poly_split_fft)(z1, z1 + hn, t1, logn);
 	ffSampling_fft(samp, samp_ctx, tmp, tmp + hn,
-		tree1, z1, z1 + hn, logn - 1, tmp + n);
+		tree1, z1, z1 + hn, logn - 1, seq, tmp + n);
 	Zf(poly_merge_fft)(z1, tmp, tmp + hn, logn);
 
+	/*
+	 * In the sequential layout, the left subtree walk starts with
+	 * the (inline) block of its leftmost degree-4 node, at its
+	 * start; it is fetched while L is in use.
+	 */
+	if (seq) {
+		PREFETCH(tree0);
+		PREFETCH(tree0 + 8);
+	}
+
 	/*
 	 * Compute tb0 = t0 + (t1 - z1) * L. Value tb0 ends up in tmp[].
 	 */
 	memcpy(tmp, t1, n * sizeof *t1);
 	Zf(poly_sub)(tmp, z1, logn);
-	Zf(poly_mul_fft)(tmp, tree, logn);
+	Zf(poly_mul_fft)(tmp, tree + ffLDL_off_L(logn, seq), logn);
 	Zf(poly_add)(tmp, t0, logn);
 
 	/*
@@ -758,7 +967,63 @@ ffSampling_fft(samplerZ samp, void *samp_ctx,
 	 */
 	Zf(poly_split_fft)(z0, z0 + hn, tmp, logn);
 	ffSampling_fft(samp, samp_ctx, tmp, tmp + hn,
-		tree0, z0, z0 + hn, logn - 1, tmp + n);
+		tree0, z0, z0 + hn, logn - 1, seq, tmp + n);
+	Zf(poly_merge_fft)(z0, tmp, tmp + hn, logn);
+}
+
+/*
+ * Perform Fast Fourier Sampling for target vector t and the compact LDL
+ * tree T with 'levels' stored levels (see ffLDL_fft_compact()). The
+ * stored levels are processed as in ffSampling_fft(); each node below
+ * them gets its subtree rebuilt into stmp[], then goes through
+ * ffSampling_fft(). The result is the same as with the full tree.
+ *
+ * tmp[] must have size for at least two polynomials of size 2^logn;
+ * stmp[] must have room for (logn+3)*2^(logn-levels) elements.
+ */
+TARGET_AVX2
+static void
+ffSampling_fft_compact(samplerZ samp, void *samp_ctx,
+	fpr *restrict z0, fpr *restrict z1,
+	const fpr *restrict tree,
+	const fpr *restrict t0, const fpr *restrict t1,
+	unsigned orig_logn, unsigned logn, unsigned levels,
+	fpr *restrict tmp, fpr *restrict stmp)
+{
+	size_t n, hn;
+	const fpr *tree0, *tree1;
+
+	if (levels == 0) {
+		ffLDL_rebuild(stmp, tree, orig_logn, logn,
+			stmp + ffLDL_treesize(logn));
+		ffSampling_fft(samp, samp_ctx, z0, z1,
+			stmp, t0, t1, logn, 0, tmp);
+		return;
+	}
+
+	n = (size_t)1 << logn;
+	hn = n >> 1;
+	tree0 = tree + n;
+	tree1 = tree + n + ffLDL_compact_treesize(logn - 1, levels - 1);
+
+	/*
+	 * Same steps as in ffSampling_fft().
+	 */
+	Zf(poly_split_fft)(z1, z1 + hn, t1, logn);
+	ffSampling_fft_compact(samp, samp_ctx, tmp, tmp + hn,
+		tree1, z1, z1 + hn, orig_logn, logn - 1, levels - 1,
+		tmp + n, stmp);
+	Zf(poly_merge_fft)(z1, tmp, tmp + hn, logn);
+
+	memcpy(tmp, t1, n * sizeof *t1);
+	Zf(poly_sub)(tmp, z1, logn);
+	Zf(poly_mul_fft)(tmp, tree, logn);
+	Zf(poly_add)(tmp, t0, logn);
+
+	Zf(poly_split_fft)(z0, z0 + hn, tmp, logn);
+	ffSampling_fft_compact(samp, samp_ctx, tmp, tmp + hn,
+		tree0, z0, z0 + hn, orig_logn, logn - 1, levels - 1,
+		tmp + n, stmp);
 	Zf(poly_merge_fft)(z0, tmp, tmp + hn, logn);
 }
 
@@ -768,19 +1033,23 @@ ffSampling_fft(samplerZ samp, void *samp_ctx,
  * computed, and if it is short enough, then s2 is returned into the
  * s2[] buffer, and 1 is returned; otherwise, s2[] is untouched and 0 is
  * returned; the caller should then try again. This function uses an
- * expanded key.
+ * expanded key: the B0 matrix and either the full LDL tree (levels = 0,
+ * layout given by seq) or a compact tree with 'levels' stored levels.
  *
- * tmp[] must have room for at least six polynomials.
+ * tmp[] must have room for at least six polynomials; with a compact
+ * tree, it must also have room for the (logn+3)*2^(logn-levels)
+ * elements of the rebuilt subtrees.
  */
 static int
 do_sign_tree(samplerZ samp, void *samp_ctx, int16_t *s2,
-	const fpr *restrict expanded_key,
+	const fpr *restrict b00, const fpr *restrict b01,
+	const fpr *restrict b10, const fpr *restrict b11,
+	const fpr *restrict tree, unsigned levels, int seq,
 	const uint16_t *hm,
 	unsigned logn, fpr *restrict tmp)
 {
 	size_t n, u;
 	fpr *t0, *t1, *tx, *ty;
-	const fpr *b00, *b01, *b10, *b11, *tree;
 	fpr ni;
 	uint32_t sqn, ng;
 	int16_t *s1tmp, *s2tmp;
@@ -788,11 +1057,6 @@ do_sign_tree(samplerZ samp, void *samp_ctx, int16_t *s2,
 	n = MKN(logn);
 	t0 = tmp;
 	t1 = t0 + n;
-	b00 = expanded_key + skoff_b00(logn);
-	b01 = expanded_key + skoff_b01(logn);
-	b10 = expanded_key + skoff_b10(logn);
-	b11 = expanded_key + skoff_b11(logn);
-	tree = expanded_key + skoff_tree(logn);
 
 	/*
 	 * Set the target vector to [hm, 0] (hm is the hashed message).
@@ -822,7 +1086,15 @@ do_sign_tree(samplerZ samp, void *samp_ctx, int16_t *s2,
 	/*
 	 * Apply sampling. Output is written back in [tx, ty].
 	 */
-	ffSampling_fft(samp, samp_ctx, tx, ty, tree, t0, t1, logn, ty + n);
+	PROF_BEGIN(FALCON_PROF_SAMPLE);
+	if (levels == 0) {
+		ffSampling_fft(samp, samp_ctx, tx, ty, tree, t0, t1,
+			logn, seq, ty + n);
+	} else {
+		ffSampling_fft_compact(samp, samp_ctx, tx, ty, tree, t0, t1,
+			logn, logn, levels, ty + n, ty + 3 * n);
+	}
+	PROF_END(FALCON_PROF_SAMPLE);
 
 	/*
 	 * Get the lattice point corresponding to that tiny vector.
@@ -845,6 +1117,7 @@ do_sign_tree(samplerZ samp, void *samp_ctx, int16_t *s2,
 	/*
 	 * Compute the signature.
 	 */
+	PROF_BEGIN(FALCON_PROF_NORM);
 	s1tmp = (int16_t *)tx;
 	sqn = 0;
 	ng = 0;
@@ -874,8 +1147,10 @@ do_sign_tree(samplerZ samp, void *samp_ctx, int16_t *s2,
 	if (Zf(is_short_half)(sqn, s2tmp, logn)) {
 		memcpy(s2, s2tmp, n * sizeof *s2);
 		memcpy(tmp, s1tmp, n * sizeof *s1tmp);
+		PROF_END(FALCON_PROF_NORM);
 		return 1;
 	}
+	PROF_END(FALCON_PROF_NORM);
 	return 0;
 }
 
@@ -1005,8 +1280,10 @@ do_sign_dyn(samplerZ samp, void *samp_ctx, int16_t *s2,
 	/*
 	 * Apply sampling; result is written over (t0,t1).
 	 */
+	PROF_BEGIN(FALCON_PROF_SAMPLE);
 	ffSampling_fft_dyntree(samp, samp_ctx,
 		t0, t1, g00, g01, g11, logn, logn, t1 + n);
+	PROF_END(FALCON_PROF_SAMPLE);
 
 	/*
 	 * We arrange the layout back to:
@@ -1052,6 +1329,7 @@ do_sign_dyn(samplerZ samp, void *samp_ctx, int16_t *s2,
 	Zf(iFFT)(t0, logn);
 	Zf(iFFT)(t1, logn);
 
+	PROF_BEGIN(FALCON_PROF_NORM);
 	s1tmp = (int16_t *)tx;
 	sqn = 0;
 	ng = 0;
@@ -1081,8 +1359,10 @@ do_sign_dyn(samplerZ samp, void *samp_ctx, int16_t *s2,
 	if (Zf(is_short_half)(sqn, s2tmp, logn)) {
 		memcpy(s2, s2tmp, n * sizeof *s2);
 		memcpy(tmp, s1tmp, n * sizeof *s1tmp);
+		PROF_END(FALCON_PROF_NORM);
 		return 1;
 	}
+	PROF_END(FALCON_PROF_NORM);
 	return 0;
 }
 
@@ -1285,6 +1565,175 @@ Zf(gaussian0_sampler)(prng *p)
 #endif // yyyAVX2-
 }
 
+/* see inner.h */
+TARGET_AVX2
+void
+Zf(gaussian0_batch)(uint8_t *z0, prng *p, size_t pos, size_t num)
+{
+	size_t ptr, u;
+
+	u = 0;
+
+#if FALCON_AVX2 || FALCON_NEON
+
+	/*
+	 * Same 72-bit table as in gaussian0_sampler(), one entry per
+	 * 64-bit value: high 15 bits and low 57 bits. Entries 7 to 17
+	 * have a zero high part. Four samples (two with NEON) are
+	 * compared with each entry at once.
+	 */
+	static const uint64_t thi[7] = {
+		0x51FB, 0x2A69, 0x113E, 0x0568, 0x014A, 0x003B, 0x0008
+	};
+	static const uint64_t tlo[18] = {
+		0x1F42ED3AC391802, 0x12B181F3F7DDB82,
+		0x1CDD0934829C1FF, 0x1754377C7994AE4,
+		0x1846CAEF33F1F6F, 0x14AC754ED74BD5F,
+		0x024DD542B776AE4, 0x1A1FFDC65AD63DA,
+		0x01F80D88A7B6428, 0x001C3FDB2040C69,
+		0x00012CF24D031FB, 0x00000949F8B091F,
+		0x0000003665DA998, 0x00000000EBF6EBB,
+		0x0000000002F5D7E, 0x000000000007098,
+		0x0000000000000C6, 0x000000000000001
+	};
+
+	const uint8_t *d;
+#endif
+
+#if FALCON_AVX2 // yyyAVX2+1
+
+	__m256i mlo, xlo, xhi, eq0, acc;
+
+	d = p->buf.d;
+	mlo = _mm256_set1_epi64x(0x1FFFFFFFFFFFFFF);
+	for (; u + 4 <= num; u += 4) {
+		union {
+			uint64_t u64[4];
+			__m256i ymm;
+		} r;
+		size_t q0, q1, q2, q3;
+		int j;
+
+		q0 = pos + u * SAMPLER_STRIDE;
+		q1 = q0 + SAMPLER_STRIDE;
+		q2 = q1 + SAMPLER_STRIDE;
+		q3 = q2 + SAMPLER_STRIDE;
+
+		/*
+		 * 72-bit values, as read by prng_get_u64() then
+		 * prng_get_u8(), split into high (15 bits) and low
+		 * (57 bits) parts.
+		 */
+		xlo = _mm256_set_epi64x(
+			*(const int64_t *)(d + q3), *(const int64_t *)(d + q2),
+			*(const int64_t *)(d + q1), *(const int64_t *)(d + q0));
+		xhi = _mm256_set_epi64x(d[q3 + 8], d[q2 + 8],
+			d[q1 + 8], d[q0 + 8]);
+		xhi = _mm256_or_si256(_mm256_slli_epi64(xhi, 7),
+			_mm256_srli_epi64(xlo, 57));
+		xlo = _mm256_and_si256(xlo, mlo);
+
+		/*
+		 * Count the table entries greater than the value; all
+		 * operands are below 2^63 so signed comparisons work.
+		 * Each match adds -1 to the accumulator.
+		 */
+		acc = _mm256_setzero_si256();
+		for (j = 0; j < 7; j ++) {
+			__m256i rhi, rlo, gt, eq;
+
+			rhi = _mm256_set1_epi64x((int64_t)thi[j]);
+			rlo = _mm256_set1_epi64x((int64_t)tlo[j]);
+			gt = _mm256_cmpgt_epi64(rhi, xhi);
+			eq = _mm256_cmpeq_epi64(rhi, xhi);
+			gt = _mm256_or_si256(gt, _mm256_and_si256(eq,
+				_mm256_cmpgt_epi64(rlo, xlo)));
+			acc = _mm256_add_epi64(acc, gt);
+		}
+		eq0 = _mm256_cmpeq_epi64(xhi, _mm256_setzero_si256());
+		for (j = 7; j < 18; j ++) {
+			__m256i rlo;
+
+			rlo = _mm256_set1_epi64x((int64_t)tlo[j]);
+			acc = _mm256_add_epi64(acc, _mm256_and_si256(eq0,
+				_mm256_cmpgt_epi64(rlo, xlo)));
+		}
+		r.ymm = _mm256_sub_epi64(_mm256_setzero_si256(), acc);
+		z0[u + 0] = (uint8_t)r.u64[0];
+		z0[u + 1] = (uint8_t)r.u64[1];
+		z0[u + 2] = (uint8_t)r.u64[2];
+		z0[u + 3] = (uint8_t)r.u64[3];
+	}
+
+#elif FALCON_NEON
+
+	uint64x2_t mlo, xlo, xhi, eq0, acc;
+
+	d = p->buf.d;
+	mlo = vdupq_n_u64(0x1FFFFFFFFFFFFFF);
+	for (; u + 2 <= num; u += 2) {
+		uint64_t w0, w1;
+		size_t q0, q1;
+		int j;
+
+		q0 = pos + u * SAMPLER_STRIDE;
+		q1 = q0 + SAMPLER_STRIDE;
+
+		/*
+		 * Same split as above; the 64-bit words are read in
+		 * little-endian order, as prng_get_u64() does (the NEON
+		 * build targets little-endian AArch64 only).
+		 */
+		memcpy(&w0, d + q0, sizeof w0);
+		memcpy(&w1, d + q1, sizeof w1);
+		xlo = vcombine_u64(vcreate_u64(w0), vcreate_u64(w1));
+		xhi = vcombine_u64(vcreate_u64(d[q0 + 8]),
+			vcreate_u64(d[q1 + 8]));
+		xhi = vorrq_u64(vshlq_n_u64(xhi, 7), vshrq_n_u64(xlo, 57));
+		xlo = vandq_u64(xlo, mlo);
+
+		/*
+		 * Comparisons are unsigned; each match is an all-ones
+		 * lane, subtracted from the accumulator.
+		 */
+		acc = vdupq_n_u64(0);
+		for (j = 0; j < 7; j ++) {
+			uint64x2_t rhi, rlo, gt, eq;
+
+			rhi = vdupq_n_u64(thi[j]);
+			rlo = vdupq_n_u64(tlo[j]);
+			gt = vcgtq_u64(rhi, xhi);
+			eq = vceqq_u64(rhi, xhi);
+			gt = vorrq_u64(gt, vandq_u64(eq, vcgtq_u64(rlo, xlo)));
+			acc = vsubq_u64(acc, gt);
+		}
+		eq0 = vceqq_u64(xhi, vdupq_n_u64(0));
+		for (j = 7; j < 18; j ++) {
+			uint64x2_t rlo;
+
+			rlo = vdupq_n_u64(tlo[j]);
+			acc = vsubq_u64(acc,
+				vandq_u64(eq0, vcgtq_u64(rlo, xlo)));
+		}
+		z0[u + 0] = (uint8_t)vgetq_lane_u64(acc, 0);
+		z0[u + 1] = (uint8_t)vgetq_lane_u64(acc, 1);
+	}
+
+#endif // yyyAVX2-
+
+	/*
+	 * Remaining values (all of them without AVX2 or NEON) go through
+	 * the single-sample code. No refill happens since all offsets are
+	 * in range.
+	 */
+	ptr = p->ptr;
+	for (; u < num; u ++) {
+		p->ptr = pos + u * SAMPLER_STRIDE;
+		z0[u] = (uint8_t)Zf(gaussian0_sampler)(p);
+	}
+	p->ptr = ptr;
+}
+
 /*
  * Sample a bit with probability exp(-x) for some x >= 0.
  */
@@ -1344,6 +1793,65 @@ BerExp(prng *p, fpr x, fpr ccs)
 	return (int)(w >> 31);
 }
 
+/* see inner.h */
+void
+Zf(sampler_init)(sampler_context *sc, inner_prng_context *src, unsigned logn)
+{
+	size_t num;
+
+	Zf(prng_init)(&sc->p, src);
+	sc->sigma_min = fpr_sigma_min[logn];
+	sc->rejections = 0;
+
+	/*
+	 * The first batch of base samples (at the start of the freshly
+	 * filled PRNG buffer) is computed here rather than on the first
+	 * sampler() call, so that a precomputed context (see
+	 * falcon_presign_make()) carries it too; the samples are the
+	 * same.
+	 */
+	num = ((sizeof sc->p.buf.d) - 10) / SAMPLER_STRIDE + 1;
+	Zf(gaussian0_batch)(sc->z0, &sc->p, 0, num);
+	sc->z0_pos = 0;
+	sc->z0_idx = 0;
+	sc->z0_num = (unsigned)num;
+}
+
+/*
+ * Get the next base sample, with the same PRNG consumption as
+ * gaussian0_sampler(). The batch is refilled when exhausted, or when
+ * the PRNG position is not the expected one (the previous BerExp
+ * used more than one byte). Whether that happens depends only on the
+ * number of bytes consumed, which the BerExp loop already exposes.
+ */
+TARGET_AVX2
+static inline int
+sampler_base(sampler_context *spc)
+{
+	size_t u;
+
+	u = spc->p.ptr;
+	if (spc->z0_idx >= spc->z0_num || u != spc->z0_pos) {
+		size_t num;
+
+		/*
+		 * Like prng_get_u64(), refill when fewer than 9 bytes
+		 * remain.
+		 */
+		if (u >= (sizeof spc->p.buf.d) - 9) {
+			Zf(prng_refill)(&spc->p);
+			u = 0;
+		}
+		num = ((sizeof spc->p.buf.d) - 10 - u) / SAMPLER_STRIDE + 1;
+		Zf(gaussian0_batch)(spc->z0, &spc->p, u, num);
+		spc->z0_idx = 0;
+		spc->z0_num = (unsigned)num;
+	}
+	spc->p.ptr = u + 9;
+	spc->z0_pos = u + SAMPLER_STRIDE;
+	return spc->z0[spc->z0_idx ++];
+}
+
 /*
  * The sampler produces a random integer that follows a discrete Gaussian
  * distribution, centered on mu, and with standard deviation sigma. The
@@ -1397,7 +1905,7 @@ Zf(sampler)(void *ctx, fpr mu, fpr isigma)
 		 *  - b = 0: z <= 0 and sampled against a Gaussian
 		 *    centered on 0.
 		 */
-		z0 = Zf(gaussian0_sampler)(&spc->p);
+		z0 = sampler_base(spc);
 		b = (int)prng_get_u8(&spc->p) & 1;
 		z = b + ((b << 1) - 1) * z0;
 
@@ -1435,16 +1943,19 @@ Zf(sampler)(void *ctx, fpr mu, fpr isigma)
 			 */
 			return s + z;
 		}
+		spc->rejections ++;
 	}
 }
 
 /* see inner.h */
 void
 Zf(sign_tree)(int16_t *sig, inner_prng_context *rng,
-	const fpr *restrict expanded_key,
-	const uint16_t *hm, unsigned logn, uint8_t *tmp)
+	const sampler_context *pre,
+	const fpr *restrict expanded_key, int seq,
+	const uint16_t *hm, unsigned logn, uint8_t *tmp, sign_stats *stats)
 {
 	fpr *ftmp;
+	int r;
 
 	ftmp = (fpr *)tmp;
 	for (;;) {
@@ -1464,32 +1975,102 @@ Zf(sign_tree)(int16_t *sig, inner_prng_context *rng,
 
 		/*
 		 * Normal sampling. We use a fast PRNG seeded from our
-		 * SHAKE context ('rng').
+		 * SHAKE context ('rng'), or the precomputed one for the
+		 * first attempt.
 		 */
-		spc.sigma_min = fpr_sigma_min[logn];
-		Zf(prng_init)(&spc.p, rng);
+		if (pre != NULL) {
+			spc = *pre;
+			pre = NULL;
+		} else {
+			Zf(sampler_init)(&spc, rng, logn);
+		}
 		samp = Zf(sampler);
 		samp_ctx = &spc;
 
 		/*
 		 * Do the actual signature.
 		 */
-		if (do_sign_tree(samp, samp_ctx, sig,
-			expanded_key, hm, logn, ftmp))
-		{
+		r = do_sign_tree(samp, samp_ctx, sig,
+			expanded_key + skoff_b00(logn),
+			expanded_key + skoff_b01(logn),
+			expanded_key + skoff_b10(logn),
+			expanded_key + skoff_b11(logn),
+			expanded_key + skoff_tree(logn), 0, seq,
+			hm, logn, ftmp);
+		if (stats != NULL) {
+			stats->attempts ++;
+			stats->rejections += spc.rejections;
+		}
+		if (r) {
+			break;
+		}
+	}
+}
+
+/* see inner.h */
+void
+Zf(sign_tree_compact)(int16_t *sig, inner_prng_context *rng,
+	const sampler_context *pre,
+	const fpr *restrict compact_key, unsigned levels,
+	const uint16_t *hm, unsigned logn, uint8_t *tmp, sign_stats *stats)
+{
+	size_t n;
+	const int8_t *sk;
+	fpr *b00, *b01, *b10, *b11, *ftmp;
+	int r;
+
+	/*
+	 * The B0 matrix is recomputed once, in tmp[]; the signature
+	 * attempts use the rest of tmp[].
+	 */
+	n = MKN(logn);
+	sk = (const int8_t *)(compact_key
+		+ ffLDL_compact_treesize(logn, levels));
+	b00 = (fpr *)tmp;
+	b01 = b00 + n;
+	b10 = b01 + n;
+	b11 = b10 + n;
+	ftmp = b11 + n;
+	load_basis_fft(b00, b01, b10, b11,
+		sk, sk + n, sk + 2 * n, sk + 3 * n, logn);
+	for (;;) {
+		sampler_context spc;
+
+		if (pre != NULL) {
+			spc = *pre;
+			pre = NULL;
+		} else {
+			Zf(sampler_init)(&spc, rng, logn);
+		}
+		r = do_sign_tree(Zf(sampler), &spc, sig,
+			b00, b01, b10, b11, compact_key, levels, 0,
+			hm, logn, ftmp);
+		if (stats != NULL) {
+			stats->attempts ++;
+			stats->rejections += spc.rejections;
+		}
+		if (r) {
 			break;
 		}
 	}
+
+	/*
+	 * Keep the s1 vector at the start of tmp[], as Zf(sign_tree)()
+	 * does.
+	 */
+	memcpy(tmp, ftmp, n * sizeof(int16_t));
 }
 
 /* see inner.h */
 void
 Zf(sign_dyn)(int16_t *sig, inner_prng_context *rng,
+	const sampler_context *pre,
 	const int8_t *restrict f, const int8_t *restrict g,
 	const int8_t *restrict F, const int8_t *restrict G,
-	const uint16_t *hm, unsigned logn, uint8_t *tmp)
+	const uint16_t *hm, unsigned logn, uint8_t *tmp, sign_stats *stats)
 {
 	fpr *ftmp;
+	int r;
 
 	ftmp = (fpr *)tmp;
 	for (;;) {
@@ -1509,19 +2090,28 @@ Zf(sign_dyn)(int16_t *sig, inner_prng_context *rng,
 
 		/*
 		 * Normal sampling. We use a fast PRNG seeded from our
-		 * SHAKE context ('rng').
+		 * SHAKE context ('rng'), or the precomputed one for the
+		 * first attempt.
 		 */
-		spc.sigma_min = fpr_sigma_min[logn];
-		Zf(prng_init)(&spc.p, rng);
+		if (pre != NULL) {
+			spc = *pre;
+			pre = NULL;
+		} else {
+			Zf(sampler_init)(&spc, rng, logn);
+		}
 		samp = Zf(sampler);
 		samp_ctx = &spc;
 
 		/*
 		 * Do the actual signature.
 		 */
-		if (do_sign_dyn(samp, samp_ctx, sig,
-			f, g, F, G, hm, logn, ftmp))
-		{
+		r = do_sign_dyn(samp, samp_ctx, sig,
+			f, g, F, G, hm, logn, ftmp);
+		if (stats != NULL) {
+			stats->attempts ++;
+			stats->rejections += spc.rejections;
+		}
+		if (r) {
 			break;
 		}
 	}
@@ -136,6 +136,8 @@ typedef struct {
 	uint8_t *pk;
 	uint8_t *sk;
 	uint8_t *esk;
+	uint8_t *csk;
+	unsigned levels;
 	uint8_t *sig;
 	size_t sig_len;
 	uint8_t *sigct;
@@ -249,6 +251,53 @@ bench_sign_tree_ct(void *ctx, unsigned long num)
 	return 0;
 }
 
+static int
+bench_expand_compact(void *ctx, unsigned long num)
+{
+	bench_context *bc;
+
+	bc = ctx;
+	while (num -- > 0) {
+		CC(falcon_expand_privkey_compact(
+			bc->csk, FALCON_COMPACTKEY_SIZE(bc->logn, bc->levels),
+			bc->levels, bc->sk, FALCON_PRIVKEY_SIZE(bc->logn),
+			bc->tmp, bc->tmp_len));
+	}
+	return 0;
+}
+
+static int
+bench_expand_sequential(void *ctx, unsigned long num)
+{
+	bench_context *bc;
+
+	bc = ctx;
+	while (num -- > 0) {
+		CC(falcon_expand_privkey_layout(
+			bc->esk, FALCON_EXPANDEDKEY_SIZE(bc->logn),
+			FALCON_EXPKEY_SEQUENTIAL,
+			bc->sk, FALCON_PRIVKEY_SIZE(bc->logn),
+			bc->tmp, bc->tmp_len));
+	}
+	return 0;
+}
+
+static int
+bench_sign_compact(void *ctx, unsigned long num)
+{
+	bench_context *bc;
+
+	bc = ctx;
+	while (num -- > 0) {
+		bc->sig_len = FALCON_SIG_COMPRESSED_MAXSIZE(bc->logn);
+		CC(falcon_sign_tree(&bc->rng,
+			bc->sig, &bc->sig_len, FALCON_SIG_COMPRESSED,
+			bc->csk,
+			"data", 4, bc->tmp, bc->tmp_len));
+	}
+	return 0;
+}
+
 static int
 bench_verify(void *ctx, unsigned long num)
 {
@@ -348,11 +397,212 @@ test_speed_falcon(unsigned logn, double threshold)
 	xfree(bc.sigct);
 }
 
+/*
+ * Compact expanded keys: key size, expansion and signature time for
+ * each number of stored tree levels. The last line is the full
+ * expanded key, for comparison.
+ */
+static void
+test_speed_compact(unsigned logn, double threshold)
+{
+	bench_context bc;
+	size_t len;
+	unsigned levels;
+
+	bc.logn = logn;
+	if (prng_init_prng_from_system(&bc.rng) != 0) {
+		fprintf(stderr, "random seeding failed\n");
+		exit(EXIT_FAILURE);
+	}
+	len = FALCON_TMPSIZE_KEYGEN(logn);
+	len = maxsz(len, FALCON_TMPSIZE_SIGNTREE(logn));
+	len = maxsz(len, FALCON_TMPSIZE_EXPANDPRIV(logn));
+	len = maxsz(len, FALCON_TMPSIZE_EXPANDCOMPACT(logn));
+	len = maxsz(len, FALCON_TMPSIZE_SIGNCOMPACT(logn));
+	bc.tmp = xmalloc(len);
+	bc.tmp_len = len;
+	bc.pk = xmalloc(FALCON_PUBKEY_SIZE(logn));
+	bc.sk = xmalloc(FALCON_PRIVKEY_SIZE(logn));
+	bc.esk = xmalloc(FALCON_EXPANDEDKEY_SIZE(logn));
+	bc.csk = xmalloc(FALCON_COMPACTKEY_SIZE(logn, logn - 2));
+	bc.sig = xmalloc(FALCON_SIG_COMPRESSED_MAXSIZE(logn));
+	bc.sig_len = 0;
+	bc.sigct = NULL;
+	bc.sigct_len = 0;
+	if (bench_keygen(&bc, 1) != 0) {
+		fprintf(stderr, "key setup failed\n");
+		exit(EXIT_FAILURE);
+	}
+
+	for (levels = 1; levels + 2 <= logn; levels ++) {
+		bc.levels = levels;
+		printf("%4u: %6u %8.1f", 1u << logn, levels,
+			(double)FALCON_COMPACTKEY_SIZE(logn, levels) / 1024.0);
+		fflush(stdout);
+		printf(" %8.2f",
+			do_bench(&bench_expand_compact, &bc, threshold)
+			/ 1000.0);
+		fflush(stdout);
+		printf(" %8.2f\n",
+			do_bench(&bench_sign_compact, &bc, threshold)
+			/ 1000.0);
+		fflush(stdout);
+	}
+	printf("%4u:   full %8.1f", 1u << logn,
+		(double)FALCON_EXPANDEDKEY_SIZE(logn) / 1024.0);
+	fflush(stdout);
+	printf(" %8.2f",
+		do_bench(&bench_expand_privkey, &bc, threshold) / 1000.0);
+	fflush(stdout);
+	printf(" %8.2f\n",
+		do_bench(&bench_sign_tree, &bc, threshold) / 1000.0);
+	fflush(stdout);
+	printf("%4u:    seq %8.1f", 1u << logn,
+		(double)FALCON_EXPANDEDKEY_SIZE(logn) / 1024.0);
+	fflush(stdout);
+	printf(" %8.2f",
+		do_bench(&bench_expand_sequential, &bc, threshold) / 1000.0);
+	fflush(stdout);
+	printf(" %8.2f\n",
+		do_bench(&bench_sign_tree, &bc, threshold) / 1000.0);
+	fflush(stdout);
+
+	xfree(bc.tmp);
+	xfree(bc.pk);
+	xfree(bc.sk);
+	xfree(bc.esk);
+	xfree(bc.csk);
+	xfree(bc.sig);
+}
+
+/*
+ * Print the per-phase breakdown of one operation, from the counters
+ * accumulated over a do_bench() run. Values are mean ticks per
+ * operation; 'ops' is the phase counting the operations.
+ */
+static void
+print_profile(const char *name, const falcon_profile *prof, int ops)
+{
+	static const struct {
+		int phase;
+		const char *name;
+	} phases[] = {
+		{ FALCON_PROF_DECODE, "decode" },
+		{ FALCON_PROF_HASH,   "hash" },
+		{ FALCON_PROF_SAMPLE, "sample" },
+		{ FALCON_PROF_NORM,   "norm" },
+		{ FALCON_PROF_VERIFY, "verify" },
+		{ FALCON_PROF_ENCODE, "encode" },
+	};
+	double num;
+	uint64_t inner;
+	size_t u;
+
+	num = (double)prof->count[ops];
+	if (num == 0.0) {
+		return;
+	}
+	printf("  %-4s", name);
+	for (u = 0; u < sizeof phases / sizeof phases[0]; u ++) {
+		int ph;
+
+		ph = phases[u].phase;
+		if (prof->count[ph] != 0) {
+			printf(" %s %9.0f", phases[u].name,
+				(double)prof->ticks[ph] / num);
+		}
+	}
+	if (prof->count[FALCON_PROF_SIGN] != 0) {
+		/*
+		 * Whatever signing does outside of sampling and the norm
+		 * check: basis multiplication, FFT, PRNG seeding.
+		 */
+		inner = prof->ticks[FALCON_PROF_SAMPLE]
+			+ prof->ticks[FALCON_PROF_NORM];
+		printf(" other %9.0f attempts %.4f",
+			(double)(prof->ticks[FALCON_PROF_SIGN] - inner) / num,
+			(double)prof->count[FALCON_PROF_SAMPLE]
+			/ (double)prof->count[FALCON_PROF_SIGN]);
+	}
+	printf("\n");
+	fflush(stdout);
+}
+
+static void
+profile_falcon(unsigned logn, double threshold)
+{
+	static const struct {
+		const char *name;
+		bench_fun bf;
+		int ops;
+	} ops[] = {
+		{ "sd",  &bench_sign_dyn,     FALCON_PROF_SIGN },
+		{ "sdc", &bench_sign_dyn_ct,  FALCON_PROF_SIGN },
+		{ "st",  &bench_sign_tree,    FALCON_PROF_SIGN },
+		{ "stc", &bench_sign_tree_ct, FALCON_PROF_SIGN },
+		{ "vv",  &bench_verify,       FALCON_PROF_VERIFY },
+		{ "vvc", &bench_verify_ct,    FALCON_PROF_VERIFY },
+	};
+	bench_context bc;
+	falcon_profile prof;
+	size_t len, u;
+
+	printf("%4u:\n", 1u << logn);
+	fflush(stdout);
+
+	bc.logn = logn;
+	if (prng_init_prng_from_system(&bc.rng) != 0) {
+		fprintf(stderr, "random seeding failed\n");
+		exit(EXIT_FAILURE);
+	}
+	len = FALCON_TMPSIZE_KEYGEN(logn);
+	len = maxsz(len, FALCON_TMPSIZE_SIGNDYN(logn));
+	len = maxsz(len, FALCON_TMPSIZE_SIGNTREE(logn));
+	len = maxsz(len, FALCON_TMPSIZE_EXPANDPRIV(logn));
+	len = maxsz(len, FALCON_TMPSIZE_VERIFY(logn));
+	bc.tmp = xmalloc(len);
+	bc.tmp_len = len;
+	bc.pk = xmalloc(FALCON_PUBKEY_SIZE(logn));
+	bc.sk = xmalloc(FALCON_PRIVKEY_SIZE(logn));
+	bc.esk = xmalloc(FALCON_EXPANDEDKEY_SIZE(logn));
+	bc.sig = xmalloc(FALCON_SIG_COMPRESSED_MAXSIZE(logn));
+	bc.sig_len = 0;
+	bc.sigct = xmalloc(FALCON_SIG_CT_SIZE(logn));
+	bc.sigct_len = 0;
+
+	if (bench_keygen(&bc, 1) != 0 || bench_expand_privkey(&bc, 1) != 0
+		|| bench_sign_dyn(&bc, 1) != 0 || bench_sign_dyn_ct(&bc, 1) != 0)
+	{
+		fprintf(stderr, "key setup failed\n");
+		exit(EXIT_FAILURE);
+	}
+	for (u = 0; u < sizeof ops / sizeof ops[0]; u ++) {
+		falcon_profile_reset();
+		do_bench(ops[u].bf, &bc, threshold);
+		falcon_profile_get(&prof);
+		print_profile(ops[u].name, &prof, ops[u].ops);
+	}
+
+	xfree(bc.tmp);
+	xfree(bc.pk);
+	xfree(bc.sk);
+	xfree(bc.esk);
+	xfree(bc.sig);
+	xfree(bc.sigct);
+}
+
 int
 main(int argc, char *argv[])
 {
 	double threshold;
+	int profile;
 
+	profile = 0;
+	if (argc >= 2 && strcmp(argv[1], "-p") == 0) {
+		profile = 1;
+		argc --;
+		argv ++;
+	}
 	if (argc < 2) {
 		threshold = 2.0;
 	} else if (argc == 2) {
@@ -362,11 +612,35 @@ main(int argc, char *argv[])
 	}
 	if (threshold <= 0.0 || threshold > 60.0) {
 		fprintf(stderr,
-"usage: speed [ threshold ]\n"
+"usage: speed [ -p ] [ threshold ]\n"
 "'threshold' is the minimum time for a bench run, in seconds (must be\n"
-"positive and less than 60).\n");
+"positive and less than 60).\n"
+"-p prints the per-phase breakdown of signing and verification; the\n"
+"library must be compiled with FALCON_PROFILE=1.\n");
 		exit(EXIT_FAILURE);
 	}
+	if (profile) {
+		falcon_profile prof;
+		int unit;
+
+		unit = falcon_profile_get(&prof);
+		if (unit == FALCON_PROF_UNIT_NONE) {
+			fprintf(stderr, "compiled without FALCON_PROFILE\n");
+			exit(EXIT_FAILURE);
+		}
+		printf("time threshold = %.4f s\n", threshold);
+		printf("mean %s per operation for each phase;"
+			" 'other' is the rest of the core signing\n",
+			unit == FALCON_PROF_UNIT_CYCLES ? "cycles" : "nanoseconds");
+		printf("attempts = signing attempts per signature"
+			" (norm check retries)\n");
+		printf("\n");
+		fflush(stdout);
+		profile_falcon(8, threshold);
+		profile_falcon(9, threshold);
+		profile_falcon(10, threshold);
+		return 0;
+	}
 	printf("time threshold = %.4f s\n", threshold);
 	printf("kg = keygen, ek = expand private key, sd = sign (without expanded key)\n");
 	printf("st = sign (with expanded key), vv = verify\n");
@@ -378,5 +652,26 @@ main(int argc, char *argv[])
 	test_speed_falcon(8, threshold);
 	test_speed_falcon(9, threshold);
 	test_speed_falcon(10, threshold);
+
+	printf("\n");
+	printf("compact expanded keys (falcon_expand_privkey_compact()),\n");
+	printf("then full keys in the recursive and sequential layouts:\n");
+	printf("degree levels size(kB)   ek(us)   st(us)\n");
+	fflush(stdout);
+	test_speed_compact(9, threshold);
+	test_speed_compact(10, threshold);
+
+	/*
+	 * Degrees 512 and 1024 again without the degree-specialized
+	 * FFT and NTT, for comparison.
+	 */
+	if (falcon_set_specialized(0)) {
+		printf("\n");
+		printf("generic-degree code (falcon_set_specialized(0)):\n");
+		fflush(stdout);
+		test_speed_falcon(9, threshold);
+		test_speed_falcon(10, threshold);
+		falcon_set_specialized(1);
+	}
 	return 0;
 }
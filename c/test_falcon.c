@@ -2147,6 +2147,259 @@ test_codec(void)
 	fflush(stdout);
 }
 
+/*
+ * Bit-at-a-time compressed encoder and decoder, as they were before the
+ * 64-bit window versions in codec.c; the fuzz test below checks that
+ * both produce and accept exactly the same things.
+ */
+static size_t
+ref_comp_encode(void *out, size_t max_out_len,
+	const int16_t *x, unsigned logn)
+{
+	uint8_t *buf;
+	size_t n, u, v;
+	uint32_t acc;
+	unsigned acc_len;
+
+	n = (size_t)1 << logn;
+	buf = out;
+	for (u = 0; u < n; u ++) {
+		if (x[u] < -2047 || x[u] > +2047) {
+			return 0;
+		}
+	}
+	acc = 0;
+	acc_len = 0;
+	v = 0;
+	for (u = 0; u < n; u ++) {
+		int t;
+		unsigned w;
+
+		acc <<= 1;
+		t = x[u];
+		if (t < 0) {
+			t = -t;
+			acc |= 1;
+		}
+		w = (unsigned)t;
+		acc <<= 7;
+		acc |= w & 127u;
+		w >>= 7;
+		acc_len += 8;
+		acc <<= (w + 1);
+		acc |= 1;
+		acc_len += w + 1;
+		while (acc_len >= 8) {
+			acc_len -= 8;
+			if (buf != NULL) {
+				if (v >= max_out_len) {
+					return 0;
+				}
+				buf[v] = (uint8_t)(acc >> acc_len);
+			}
+			v ++;
+		}
+	}
+	if (acc_len > 0) {
+		if (buf != NULL) {
+			if (v >= max_out_len) {
+				return 0;
+			}
+			buf[v] = (uint8_t)(acc << (8 - acc_len));
+		}
+		v ++;
+	}
+	return v;
+}
+
+static size_t
+ref_comp_decode(int16_t *x, unsigned logn,
+	const void *in, size_t max_in_len)
+{
+	const uint8_t *buf;
+	size_t n, u, v;
+	uint32_t acc;
+	unsigned acc_len;
+
+	n = (size_t)1 << logn;
+	buf = in;
+	acc = 0;
+	acc_len = 0;
+	v = 0;
+	for (u = 0; u < n; u ++) {
+		unsigned b, s, m;
+
+		if (v >= max_in_len) {
+			return 0;
+		}
+		acc = (acc << 8) | (uint32_t)buf[v ++];
+		b = acc >> acc_len;
+		s = b & 128;
+		m = b & 127;
+		for (;;) {
+			if (acc_len == 0) {
+				if (v >= max_in_len) {
+					return 0;
+				}
+				acc = (acc << 8) | (uint32_t)buf[v ++];
+				acc_len = 8;
+			}
+			acc_len --;
+			if (((acc >> acc_len) & 1) != 0) {
+				break;
+			}
+			m += 128;
+			if (m > 2047) {
+				return 0;
+			}
+		}
+		if (s && m == 0) {
+			return 0;
+		}
+		x[u] = (int16_t)(s ? -(int)m : (int)m);
+	}
+	if ((acc & ((1u << acc_len) - 1u)) != 0) {
+		return 0;
+	}
+	return v;
+}
+
+static void
+test_comp_fuzz(void)
+{
+	static int16_t s1[1024], s2[1024], s3[1024];
+	static uint8_t e1[4096], e2[4096];
+	prng p;
+	inner_prng_context sc;
+	unsigned logn;
+
+	printf("Test comp encode/decode fuzz: ");
+	fflush(stdout);
+
+	inner_prng_init(&sc);
+	inner_prng_inject(&sc, (const uint8_t *)"comp fuzz", 9);
+	inner_prng_flip(&sc);
+	Zf(prng_init)(&p, &sc);
+	for (logn = 1; logn <= 10; logn ++) {
+		size_t n, u;
+		int i;
+
+		n = (size_t)1 << logn;
+		for (i = 0; i < 2000; i ++) {
+			size_t len1, len2, max_len, r1, r2;
+			unsigned mode, scale;
+
+			/*
+			 * Coefficients of various magnitudes, sometimes
+			 * out of range.
+			 */
+			scale = 1 + (prng_get_u8(&p) & 15);
+			for (u = 0; u < n; u ++) {
+				int t;
+
+				t = (int)(prng_get_u64(&p) % (1u << scale));
+				if ((prng_get_u8(&p) & 1) != 0) {
+					t = -t;
+				}
+				if (scale == 16) {
+					t = (t & 0x0FFF) - 2048;
+				} else if (t > 2047 || t < -2047) {
+					t /= 2;
+				}
+				s1[u] = (int16_t)t;
+			}
+
+			/*
+			 * Encoding, with enough room or not.
+			 */
+			len1 = Zf(comp_encode)(NULL, 0, s1, logn);
+			len2 = ref_comp_encode(NULL, 0, s1, logn);
+			if (len1 != len2) {
+				fprintf(stderr, "comp_encode length: %zu / %zu\n",
+					len1, len2);
+				exit(EXIT_FAILURE);
+			}
+			max_len = prng_get_u8(&p) < 32
+				? (size_t)(prng_get_u64(&p) % (len2 + 2))
+				: sizeof e1;
+			memset(e1, 0, sizeof e1);
+			memset(e2, 0, sizeof e2);
+			len1 = Zf(comp_encode)(e1, max_len, s1, logn);
+			len2 = ref_comp_encode(e2, max_len, s1, logn);
+			if (len1 != len2 || (len1 != 0
+				&& memcmp(e1, e2, len1) != 0))
+			{
+				fprintf(stderr, "comp_encode mismatch\n");
+				exit(EXIT_FAILURE);
+			}
+			if (len2 == 0) {
+				len2 = ref_comp_encode(e2, sizeof e2, s1, logn);
+			}
+
+			/*
+			 * Decoding of the valid encoding, of a mutated
+			 * copy (bit flips, truncation, trailing or random
+			 * data).
+			 */
+			mode = prng_get_u8(&p) & 7;
+			max_len = len2;
+			switch (mode) {
+			case 1: case 2: case 3:
+				for (u = 0; u < mode; u ++) {
+					size_t j;
+
+					j = (size_t)(prng_get_u64(&p)
+						% (len2 == 0 ? 1 : len2));
+					e2[j] ^= 1u << (prng_get_u8(&p) & 7);
+				}
+				break;
+			case 4:
+				max_len = (size_t)(prng_get_u64(&p)
+					% (len2 + 1));
+				break;
+			case 5:
+				for (u = 0; u < 16; u ++) {
+					e2[len2 + u] = prng_get_u8(&p);
+				}
+				max_len = len2 + (prng_get_u8(&p) & 15);
+				break;
+			case 6:
+				for (u = 0; u < len2 + 16; u ++) {
+					e2[u] = prng_get_u8(&p);
+				}
+				max_len = len2 + 16;
+				break;
+			default:
+				break;
+			}
+			memcpy(e1, e2, sizeof e1);
+			memset(s2, 0, sizeof s2);
+			memset(s3, 0, sizeof s3);
+			r1 = Zf(comp_decode)(s2, logn, e1, max_len);
+			r2 = ref_comp_decode(s3, logn, e2, max_len);
+			if (r1 != r2 || (r1 != 0
+				&& memcmp(s2, s3, n * sizeof *s2) != 0))
+			{
+				fprintf(stderr, "comp_decode mismatch"
+					" (logn=%u, mode=%u): %zu / %zu\n",
+					logn, mode, r1, r2);
+				exit(EXIT_FAILURE);
+			}
+			if (mode == 0 && len2 != 0 && (r1 != len2
+				|| memcmp(s1, s2, n * sizeof *s1) != 0))
+			{
+				fprintf(stderr, "comp_decode roundtrip\n");
+				exit(EXIT_FAILURE);
+			}
+		}
+		printf(".");
+		fflush(stdout);
+	}
+
+	printf(" done.\n");
+	fflush(stdout);
+}
+
 static void
 test_vrfy_inner(unsigned logn, const int8_t *f, const int8_t *g,
 	const int8_t *F, const int8_t *G, const uint16_t *h,
@@ -2312,6 +2565,177 @@ test_vrfy(void)
 	fflush(stdout);
 }
 
+/*
+ * The AVX2 build of the core (see falcon.c) has its own NTT and
+ * pointwise routines for arithmetic modulo q; they must match the
+ * generic ones exactly.
+ */
+#ifndef FALCON_PREFIX_AVX2
+#define FALCON_PREFIX_AVX2   falcon_inner_avx2
+#endif
+#define Zv(name)   Zf_(FALCON_PREFIX_AVX2, name)
+
+void Zv(hash_to_point_ct)(inner_prng_context *sc,
+	uint16_t *x, unsigned logn, uint8_t *tmp);
+void Zv(keygen)(inner_prng_context *rng,
+	int8_t *f, int8_t *g, int8_t *F, int8_t *G, uint16_t *h,
+	unsigned logn, uint8_t *tmp);
+void Zv(to_ntt_monty)(uint16_t *h, unsigned logn);
+int Zv(verify_raw)(const uint16_t *c0, const int16_t *s2,
+	const uint16_t *h, unsigned logn, uint8_t *tmp);
+int Zv(compute_public)(uint16_t *h,
+	const int8_t *f, const int8_t *g, unsigned logn, uint8_t *tmp);
+
+/*
+ * Tell whether the vector build (AVX2 or NEON, see falcon.c) can run on
+ * this CPU. The selected implementation is left unchanged.
+ */
+static int
+have_vector_impl(void)
+{
+	int orig_impl, r;
+
+	orig_impl = falcon_get_impl();
+	r = falcon_set_impl(FALCON_IMPL_AVX2) == 0
+		|| falcon_set_impl(FALCON_IMPL_NEON) == 0;
+	falcon_set_impl(orig_impl);
+	return r;
+}
+
+static void
+test_vrfy_impl(void)
+{
+	inner_prng_context rng;
+	prng p;
+	uint16_t h1[1024], h2[1024], c0[1024];
+	int16_t s2[1024];
+	int8_t f[1024], g[1024];
+	uint8_t tmp1[2048], tmp2[2048];
+	unsigned logn;
+
+	printf("Test verify (generic/vector): ");
+	fflush(stdout);
+
+	if (!have_vector_impl()) {
+		printf("skipped.\n");
+		fflush(stdout);
+		return;
+	}
+
+	inner_prng_init(&rng);
+	inner_prng_inject(&rng, (const uint8_t *)"vrfy-avx2", 9);
+	inner_prng_flip(&rng);
+	Zf(prng_init)(&p, &rng);
+	for (logn = 1; logn <= 10; logn ++) {
+		size_t u, n;
+		int i;
+
+		n = (size_t)1 << logn;
+		for (i = 0; i < 20; i ++) {
+			int r1, r2;
+
+			/*
+			 * Random public key, point and short vector.
+			 */
+			for (u = 0; u < n; u ++) {
+				h1[u] = (uint16_t)(prng_get_u64(&p) % 12289);
+				c0[u] = (uint16_t)(prng_get_u64(&p) % 12289);
+				s2[u] = (int16_t)((prng_get_u8(&p) & 0x7F) - 64);
+				f[u] = (int8_t)((prng_get_u8(&p) & 0x1F) - 16);
+				g[u] = (int8_t)((prng_get_u8(&p) & 0x1F) - 16);
+			}
+			memcpy(h2, h1, n * sizeof *h1);
+			Zf(to_ntt_monty)(h1, logn);
+			Zv(to_ntt_monty)(h2, logn);
+			check_eq(h1, h2, n * sizeof *h1, "to_ntt_monty");
+
+			r1 = Zf(verify_raw)(c0, s2, h1, logn, tmp1);
+			r2 = Zv(verify_raw)(c0, s2, h2, logn, tmp2);
+			if (r1 != r2) {
+				fprintf(stderr, "verify_raw mismatch\n");
+				exit(EXIT_FAILURE);
+			}
+			check_eq(tmp1, tmp2, n * sizeof *s2, "verify_raw");
+
+			r1 = Zf(compute_public)(h1, f, g, logn, tmp1);
+			r2 = Zv(compute_public)(h2, f, g, logn, tmp2);
+			if (r1 != r2) {
+				fprintf(stderr, "compute_public mismatch\n");
+				exit(EXIT_FAILURE);
+			}
+			if (r1) {
+				check_eq(h1, h2, n * sizeof *h1,
+					"compute_public");
+			}
+		}
+		printf(".");
+		fflush(stdout);
+	}
+
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+/*
+ * The vector hash_to_point_ct() (AVX2 or NEON, whichever the vector
+ * build targets) must return the same points as the generic one, and
+ * consume the same PRNG bytes.
+ */
+static void
+test_htp_impl(void)
+{
+	uint16_t x1[1024], x2[1024];
+	uint8_t tmp[2048];
+	unsigned logn;
+	int orig_impl;
+
+	printf("Test hash-to-point CT (generic/vector): ");
+	fflush(stdout);
+
+	if (!have_vector_impl()) {
+		printf("skipped.\n");
+		fflush(stdout);
+		return;
+	}
+	orig_impl = falcon_get_impl();
+	printf("[%s]", falcon_set_impl(FALCON_IMPL_NEON) == 0
+		? "neon" : "avx2");
+	falcon_set_impl(orig_impl);
+
+	for (logn = 1; logn <= 10; logn ++) {
+		size_t n;
+		int i;
+
+		n = (size_t)1 << logn;
+		for (i = 0; i < 1000; i ++) {
+			inner_prng_context sc1, sc2;
+			uint8_t seed[6], t1[16], t2[16];
+
+			seed[0] = 'h';
+			seed[1] = 't';
+			seed[2] = 'p';
+			seed[3] = (uint8_t)logn;
+			seed[4] = (uint8_t)i;
+			seed[5] = (uint8_t)(i >> 8);
+			inner_prng_init(&sc1);
+			inner_prng_inject(&sc1, seed, sizeof seed);
+			inner_prng_flip(&sc1);
+			sc2 = sc1;
+			Zf(hash_to_point_ct)(&sc1, x1, logn, tmp);
+			Zv(hash_to_point_ct)(&sc2, x2, logn, tmp);
+			check_eq(x1, x2, n * sizeof *x1, "hash_to_point_ct");
+			inner_prng_extract(&sc1, t1, sizeof t1);
+			inner_prng_extract(&sc2, t2, sizeof t2);
+			check_eq(t1, t2, sizeof t1, "hash_to_point_ct state");
+		}
+		printf(".");
+		fflush(stdout);
+	}
+
+	printf(" done.\n");
+	fflush(stdout);
+}
+
 static const uint64_t KAT_RNG_1[] = {
 	0xDB1F30843AAD694Cu, 0xFAD9C14E86D5B53Cu, 0x7F84F914F46C439Fu,
 	0xC46A6E399A376C6Du, 0x47A5CD6F8C6B1789u, 0x1E85D879707DA987u,
@@ -3582,8 +4006,7 @@ test_sampler(void)
 	inner_prng_init(&rng);
 	inner_prng_inject(&rng, (const void *)"test sampler", 12);
 	inner_prng_flip(&rng);
-	Zf(prng_init)(&sc.p, &rng);
-	sc.sigma_min = fpr_sigma_min[9];
+	Zf(sampler_init)(&sc, &rng, 9);
 
 	isigma = fpr_div(fpr_of(10), fpr_of(17));
 	mu = fpr_neg(fpr_one);
@@ -3600,103 +4023,409 @@ test_sampler(void)
 	fflush(stdout);
 }
 
+int Zv(gaussian0_sampler)(prng *p);
+void Zv(gaussian0_batch)(uint8_t *z0, prng *p, size_t pos, size_t num);
+
+/*
+ * Batched base samples must match gaussian0_sampler() at every buffer
+ * offset, in both builds; and the sampler must produce the same values
+ * whether its batch is reused or recomputed on every call.
+ */
 static void
-test_sign_self(const int8_t *f, const int8_t *g,
-	const int8_t *F, const int8_t *G, const uint16_t *h_src,
-	unsigned logn, uint8_t *tmp)
+test_gaussian0_batch(void)
 {
-	int i;
-	size_t n;
 	inner_prng_context rng;
-	char buf[20];
-	uint16_t *h, *hm, *hm2;
-	int16_t *sig;
-	uint8_t *tt;
-	fpr *expanded_key;
-
-	n = (size_t)1 << logn;
-	h = (uint16_t *)tmp;
-	hm = h + n;
-	sig = (int16_t *)(hm + n);
-	hm2 = (uint16_t *)sig;
-	tt = (uint8_t *)(sig + n);
-	if (logn == 1) {
-		tt += 4;
-	}
+	prng p;
+	sampler_context sc1, sc2;
+	uint8_t z0[SAMPLER_BATCH];
+	int vec, i;
 
-	memcpy(h, h_src, n * sizeof *h);
-	Zf(to_ntt_monty)(h, logn);
+	printf("Test gaussian0 batch: ");
+	fflush(stdout);
 
-	/* sprintf(buf, "sign %u", logn); */
-	memcpy(buf, "sign 0", 7);
-	buf[5] = '0' + logn;
+	vec = have_vector_impl();
 
 	inner_prng_init(&rng);
-	inner_prng_inject(&rng, (uint8_t *)buf, strlen(buf));
+	inner_prng_inject(&rng, (const uint8_t *)"gaussian0 batch", 15);
 	inner_prng_flip(&rng);
-	for (i = 0; i < 100; i ++) {
-		uint8_t msg[50];  /* nonce + plain */
-		inner_prng_context sc, sc2;
-		size_t u;
-
-		inner_prng_extract(&rng, msg, sizeof msg);
-
-		inner_prng_init(&sc);
-		inner_prng_inject(&sc, msg, sizeof msg);
-		inner_prng_flip(&sc);
-		sc2 = sc;
-		Zf(hash_to_point_vartime)(&sc, hm, logn);
-		Zf(hash_to_point_ct)(&sc2, hm2, logn, tt);
-		for (u = 0; u < n; u ++) {
-			if (hm2[u] != hm[u]) {
-				fprintf(stderr, "hash_to_point() mismatch\n");
-				exit(EXIT_FAILURE);
+	Zf(prng_init)(&p, &rng);
+	for (i = 0; i < 20; i ++) {
+		size_t pos;
+
+		Zf(prng_refill)(&p);
+		for (pos = 0; pos < (sizeof p.buf.d) - 9; pos ++) {
+			size_t num, u;
+			int k;
+
+			num = ((sizeof p.buf.d) - 10 - pos) / SAMPLER_STRIDE + 1;
+			for (k = 0; k < 1 + vec; k ++) {
+				memset(z0, 0xFF, sizeof z0);
+				if (k == 0) {
+					Zf(gaussian0_batch)(z0, &p, pos, num);
+				} else {
+					Zv(gaussian0_batch)(z0, &p, pos, num);
+				}
+				if (p.ptr != 0) {
+					fprintf(stderr, "batch moved ptr\n");
+					exit(EXIT_FAILURE);
+				}
+				for (u = 0; u < num; u ++) {
+					int z;
+
+					p.ptr = pos + u * SAMPLER_STRIDE;
+					z = k == 0 ? Zf(gaussian0_sampler)(&p)
+						: Zv(gaussian0_sampler)(&p);
+					p.ptr = 0;
+					if (z0[u] != z) {
+						fprintf(stderr, "batch mismatch"
+							" (%d, %zu, %zu): %d / %d\n",
+							k, pos, u, z0[u], z);
+						exit(EXIT_FAILURE);
+					}
+				}
 			}
 		}
-		Zf(sign_dyn)(sig, &rng, f, g, F, G, hm, logn, tt);
-		if (!Zf(verify_raw)(hm, sig, h, logn, tt)) {
-			fprintf(stderr, "self signature (dyn) not verified\n");
-			exit(EXIT_FAILURE);
-		}
-
-		if (i % 10 == 0) {
-			printf(".");
-			fflush(stdout);
-		}
+		printf(".");
+		fflush(stdout);
 	}
 
-	expanded_key = (fpr *)tt;
-	tt = (uint8_t *)expanded_key + (8 * logn + 40) * n;
-	Zf(expand_privkey)(expanded_key, f, g, F, G, logn, tt);
-
-	for (i = 0; i < 100; i ++) {
-		uint8_t msg[50];  /* nonce + plain */
-		inner_prng_context sc;
-
-		inner_prng_extract(&rng, msg, sizeof msg);
-
-		inner_prng_init(&sc);
-		inner_prng_inject(&sc, msg, sizeof msg);
-		inner_prng_flip(&sc);
-		Zf(hash_to_point_vartime)(&sc, hm, logn);
-		Zf(sign_tree)(sig, &rng, expanded_key, hm, logn, tt);
-
-		if (!Zf(verify_raw)(hm, sig, h, logn, tt)) {
-			fprintf(stderr, "self signature (dyn) not verified\n");
+	inner_prng_init(&rng);
+	inner_prng_inject(&rng, (const uint8_t *)"gaussian0 batch", 15);
+	inner_prng_flip(&rng);
+	Zf(sampler_init)(&sc1, &rng, 9);
+	inner_prng_init(&rng);
+	inner_prng_inject(&rng, (const uint8_t *)"gaussian0 batch", 15);
+	inner_prng_flip(&rng);
+	Zf(sampler_init)(&sc2, &rng, 9);
+	for (i = 0; i < 100000; i ++) {
+		fpr mu, isigma;
+
+		mu = fpr_div(fpr_of(i % 1999 - 999), fpr_of(7));
+		isigma = fpr_div(fpr_of(10), fpr_of(12 + i % 7));
+		sc2.z0_num = 0;
+		if (Zf(sampler)(&sc1, mu, isigma)
+			!= Zf(sampler)(&sc2, mu, isigma))
+		{
+			fprintf(stderr, "batched sampler mismatch (%d)\n", i);
 			exit(EXIT_FAILURE);
 		}
-
-		if (i % 10 == 0) {
-			printf(".");
-			fflush(stdout);
-		}
+	}
+	if (sc1.rejections != sc2.rejections || sc1.p.ptr != sc2.p.ptr) {
+		fprintf(stderr, "batched sampler state mismatch\n");
+		exit(EXIT_FAILURE);
 	}
 
-	printf(" ");
+	printf(" done.\n");
 	fflush(stdout);
 }
 
-static void
+void Zv(FFT)(fpr *f, unsigned logn);
+void Zv(iFFT)(fpr *f, unsigned logn);
+void Zv(poly_add)(fpr *restrict a, const fpr *restrict b, unsigned logn);
+void Zv(poly_sub)(fpr *restrict a, const fpr *restrict b, unsigned logn);
+void Zv(poly_neg)(fpr *a, unsigned logn);
+void Zv(poly_adj_fft)(fpr *a, unsigned logn);
+void Zv(poly_mul_fft)(fpr *restrict a, const fpr *restrict b, unsigned logn);
+void Zv(poly_muladj_fft)(fpr *restrict a,
+	const fpr *restrict b, unsigned logn);
+void Zv(poly_mulselfadj_fft)(fpr *a, unsigned logn);
+void Zv(poly_mulconst)(fpr *a, fpr x, unsigned logn);
+void Zv(poly_add_muladj_fft)(fpr *restrict d,
+	const fpr *restrict F, const fpr *restrict G,
+	const fpr *restrict f, const fpr *restrict g, unsigned logn);
+void Zv(poly_mul_autoadj_fft)(fpr *restrict a,
+	const fpr *restrict b, unsigned logn);
+
+/*
+ * The NEON build does not fuse products and sums, so its FFT and
+ * polynomial routines must match the generic ones bit for bit (the
+ * AVX2 build uses FMA and may differ in the last bits).
+ */
+static void
+test_fft_impl(void)
+{
+	inner_prng_context rng;
+	prng p;
+	fpr a1[1024], a2[1024], b[1024], c[1024], d[1024], e[1024];
+	unsigned logn;
+	int orig_impl, i;
+
+	printf("Test FFT (generic/neon): ");
+	fflush(stdout);
+
+	orig_impl = falcon_get_impl();
+	if (falcon_set_impl(FALCON_IMPL_NEON) != 0) {
+		printf("skipped.\n");
+		fflush(stdout);
+		return;
+	}
+	falcon_set_impl(orig_impl);
+
+	inner_prng_init(&rng);
+	inner_prng_inject(&rng, (const uint8_t *)"fft-neon", 8);
+	inner_prng_flip(&rng);
+	Zf(prng_init)(&p, &rng);
+	for (logn = 1; logn <= 10; logn ++) {
+		size_t n, u;
+
+		n = (size_t)1 << logn;
+		for (i = 0; i < 20; i ++) {
+			fpr x;
+
+			for (u = 0; u < n; u ++) {
+				a1[u] = fpr_of((int64_t)(prng_get_u64(&p) % 4001)
+					- 2000);
+				b[u] = fpr_scaled((int64_t)(prng_get_u64(&p)
+					>> 11) - ((int64_t)1 << 52), -40);
+				c[u] = fpr_of((int64_t)(prng_get_u64(&p) % 201)
+					- 100);
+				d[u] = fpr_of((int64_t)(prng_get_u64(&p) % 201)
+					- 100);
+			}
+			x = fpr_scaled((int64_t)(prng_get_u64(&p) >> 11), -50);
+
+#define FFT_IMPL_CHECK(name, ...)   do { \
+		memcpy(a2, a1, n * sizeof(fpr)); \
+		Zf(name)(a1, __VA_ARGS__); \
+		Zv(name)(a2, __VA_ARGS__); \
+		if (memcmp(a1, a2, n * sizeof(fpr)) != 0) { \
+			fprintf(stderr, "FFT mismatch (%u): %s\n", \
+				logn, #name); \
+			exit(EXIT_FAILURE); \
+		} \
+	} while (0)
+
+			FFT_IMPL_CHECK(FFT, logn);
+			Zf(FFT)(b, logn);
+			Zf(FFT)(c, logn);
+			Zf(FFT)(d, logn);
+			memcpy(e, b, n * sizeof(fpr));
+			Zf(poly_mul_fft)(e, c, logn);
+			FFT_IMPL_CHECK(poly_add, b, logn);
+			FFT_IMPL_CHECK(poly_sub, c, logn);
+			FFT_IMPL_CHECK(poly_neg, logn);
+			FFT_IMPL_CHECK(poly_adj_fft, logn);
+			FFT_IMPL_CHECK(poly_mul_fft, b, logn);
+			FFT_IMPL_CHECK(poly_muladj_fft, c, logn);
+			FFT_IMPL_CHECK(poly_mulconst, x, logn);
+			FFT_IMPL_CHECK(poly_mul_autoadj_fft, d, logn);
+			FFT_IMPL_CHECK(poly_add_muladj_fft, b, c, d, e, logn);
+			FFT_IMPL_CHECK(iFFT, logn);
+			FFT_IMPL_CHECK(FFT, logn);
+			FFT_IMPL_CHECK(poly_mulselfadj_fft, logn);
+			FFT_IMPL_CHECK(iFFT, logn);
+
+#undef FFT_IMPL_CHECK
+		}
+		printf(".");
+		fflush(stdout);
+	}
+
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+/*
+ * The degree-specialized FFT and NTT (logn = 9 and 10) must compute
+ * exactly what the generic code computes, in both builds.
+ */
+static void
+test_specialized(void)
+{
+	inner_prng_context rng;
+	prng p;
+	fpr a1[1024], a2[1024];
+	uint16_t h1[1024], h2[1024];
+	int8_t f[1024], g[1024];
+	uint8_t tmp[4096];
+	unsigned logn;
+	int vec, i;
+
+	printf("Test specialized degrees: ");
+	fflush(stdout);
+
+	if (!falcon_set_specialized(1)) {
+		printf("skipped.\n");
+		fflush(stdout);
+		return;
+	}
+	vec = have_vector_impl();
+	inner_prng_init(&rng);
+	inner_prng_inject(&rng, (const uint8_t *)"specialize", 10);
+	inner_prng_flip(&rng);
+	Zf(prng_init)(&p, &rng);
+	for (logn = 9; logn <= 10; logn ++) {
+		size_t n, u;
+
+		n = (size_t)1 << logn;
+		for (i = 0; i < 20; i ++) {
+			int r1, r2;
+
+			for (u = 0; u < n; u ++) {
+				a1[u] = fpr_scaled((int64_t)(prng_get_u64(&p)
+					>> 11) - ((int64_t)1 << 52), -40);
+				f[u] = (int8_t)((int)(prng_get_u64(&p) % 7) - 3);
+				g[u] = (int8_t)((int)(prng_get_u64(&p) % 7) - 3);
+			}
+			f[0] |= 1;
+
+#define SPEC_CHECK(buf1, buf2, call, ...)   do { \
+		memcpy(buf2, buf1, n * sizeof *buf1); \
+		falcon_set_specialized(0); \
+		call(buf1, __VA_ARGS__); \
+		falcon_set_specialized(1); \
+		call(buf2, __VA_ARGS__); \
+		if (memcmp(buf1, buf2, n * sizeof *buf1) != 0) { \
+			fprintf(stderr, "specialized mismatch (%u): %s\n", \
+				logn, #call); \
+			exit(EXIT_FAILURE); \
+		} \
+	} while (0)
+
+			SPEC_CHECK(a1, a2, Zf(FFT), logn);
+			SPEC_CHECK(a1, a2, Zf(iFFT), logn);
+			if (vec) {
+				SPEC_CHECK(a1, a2, Zv(FFT), logn);
+				SPEC_CHECK(a1, a2, Zv(iFFT), logn);
+			}
+			for (u = 0; u < n; u ++) {
+				h1[u] = (uint16_t)(prng_get_u64(&p) % 12289);
+			}
+			SPEC_CHECK(h1, h2, Zf(to_ntt_monty), logn);
+			if (vec) {
+				SPEC_CHECK(h1, h2, Zv(to_ntt_monty), logn);
+			}
+
+#undef SPEC_CHECK
+
+			falcon_set_specialized(0);
+			r1 = Zf(compute_public)(h1, f, g, logn, tmp);
+			falcon_set_specialized(1);
+			r2 = Zf(compute_public)(h2, f, g, logn, tmp);
+			if (r1 != r2 || (r1 && memcmp(h1, h2, n * sizeof *h1) != 0)) {
+				fprintf(stderr, "specialized mismatch (%u):"
+					" compute_public\n", logn);
+				exit(EXIT_FAILURE);
+			}
+			if (vec) {
+				falcon_set_specialized(0);
+				r1 = Zv(compute_public)(h1, f, g, logn, tmp);
+				falcon_set_specialized(1);
+				r2 = Zv(compute_public)(h2, f, g, logn, tmp);
+				if (r1 != r2 || (r1 && memcmp(h1, h2,
+					n * sizeof *h1) != 0))
+				{
+					fprintf(stderr, "specialized mismatch (%u):"
+						" compute_public\n", logn);
+					exit(EXIT_FAILURE);
+				}
+			}
+		}
+		printf(".");
+		fflush(stdout);
+	}
+
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+static void
+test_sign_self(const int8_t *f, const int8_t *g,
+	const int8_t *F, const int8_t *G, const uint16_t *h_src,
+	unsigned logn, uint8_t *tmp)
+{
+	int i;
+	size_t n;
+	inner_prng_context rng;
+	char buf[20];
+	uint16_t *h, *hm, *hm2;
+	int16_t *sig;
+	uint8_t *tt;
+	fpr *expanded_key;
+
+	n = (size_t)1 << logn;
+	h = (uint16_t *)tmp;
+	hm = h + n;
+	sig = (int16_t *)(hm + n);
+	hm2 = (uint16_t *)sig;
+	tt = (uint8_t *)(sig + n);
+	if (logn == 1) {
+		tt += 4;
+	}
+
+	memcpy(h, h_src, n * sizeof *h);
+	Zf(to_ntt_monty)(h, logn);
+
+	/* sprintf(buf, "sign %u", logn); */
+	memcpy(buf, "sign 0", 7);
+	buf[5] = '0' + logn;
+
+	inner_prng_init(&rng);
+	inner_prng_inject(&rng, (uint8_t *)buf, strlen(buf));
+	inner_prng_flip(&rng);
+	for (i = 0; i < 100; i ++) {
+		uint8_t msg[50];  /* nonce + plain */
+		inner_prng_context sc, sc2;
+		size_t u;
+
+		inner_prng_extract(&rng, msg, sizeof msg);
+
+		inner_prng_init(&sc);
+		inner_prng_inject(&sc, msg, sizeof msg);
+		inner_prng_flip(&sc);
+		sc2 = sc;
+		Zf(hash_to_point_vartime)(&sc, hm, logn);
+		Zf(hash_to_point_ct)(&sc2, hm2, logn, tt);
+		for (u = 0; u < n; u ++) {
+			if (hm2[u] != hm[u]) {
+				fprintf(stderr, "hash_to_point() mismatch\n");
+				exit(EXIT_FAILURE);
+			}
+		}
+		Zf(sign_dyn)(sig, &rng, NULL, f, g, F, G, hm, logn, tt, NULL);
+		if (!Zf(verify_raw)(hm, sig, h, logn, tt)) {
+			fprintf(stderr, "self signature (dyn) not verified\n");
+			exit(EXIT_FAILURE);
+		}
+
+		if (i % 10 == 0) {
+			printf(".");
+			fflush(stdout);
+		}
+	}
+
+	expanded_key = (fpr *)tt;
+	tt = (uint8_t *)expanded_key + (8 * logn + 40) * n;
+	Zf(expand_privkey)(expanded_key, f, g, F, G, logn, 0, tt);
+
+	for (i = 0; i < 100; i ++) {
+		uint8_t msg[50];  /* nonce + plain */
+		inner_prng_context sc;
+
+		inner_prng_extract(&rng, msg, sizeof msg);
+
+		inner_prng_init(&sc);
+		inner_prng_inject(&sc, msg, sizeof msg);
+		inner_prng_flip(&sc);
+		Zf(hash_to_point_vartime)(&sc, hm, logn);
+		Zf(sign_tree)(sig, &rng, NULL, expanded_key, 0, hm, logn, tt, NULL);
+
+		if (!Zf(verify_raw)(hm, sig, h, logn, tt)) {
+			fprintf(stderr, "self signature (dyn) not verified\n");
+			exit(EXIT_FAILURE);
+		}
+
+		if (i % 10 == 0) {
+			printf(".");
+			fflush(stdout);
+		}
+	}
+
+	printf(" ");
+	fflush(stdout);
+}
+
+static void
 test_sign(void)
 {
 	uint8_t *tmp;
@@ -3770,7 +4499,7 @@ test_keygen_inner(unsigned logn, uint8_t *tmp)
 		inner_prng_flip(&sc);
 		Zf(hash_to_point_vartime)(&sc, hm, logn);
 		do {
-			Zf(sign_dyn)(sig, &rng, f, g, F, G, hm, logn, tt);
+			Zf(sign_dyn)(sig, &rng, NULL, f, g, F, G, hm, logn, tt, NULL);
 			memcpy(s1, tt, n * sizeof *s1);
 		} while (!Zf(is_invertible)(sig, logn, tt));
 		Zf(to_ntt_monty)(h, logn);
@@ -3809,15 +4538,185 @@ test_keygen(void)
 	fflush(stdout);
 }
 
+/*
+ * The vector keygen (AVX2 or NEON, whichever the vector build targets)
+ * must return the same key pair as the generic one for the same RNG
+ * state. With FMA, the floating-point values differ slightly, but the
+ * keys may change only with negligible probability (see FALCON_FMA in
+ * config.h).
+ */
+static void
+test_keygen_impl(void)
+{
+	int8_t f1[1024], g1[1024], F1[1024], G1[1024];
+	int8_t f2[1024], g2[1024], F2[1024], G2[1024];
+	uint16_t h1[1024], h2[1024];
+	uint8_t *tmp;
+	unsigned logn;
+
+	printf("Test keygen (generic/vector): ");
+	fflush(stdout);
+
+	if (!have_vector_impl()) {
+		printf("skipped.\n");
+		fflush(stdout);
+		return;
+	}
+
+	tmp = xmalloc(FALCON_TMPSIZE_KEYGEN(10));
+	for (logn = 1; logn <= 10; logn ++) {
+		size_t n;
+		int i, num;
+
+		n = (size_t)1 << logn;
+		num = logn >= 9 ? 3 : 10;
+		for (i = 0; i < num; i ++) {
+			inner_prng_context rng1, rng2;
+			uint8_t seed[4];
+
+			seed[0] = 'k';
+			seed[1] = 'g';
+			seed[2] = (uint8_t)logn;
+			seed[3] = (uint8_t)i;
+			inner_prng_init(&rng1);
+			inner_prng_inject(&rng1, seed, sizeof seed);
+			inner_prng_flip(&rng1);
+			rng2 = rng1;
+			Zf(keygen)(&rng1, f1, g1, F1, G1, h1, logn, tmp);
+			Zv(keygen)(&rng2, f2, g2, F2, G2, h2, logn, tmp);
+			check_eq(f1, f2, n, "keygen f");
+			check_eq(g1, g2, n, "keygen g");
+			check_eq(F1, F2, n, "keygen F");
+			check_eq(G1, G2, n, "keygen G");
+			check_eq(h1, h2, n * sizeof *h1, "keygen h");
+		}
+		printf(".");
+		fflush(stdout);
+	}
+	xfree(tmp);
+
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+/*
+ * falcon_keygen_make_mt() must return the same key pair as
+ * falcon_keygen_make() for the same RNG state, whatever the number of
+ * threads.
+ */
+static void
+test_keygen_mt(void)
+{
+	static const unsigned threads[] = { 2, 3, 5 };
+	unsigned logn;
+	int r;
+
+	printf("Test keygen (threads): ");
+	fflush(stdout);
+
+	for (logn = 1; logn <= 10; logn ++) {
+		prng_context rng;
+		uint8_t *sk1, *pk1, *sk2, *pk2, *tmp;
+		size_t sk_len, pk_len, tmp_len;
+		int i, num;
+
+		sk_len = FALCON_PRIVKEY_SIZE(logn);
+		pk_len = FALCON_PUBKEY_SIZE(logn);
+		tmp_len = FALCON_TMPSIZE_KEYGEN_MT(logn, 5);
+		sk1 = xmalloc(sk_len);
+		pk1 = xmalloc(pk_len);
+		sk2 = xmalloc(sk_len);
+		pk2 = xmalloc(pk_len);
+		tmp = xmalloc(tmp_len);
+		num = logn >= 9 ? 2 : 5;
+		for (i = 0; i < num; i ++) {
+			uint8_t seed[2];
+			size_t u;
+
+			seed[0] = (uint8_t)logn;
+			seed[1] = (uint8_t)i;
+			prng_init_prng_from_seed(&rng, seed, sizeof seed);
+			r = falcon_keygen_make(&rng, logn, sk1, sk_len,
+				pk1, pk_len, tmp, FALCON_TMPSIZE_KEYGEN(logn));
+			if (r != 0) {
+				fprintf(stderr, "keygen failed: %d\n", r);
+				exit(EXIT_FAILURE);
+			}
+			for (u = 0; u < sizeof threads / sizeof threads[0];
+				u ++)
+			{
+				prng_init_prng_from_seed(&rng,
+					seed, sizeof seed);
+				memset(sk2, 0, sk_len);
+				memset(pk2, 0, pk_len);
+				r = falcon_keygen_make_mt(&rng, logn,
+					sk2, sk_len, pk2, pk_len,
+					tmp, FALCON_TMPSIZE_KEYGEN_MT(logn,
+					threads[u]), threads[u]);
+				if (r != 0) {
+					fprintf(stderr,
+						"keygen_mt failed: %d\n", r);
+					exit(EXIT_FAILURE);
+				}
+				check_eq(sk1, sk2, sk_len, "keygen_mt privkey");
+				check_eq(pk1, pk2, pk_len, "keygen_mt pubkey");
+			}
+		}
+
+		/*
+		 * One thread is the serial code, with the serial buffer
+		 * size; out-of-range thread counts and short buffers are
+		 * rejected.
+		 */
+		if (FALCON_TMPSIZE_KEYGEN_MT(logn, 1)
+			!= FALCON_TMPSIZE_KEYGEN(logn))
+		{
+			fprintf(stderr, "keygen_mt tmp size\n");
+			exit(EXIT_FAILURE);
+		}
+		r = falcon_keygen_make_mt(&rng, logn, sk2, sk_len, pk2, pk_len,
+			tmp, tmp_len, 0);
+		if (r != FALCON_ERR_BADARG) {
+			fprintf(stderr, "keygen_mt(0 threads): %d\n", r);
+			exit(EXIT_FAILURE);
+		}
+		r = falcon_keygen_make_mt(&rng, logn, sk2, sk_len, pk2, pk_len,
+			tmp, tmp_len, FALCON_KEYGEN_MAX_THREADS + 1);
+		if (r != FALCON_ERR_BADARG) {
+			fprintf(stderr, "keygen_mt(too many threads): %d\n", r);
+			exit(EXIT_FAILURE);
+		}
+		r = falcon_keygen_make_mt(&rng, logn, sk2, sk_len, pk2, pk_len,
+			tmp, FALCON_TMPSIZE_KEYGEN_MT(logn, 5) - 1, 5);
+		if (r != FALCON_ERR_SIZE) {
+			fprintf(stderr, "keygen_mt(short tmp): %d\n", r);
+			exit(EXIT_FAILURE);
+		}
+
+		xfree(sk1);
+		xfree(pk1);
+		xfree(sk2);
+		xfree(pk2);
+		xfree(tmp);
+		printf(".");
+		fflush(stdout);
+	}
+
+	printf(" done.\n");
+	fflush(stdout);
+}
+
 static void
 test_external_API_inner(unsigned logn, prng_context *rng)
 {
 	int i;
 	void *pubkey, *pubkey2, *privkey, *sig, *sigpad, *sigct, *expkey;
+	void *exppub;
 	size_t pubkey_len, privkey_len, sig_len, sigpad_len, sigct_len;
-	size_t expkey_len;
-	uint8_t *tmpkg, *tmpmp, *tmpsd, *tmpst, *tmpvv, *tmpek;
+	size_t expkey_len, exppub_len;
+	uint8_t *tmpkg, *tmpmp, *tmpsd, *tmpst, *tmpvv, *tmpek, *tmpvb;
 	size_t tmpkg_len, tmpmp_len, tmpsd_len, tmpst_len, tmpvv_len, tmpek_len;
+	size_t tmpvb_len;
 
 	printf("[%u]", logn);
 	fflush(stdout);
@@ -3828,6 +4727,7 @@ test_external_API_inner(unsigned logn, prng_context *rng)
 	sigpad_len = FALCON_SIG_PADDED_SIZE(logn);
 	sigct_len = FALCON_SIG_CT_SIZE(logn);
 	expkey_len = FALCON_EXPANDEDKEY_SIZE(logn);
+	exppub_len = FALCON_EXPANDEDPUBKEY_SIZE(logn);
 
 	pubkey = xmalloc(pubkey_len);
 	pubkey2 = xmalloc(pubkey_len);
@@ -3836,6 +4736,7 @@ test_external_API_inner(unsigned logn, prng_context *rng)
 	sigpad = xmalloc(sig_len);
 	sigct = xmalloc(sigct_len);
 	expkey = xmalloc(expkey_len);
+	exppub = xmalloc(exppub_len);
 
 	tmpkg_len = FALCON_TMPSIZE_KEYGEN(logn);
 	tmpmp_len = FALCON_TMPSIZE_MAKEPUB(logn);
@@ -3843,6 +4744,7 @@ test_external_API_inner(unsigned logn, prng_context *rng)
 	tmpst_len = FALCON_TMPSIZE_SIGNTREE(logn);
 	tmpvv_len = FALCON_TMPSIZE_VERIFY(logn);
 	tmpek_len = FALCON_TMPSIZE_EXPANDPRIV(logn);
+	tmpvb_len = FALCON_TMPSIZE_VERIFYBATCH(logn);
 
 	tmpkg = xmalloc(tmpkg_len);
 	tmpmp = xmalloc(tmpmp_len);
@@ -3850,6 +4752,7 @@ test_external_API_inner(unsigned logn, prng_context *rng)
 	tmpst = xmalloc(tmpst_len);
 	tmpvv = xmalloc(tmpvv_len);
 	tmpek = xmalloc(tmpek_len);
+	tmpvb = xmalloc(tmpvb_len);
 
 	for (i = 0; i < 12; i ++) {
 		int r;
@@ -3971,6 +4874,75 @@ test_external_API_inner(unsigned logn, prng_context *rng)
 			}
 		}
 
+		r = falcon_expand_pubkey(exppub, exppub_len,
+			pubkey, pubkey_len);
+		if (r != 0) {
+			fprintf(stderr, "expand_pubkey failed: %d\n", r);
+			exit(EXIT_FAILURE);
+		}
+		r = falcon_verify_expanded(sig, sig_len, FALCON_SIG_COMPRESSED,
+			exppub, "data1", 5, tmpvv, tmpvv_len);
+		if (r != 0) {
+			fprintf(stderr, "verify_expanded failed: %d\n", r);
+			exit(EXIT_FAILURE);
+		}
+		r = falcon_verify_expanded(sigpad, sigpad_len,
+			FALCON_SIG_PADDED, exppub, "data1", 5,
+			tmpvv, tmpvv_len);
+		if (r != 0) {
+			fprintf(stderr,
+				"verify_expanded(padded) failed: %d\n", r);
+			exit(EXIT_FAILURE);
+		}
+		r = falcon_verify_expanded(sigct, sigct_len, FALCON_SIG_CT,
+			exppub, "data1", 5, tmpvv, tmpvv_len);
+		if (r != 0) {
+			fprintf(stderr, "verify_expanded(ct) failed: %d\n", r);
+			exit(EXIT_FAILURE);
+		}
+		if (logn >= 5) {
+			r = falcon_verify_expanded(sig, sig_len,
+				FALCON_SIG_COMPRESSED, exppub, "data2", 5,
+				tmpvv, tmpvv_len);
+			if (r != FALCON_ERR_BADSIG) {
+				fprintf(stderr,
+					"wrong verify_expanded err: %d\n", r);
+				exit(EXIT_FAILURE);
+			}
+		}
+
+		{
+			const void *bsig[3], *bpk[3], *bdata[3];
+			size_t bsig_len[3], bpk_len[3], bdata_len[3];
+			int bres[3];
+			size_t j;
+
+			for (j = 0; j < 3; j ++) {
+				bsig[j] = sig;
+				bsig_len[j] = sig_len;
+				bpk[j] = pubkey;
+				bpk_len[j] = pubkey_len;
+				bdata[j] = j == 1 ? "data2" : "data1";
+				bdata_len[j] = 5;
+			}
+			bpk[2] = pubkey2;
+			r = falcon_verify_batch(3, bsig, bsig_len,
+				FALCON_SIG_COMPRESSED, bpk, bpk_len,
+				bdata, bdata_len, bres, tmpvb, tmpvb_len);
+			if (bres[0] != 0 || bres[2] != 0) {
+				fprintf(stderr, "verify_batch failed: %d %d\n",
+					bres[0], bres[2]);
+				exit(EXIT_FAILURE);
+			}
+			if (logn >= 5 && (bres[1] != FALCON_ERR_BADSIG
+				|| r != FALCON_ERR_BADSIG))
+			{
+				fprintf(stderr, "wrong verify_batch err: %d %d\n",
+					bres[1], r);
+				exit(EXIT_FAILURE);
+			}
+		}
+
 		r = falcon_expand_privkey(expkey, expkey_len,
 			privkey, privkey_len, tmpek, tmpek_len);
 		if (r != 0) {
@@ -4067,12 +5039,14 @@ test_external_API_inner(unsigned logn, prng_context *rng)
 	xfree(sigpad);
 	xfree(sigct);
 	xfree(expkey);
+	xfree(exppub);
 	xfree(tmpkg);
 	xfree(tmpmp);
 	xfree(tmpsd);
 	xfree(tmpst);
 	xfree(tmpvv);
 	xfree(tmpek);
+	xfree(tmpvb);
 }
 
 static void
@@ -4080,16 +5054,1349 @@ test_external_API(void)
 {
 	unsigned logn;
 	prng_context rng;
+	int impl, orig_impl;
 
 	printf("Test external API: ");
 	fflush(stdout);
 
-	prng_init_prng_from_seed(&rng, "external", 8);
-	for (logn = 1; logn <= 10; logn ++) {
-		test_external_API_inner(logn, &rng);
-	}
-
-	printf("done.\n");
+	/*
+	 * Run the tests with every implementation available on this
+	 * system (the generic one is always available).
+	 */
+	orig_impl = falcon_get_impl();
+	for (impl = FALCON_IMPL_GENERIC; impl <= FALCON_IMPL_NEON; impl ++) {
+		if (falcon_set_impl(impl) != 0) {
+			if (impl == FALCON_IMPL_GENERIC) {
+				fprintf(stderr, "generic implementation"
+					" not available\n");
+				exit(EXIT_FAILURE);
+			}
+			continue;
+		}
+		if (falcon_get_impl() != impl) {
+			fprintf(stderr, "implementation not selected\n");
+			exit(EXIT_FAILURE);
+		}
+		printf("[%s]", impl == FALCON_IMPL_AVX2 ? "avx2"
+			: impl == FALCON_IMPL_NEON ? "neon" : "generic");
+		fflush(stdout);
+		prng_init_prng_from_seed(&rng, "external", 8);
+		for (logn = 1; logn <= 10; logn ++) {
+			test_external_API_inner(logn, &rng);
+		}
+	}
+	if (falcon_set_impl(FALCON_IMPL_NEON + 1) != FALCON_ERR_BADARG) {
+		fprintf(stderr, "unknown implementation accepted\n");
+		exit(EXIT_FAILURE);
+	}
+	falcon_set_impl(orig_impl);
+
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+static void
+test_sign_stats(void)
+{
+	prng_context rng, rng2;
+	falcon_sign_stats st;
+	uint8_t pk[FALCON_PUBKEY_SIZE(9)], sk[FALCON_PRIVKEY_SIZE(9)];
+	uint8_t esk[FALCON_EXPANDEDKEY_SIZE(9)];
+	uint8_t sig[FALCON_SIG_COMPRESSED_MAXSIZE(9)];
+	uint8_t sig2[FALCON_SIG_COMPRESSED_MAXSIZE(9)];
+	uint8_t *tmp;
+	size_t tmp_len, sig_len, sig2_len;
+	unsigned logn;
+	int i, r, retried;
+
+	printf("Test sign stats: ");
+	fflush(stdout);
+
+	tmp_len = FALCON_TMPSIZE_KEYGEN(9);
+	if (tmp_len < FALCON_TMPSIZE_SIGNDYN(9)) {
+		tmp_len = FALCON_TMPSIZE_SIGNDYN(9);
+	}
+	tmp = xmalloc(tmp_len);
+	prng_init_prng_from_seed(&rng, "stats", 5);
+
+	for (logn = 2; logn <= 9; logn += 7) {
+		r = falcon_keygen_make(&rng, logn,
+			sk, FALCON_PRIVKEY_SIZE(logn),
+			pk, FALCON_PUBKEY_SIZE(logn), tmp, tmp_len);
+		if (r == 0) {
+			r = falcon_expand_privkey(esk,
+				FALCON_EXPANDEDKEY_SIZE(logn),
+				sk, FALCON_PRIVKEY_SIZE(logn), tmp, tmp_len);
+		}
+		if (r != 0) {
+			fprintf(stderr, "key setup failed: %d\n", r);
+			exit(EXIT_FAILURE);
+		}
+
+		retried = 0;
+		for (i = 0; i < 100; i ++) {
+			/*
+			 * The _ex variant must produce the same signature
+			 * as the plain one from the same RNG state.
+			 */
+			rng2 = rng;
+			sig_len = sizeof sig;
+			memset(&st, 0xFF, sizeof st);
+			r = falcon_sign_dyn_ex(&rng, sig, &sig_len,
+				FALCON_SIG_COMPRESSED,
+				sk, FALCON_PRIVKEY_SIZE(logn),
+				"data", 4, tmp, tmp_len, &st);
+			if (r != 0) {
+				fprintf(stderr, "sign_dyn_ex failed: %d\n", r);
+				exit(EXIT_FAILURE);
+			}
+			sig2_len = sizeof sig2;
+			r = falcon_sign_dyn(&rng2, sig2, &sig2_len,
+				FALCON_SIG_COMPRESSED,
+				sk, FALCON_PRIVKEY_SIZE(logn),
+				"data", 4, tmp, tmp_len);
+			if (r != 0 || sig_len != sig2_len) {
+				fprintf(stderr, "sign_dyn mismatch\n");
+				exit(EXIT_FAILURE);
+			}
+			check_eq(sig, sig2, sig_len, "sign_dyn_ex");
+			if (st.attempts < 1 || st.encode_retries != 0) {
+				fprintf(stderr, "wrong dyn stats\n");
+				exit(EXIT_FAILURE);
+			}
+			if (logn == 9 && st.sampler_rejections == 0) {
+				fprintf(stderr, "no sampler rejection\n");
+				exit(EXIT_FAILURE);
+			}
+			retried |= st.attempts > 1;
+
+			sig_len = sizeof sig;
+			memset(&st, 0xFF, sizeof st);
+			r = falcon_sign_tree_ex(&rng, sig, &sig_len,
+				FALCON_SIG_PADDED, esk, "data", 4,
+				tmp, tmp_len, &st);
+			if (r != 0) {
+				fprintf(stderr, "sign_tree_ex failed: %d\n", r);
+				exit(EXIT_FAILURE);
+			}
+			if (st.attempts < 1
+				|| st.encode_retries == 0xFFFFFFFF)
+			{
+				fprintf(stderr, "wrong tree stats\n");
+				exit(EXIT_FAILURE);
+			}
+			r = falcon_verify(sig, sig_len, FALCON_SIG_PADDED,
+				pk, FALCON_PUBKEY_SIZE(logn), "data", 4,
+				tmp, tmp_len);
+			if (r != 0) {
+				fprintf(stderr, "sign_tree_ex: bad sig %d\n", r);
+				exit(EXIT_FAILURE);
+			}
+		}
+
+		/*
+		 * With degree 4, candidates are often too long: some
+		 * signature must have needed more than one attempt.
+		 */
+		if (logn == 2 && !retried) {
+			fprintf(stderr, "no signing retry at logn=2\n");
+			exit(EXIT_FAILURE);
+		}
+		printf(".");
+		fflush(stdout);
+	}
+
+	xfree(tmp);
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+static void
+test_stored_expkey(void)
+{
+	prng_context rng, rng2;
+	uint8_t pk[FALCON_PUBKEY_SIZE(10)], sk[FALCON_PRIVKEY_SIZE(10)];
+	uint8_t sig[FALCON_SIG_CT_SIZE(10)], sig2[FALCON_SIG_CT_SIZE(10)];
+	uint8_t *tmp, *esk, *rec, *buf;
+	const void *ek;
+	size_t tmp_len, rec_len, sig_len, sig2_len;
+	unsigned logn;
+	int r;
+
+	printf("Test stored expanded key: ");
+	fflush(stdout);
+
+	tmp_len = FALCON_TMPSIZE_KEYGEN(10);
+	if (tmp_len < FALCON_TMPSIZE_EXPANDPRIV(10)) {
+		tmp_len = FALCON_TMPSIZE_EXPANDPRIV(10);
+	}
+	if (tmp_len < FALCON_TMPSIZE_SIGNTREE(10)) {
+		tmp_len = FALCON_TMPSIZE_SIGNTREE(10);
+	}
+	tmp = xmalloc(tmp_len);
+	esk = xmalloc(FALCON_EXPANDEDKEY_SIZE(10) + 1);
+	buf = xmalloc(FALCON_STORED_EXPANDEDKEY_SIZE(10) + 8);
+	prng_init_prng_from_seed(&rng, "stored", 6);
+
+	for (logn = 1; logn <= 10; logn ++) {
+		r = falcon_keygen_make(&rng, logn,
+			sk, FALCON_PRIVKEY_SIZE(logn),
+			pk, FALCON_PUBKEY_SIZE(logn), tmp, tmp_len);
+		if (r == 0) {
+			/*
+			 * Odd address: the record must not depend on the
+			 * alignment of the source key.
+			 */
+			r = falcon_expand_privkey(esk + 1,
+				FALCON_EXPANDEDKEY_SIZE(logn),
+				sk, FALCON_PRIVKEY_SIZE(logn), tmp, tmp_len);
+		}
+		if (r != 0) {
+			fprintf(stderr, "key setup failed: %d\n", r);
+			exit(EXIT_FAILURE);
+		}
+
+		rec_len = FALCON_STORED_EXPANDEDKEY_SIZE(logn);
+		if ((rec_len & 63) != 0) {
+			fprintf(stderr, "unaligned record size\n");
+			exit(EXIT_FAILURE);
+		}
+		rec = buf;
+		if (falcon_store_expanded_key(rec, rec_len - 1, esk + 1)
+			!= FALCON_ERR_SIZE
+			|| falcon_store_expanded_key(rec + 1, rec_len, esk + 1)
+			!= FALCON_ERR_BADARG)
+		{
+			fprintf(stderr, "bad store parameters accepted\n");
+			exit(EXIT_FAILURE);
+		}
+		r = falcon_store_expanded_key(rec, rec_len, esk + 1);
+		if (r != 0) {
+			fprintf(stderr, "store failed: %d\n", r);
+			exit(EXIT_FAILURE);
+		}
+		r = falcon_open_expanded_key(&ek, rec, rec_len + 100);
+		if (r != (int)rec_len) {
+			fprintf(stderr, "open failed: %d\n", r);
+			exit(EXIT_FAILURE);
+		}
+		if (falcon_check_expanded_key(rec, rec_len) != 0) {
+			fprintf(stderr, "check failed\n");
+			exit(EXIT_FAILURE);
+		}
+
+		/*
+		 * The stored key signs like the original one.
+		 */
+		rng2 = rng;
+		sig_len = sizeof sig;
+		r = falcon_sign_tree(&rng, sig, &sig_len, FALCON_SIG_CT,
+			esk + 1, "data", 4, tmp, tmp_len);
+		sig2_len = sizeof sig2;
+		if (r == 0) {
+			r = falcon_sign_tree(&rng2, sig2, &sig2_len,
+				FALCON_SIG_CT, ek, "data", 4, tmp, tmp_len);
+		}
+		if (r != 0) {
+			fprintf(stderr, "sign failed: %d\n", r);
+			exit(EXIT_FAILURE);
+		}
+		check_eq(sig, sig2, sig_len, "stored key signature");
+		if (sig_len != sig2_len) {
+			fprintf(stderr, "stored key signature length\n");
+			exit(EXIT_FAILURE);
+		}
+
+		/*
+		 * Corruption of the key is caught by the checksum, that of
+		 * the header (format tag, degree, version) when opening.
+		 */
+		rec[72 + 13] ^= 0x04;
+		if (falcon_open_expanded_key(&ek, rec, rec_len) != (int)rec_len
+			|| falcon_check_expanded_key(rec, rec_len)
+			!= FALCON_ERR_FORMAT)
+		{
+			fprintf(stderr, "corrupted key accepted\n");
+			exit(EXIT_FAILURE);
+		}
+		rec[72 + 13] ^= 0x04;
+		rec[24 + 7] ^= 0x80;
+		if (falcon_open_expanded_key(&ek, rec, rec_len)
+			!= FALCON_ERR_FORMAT)
+		{
+			fprintf(stderr, "wrong format tag accepted\n");
+			exit(EXIT_FAILURE);
+		}
+		rec[24 + 7] ^= 0x80;
+		rec[8] ++;
+		if (falcon_open_expanded_key(&ek, rec, rec_len)
+			!= FALCON_ERR_FORMAT)
+		{
+			fprintf(stderr, "wrong version accepted\n");
+			exit(EXIT_FAILURE);
+		}
+		rec[8] --;
+		if (falcon_open_expanded_key(&ek, rec, rec_len - 1)
+			!= FALCON_ERR_SIZE
+			|| falcon_open_expanded_key(&ek, rec + 1, rec_len)
+			!= FALCON_ERR_BADARG)
+		{
+			fprintf(stderr, "truncated record accepted\n");
+			exit(EXIT_FAILURE);
+		}
+		if (falcon_check_expanded_key(rec, rec_len) != 0) {
+			fprintf(stderr, "restored record rejected\n");
+			exit(EXIT_FAILURE);
+		}
+
+		printf(".");
+		fflush(stdout);
+	}
+
+	xfree(buf);
+	xfree(esk);
+	xfree(tmp);
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+static void
+test_compact_expkey(void)
+{
+	prng_context rng, rng2;
+	uint8_t pk[FALCON_PUBKEY_SIZE(10)], sk[FALCON_PRIVKEY_SIZE(10)];
+	uint8_t sig[FALCON_SIG_CT_SIZE(10)], sig2[FALCON_SIG_CT_SIZE(10)];
+	uint8_t *tmp, *esk, *csk, *rec;
+	size_t tmp_len, sig_len, sig2_len, csk_len;
+	unsigned logn, levels;
+	int r;
+
+	printf("Test compact expanded key: ");
+	fflush(stdout);
+
+	tmp_len = FALCON_TMPSIZE_KEYGEN(10);
+	if (tmp_len < FALCON_TMPSIZE_EXPANDPRIV(10)) {
+		tmp_len = FALCON_TMPSIZE_EXPANDPRIV(10);
+	}
+	if (tmp_len < FALCON_TMPSIZE_EXPANDCOMPACT(10)) {
+		tmp_len = FALCON_TMPSIZE_EXPANDCOMPACT(10);
+	}
+	if (tmp_len < FALCON_TMPSIZE_SIGNCOMPACT(10)) {
+		tmp_len = FALCON_TMPSIZE_SIGNCOMPACT(10);
+	}
+	tmp = xmalloc(tmp_len);
+	esk = xmalloc(FALCON_EXPANDEDKEY_SIZE(10));
+	csk = xmalloc(FALCON_COMPACTKEY_SIZE(10, 8) + 1);
+	rec = xmalloc(FALCON_STORED_EXPANDEDKEY_SIZE(10));
+	prng_init_prng_from_seed(&rng, "compact", 7);
+
+	for (logn = 3; logn <= 10; logn ++) {
+		r = falcon_keygen_make(&rng, logn,
+			sk, FALCON_PRIVKEY_SIZE(logn),
+			pk, FALCON_PUBKEY_SIZE(logn), tmp, tmp_len);
+		if (r == 0) {
+			r = falcon_expand_privkey(esk,
+				FALCON_EXPANDEDKEY_SIZE(logn),
+				sk, FALCON_PRIVKEY_SIZE(logn), tmp, tmp_len);
+		}
+		if (r != 0) {
+			fprintf(stderr, "key setup failed: %d\n", r);
+			exit(EXIT_FAILURE);
+		}
+		if (falcon_expand_privkey_compact(csk,
+			FALCON_COMPACTKEY_SIZE(logn, 1), 0,
+			sk, FALCON_PRIVKEY_SIZE(logn), tmp, tmp_len)
+			!= FALCON_ERR_BADARG
+			|| falcon_expand_privkey_compact(csk,
+			FALCON_COMPACTKEY_SIZE(logn, logn - 1), logn - 1,
+			sk, FALCON_PRIVKEY_SIZE(logn), tmp, tmp_len)
+			!= FALCON_ERR_BADARG
+			|| falcon_expand_privkey_compact(csk,
+			FALCON_COMPACTKEY_SIZE(logn, 1) - 1, 1,
+			sk, FALCON_PRIVKEY_SIZE(logn), tmp, tmp_len)
+			!= FALCON_ERR_SIZE)
+		{
+			fprintf(stderr, "bad compact parameters accepted\n");
+			exit(EXIT_FAILURE);
+		}
+
+		for (levels = 1; levels + 2 <= logn; levels ++) {
+			/*
+			 * Odd address, as with full expanded keys.
+			 */
+			csk_len = FALCON_COMPACTKEY_SIZE(logn, levels);
+			r = falcon_expand_privkey_compact(csk + 1, csk_len,
+				levels, sk, FALCON_PRIVKEY_SIZE(logn),
+				tmp, tmp_len);
+			if (r != 0) {
+				fprintf(stderr, "compact expand failed: %d\n",
+					r);
+				exit(EXIT_FAILURE);
+			}
+			if (falcon_get_logn(csk + 1, csk_len) != (int)logn) {
+				fprintf(stderr, "compact key: wrong degree\n");
+				exit(EXIT_FAILURE);
+			}
+
+			/*
+			 * The compact key signs exactly like the full one.
+			 */
+			rng2 = rng;
+			sig_len = sizeof sig;
+			r = falcon_sign_tree(&rng, sig, &sig_len,
+				FALCON_SIG_COMPRESSED, esk, "data", 4,
+				tmp, tmp_len);
+			sig2_len = sizeof sig2;
+			if (r == 0) {
+				r = falcon_sign_tree(&rng2, sig2, &sig2_len,
+					FALCON_SIG_COMPRESSED, csk + 1,
+					"data", 4, tmp, tmp_len);
+			}
+			if (r != 0) {
+				fprintf(stderr, "sign failed: %d\n", r);
+				exit(EXIT_FAILURE);
+			}
+			if (sig_len != sig2_len) {
+				fprintf(stderr, "compact key signature length\n");
+				exit(EXIT_FAILURE);
+			}
+			check_eq(sig, sig2, sig_len, "compact key signature");
+			r = falcon_verify(sig2, sig2_len, FALCON_SIG_COMPRESSED,
+				pk, FALCON_PUBKEY_SIZE(logn), "data", 4,
+				tmp, tmp_len);
+			if (r != 0) {
+				fprintf(stderr, "verify failed: %d\n", r);
+				exit(EXIT_FAILURE);
+			}
+
+			sig2_len = sizeof sig2;
+			if (falcon_sign_tree(&rng2, sig2, &sig2_len,
+				FALCON_SIG_CT, csk + 1, "data", 4, tmp,
+				FALCON_TMPSIZE_SIGNCOMPACT(logn) - 1)
+				!= FALCON_ERR_SIZE
+				|| falcon_store_expanded_key(rec,
+				FALCON_STORED_EXPANDEDKEY_SIZE(logn), csk + 1)
+				!= FALCON_ERR_FORMAT)
+			{
+				fprintf(stderr, "compact key misused\n");
+				exit(EXIT_FAILURE);
+			}
+		}
+
+		printf(".");
+		fflush(stdout);
+	}
+
+	xfree(rec);
+	xfree(csk);
+	xfree(esk);
+	xfree(tmp);
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+static void
+test_sequential_expkey(void)
+{
+	prng_context rng, rng2;
+	uint8_t pk[FALCON_PUBKEY_SIZE(10)], sk[FALCON_PRIVKEY_SIZE(10)];
+	uint8_t sig[FALCON_SIG_CT_SIZE(10)], sig2[FALCON_SIG_CT_SIZE(10)];
+	uint8_t *tmp, *esk, *ssk, *rec;
+	const void *ek;
+	size_t tmp_len, sig_len, sig2_len, esk_len, rec_len;
+	unsigned logn;
+	int r;
+
+	printf("Test sequential expanded key: ");
+	fflush(stdout);
+
+	tmp_len = FALCON_TMPSIZE_KEYGEN(10);
+	if (tmp_len < FALCON_TMPSIZE_EXPANDPRIV(10)) {
+		tmp_len = FALCON_TMPSIZE_EXPANDPRIV(10);
+	}
+	if (tmp_len < FALCON_TMPSIZE_SIGNTREE(10)) {
+		tmp_len = FALCON_TMPSIZE_SIGNTREE(10);
+	}
+	tmp = xmalloc(tmp_len);
+	esk = xmalloc(FALCON_EXPANDEDKEY_SIZE(10));
+	ssk = xmalloc(FALCON_EXPANDEDKEY_SIZE(10) + 1);
+	rec = xmalloc(FALCON_STORED_EXPANDEDKEY_SIZE(10));
+	prng_init_prng_from_seed(&rng, "sequential", 10);
+
+	for (logn = 1; logn <= 10; logn ++) {
+		esk_len = FALCON_EXPANDEDKEY_SIZE(logn);
+		rec_len = FALCON_STORED_EXPANDEDKEY_SIZE(logn);
+		r = falcon_keygen_make(&rng, logn,
+			sk, FALCON_PRIVKEY_SIZE(logn),
+			pk, FALCON_PUBKEY_SIZE(logn), tmp, tmp_len);
+		if (r == 0) {
+			r = falcon_expand_privkey_layout(esk, esk_len,
+				FALCON_EXPKEY_RECURSIVE,
+				sk, FALCON_PRIVKEY_SIZE(logn), tmp, tmp_len);
+		}
+		if (r == 0) {
+			/*
+			 * Odd address, as with the other expanded keys.
+			 */
+			r = falcon_expand_privkey_layout(ssk + 1, esk_len,
+				FALCON_EXPKEY_SEQUENTIAL,
+				sk, FALCON_PRIVKEY_SIZE(logn), tmp, tmp_len);
+		}
+		if (r != 0) {
+			fprintf(stderr, "key setup failed: %d\n", r);
+			exit(EXIT_FAILURE);
+		}
+		if (falcon_expand_privkey_layout(ssk + 1, esk_len, 2,
+			sk, FALCON_PRIVKEY_SIZE(logn), tmp, tmp_len)
+			!= FALCON_ERR_BADARG
+			|| falcon_expand_privkey_layout(ssk + 1, esk_len - 1,
+			FALCON_EXPKEY_SEQUENTIAL,
+			sk, FALCON_PRIVKEY_SIZE(logn), tmp, tmp_len)
+			!= FALCON_ERR_SIZE)
+		{
+			fprintf(stderr, "bad layout parameters accepted\n");
+			exit(EXIT_FAILURE);
+		}
+		r = falcon_expand_privkey_layout(ssk + 1, esk_len,
+			FALCON_EXPKEY_SEQUENTIAL,
+			sk, FALCON_PRIVKEY_SIZE(logn), tmp, tmp_len);
+		if (r != 0 || falcon_get_logn(ssk + 1, esk_len) != (int)logn) {
+			fprintf(stderr, "sequential expand failed: %d\n", r);
+			exit(EXIT_FAILURE);
+		}
+
+		/*
+		 * Both layouts sign identically.
+		 */
+		rng2 = rng;
+		sig_len = sizeof sig;
+		r = falcon_sign_tree(&rng, sig, &sig_len, FALCON_SIG_CT,
+			esk, "data", 4, tmp, tmp_len);
+		sig2_len = sizeof sig2;
+		if (r == 0) {
+			r = falcon_sign_tree(&rng2, sig2, &sig2_len,
+				FALCON_SIG_CT, ssk + 1, "data", 4,
+				tmp, tmp_len);
+		}
+		if (r != 0) {
+			fprintf(stderr, "sign failed: %d\n", r);
+			exit(EXIT_FAILURE);
+		}
+		if (sig_len != sig2_len) {
+			fprintf(stderr, "sequential key signature length\n");
+			exit(EXIT_FAILURE);
+		}
+		check_eq(sig, sig2, sig_len, "sequential key signature");
+		r = falcon_verify(sig2, sig2_len, FALCON_SIG_CT,
+			pk, FALCON_PUBKEY_SIZE(logn), "data", 4,
+			tmp, tmp_len);
+		if (r != 0) {
+			fprintf(stderr, "verify failed: %d\n", r);
+			exit(EXIT_FAILURE);
+		}
+
+		/*
+		 * Stored records keep the layout (format version 2).
+		 */
+		r = falcon_store_expanded_key(rec, rec_len, ssk + 1);
+		if (r == 0) {
+			r = falcon_open_expanded_key(&ek, rec, rec_len);
+		}
+		if (r != (int)rec_len || rec[8] != 2
+			|| falcon_check_expanded_key(rec, rec_len) != 0)
+		{
+			fprintf(stderr, "sequential store/open failed: %d\n", r);
+			exit(EXIT_FAILURE);
+		}
+		rng2 = rng;
+		sig_len = sizeof sig;
+		r = falcon_sign_tree(&rng, sig, &sig_len, FALCON_SIG_CT,
+			esk, "data", 4, tmp, tmp_len);
+		sig2_len = sizeof sig2;
+		if (r == 0) {
+			r = falcon_sign_tree(&rng2, sig2, &sig2_len,
+				FALCON_SIG_CT, ek, "data", 4, tmp, tmp_len);
+		}
+		if (r != 0) {
+			fprintf(stderr, "sign failed: %d\n", r);
+			exit(EXIT_FAILURE);
+		}
+		check_eq(sig, sig2, sig_len, "stored sequential signature");
+		rec[8] = 1;
+		if (falcon_open_expanded_key(&ek, rec, rec_len)
+			!= FALCON_ERR_FORMAT)
+		{
+			fprintf(stderr, "wrong layout version accepted\n");
+			exit(EXIT_FAILURE);
+		}
+
+		printf(".");
+		fflush(stdout);
+	}
+
+	xfree(rec);
+	xfree(ssk);
+	xfree(esk);
+	xfree(tmp);
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+static void
+test_ntt_pubkey(void)
+{
+	prng_context rng;
+	uint8_t pk[FALCON_PUBKEY_SIZE(10)], sk[FALCON_PRIVKEY_SIZE(10)];
+	uint8_t npk[2][FALCON_NTTPUBKEY_SIZE(10)];
+	uint8_t sig[FALCON_SIG_COMPRESSED_MAXSIZE(10)];
+	uint16_t epk[FALCON_EXPANDEDPUBKEY_SIZE(10) / 2];
+	uint16_t epk2[FALCON_EXPANDEDPUBKEY_SIZE(10) / 2];
+	uint16_t h[1024], h2[1024];
+	uint8_t *tmp;
+	size_t tmp_len, sig_len, pk_len;
+	unsigned logn;
+	int form, r;
+
+	printf("Test NTT public key: ");
+	fflush(stdout);
+
+	tmp_len = FALCON_TMPSIZE_KEYGEN(10);
+	if (tmp_len < FALCON_TMPSIZE_SIGNDYN(10)) {
+		tmp_len = FALCON_TMPSIZE_SIGNDYN(10);
+	}
+	tmp = xmalloc(tmp_len);
+	prng_init_prng_from_seed(&rng, "nttpub", 6);
+
+	for (logn = 1; logn <= 10; logn ++) {
+		pk_len = FALCON_PUBKEY_SIZE(logn);
+		r = falcon_keygen_make(&rng, logn,
+			sk, FALCON_PRIVKEY_SIZE(logn), pk, pk_len,
+			tmp, tmp_len);
+		if (r == 0) {
+			sig_len = sizeof sig;
+			r = falcon_sign_dyn(&rng, sig, &sig_len,
+				FALCON_SIG_COMPRESSED,
+				sk, FALCON_PRIVKEY_SIZE(logn), "data", 4,
+				tmp, tmp_len);
+		}
+		if (r == 0) {
+			r = falcon_expand_pubkey(epk, sizeof epk, pk, pk_len);
+		}
+		if (r != 0) {
+			fprintf(stderr, "key setup failed: %d\n", r);
+			exit(EXIT_FAILURE);
+		}
+		if (falcon_encode_ntt_pubkey(npk[0], pk_len, 2,
+			pk, pk_len, tmp, tmp_len) != FALCON_ERR_BADARG
+			|| falcon_encode_ntt_pubkey(npk[0], pk_len - 1,
+			FALCON_NTTPUB_PLAIN, pk, pk_len, tmp, tmp_len)
+			!= FALCON_ERR_SIZE
+			|| falcon_encode_ntt_pubkey(npk[0], pk_len,
+			FALCON_NTTPUB_PLAIN, pk, pk_len,
+			tmp, FALCON_TMPSIZE_NTTPUB(logn) - 1)
+			!= FALCON_ERR_SIZE)
+		{
+			fprintf(stderr, "bad NTT encoding parameters accepted\n");
+			exit(EXIT_FAILURE);
+		}
+
+		for (form = FALCON_NTTPUB_PLAIN;
+			form <= FALCON_NTTPUB_MONTY; form ++)
+		{
+			r = falcon_encode_ntt_pubkey(npk[form], pk_len, form,
+				pk, pk_len, tmp, FALCON_TMPSIZE_NTTPUB(logn));
+			if (r != 0) {
+				fprintf(stderr, "NTT encoding failed: %d\n", r);
+				exit(EXIT_FAILURE);
+			}
+			if (npk[form][0] != ((1 + form) << 4) + logn
+				|| falcon_get_logn(npk[form], pk_len)
+				!= (int)logn)
+			{
+				fprintf(stderr, "NTT key: wrong header\n");
+				exit(EXIT_FAILURE);
+			}
+
+			/*
+			 * Values are those of the internal NTT.
+			 */
+			Zf(modq_decode)(h, logn, pk + 1, pk_len - 1);
+			if (form == FALCON_NTTPUB_MONTY) {
+				Zf(to_ntt_monty)(h, logn);
+			} else {
+				Zf(to_ntt)(h, logn);
+			}
+			Zf(modq_decode)(h2, logn, npk[form] + 1, pk_len - 1);
+			check_eq(h, h2, sizeof(uint16_t) << logn,
+				"NTT key values");
+
+			r = falcon_verify_ntt_pubkey(sig, sig_len,
+				FALCON_SIG_COMPRESSED, npk[form], pk_len,
+				"data", 4, tmp, tmp_len);
+			if (r != 0) {
+				fprintf(stderr, "NTT key verify failed: %d\n",
+					r);
+				exit(EXIT_FAILURE);
+			}
+			if (falcon_verify_ntt_pubkey(sig, sig_len,
+				FALCON_SIG_COMPRESSED, npk[form], pk_len,
+				"dat4", 4, tmp, tmp_len) != FALCON_ERR_BADSIG
+				|| falcon_verify_ntt_pubkey(sig, sig_len,
+				FALCON_SIG_COMPRESSED, npk[form], pk_len,
+				"data", 4, tmp, FALCON_TMPSIZE_VERIFY(logn) - 1)
+				!= FALCON_ERR_SIZE
+				|| falcon_verify_ntt_pubkey(sig, sig_len,
+				FALCON_SIG_COMPRESSED, npk[form], pk_len - 1,
+				"data", 4, tmp, tmp_len) != FALCON_ERR_FORMAT)
+			{
+				fprintf(stderr, "NTT key: bad verify accepted\n");
+				exit(EXIT_FAILURE);
+			}
+
+			/*
+			 * An NTT key expands to the same expanded key (the
+			 * arrays are aligned, so the values start at
+			 * offset 2).
+			 */
+			r = falcon_expand_pubkey(epk2, sizeof epk2,
+				npk[form], pk_len);
+			if (r != 0) {
+				fprintf(stderr, "NTT key expand failed: %d\n",
+					r);
+				exit(EXIT_FAILURE);
+			}
+			if (*(uint8_t *)epk2 != logn) {
+				fprintf(stderr, "NTT key expansion: degree\n");
+				exit(EXIT_FAILURE);
+			}
+			check_eq(epk + 1, epk2 + 1, sizeof(uint16_t) << logn,
+				"NTT key expansion");
+		}
+
+		/*
+		 * The two encodings are not interchangeable.
+		 */
+		if (falcon_verify_ntt_pubkey(sig, sig_len,
+			FALCON_SIG_COMPRESSED, pk, pk_len,
+			"data", 4, tmp, tmp_len) != FALCON_ERR_FORMAT
+			|| falcon_verify(sig, sig_len,
+			FALCON_SIG_COMPRESSED, npk[0], pk_len,
+			"data", 4, tmp, tmp_len) != FALCON_ERR_FORMAT
+			|| falcon_encode_ntt_pubkey(npk[1], pk_len,
+			FALCON_NTTPUB_PLAIN, npk[0], pk_len,
+			tmp, tmp_len) != FALCON_ERR_FORMAT)
+		{
+			fprintf(stderr, "wrong key encoding accepted\n");
+			exit(EXIT_FAILURE);
+		}
+		npk[0][0] = 0x30 + logn;
+		if (falcon_verify_ntt_pubkey(sig, sig_len,
+			FALCON_SIG_COMPRESSED, npk[0], pk_len,
+			"data", 4, tmp, tmp_len) != FALCON_ERR_FORMAT)
+		{
+			fprintf(stderr, "unknown NTT form accepted\n");
+			exit(EXIT_FAILURE);
+		}
+
+		printf(".");
+		fflush(stdout);
+	}
+
+	xfree(tmp);
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+/*
+ * A precomputed record followed by falcon_sign_tree_pre() (or
+ * falcon_sign_dyn_pre()) must give the same signature, and leave the
+ * PRNG in the same state, as falcon_sign_tree_ex() (falcon_sign_dyn_ex());
+ * a record is usable once, and only for its degree.
+ */
+static void
+test_presign(void)
+{
+	static const int sig_types[] = {
+		FALCON_SIG_COMPRESSED, FALCON_SIG_PADDED, FALCON_SIG_CT
+	};
+
+	prng_context rng, rng2;
+	falcon_presign ps;
+	uint8_t pk[FALCON_PUBKEY_SIZE(10)], sk[FALCON_PRIVKEY_SIZE(10)];
+	uint8_t sig1[FALCON_SIG_CT_SIZE(10)], sig2[FALCON_SIG_CT_SIZE(10)];
+	uint8_t t1[16], t2[16];
+	uint8_t *tmp, *esk;
+	size_t tmp_len, sig1_len, sig2_len;
+	unsigned logn, levels;
+	int i, dyn, r1, r2;
+
+	printf("Test presign: ");
+	fflush(stdout);
+
+	tmp_len = FALCON_TMPSIZE_MAX(10);
+	tmp = xmalloc(tmp_len);
+	esk = xmalloc(FALCON_EXPANDEDKEY_SIZE(10));
+	prng_init_prng_from_seed(&rng, "presign", 7);
+
+	if (falcon_presign_make(&rng, 0, &ps) != FALCON_ERR_BADARG
+		|| falcon_presign_make(&rng, 11, &ps) != FALCON_ERR_BADARG)
+	{
+		fprintf(stderr, "presign: bad degree accepted\n");
+		exit(EXIT_FAILURE);
+	}
+
+	for (logn = 1; logn <= 10; logn ++) {
+		r1 = falcon_keygen_make(&rng, logn,
+			sk, FALCON_PRIVKEY_SIZE(logn),
+			pk, FALCON_PUBKEY_SIZE(logn), tmp, tmp_len);
+		if (r1 != 0) {
+			fprintf(stderr, "keygen failed: %d\n", r1);
+			exit(EXIT_FAILURE);
+		}
+
+		/*
+		 * Raw key, full expanded key, compact expanded key.
+		 */
+		for (levels = 0; levels <= 2; levels ++) {
+			dyn = levels == 0;
+			if (levels == 1) {
+				r1 = falcon_expand_privkey(esk,
+					FALCON_EXPANDEDKEY_SIZE(logn),
+					sk, FALCON_PRIVKEY_SIZE(logn),
+					tmp, tmp_len);
+			} else if (levels == 2 && logn >= 3) {
+				r1 = falcon_expand_privkey_compact(esk,
+					FALCON_COMPACTKEY_SIZE(logn, 1), 1,
+					sk, FALCON_PRIVKEY_SIZE(logn),
+					tmp, tmp_len);
+			} else if (levels == 2) {
+				break;
+			}
+			if (r1 != 0) {
+				fprintf(stderr, "expand failed: %d\n", r1);
+				exit(EXIT_FAILURE);
+			}
+
+			for (i = 0; i < 6; i ++) {
+				int sig_type;
+
+				sig_type = sig_types[i % 3];
+				rng2 = rng;
+				sig1_len = sizeof sig1;
+				sig2_len = sizeof sig2;
+				if (dyn) {
+					r1 = falcon_sign_dyn_ex(&rng,
+						sig1, &sig1_len, sig_type,
+						sk, FALCON_PRIVKEY_SIZE(logn),
+						"data", 4, tmp, tmp_len, NULL);
+				} else {
+					r1 = falcon_sign_tree_ex(&rng,
+						sig1, &sig1_len, sig_type,
+						esk, "data", 4,
+						tmp, tmp_len, NULL);
+				}
+				r2 = falcon_presign_make(&rng2, logn, &ps);
+				if (r2 == 0 && dyn) {
+					r2 = falcon_sign_dyn_pre(&rng2, &ps,
+						sig2, &sig2_len, sig_type,
+						sk, FALCON_PRIVKEY_SIZE(logn),
+						"data", 4, tmp, tmp_len, NULL);
+				} else if (r2 == 0) {
+					r2 = falcon_sign_tree_pre(&rng2, &ps,
+						sig2, &sig2_len, sig_type,
+						esk, "data", 4,
+						tmp, tmp_len, NULL);
+				}
+				if (r1 != 0 || r2 != 0) {
+					fprintf(stderr, "presign: sign failed:"
+						" %d / %d\n", r1, r2);
+					exit(EXIT_FAILURE);
+				}
+				if (sig1_len != sig2_len) {
+					fprintf(stderr, "presign: length"
+						" mismatch\n");
+					exit(EXIT_FAILURE);
+				}
+				check_eq(sig1, sig2, sig1_len, "presign");
+				rng2 = rng;
+				prng_extract(&rng, t1, sizeof t1);
+				prng_extract(&rng2, t2, sizeof t2);
+				check_eq(t1, t2, sizeof t1, "presign state");
+			}
+
+			/*
+			 * A used record is cleared and rejected.
+			 */
+			sig2_len = sizeof sig2;
+			if (dyn) {
+				r2 = falcon_sign_dyn_pre(&rng, &ps,
+					sig2, &sig2_len, FALCON_SIG_COMPRESSED,
+					sk, FALCON_PRIVKEY_SIZE(logn),
+					"data", 4, tmp, tmp_len, NULL);
+			} else {
+				r2 = falcon_sign_tree_pre(&rng, &ps,
+					sig2, &sig2_len, FALCON_SIG_COMPRESSED,
+					esk, "data", 4, tmp, tmp_len, NULL);
+			}
+			if (r2 != FALCON_ERR_BADARG) {
+				fprintf(stderr, "presign: reuse accepted\n");
+				exit(EXIT_FAILURE);
+			}
+
+			/*
+			 * So is a record for another degree; it is cleared
+			 * too.
+			 */
+			falcon_presign_make(&rng, logn == 1 ? 2 : 1, &ps);
+			sig2_len = sizeof sig2;
+			if (dyn) {
+				r2 = falcon_sign_dyn_pre(&rng, &ps,
+					sig2, &sig2_len, FALCON_SIG_COMPRESSED,
+					sk, FALCON_PRIVKEY_SIZE(logn),
+					"data", 4, tmp, tmp_len, NULL);
+			} else {
+				r2 = falcon_sign_tree_pre(&rng, &ps,
+					sig2, &sig2_len, FALCON_SIG_COMPRESSED,
+					esk, "data", 4, tmp, tmp_len, NULL);
+			}
+			if (r2 != FALCON_ERR_BADARG) {
+				fprintf(stderr, "presign: wrong degree"
+					" accepted\n");
+				exit(EXIT_FAILURE);
+			}
+			for (sig2_len = 0; sig2_len < sizeof ps; sig2_len ++) {
+				if (((uint8_t *)&ps)[sig2_len] != 0) {
+					fprintf(stderr, "presign: record"
+						" not cleared\n");
+					exit(EXIT_FAILURE);
+				}
+			}
+		}
+		printf(".");
+		fflush(stdout);
+	}
+
+	xfree(esk);
+	xfree(tmp);
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+static void
+test_sign_batch(void)
+{
+	prng_context rng, rng2;
+	uint8_t pk[FALCON_PUBKEY_SIZE(10)], sk[FALCON_PRIVKEY_SIZE(10)];
+	uint8_t sigbuf[4][FALCON_SIG_CT_SIZE(10)];
+	uint8_t sig2[FALCON_SIG_CT_SIZE(10)];
+	void *sig[4];
+	const void *data[4];
+	size_t sig_len[4], data_len[4], sig2_len;
+	int results[4];
+	falcon_sign_stats stats[4];
+	uint8_t *tmp, *esk;
+	size_t tmp_len, u;
+	unsigned logn, levels;
+	int r;
+
+	printf("Test sign batch: ");
+	fflush(stdout);
+
+	tmp_len = FALCON_TMPSIZE_KEYGEN(10);
+	if (tmp_len < FALCON_TMPSIZE_EXPANDCOMPACT(10)) {
+		tmp_len = FALCON_TMPSIZE_EXPANDCOMPACT(10);
+	}
+	if (tmp_len < FALCON_TMPSIZE_SIGNCOMPACT(10)) {
+		tmp_len = FALCON_TMPSIZE_SIGNCOMPACT(10);
+	}
+	tmp = xmalloc(tmp_len);
+	esk = xmalloc(FALCON_EXPANDEDKEY_SIZE(10));
+	prng_init_prng_from_seed(&rng, "batch", 5);
+	data[0] = "data";
+	data_len[0] = 4;
+	data[1] = "";
+	data_len[1] = 0;
+	data[2] = "other data";
+	data_len[2] = 10;
+	data[3] = "data";
+	data_len[3] = 4;
+	for (u = 0; u < 4; u ++) {
+		sig[u] = sigbuf[u];
+	}
+
+	for (logn = 1; logn <= 10; logn ++) {
+		r = falcon_keygen_make(&rng, logn,
+			sk, FALCON_PRIVKEY_SIZE(logn),
+			pk, FALCON_PUBKEY_SIZE(logn), tmp, tmp_len);
+		if (r != 0) {
+			fprintf(stderr, "keygen failed: %d\n", r);
+			exit(EXIT_FAILURE);
+		}
+
+		/*
+		 * A full key, then a compact key (when large enough).
+		 */
+		for (levels = 0; levels <= 1; levels ++) {
+			if (levels == 0) {
+				r = falcon_expand_privkey(esk,
+					FALCON_EXPANDEDKEY_SIZE(logn),
+					sk, FALCON_PRIVKEY_SIZE(logn),
+					tmp, tmp_len);
+			} else if (logn >= 3) {
+				r = falcon_expand_privkey_compact(esk,
+					FALCON_COMPACTKEY_SIZE(logn, levels),
+					levels, sk, FALCON_PRIVKEY_SIZE(logn),
+					tmp, tmp_len);
+			} else {
+				break;
+			}
+			if (r != 0) {
+				fprintf(stderr, "expand failed: %d\n", r);
+				exit(EXIT_FAILURE);
+			}
+
+			/*
+			 * Item 2 has a buffer too small for a CT signature;
+			 * it fails alone.
+			 */
+			for (u = 0; u < 4; u ++) {
+				sig_len[u] = FALCON_SIG_CT_SIZE(logn);
+			}
+			sig_len[2] = FALCON_SIG_CT_SIZE(logn) - 1;
+			rng2 = rng;
+			r = falcon_sign_tree_batch(&rng, 4, sig, sig_len,
+				FALCON_SIG_CT, esk, data, data_len, results,
+				tmp, tmp_len, stats);
+			if (r != FALCON_ERR_SIZE || results[2] != r) {
+				fprintf(stderr, "sign batch: wrong error: %d\n",
+					r);
+				exit(EXIT_FAILURE);
+			}
+
+			/*
+			 * Same outcome as separate calls with the same PRNG.
+			 */
+			for (u = 0; u < 4; u ++) {
+				sig2_len = u == 2 ? FALCON_SIG_CT_SIZE(logn) - 1
+					: sizeof sig2;
+				r = falcon_sign_tree(&rng2, sig2, &sig2_len,
+					FALCON_SIG_CT, esk, data[u], data_len[u],
+					tmp, tmp_len);
+				if (r != results[u]) {
+					fprintf(stderr, "sign batch: item %u:"
+						" %d / %d\n",
+						(unsigned)u, results[u], r);
+					exit(EXIT_FAILURE);
+				}
+				if (r != 0) {
+					continue;
+				}
+				if (sig_len[u] != sig2_len
+					|| stats[u].attempts == 0)
+				{
+					fprintf(stderr, "sign batch: length\n");
+					exit(EXIT_FAILURE);
+				}
+				check_eq(sig[u], sig2, sig2_len,
+					"batch signature");
+				r = falcon_verify(sig[u], sig_len[u],
+					FALCON_SIG_CT,
+					pk, FALCON_PUBKEY_SIZE(logn),
+					data[u], data_len[u], tmp, tmp_len);
+				if (r != 0) {
+					fprintf(stderr, "verify failed: %d\n",
+						r);
+					exit(EXIT_FAILURE);
+				}
+			}
+			if (memcmp(&rng, &rng2, sizeof rng) != 0) {
+				fprintf(stderr, "sign batch: PRNG state\n");
+				exit(EXIT_FAILURE);
+			}
+		}
+
+		/*
+		 * A key-level error is reported for all items.
+		 */
+		if (falcon_sign_tree_batch(&rng, 4, sig, sig_len,
+			FALCON_SIG_CT, esk, data, data_len, results,
+			tmp, FALCON_TMPSIZE_SIGNTREE(logn) - 1, NULL)
+			!= FALCON_ERR_SIZE || results[0] != FALCON_ERR_SIZE
+			|| results[3] != FALCON_ERR_SIZE
+			|| falcon_sign_tree_batch(&rng, 0, sig, sig_len,
+			FALCON_SIG_CT, esk, data, data_len, results,
+			tmp, tmp_len, NULL) != 0)
+		{
+			fprintf(stderr, "sign batch: bad parameters\n");
+			exit(EXIT_FAILURE);
+		}
+
+		printf(".");
+		fflush(stdout);
+	}
+
+	xfree(esk);
+	xfree(tmp);
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+static void
+test_ctx(void)
+{
+	static const unsigned flags[] = { 0, FALCON_CTX_HUGEPAGES };
+	prng_context rng, rng2;
+	uint8_t pk[FALCON_PUBKEY_SIZE(10)], sk[FALCON_PRIVKEY_SIZE(10)];
+	uint8_t pk2[FALCON_PUBKEY_SIZE(10)];
+	uint8_t sig[FALCON_SIG_CT_SIZE(10)], sig2[FALCON_SIG_CT_SIZE(10)];
+	uint8_t *esk, *tmp, *buf, *arena;
+	falcon_ctx *ctx;
+	size_t sig_len, sig2_len, tmp_len, len, arena_len, u;
+	unsigned logn, f;
+	int r;
+
+	printf("Test context: ");
+	fflush(stdout);
+
+	/*
+	 * FALCON_TMPSIZE_MAX() covers all single-threaded operations.
+	 */
+	for (logn = 1; logn <= 10; logn ++) {
+		size_t sz[10];
+
+		sz[0] = FALCON_TMPSIZE_KEYGEN(logn);
+		sz[1] = FALCON_TMPSIZE_MAKEPUB(logn);
+		sz[2] = FALCON_TMPSIZE_SIGNDYN(logn);
+		sz[3] = FALCON_TMPSIZE_SIGNTREE(logn);
+		sz[4] = FALCON_TMPSIZE_EXPANDPRIV(logn);
+		sz[5] = FALCON_TMPSIZE_EXPANDCOMPACT(logn);
+		sz[6] = FALCON_TMPSIZE_SIGNCOMPACT(logn);
+		sz[7] = FALCON_TMPSIZE_NTTPUB(logn);
+		sz[8] = FALCON_TMPSIZE_VERIFY(logn);
+		sz[9] = FALCON_TMPSIZE_VERIFYBATCH(logn);
+		for (u = 0; u < 10; u ++) {
+			if (sz[u] > FALCON_TMPSIZE_MAX(logn)) {
+				fprintf(stderr, "FALCON_TMPSIZE_MAX(%u) too small"
+					" (%u)\n", logn, (unsigned)u);
+				exit(EXIT_FAILURE);
+			}
+		}
+	}
+
+	if (falcon_ctx_new(0, 1, 0) != NULL
+		|| falcon_ctx_new(11, 1, 0) != NULL
+		|| falcon_ctx_new(10, FALCON_KEYGEN_MAX_THREADS + 1, 0) != NULL
+		|| falcon_ctx_new(10, 1, 2) != NULL)
+	{
+		fprintf(stderr, "bad context parameters accepted\n");
+		exit(EXIT_FAILURE);
+	}
+	falcon_ctx_free(NULL);
+
+	tmp_len = FALCON_TMPSIZE_MAX(10);
+	tmp = xmalloc(tmp_len);
+	esk = xmalloc(FALCON_EXPANDEDKEY_SIZE(10));
+	len = FALCON_CTX_SIZE(10, 4);
+	buf = xmalloc(len + 1);
+	prng_init_prng_from_seed(&rng, "context", 7);
+
+	for (f = 0; f < 3; f ++) {
+		if (f < 2) {
+			ctx = falcon_ctx_new(10, 4, flags[f]);
+		} else {
+			/*
+			 * Caller buffer, at an odd address.
+			 */
+			if (falcon_ctx_init(buf + 1, len - 1, 10, 4) != NULL) {
+				fprintf(stderr, "short context buffer\n");
+				exit(EXIT_FAILURE);
+			}
+			ctx = falcon_ctx_init(buf + 1, len, 10, 4);
+		}
+		if (ctx == NULL) {
+			fprintf(stderr, "context creation failed\n");
+			exit(EXIT_FAILURE);
+		}
+		if (f == 2 && falcon_ctx_backing(ctx) != FALCON_CTX_CALLER) {
+			fprintf(stderr, "wrong context backing\n");
+			exit(EXIT_FAILURE);
+		}
+		if (falcon_ctx_tmp(ctx, &u) == NULL
+			|| u < FALCON_TMPSIZE_KEYGEN_MT(10, 4))
+		{
+			fprintf(stderr, "context arena too small\n");
+			exit(EXIT_FAILURE);
+		}
+
+		for (logn = 1; logn <= 10; logn ++) {
+			/*
+			 * Key pair generation, then signatures and
+			 * verification, all through the context; signatures
+			 * match those of the tmp[] functions.
+			 */
+			rng2 = rng;
+			r = falcon_keygen_make_ctx(ctx, &rng, logn,
+				sk, FALCON_PRIVKEY_SIZE(logn),
+				pk, FALCON_PUBKEY_SIZE(logn));
+			if (r == 0) {
+				r = falcon_keygen_make_mt_ctx(ctx, &rng2, logn,
+					sk, FALCON_PRIVKEY_SIZE(logn),
+					pk2, FALCON_PUBKEY_SIZE(logn), 4);
+			}
+			if (r == 0) {
+				r = falcon_make_public_ctx(ctx,
+					pk2, FALCON_PUBKEY_SIZE(logn),
+					sk, FALCON_PRIVKEY_SIZE(logn));
+			}
+			if (r == 0) {
+				r = falcon_expand_privkey_ctx(ctx,
+					esk, FALCON_EXPANDEDKEY_SIZE(logn),
+					sk, FALCON_PRIVKEY_SIZE(logn));
+			}
+			if (r != 0) {
+				fprintf(stderr, "context key setup failed: %d\n",
+					r);
+				exit(EXIT_FAILURE);
+			}
+			check_eq(pk, pk2, FALCON_PUBKEY_SIZE(logn),
+				"context public key");
+
+			rng2 = rng;
+			sig_len = sizeof sig;
+			r = falcon_sign_tree_ctx(ctx, &rng, sig, &sig_len,
+				FALCON_SIG_CT, esk, "data", 4);
+			sig2_len = sizeof sig2;
+			if (r == 0) {
+				r = falcon_sign_tree(&rng2, sig2, &sig2_len,
+					FALCON_SIG_CT, esk, "data", 4,
+					tmp, tmp_len);
+			}
+			if (r != 0 || sig_len != sig2_len) {
+				fprintf(stderr, "context sign failed: %d\n", r);
+				exit(EXIT_FAILURE);
+			}
+			check_eq(sig, sig2, sig_len, "context signature");
+			r = falcon_verify_ctx(ctx, sig, sig_len, FALCON_SIG_CT,
+				pk, FALCON_PUBKEY_SIZE(logn), "data", 4);
+			if (r == 0) {
+				sig_len = sizeof sig;
+				r = falcon_sign_dyn_ctx(ctx, &rng, sig, &sig_len,
+					FALCON_SIG_COMPRESSED,
+					sk, FALCON_PRIVKEY_SIZE(logn),
+					"data", 4);
+			}
+			if (r == 0) {
+				r = falcon_verify_ctx(ctx, sig, sig_len,
+					FALCON_SIG_COMPRESSED,
+					pk, FALCON_PUBKEY_SIZE(logn), "data", 4);
+			}
+			if (r != 0) {
+				fprintf(stderr, "context verify failed: %d\n",
+					r);
+				exit(EXIT_FAILURE);
+			}
+			if (falcon_verify_ctx(ctx, sig, sig_len,
+				FALCON_SIG_COMPRESSED,
+				pk, FALCON_PUBKEY_SIZE(logn), "dat4", 4)
+				!= FALCON_ERR_BADSIG)
+			{
+				fprintf(stderr, "context: bad signature"
+					" accepted\n");
+				exit(EXIT_FAILURE);
+			}
+		}
+
+		arena = falcon_ctx_tmp(ctx, &arena_len);
+		falcon_ctx_free(ctx);
+		if (f == 2) {
+			for (u = 0; u < arena_len; u ++) {
+				if (arena[u] != 0) {
+					fprintf(stderr, "context arena not"
+						" cleared\n");
+					exit(EXIT_FAILURE);
+				}
+			}
+		}
+		printf(".");
+		fflush(stdout);
+	}
+
+	xfree(buf);
+	xfree(esk);
+	xfree(tmp);
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+static void
+test_profile(void)
+{
+	prng_context rng;
+	falcon_profile prof;
+	uint8_t pk[FALCON_PUBKEY_SIZE(9)], sk[FALCON_PRIVKEY_SIZE(9)];
+	uint8_t sig[FALCON_SIG_COMPRESSED_MAXSIZE(9)];
+	uint8_t *tmp;
+	size_t tmp_len, sig_len, u;
+	int unit, r;
+
+	printf("Test profile: ");
+	fflush(stdout);
+
+	tmp_len = FALCON_TMPSIZE_KEYGEN(9);
+	if (tmp_len < FALCON_TMPSIZE_SIGNDYN(9)) {
+		tmp_len = FALCON_TMPSIZE_SIGNDYN(9);
+	}
+	tmp = xmalloc(tmp_len);
+	prng_init_prng_from_seed(&rng, "profile", 7);
+	r = falcon_keygen_make(&rng, 9, sk, sizeof sk, pk, sizeof pk,
+		tmp, tmp_len);
+	if (r != 0) {
+		fprintf(stderr, "keygen failed: %d\n", r);
+		exit(EXIT_FAILURE);
+	}
+
+	falcon_profile_reset();
+	sig_len = sizeof sig;
+	r = falcon_sign_dyn(&rng, sig, &sig_len, FALCON_SIG_COMPRESSED,
+		sk, sizeof sk, "data", 4, tmp, tmp_len);
+	if (r != 0) {
+		fprintf(stderr, "sign failed: %d\n", r);
+		exit(EXIT_FAILURE);
+	}
+	r = falcon_verify(sig, sig_len, FALCON_SIG_COMPRESSED,
+		pk, sizeof pk, "data", 4, tmp, tmp_len);
+	if (r != 0) {
+		fprintf(stderr, "verify failed: %d\n", r);
+		exit(EXIT_FAILURE);
+	}
+
+	unit = falcon_profile_get(&prof);
+	for (u = 0; u < FALCON_PROF_NUM; u ++) {
+		if (unit == FALCON_PROF_UNIT_NONE) {
+			if (prof.count[u] != 0 || prof.ticks[u] != 0) {
+				fprintf(stderr, "counters set without"
+					" FALCON_PROFILE\n");
+				exit(EXIT_FAILURE);
+			}
+		} else if (prof.count[u] == 0) {
+			fprintf(stderr, "phase %u not measured\n", (unsigned)u);
+			exit(EXIT_FAILURE);
+		}
+	}
+	if (prof.count[FALCON_PROF_SAMPLE] < prof.count[FALCON_PROF_SIGN]) {
+		fprintf(stderr, "fewer attempts than signatures\n");
+		exit(EXIT_FAILURE);
+	}
+	falcon_profile_reset();
+	falcon_profile_get(&prof);
+	if (prof.count[FALCON_PROF_SIGN] != 0) {
+		fprintf(stderr, "counters not reset\n");
+		exit(EXIT_FAILURE);
+	}
+
+	xfree(tmp);
+	printf("%s done.\n", unit == FALCON_PROF_UNIT_NONE ? "(disabled)"
+		: unit == FALCON_PROF_UNIT_CYCLES ? "(cycles)" : "(ns)");
 	fflush(stdout);
 }
 
@@ -4754,17 +7061,17 @@ test_nist_KAT(unsigned logn, const char *srefhash)
 		inner_prng_inject(&sc, seed2, 48);
 		inner_prng_flip(&sc);
 
-		Zf(sign_dyn)(sig, &sc, f, g, F, G, hm, logn, tmp);
+		Zf(sign_dyn)(sig, &sc, NULL, f, g, F, G, hm, logn, tmp, NULL);
 
 		/*
 		 * Expand the private key and sign again the message,
 		 * and check that the same signature is obtained.
 		 */
-		Zf(expand_privkey)(esk, f, g, F, G, logn, tmp);
+		Zf(expand_privkey)(esk, f, g, F, G, logn, 0, tmp);
 		inner_prng_init(&sc);
 		inner_prng_inject(&sc, seed2, 48);
 		inner_prng_flip(&sc);
-		Zf(sign_tree)(sig2, &sc, esk, hm, logn, tmp);
+		Zf(sign_tree)(sig2, &sc, NULL, esk, 0, hm, logn, tmp, NULL);
 		check_eq(sig, sig2, n * sizeof *sig, "Sign dyn/tree mismatch");
 
 		/*
@@ -4918,7 +7225,7 @@ test_speed_falcon(unsigned logn, uint8_t *tmp)
 
 		begin = clock();
 		for (c = 0; c < num; c ++) {
-			Zf(sign_dyn)(sig, &rng, f, g, F, G, hm, logn, tt);
+			Zf(sign_dyn)(sig, &rng, NULL, f, g, F, G, hm, logn, tt, NULL);
 		}
 		end = clock();
 		d = (double)(end - begin) / (double)CLOCKS_PER_SEC;
@@ -4932,7 +7239,7 @@ test_speed_falcon(unsigned logn, uint8_t *tmp)
 
 	expanded_key = (fpr *)tt;
 	tt2 = (uint8_t *)expanded_key + (8 * logn + 40) * n;
-	Zf(expand_privkey)(expanded_key, f, g, F, G, logn, tt2);
+	Zf(expand_privkey)(expanded_key, f, g, F, G, logn, 0, tt2);
 
 	num = 1;
 	for (;;) {
@@ -4951,7 +7258,7 @@ test_speed_falcon(unsigned logn, uint8_t *tmp)
 
 		begin = clock();
 		for (c = 0; c < num; c ++) {
-			Zf(sign_tree)(sig, &rng, expanded_key, hm, logn, tt2);
+			Zf(sign_tree)(sig, &rng, NULL, expanded_key, 0, hm, logn, tt2, NULL);
 		}
 		end = clock();
 		d = (double)(end - begin) / (double)CLOCKS_PER_SEC;
@@ -5012,15 +7319,32 @@ main(void)
 
 	test_SHAKE256();
 	test_codec();
+	test_comp_fuzz();
 	test_vrfy();
+	test_vrfy_impl();
+	test_htp_impl();
 	test_RNG();
 	test_FP_block();
 	test_poly();
 	test_gaussian0_sampler();
 	test_sampler();
+	test_gaussian0_batch();
+	test_fft_impl();
+	test_specialized();
 	test_sign();
 	test_keygen();
+	test_keygen_impl();
+	test_keygen_mt();
 	test_external_API();
+	test_sign_stats();
+	test_stored_expkey();
+	test_compact_expkey();
+	test_sequential_expkey();
+	test_ntt_pubkey();
+	test_sign_batch();
+	test_presign();
+	test_ctx();
+	test_profile();
 	test_nist_KAT(9, "a57400cbaee7109358859a56c735a3cf048a9da2");
 	test_nist_KAT(10, "affdeb3aa83bf9a2039fa9c17d65fd3e3b9828e2");
 
@@ -137,6 +137,96 @@ void test_unified_sequence() {
     printf("PASSED: Sequential outputs are unique\n");
 }
 
+void test_keccak256_streaming() {
+    printf("\nTest: Keccak256 Streaming Absorb\n");
+
+    // Keccak-256("abc")
+    static const uint8_t kat_abc[32] = {
+        0x4e, 0x03, 0x65, 0x7a, 0xea, 0x45, 0xa9, 0x4f,
+        0xc7, 0xd4, 0x7b, 0xa8, 0x26, 0xc8, 0xd6, 0x67,
+        0xc0, 0xd1, 0xe6, 0xe3, 0x3a, 0x64, 0xa0, 0x36,
+        0xec, 0x44, 0xf5, 0x8f, 0xa1, 0x2d, 0x6c, 0x45
+    };
+    static uint8_t input[70000];
+    inner_keccak256_prng_ctx ctx1, ctx2;
+    uint8_t output1[64];
+    uint8_t output2[64];
+    size_t off, chunk;
+
+    inner_keccak256_init(&ctx1);
+    inner_keccak256_inject(&ctx1, (const uint8_t *)"abc", 3);
+    inner_keccak256_flip(&ctx1);
+    assert(memcmp(ctx1.state, kat_abc, 32) == 0);
+    printf("PASSED: Absorbed state matches Keccak-256 test vector\n");
+
+    for (off = 0; off < sizeof input; off++) {
+        input[off] = (uint8_t)(off * 31 + (off >> 8));
+    }
+
+    // Inject well past any block or 16-bit length boundary in one go
+    inner_keccak256_init(&ctx1);
+    assert(inner_keccak256_inject(&ctx1, input, sizeof input) == 0);
+    inner_keccak256_flip(&ctx1);
+    inner_keccak256_extract(&ctx1, output1, sizeof output1);
+
+    // Inject the same data in uneven chunks
+    inner_keccak256_init(&ctx2);
+    for (off = 0, chunk = 1; off < sizeof input; off += chunk, chunk += 97) {
+        if (chunk > sizeof input - off) {
+            chunk = sizeof input - off;
+        }
+        assert(inner_keccak256_inject(&ctx2, input + off, chunk) == 0);
+    }
+    assert(inner_keccak256_inject(&ctx2, NULL, 0) == 0);
+    inner_keccak256_flip(&ctx2);
+    inner_keccak256_extract(&ctx2, output2, sizeof output2);
+
+    printf("Long input output: ");
+    print_hex(output1, 32);
+    assert(memcmp(output1, output2, sizeof output1) == 0);
+    printf("PASSED: Long chunked input matches single injection\n");
+}
+
+void test_keccak256_counter_mode() {
+    printf("\nTest: Keccak256 Counter-Mode Output\n");
+
+    static const size_t lens[] = { 1, 31, 1, 32, 56, 64, 100, 128, 3, 272, 7 };
+    inner_keccak256_prng_ctx ctx;
+    uint8_t expected[1024 + 32];
+    uint8_t output[1024];
+    uint64_t counter;
+    size_t u, total;
+
+    inner_keccak256_init(&ctx);
+    inner_keccak256_inject(&ctx, (const uint8_t *)"counter mode", 12);
+    inner_keccak256_flip(&ctx);
+
+    // Reference stream: Keccak256(state || big-endian counter)
+    for (counter = 0; counter < sizeof expected / 32; counter++) {
+        uint8_t block[40];
+        SHA3_CTX kc;
+        int i;
+
+        memcpy(block, ctx.state, 32);
+        for (i = 0; i < 8; i++) {
+            block[32 + i] = (uint8_t)(counter >> (56 - i * 8));
+        }
+        keccak_init(&kc);
+        keccak_update(&kc, block, sizeof block);
+        keccak_final(&kc, expected + counter * 32);
+    }
+
+    // Extraction with mixed lengths crosses every group boundary
+    total = 0;
+    for (u = 0; u < sizeof lens / sizeof lens[0]; u++) {
+        inner_keccak256_extract(&ctx, output + total, lens[u]);
+        total += lens[u];
+    }
+    assert(total <= sizeof output);
+    assert(memcmp(output, expected, total) == 0);
+    printf("PASSED: Output matches Keccak256(state || counter)\n");
+}
+
 int main() {
     printf("Running Unified PRNG Tests\n");
     printf("==========================\n\n");
@@ -145,6 +235,8 @@ int main() {
     test_unified_different_lengths();
     test_unified_incremental_injection();
     test_unified_sequence();
+    test_keccak256_streaming();
+    test_keccak256_counter_mode();
     
     printf("\nAll unified PRNG tests passed successfully!\n");
     return 0;
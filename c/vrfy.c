@@ -498,14 +498,586 @@ mq_div_12289(uint32_t x, uint32_t y)
 	return mq_montymul(y18, x);
 }
 
+#if FALCON_AVX2 // yyyAVX2+1
+
 /*
- * Compute NTT on a ring element.
+ * AVX2 versions of the modular operations, on 16 lanes of 16 bits.
+ * All lane values are in the 0..q-1 range, as with the scalar
+ * functions above, and results are identical to the scalar ones.
  */
-static void
-mq_NTT(uint16_t *a, unsigned logn)
+
+/*
+ * Conditional addition of q to lanes whose value is negative (when
+ * interpreted as signed 16-bit integers).
+ */
+TARGET_AVX2
+static inline __m256i
+mq_fix_x16(__m256i d)
+{
+	return _mm256_add_epi16(d,
+		_mm256_and_si256(_mm256_set1_epi16(Q), _mm256_srai_epi16(d, 15)));
+}
+
+TARGET_AVX2
+static inline __m256i
+mq_add_x16(__m256i x, __m256i y)
+{
+	return mq_fix_x16(_mm256_sub_epi16(_mm256_add_epi16(x, y),
+		_mm256_set1_epi16(Q)));
+}
+
+TARGET_AVX2
+static inline __m256i
+mq_sub_x16(__m256i x, __m256i y)
+{
+	return mq_fix_x16(_mm256_sub_epi16(x, y));
+}
+
+TARGET_AVX2
+static inline __m256i
+mq_montymul_x16(__m256i x, __m256i y)
+{
+	/*
+	 * z = x*y is split into its low (zl) and high (zh) 16-bit halves.
+	 * With k = zl*Q0I mod 2^16, the low half of k*q is 2^16 - zl if
+	 * zl != 0, and 0 otherwise; thus (z + k*q) >> 16 is zh plus the
+	 * high half of k*q, plus 1 if zl != 0. As in the scalar code, the
+	 * result is less than 2q and a conditional subtraction finishes
+	 * the reduction.
+	 */
+	__m256i zl, zh, k, c;
+
+	zl = _mm256_mullo_epi16(x, y);
+	zh = _mm256_mulhi_epu16(x, y);
+	k = _mm256_mullo_epi16(zl, _mm256_set1_epi16(Q0I));
+	k = _mm256_mulhi_epu16(k, _mm256_set1_epi16(Q));
+	c = _mm256_add_epi16(_mm256_set1_epi16(1),
+		_mm256_cmpeq_epi16(zl, _mm256_setzero_si256()));
+	zh = _mm256_add_epi16(_mm256_add_epi16(zh, k), c);
+	return mq_fix_x16(_mm256_sub_epi16(zh, _mm256_set1_epi16(Q)));
+}
+
+/*
+ * Butterflies with a distance d < 16 all stay within a block of 16
+ * values. For such a layer, we swap each lane with its partner
+ * (lane index XOR d), so that every lane holds both inputs of its
+ * butterfly; both lanes of a pair then compute the twiddle product
+ * and keep the output that belongs to them. vm selects the lanes of
+ * the second halves (index bit d set); sw() is the partner swap.
+ */
+TARGET_AVX2
+static inline __m256i
+mq_swap8_x16(__m256i x)
+{
+	return _mm256_permute2x128_si256(x, x, 0x01);
+}
+
+TARGET_AVX2
+static inline __m256i
+mq_swap4_x16(__m256i x)
+{
+	return _mm256_shuffle_epi32(x, 0x4E);
+}
+
+TARGET_AVX2
+static inline __m256i
+mq_swap2_x16(__m256i x)
+{
+	return _mm256_shuffle_epi32(x, 0xB1);
+}
+
+TARGET_AVX2
+static inline __m256i
+mq_swap1_x16(__m256i x)
+{
+	return _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(x, 0xB1), 0xB1);
+}
+
+/*
+ * Forward (Cooley-Tukey) butterfly layer within a block: u + s*v and
+ * u - s*v. y is the partner-swapped x.
+ */
+TARGET_AVX2
+static inline __m256i
+mq_ntt_inreg_x16(__m256i x, __m256i y, __m256i vm, __m256i s)
+{
+	__m256i u, v, w;
+
+	u = _mm256_blendv_epi8(x, y, vm);
+	v = _mm256_blendv_epi8(y, x, vm);
+	w = mq_montymul_x16(v, s);
+	return _mm256_blendv_epi8(mq_add_x16(u, w), mq_sub_x16(u, w), vm);
+}
+
+/*
+ * Inverse (Gentleman-Sande) butterfly layer within a block: u + v and
+ * (u - v)*s. y is the partner-swapped x.
+ */
+TARGET_AVX2
+static inline __m256i
+mq_intt_inreg_x16(__m256i x, __m256i y, __m256i vm, __m256i s)
+{
+	__m256i u, v;
+
+	u = _mm256_blendv_epi8(x, y, vm);
+	v = _mm256_blendv_epi8(y, x, vm);
+	return _mm256_blendv_epi8(mq_add_x16(u, v),
+		mq_montymul_x16(mq_sub_x16(u, v), s), vm);
+}
+
+/*
+ * Twiddle vectors for the in-block layers: tw[j] is the factor for
+ * the butterfly group that lane j belongs to, for groups of 16, 8, 4
+ * and 2 lanes, taken from consecutive table entries.
+ */
+TARGET_AVX2
+static inline __m256i
+mq_tw2_x16(const uint16_t *tab)
+{
+	__m128i lo, hi;
+
+	lo = _mm_set1_epi16((short)tab[0]);
+	hi = _mm_set1_epi16((short)tab[1]);
+	return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+}
+
+TARGET_AVX2
+static inline __m256i
+mq_tw4_x16(const uint16_t *tab)
+{
+	__m128i t, lo, hi;
+
+	t = _mm_loadl_epi64((const __m128i *)tab);
+	t = _mm_unpacklo_epi16(t, t);
+	lo = _mm_unpacklo_epi32(t, t);
+	hi = _mm_unpackhi_epi32(t, t);
+	return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+}
+
+TARGET_AVX2
+static inline __m256i
+mq_tw8_x16(const uint16_t *tab)
+{
+	__m128i t, lo, hi;
+
+	t = _mm_loadu_si128((const __m128i *)tab);
+	lo = _mm_unpacklo_epi16(t, t);
+	hi = _mm_unpackhi_epi16(t, t);
+	return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+}
+
+/*
+ * NTT with AVX2 (n >= 16). Layers with a butterfly distance of at
+ * least 16 process 16 butterflies per step; the last four layers are
+ * then applied to each block of 16 values in registers.
+ */
+TARGET_AVX2
+static FALCON_INLINE void
+mq_NTT_avx2(uint16_t *a, unsigned logn)
+{
+	size_t n, t, m, k;
+	__m256i vm8, vm4, vm2, vm1;
+
+	n = (size_t)1 << logn;
+	t = n;
+	for (m = 1; t > 16; m <<= 1) {
+		size_t ht, i, j1;
+
+		ht = t >> 1;
+		for (i = 0, j1 = 0; i < m; i ++, j1 += t) {
+			size_t j, j2;
+			__m256i s;
+
+			s = _mm256_set1_epi16((short)GMb[m + i]);
+			j2 = j1 + ht;
+			for (j = j1; j < j2; j += 16) {
+				__m256i u, v;
+
+				u = _mm256_loadu_si256((__m256i *)(a + j));
+				v = _mm256_loadu_si256((__m256i *)(a + j + ht));
+				v = mq_montymul_x16(v, s);
+				_mm256_storeu_si256((__m256i *)(a + j),
+					mq_add_x16(u, v));
+				_mm256_storeu_si256((__m256i *)(a + j + ht),
+					mq_sub_x16(u, v));
+			}
+		}
+		t = ht;
+	}
+
+	/*
+	 * Here t = 16 and m = n/16.
+	 */
+	vm8 = _mm256_setr_epi16(0, 0, 0, 0, 0, 0, 0, 0,
+		-1, -1, -1, -1, -1, -1, -1, -1);
+	vm4 = _mm256_setr_epi16(0, 0, 0, 0, -1, -1, -1, -1,
+		0, 0, 0, 0, -1, -1, -1, -1);
+	vm2 = _mm256_setr_epi16(0, 0, -1, -1, 0, 0, -1, -1,
+		0, 0, -1, -1, 0, 0, -1, -1);
+	vm1 = _mm256_setr_epi16(0, -1, 0, -1, 0, -1, 0, -1,
+		0, -1, 0, -1, 0, -1, 0, -1);
+	for (k = 0; k < m; k ++) {
+		__m256i x;
+
+		x = _mm256_loadu_si256((__m256i *)(a + (k << 4)));
+		x = mq_ntt_inreg_x16(x, mq_swap8_x16(x), vm8,
+			_mm256_set1_epi16((short)GMb[m + k]));
+		x = mq_ntt_inreg_x16(x, mq_swap4_x16(x), vm4,
+			mq_tw2_x16(&GMb[(m << 1) + (k << 1)]));
+		x = mq_ntt_inreg_x16(x, mq_swap2_x16(x), vm2,
+			mq_tw4_x16(&GMb[(m << 2) + (k << 2)]));
+		x = mq_ntt_inreg_x16(x, mq_swap1_x16(x), vm1,
+			mq_tw8_x16(&GMb[(m << 3) + (k << 3)]));
+		_mm256_storeu_si256((__m256i *)(a + (k << 4)), x);
+	}
+}
+
+/*
+ * Inverse NTT with AVX2 (n >= 16), mirroring mq_NTT_avx2(): the first
+ * four layers run in registers on blocks of 16 values.
+ */
+TARGET_AVX2
+static FALCON_INLINE void
+mq_iNTT_avx2(uint16_t *a, unsigned logn)
+{
+	size_t n, t, m, k, hn;
+	uint32_t ni;
+	__m256i vm8, vm4, vm2, vm1, sn;
+
+	n = (size_t)1 << logn;
+	hn = n >> 1;
+	vm8 = _mm256_setr_epi16(0, 0, 0, 0, 0, 0, 0, 0,
+		-1, -1, -1, -1, -1, -1, -1, -1);
+	vm4 = _mm256_setr_epi16(0, 0, 0, 0, -1, -1, -1, -1,
+		0, 0, 0, 0, -1, -1, -1, -1);
+	vm2 = _mm256_setr_epi16(0, 0, -1, -1, 0, 0, -1, -1,
+		0, 0, -1, -1, 0, 0, -1, -1);
+	vm1 = _mm256_setr_epi16(0, -1, 0, -1, 0, -1, 0, -1,
+		0, -1, 0, -1, 0, -1, 0, -1);
+	for (k = 0; k < (n >> 4); k ++) {
+		__m256i x;
+
+		x = _mm256_loadu_si256((__m256i *)(a + (k << 4)));
+		x = mq_intt_inreg_x16(x, mq_swap1_x16(x), vm1,
+			mq_tw8_x16(&iGMb[hn + (k << 3)]));
+		x = mq_intt_inreg_x16(x, mq_swap2_x16(x), vm2,
+			mq_tw4_x16(&iGMb[(hn >> 1) + (k << 2)]));
+		x = mq_intt_inreg_x16(x, mq_swap4_x16(x), vm4,
+			mq_tw2_x16(&iGMb[(hn >> 2) + (k << 1)]));
+		x = mq_intt_inreg_x16(x, mq_swap8_x16(x), vm8,
+			_mm256_set1_epi16((short)iGMb[(hn >> 3) + k]));
+		_mm256_storeu_si256((__m256i *)(a + (k << 4)), x);
+	}
+
+	t = 16;
+	m = n >> 4;
+	while (m > 1) {
+		size_t hm, dt, i, j1;
+
+		hm = m >> 1;
+		dt = t << 1;
+		for (i = 0, j1 = 0; i < hm; i ++, j1 += dt) {
+			size_t j, j2;
+			__m256i s;
+
+			j2 = j1 + t;
+			s = _mm256_set1_epi16((short)iGMb[hm + i]);
+			for (j = j1; j < j2; j += 16) {
+				__m256i u, v;
+
+				u = _mm256_loadu_si256((__m256i *)(a + j));
+				v = _mm256_loadu_si256((__m256i *)(a + j + t));
+				_mm256_storeu_si256((__m256i *)(a + j),
+					mq_add_x16(u, v));
+				_mm256_storeu_si256((__m256i *)(a + j + t),
+					mq_montymul_x16(mq_sub_x16(u, v), s));
+			}
+		}
+		t = dt;
+		m = hm;
+	}
+
+	/*
+	 * Division by n, as in mq_iNTT().
+	 */
+	ni = R;
+	for (m = n; m > 1; m >>= 1) {
+		ni = mq_rshift1(ni);
+	}
+	sn = _mm256_set1_epi16((short)ni);
+	for (m = 0; m < n; m += 16) {
+		__m256i x;
+
+		x = _mm256_loadu_si256((__m256i *)(a + m));
+		_mm256_storeu_si256((__m256i *)(a + m), mq_montymul_x16(x, sn));
+	}
+}
+
+#elif FALCON_NEON
+
+/*
+ * NEON versions of the modular operations, on 8 lanes of 16 bits.
+ * They follow the AVX2 code above (same layer split, with blocks of 8
+ * values instead of 16), and results are identical to the scalar ones.
+ * Like the rest of the NEON build, they run only after
+ * falcon_set_impl(FALCON_IMPL_NEON) (see falcon.c); test_vrfy_impl()
+ * in test_falcon.c compares them with the generic code.
+ */
+
+/*
+ * Conditional addition of q to lanes whose value is negative (when
+ * interpreted as signed 16-bit integers).
+ */
+static inline uint16x8_t
+mq_fix_x8(uint16x8_t d)
+{
+	return vaddq_u16(d, vandq_u16(vdupq_n_u16(Q),
+		vreinterpretq_u16_s16(vshrq_n_s16(
+			vreinterpretq_s16_u16(d), 15))));
+}
+
+static inline uint16x8_t
+mq_add_x8(uint16x8_t x, uint16x8_t y)
+{
+	return mq_fix_x8(vsubq_u16(vaddq_u16(x, y), vdupq_n_u16(Q)));
+}
+
+static inline uint16x8_t
+mq_sub_x8(uint16x8_t x, uint16x8_t y)
+{
+	return mq_fix_x8(vsubq_u16(x, y));
+}
+
+static inline uint16x8_t
+mq_montymul_x8(uint16x8_t x, uint16x8_t y)
+{
+	/*
+	 * Same computation as mq_montymul(), with the 32-bit products
+	 * in two halves: z = x*y + k*q with k = (x*y)*Q0I mod 2^16, then
+	 * a narrowing shift by 16 and a conditional subtraction.
+	 */
+	uint16x8_t q, k;
+	uint32x4_t z0, z1;
+
+	q = vdupq_n_u16(Q);
+	k = vmulq_u16(vmulq_u16(x, y), vdupq_n_u16(Q0I));
+	z0 = vmull_u16(vget_low_u16(x), vget_low_u16(y));
+	z1 = vmull_high_u16(x, y);
+	z0 = vmlal_u16(z0, vget_low_u16(k), vget_low_u16(q));
+	z1 = vmlal_high_u16(z1, k, q);
+	return mq_fix_x8(vsubq_u16(
+		vshrn_high_n_u32(vshrn_n_u32(z0, 16), z1, 16), q));
+}
+
+/*
+ * In-block layers (distance 4, 2 and 1), as in the AVX2 code: each
+ * lane is swapped with its partner, and the lanes selected by vm
+ * (index bit d set) keep the second output of their butterfly.
+ */
+static const uint16_t mq_vm_x8[3][8] = {
+	{ 0, 0, 0, 0, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF },
+	{ 0, 0, 0xFFFF, 0xFFFF, 0, 0, 0xFFFF, 0xFFFF },
+	{ 0, 0xFFFF, 0, 0xFFFF, 0, 0xFFFF, 0, 0xFFFF }
+};
+
+static inline uint16x8_t
+mq_swap4_x8(uint16x8_t x)
+{
+	return vextq_u16(x, x, 4);
+}
+
+static inline uint16x8_t
+mq_swap2_x8(uint16x8_t x)
+{
+	return vreinterpretq_u16_u32(vrev64q_u32(vreinterpretq_u32_u16(x)));
+}
+
+static inline uint16x8_t
+mq_swap1_x8(uint16x8_t x)
+{
+	return vrev32q_u16(x);
+}
+
+static inline uint16x8_t
+mq_ntt_inreg_x8(uint16x8_t x, uint16x8_t y, uint16x8_t vm, uint16x8_t s)
+{
+	uint16x8_t u, v, w;
+
+	u = vbslq_u16(vm, y, x);
+	v = vbslq_u16(vm, x, y);
+	w = mq_montymul_x8(v, s);
+	return vbslq_u16(vm, mq_sub_x8(u, w), mq_add_x8(u, w));
+}
+
+static inline uint16x8_t
+mq_intt_inreg_x8(uint16x8_t x, uint16x8_t y, uint16x8_t vm, uint16x8_t s)
+{
+	uint16x8_t u, v;
+
+	u = vbslq_u16(vm, y, x);
+	v = vbslq_u16(vm, x, y);
+	return vbslq_u16(vm,
+		mq_montymul_x8(mq_sub_x8(u, v), s), mq_add_x8(u, v));
+}
+
+/*
+ * Twiddle vectors for groups of 4 and 2 lanes.
+ */
+static inline uint16x8_t
+mq_tw2_x8(const uint16_t *tab)
+{
+	return vcombine_u16(vdup_n_u16(tab[0]), vdup_n_u16(tab[1]));
+}
+
+static inline uint16x8_t
+mq_tw4_x8(const uint16_t *tab)
+{
+	uint16x4_t t;
+
+	t = vld1_u16(tab);
+	return vcombine_u16(vzip1_u16(t, t), vzip2_u16(t, t));
+}
+
+/*
+ * NTT with NEON (n >= 8).
+ */
+static FALCON_INLINE void
+mq_NTT_neon(uint16_t *a, unsigned logn)
+{
+	size_t n, t, m, k;
+	uint16x8_t vm4, vm2, vm1;
+
+	n = (size_t)1 << logn;
+	t = n;
+	for (m = 1; t > 8; m <<= 1) {
+		size_t ht, i, j1;
+
+		ht = t >> 1;
+		for (i = 0, j1 = 0; i < m; i ++, j1 += t) {
+			size_t j, j2;
+			uint16x8_t s;
+
+			s = vdupq_n_u16(GMb[m + i]);
+			j2 = j1 + ht;
+			for (j = j1; j < j2; j += 8) {
+				uint16x8_t u, v;
+
+				u = vld1q_u16(a + j);
+				v = mq_montymul_x8(vld1q_u16(a + j + ht), s);
+				vst1q_u16(a + j, mq_add_x8(u, v));
+				vst1q_u16(a + j + ht, mq_sub_x8(u, v));
+			}
+		}
+		t = ht;
+	}
+
+	/*
+	 * Here t = 8 and m = n/8.
+	 */
+	vm4 = vld1q_u16(mq_vm_x8[0]);
+	vm2 = vld1q_u16(mq_vm_x8[1]);
+	vm1 = vld1q_u16(mq_vm_x8[2]);
+	for (k = 0; k < m; k ++) {
+		uint16x8_t x;
+
+		x = vld1q_u16(a + (k << 3));
+		x = mq_ntt_inreg_x8(x, mq_swap4_x8(x), vm4,
+			vdupq_n_u16(GMb[m + k]));
+		x = mq_ntt_inreg_x8(x, mq_swap2_x8(x), vm2,
+			mq_tw2_x8(&GMb[(m << 1) + (k << 1)]));
+		x = mq_ntt_inreg_x8(x, mq_swap1_x8(x), vm1,
+			mq_tw4_x8(&GMb[(m << 2) + (k << 2)]));
+		vst1q_u16(a + (k << 3), x);
+	}
+}
+
+/*
+ * Inverse NTT with NEON (n >= 8), mirroring mq_NTT_neon().
+ */
+static FALCON_INLINE void
+mq_iNTT_neon(uint16_t *a, unsigned logn)
+{
+	size_t n, t, m, k, hn;
+	uint32_t ni;
+	uint16x8_t vm4, vm2, vm1, sn;
+
+	n = (size_t)1 << logn;
+	hn = n >> 1;
+	vm4 = vld1q_u16(mq_vm_x8[0]);
+	vm2 = vld1q_u16(mq_vm_x8[1]);
+	vm1 = vld1q_u16(mq_vm_x8[2]);
+	for (k = 0; k < (n >> 3); k ++) {
+		uint16x8_t x;
+
+		x = vld1q_u16(a + (k << 3));
+		x = mq_intt_inreg_x8(x, mq_swap1_x8(x), vm1,
+			mq_tw4_x8(&iGMb[hn + (k << 2)]));
+		x = mq_intt_inreg_x8(x, mq_swap2_x8(x), vm2,
+			mq_tw2_x8(&iGMb[(hn >> 1) + (k << 1)]));
+		x = mq_intt_inreg_x8(x, mq_swap4_x8(x), vm4,
+			vdupq_n_u16(iGMb[(hn >> 2) + k]));
+		vst1q_u16(a + (k << 3), x);
+	}
+
+	t = 8;
+	m = n >> 3;
+	while (m > 1) {
+		size_t hm, dt, i, j1;
+
+		hm = m >> 1;
+		dt = t << 1;
+		for (i = 0, j1 = 0; i < hm; i ++, j1 += dt) {
+			size_t j, j2;
+			uint16x8_t s;
+
+			j2 = j1 + t;
+			s = vdupq_n_u16(iGMb[hm + i]);
+			for (j = j1; j < j2; j += 8) {
+				uint16x8_t u, v;
+
+				u = vld1q_u16(a + j);
+				v = vld1q_u16(a + j + t);
+				vst1q_u16(a + j, mq_add_x8(u, v));
+				vst1q_u16(a + j + t,
+					mq_montymul_x8(mq_sub_x8(u, v), s));
+			}
+		}
+		t = dt;
+		m = hm;
+	}
+
+	ni = R;
+	for (m = n; m > 1; m >>= 1) {
+		ni = mq_rshift1(ni);
+	}
+	sn = vdupq_n_u16((uint16_t)ni);
+	for (m = 0; m < n; m += 8) {
+		vst1q_u16(a + m, mq_montymul_x8(vld1q_u16(a + m), sn));
+	}
+}
+
+#endif // yyyAVX2-
+
+/*
+ * Body of mq_NTT(), instantiated per degree (see SPECIALIZED_LOGN()).
+ */
+TARGET_AVX2
+static FALCON_INLINE void
+mq_NTT_body(uint16_t *a, unsigned logn)
 {
 	size_t n, t, m;
 
+#if FALCON_AVX2 // yyyAVX2+1
+	if (logn >= 4) {
+		mq_NTT_avx2(a, logn);
+		return;
+	}
+#elif FALCON_NEON
+	if (logn >= 3) {
+		mq_NTT_neon(a, logn);
+		return;
+	}
+#endif // yyyAVX2-
 	n = (size_t)1 << logn;
 	t = n;
 	for (m = 1; m < n; m <<= 1) {
@@ -532,14 +1104,46 @@ mq_NTT(uint16_t *a, unsigned logn)
 }
 
 /*
- * Compute the inverse NTT on a ring element, binary case.
+ * Compute NTT on a ring element.
  */
+TARGET_AVX2
 static void
-mq_iNTT(uint16_t *a, unsigned logn)
+mq_NTT(uint16_t *a, unsigned logn)
+{
+	switch (SPECIALIZED_LOGN(logn)) {
+	case 9:
+		mq_NTT_body(a, 9);
+		break;
+	case 10:
+		mq_NTT_body(a, 10);
+		break;
+	default:
+		mq_NTT_body(a, logn);
+		break;
+	}
+}
+
+/*
+ * Body of mq_iNTT(), instantiated per degree (see SPECIALIZED_LOGN()).
+ */
+TARGET_AVX2
+static FALCON_INLINE void
+mq_iNTT_body(uint16_t *a, unsigned logn)
 {
 	size_t n, t, m;
 	uint32_t ni;
 
+#if FALCON_AVX2 // yyyAVX2+1
+	if (logn >= 4) {
+		mq_iNTT_avx2(a, logn);
+		return;
+	}
+#elif FALCON_NEON
+	if (logn >= 3) {
+		mq_iNTT_neon(a, logn);
+		return;
+	}
+#endif // yyyAVX2-
 	n = (size_t)1 << logn;
 	t = 1;
 	m = n;
@@ -587,16 +1191,61 @@ mq_iNTT(uint16_t *a, unsigned logn)
 	}
 }
 
+/*
+ * Compute the inverse NTT on a ring element, binary case.
+ */
+TARGET_AVX2
+static void
+mq_iNTT(uint16_t *a, unsigned logn)
+{
+	switch (SPECIALIZED_LOGN(logn)) {
+	case 9:
+		mq_iNTT_body(a, 9);
+		break;
+	case 10:
+		mq_iNTT_body(a, 10);
+		break;
+	default:
+		mq_iNTT_body(a, logn);
+		break;
+	}
+}
+
 /*
  * Convert a polynomial (mod q) to Montgomery representation.
  */
+TARGET_AVX2
 static void
 mq_poly_tomonty(uint16_t *f, unsigned logn)
 {
 	size_t u, n;
 
 	n = (size_t)1 << logn;
-	for (u = 0; u < n; u ++) {
+	u = 0;
+#if FALCON_AVX2 // yyyAVX2+1
+	if (n >= 16) {
+		__m256i r2;
+
+		r2 = _mm256_set1_epi16(R2);
+		for (; u < n; u += 16) {
+			__m256i x;
+
+			x = _mm256_loadu_si256((__m256i *)(f + u));
+			_mm256_storeu_si256((__m256i *)(f + u),
+				mq_montymul_x16(x, r2));
+		}
+	}
+#elif FALCON_NEON
+	if (n >= 8) {
+		uint16x8_t r2;
+
+		r2 = vdupq_n_u16(R2);
+		for (; u < n; u += 8) {
+			vst1q_u16(f + u, mq_montymul_x8(vld1q_u16(f + u), r2));
+		}
+	}
+#endif // yyyAVX2-
+	for (; u < n; u ++) {
 		f[u] = (uint16_t)mq_montymul(f[u], R2);
 	}
 }
@@ -605,13 +1254,34 @@ mq_poly_tomonty(uint16_t *f, unsigned logn)
  * Multiply two polynomials together (NTT representation, and using
  * a Montgomery multiplication). Result f*g is written over f.
  */
+TARGET_AVX2
 static void
 mq_poly_montymul_ntt(uint16_t *f, const uint16_t *g, unsigned logn)
 {
 	size_t u, n;
 
 	n = (size_t)1 << logn;
-	for (u = 0; u < n; u ++) {
+	u = 0;
+#if FALCON_AVX2 // yyyAVX2+1
+	if (n >= 16) {
+		for (; u < n; u += 16) {
+			__m256i x, y;
+
+			x = _mm256_loadu_si256((__m256i *)(f + u));
+			y = _mm256_loadu_si256((const __m256i *)(g + u));
+			_mm256_storeu_si256((__m256i *)(f + u),
+				mq_montymul_x16(x, y));
+		}
+	}
+#elif FALCON_NEON
+	if (n >= 8) {
+		for (; u < n; u += 8) {
+			vst1q_u16(f + u, mq_montymul_x8(
+				vld1q_u16(f + u), vld1q_u16(g + u)));
+		}
+	}
+#endif // yyyAVX2-
+	for (; u < n; u ++) {
 		f[u] = (uint16_t)mq_montymul(f[u], g[u]);
 	}
 }
@@ -619,13 +1289,34 @@ mq_poly_montymul_ntt(uint16_t *f, const uint16_t *g, unsigned logn)
 /*
  * Subtract polynomial g from polynomial f.
  */
+TARGET_AVX2
 static void
 mq_poly_sub(uint16_t *f, const uint16_t *g, unsigned logn)
 {
 	size_t u, n;
 
 	n = (size_t)1 << logn;
-	for (u = 0; u < n; u ++) {
+	u = 0;
+#if FALCON_AVX2 // yyyAVX2+1
+	if (n >= 16) {
+		for (; u < n; u += 16) {
+			__m256i x, y;
+
+			x = _mm256_loadu_si256((__m256i *)(f + u));
+			y = _mm256_loadu_si256((const __m256i *)(g + u));
+			_mm256_storeu_si256((__m256i *)(f + u),
+				mq_sub_x16(x, y));
+		}
+	}
+#elif FALCON_NEON
+	if (n >= 8) {
+		for (; u < n; u += 8) {
+			vst1q_u16(f + u, mq_sub_x8(
+				vld1q_u16(f + u), vld1q_u16(g + u)));
+		}
+	}
+#endif // yyyAVX2-
+	for (; u < n; u ++) {
 		f[u] = (uint16_t)mq_sub(f[u], g[u]);
 	}
 }
@@ -640,6 +1331,20 @@ Zf(to_ntt_monty)(uint16_t *h, unsigned logn)
 	mq_poly_tomonty(h, logn);
 }
 
+/* see inner.h */
+void
+Zf(to_ntt)(uint16_t *h, unsigned logn)
+{
+	mq_NTT(h, logn);
+}
+
+/* see inner.h */
+void
+Zf(ntt_to_monty)(uint16_t *h, unsigned logn)
+{
+	mq_poly_tomonty(h, logn);
+}
+
 /* see inner.h */
 int
 Zf(verify_raw)(const uint16_t *c0, const int16_t *s2,
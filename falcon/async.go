@@ -0,0 +1,356 @@
+package falcon
+
+/*
+#include "falcon.h"
+
+#define FALCON_GO_SIGN_CHUNK   64
+
+// Sign a chunk of messages concatenated in arena[]; offs[] holds, for
+// each item, the offset and length of its message. Signature i is
+// written at sigs + i * sig_stride, and its length in sig_len[i]. The
+// pointer arrays expected by falcon_sign_tree_batch() are built here, so
+// that Go only passes pointer-free memory to C.
+static int
+falcon_go_sign_batch(prng_context *rng, size_t num,
+	const uint8_t *arena, const size_t *offs,
+	uint8_t *sigs, size_t sig_stride, size_t *sig_len, int sig_type,
+	const void *expanded_key, int *results,
+	void *tmp, size_t tmp_len, falcon_sign_stats *stats)
+{
+	void *sig[FALCON_GO_SIGN_CHUNK];
+	const void *data[FALCON_GO_SIGN_CHUNK];
+	size_t data_len[FALCON_GO_SIGN_CHUNK];
+	size_t u;
+
+	if (num > FALCON_GO_SIGN_CHUNK) {
+		return FALCON_ERR_BADARG;
+	}
+	for (u = 0; u < num; u ++) {
+		sig[u] = sigs + u * sig_stride;
+		sig_len[u] = sig_stride;
+		data[u] = arena + offs[2 * u + 0];
+		data_len[u] = offs[2 * u + 1];
+	}
+	return falcon_sign_tree_batch(rng, num, sig, sig_len, sig_type,
+		expanded_key, data, data_len, results, tmp, tmp_len, stats);
+}
+*/
+import "C"
+import (
+	"errors"
+	"runtime"
+	"sync"
+	"time"
+	"unsafe"
+)
+
+// signChunk is the number of messages handed to C in one call
+const signChunk = C.FALCON_GO_SIGN_CHUNK
+
+var errAsyncSignerClosed = errors.New("async signer closed")
+
+// signBatchBuffers holds the per-call arrays of SignBatch, kept in the
+// Signer so that repeated batches do not allocate them again
+type signBatchBuffers struct {
+	arena   []byte
+	offs    []C.size_t
+	sigLen  []C.size_t
+	results []C.int
+	stats   []C.falcon_sign_stats
+}
+
+// SignBatch signs all messages with the given signature type, through
+// falcon_sign_tree_batch: up to 64 messages share one cgo call, one key
+// check and the Signer's scratch buffer. It returns one signature and one
+// error slot per message; signatures are the same as with Sign for the
+// same PRNG state
+func (s *Signer) SignBatch(messages [][]byte, sigType int) ([][]byte, []error) {
+	sigs := make([][]byte, len(messages))
+	errs := make([]error, len(messages))
+	sigSize, err := sigBufferSize(s.logN, sigType)
+	if err != nil {
+		for i := range errs {
+			errs[i] = err
+		}
+		return sigs, errs
+	}
+	out := make([]byte, len(messages)*sigSize)
+
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	if s.batch == nil {
+		s.batch = &signBatchBuffers{
+			offs:    make([]C.size_t, 2*signChunk),
+			sigLen:  make([]C.size_t, signChunk),
+			results: make([]C.int, signChunk),
+			stats:   make([]C.falcon_sign_stats, signChunk),
+		}
+	}
+	b := s.batch
+
+	for lo := 0; lo < len(messages); {
+		// A chunk never spans a reseed of the PRNG context
+		hi := lo + signChunk
+		if hi > len(messages) {
+			hi = len(messages)
+		}
+		rng, n, err := s.rng.contextBatch(hi - lo)
+		if err != nil {
+			for i := lo; i < len(messages); i++ {
+				errs[i] = err
+			}
+			break
+		}
+		hi = lo + n
+
+		b.arena = b.arena[:0]
+		for i, m := range messages[lo:hi] {
+			b.offs[2*i+0] = C.size_t(len(b.arena))
+			b.offs[2*i+1] = C.size_t(len(m))
+			b.arena = append(b.arena, m...)
+		}
+		if len(b.arena) == 0 {
+			b.arena = append(b.arena, 0)
+		}
+
+		if !s.store.acquire() {
+			for i := lo; i < len(messages); i++ {
+				errs[i] = errKeyStoreClosed
+			}
+			break
+		}
+		m := currentSignMetrics()
+		var stats *C.falcon_sign_stats
+		if m != nil {
+			stats = &b.stats[0]
+		}
+		start := time.Now()
+		C.falcon_go_sign_batch(
+			&rng.ctx, C.size_t(n),
+			(*C.uint8_t)(unsafe.Pointer(&b.arena[0])), &b.offs[0],
+			(*C.uint8_t)(unsafe.Pointer(&out[lo*sigSize])), C.size_t(sigSize),
+			&b.sigLen[0], C.int(sigType),
+			bytesPtr(s.expKey), &b.results[0],
+			bytesPtr(s.tmp), C.size_t(len(s.tmp)),
+			stats,
+		)
+		elapsed := time.Since(start)
+		s.store.release()
+
+		for i := 0; i < n; i++ {
+			if b.results[i] != 0 {
+				errs[lo+i] = falconError(b.results[i])
+				continue
+			}
+			off := (lo + i) * sigSize
+			sigs[lo+i] = out[off : off+int(b.sigLen[i]) : off+sigSize]
+			if m != nil {
+				probe := signProbe{m: m, stats: &b.stats[i], start: start}
+				probe.observe(elapsed / time.Duration(n))
+			}
+		}
+		lo = hi
+	}
+	return sigs, errs
+}
+
+// fork returns a Signer sharing the expanded key of s, with its own
+// scratch buffer and PRNG context, so that both can sign concurrently
+func (s *Signer) fork() *Signer {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	return &Signer{
+		logN:   s.logN,
+		expKey: s.expKey,
+		tmp:    make([]byte, len(s.tmp)),
+		rng:    reseedingRNG{policy: s.rng.policy},
+		store:  s.store,
+	}
+}
+
+// AsyncSignerConfig configures an AsyncSigner
+type AsyncSignerConfig struct {
+	SigType  int           // signature type of all requests
+	MaxBatch int           // most requests signed together (default and maximum 64)
+	MaxDelay time.Duration // longest wait for a batch to fill (0: sign what is queued)
+	Workers  int           // signing goroutines (default GOMAXPROCS)
+	Queue    int           // pending requests before Sign blocks (default Workers*MaxBatch)
+}
+
+// SignFuture is the pending result of an AsyncSigner request
+type SignFuture struct {
+	done chan struct{}
+	sig  []byte
+	err  error
+}
+
+// Done returns a channel closed once the signature is ready
+func (f *SignFuture) Done() <-chan struct{} {
+	return f.done
+}
+
+// Wait blocks until the signature is ready and returns it
+func (f *SignFuture) Wait() ([]byte, error) {
+	<-f.done
+	return f.sig, f.err
+}
+
+// signRequest is one message queued on an AsyncSigner
+type signRequest struct {
+	message []byte
+	future  *SignFuture
+}
+
+// AsyncSigner signs messages queued from any number of goroutines.
+//
+// Each worker goroutine takes a request from the queue, adds those that
+// arrive within MaxDelay (or, with MaxDelay = 0, those already queued),
+// up to MaxBatch, and signs them with one SignBatch call. Under load,
+// batches fill up and the per-message cgo and locking costs are shared;
+// when idle, a request is signed alone with at most MaxDelay of extra
+// latency. Workers share the expanded key of the Signer they were created
+// from, each with its own scratch buffer and PRNG context, so up to
+// Workers batches are signed in parallel.
+type AsyncSigner struct {
+	cfg     AsyncSignerConfig
+	reqs    chan signRequest
+	wg      sync.WaitGroup
+	closeMu sync.RWMutex
+	closed  bool
+}
+
+// NewAsyncSigner starts an AsyncSigner signing with the key of signer.
+// The Signer must not be wiped before the AsyncSigner is closed.
+func NewAsyncSigner(signer *Signer, cfg AsyncSignerConfig) (*AsyncSigner, error) {
+	if _, err := sigBufferSize(signer.logN, cfg.SigType); err != nil {
+		return nil, err
+	}
+	if cfg.MaxBatch < 1 || cfg.MaxBatch > signChunk {
+		cfg.MaxBatch = signChunk
+	}
+	if cfg.MaxDelay < 0 {
+		return nil, errors.New("negative batch delay")
+	}
+	if cfg.Workers < 1 {
+		cfg.Workers = runtime.GOMAXPROCS(0)
+	}
+	if cfg.Queue < 1 {
+		cfg.Queue = cfg.Workers * cfg.MaxBatch
+	}
+
+	a := &AsyncSigner{
+		cfg:  cfg,
+		reqs: make(chan signRequest, cfg.Queue),
+	}
+	a.wg.Add(cfg.Workers)
+	for i := 0; i < cfg.Workers; i++ {
+		go a.worker(signer.fork())
+	}
+	return a, nil
+}
+
+// Sign queues a message for signing and returns its future. The message
+// must not be modified until the future is done. Sign blocks while the
+// queue is full.
+func (a *AsyncSigner) Sign(message []byte) *SignFuture {
+	f := &SignFuture{done: make(chan struct{})}
+	a.closeMu.RLock()
+	defer a.closeMu.RUnlock()
+	if a.closed {
+		f.err = errAsyncSignerClosed
+		close(f.done)
+		return f
+	}
+	a.reqs <- signRequest{message: message, future: f}
+	return f
+}
+
+// Close stops accepting requests, waits until all queued requests are
+// signed and stops the workers
+func (a *AsyncSigner) Close() {
+	a.closeMu.Lock()
+	if a.closed {
+		a.closeMu.Unlock()
+		return
+	}
+	a.closed = true
+	close(a.reqs)
+	a.closeMu.Unlock()
+	a.wg.Wait()
+}
+
+// worker gathers and signs batches of requests until the queue is closed
+func (a *AsyncSigner) worker(s *Signer) {
+	defer a.wg.Done()
+	// Only the scratch buffer is the worker's own; the key is shared
+	defer wipe(s.tmp)
+
+	batch := make([]signRequest, 0, a.cfg.MaxBatch)
+	messages := make([][]byte, 0, a.cfg.MaxBatch)
+	timer := time.NewTimer(time.Hour)
+	timer.Stop()
+
+	for {
+		req, ok := <-a.reqs
+		if !ok {
+			return
+		}
+		batch = append(batch[:0], req)
+		open := a.fill(&batch, timer)
+
+		messages = messages[:0]
+		for _, r := range batch {
+			messages = append(messages, r.message)
+		}
+		sigs, errs := s.SignBatch(messages, a.cfg.SigType)
+		for i, r := range batch {
+			r.future.sig, r.future.err = sigs[i], errs[i]
+			close(r.future.done)
+			batch[i] = signRequest{}
+		}
+		if !open {
+			return
+		}
+	}
+}
+
+// fill adds queued requests to the batch, up to MaxBatch, waiting at most
+// MaxDelay for them. It returns false once the queue is closed and empty.
+func (a *AsyncSigner) fill(batch *[]signRequest, timer *time.Timer) bool {
+	if a.cfg.MaxDelay == 0 {
+		for len(*batch) < a.cfg.MaxBatch {
+			select {
+			case req, ok := <-a.reqs:
+				if !ok {
+					return false
+				}
+				*batch = append(*batch, req)
+			default:
+				return true
+			}
+		}
+		return true
+	}
+
+	timer.Reset(a.cfg.MaxDelay)
+	defer func() {
+		if !timer.Stop() {
+			select {
+			case <-timer.C:
+			default:
+			}
+		}
+	}()
+	for len(*batch) < a.cfg.MaxBatch {
+		select {
+		case req, ok := <-a.reqs:
+			if !ok {
+				return false
+			}
+			*batch = append(*batch, req)
+		case <-timer.C:
+			return true
+		}
+	}
+	return true
+}
@@ -0,0 +1,146 @@
+package falcon
+
+/*
+#include "falcon.h"
+
+#define FALCON_GO_BATCH_CHUNK   64
+
+// Verify a chunk of signatures whose sig / pubkey / message bytes are
+// concatenated in arena[]. offs[] holds, for each item, six values: the
+// offset and length of the signature, of the public key and of the
+// message. The pointer arrays expected by falcon_verify_batch() are
+// built here, so that Go only passes pointer-free memory to C.
+static int
+falcon_go_verify_batch(size_t num, const uint8_t *arena, const size_t *offs,
+	int sig_type, int *results, void *tmp, size_t tmp_len)
+{
+	const void *sig[FALCON_GO_BATCH_CHUNK];
+	const void *pk[FALCON_GO_BATCH_CHUNK];
+	const void *data[FALCON_GO_BATCH_CHUNK];
+	size_t sig_len[FALCON_GO_BATCH_CHUNK];
+	size_t pk_len[FALCON_GO_BATCH_CHUNK];
+	size_t data_len[FALCON_GO_BATCH_CHUNK];
+	size_t u;
+
+	if (num > FALCON_GO_BATCH_CHUNK) {
+		return FALCON_ERR_BADARG;
+	}
+	for (u = 0; u < num; u ++) {
+		sig[u] = arena + offs[6 * u + 0];
+		sig_len[u] = offs[6 * u + 1];
+		pk[u] = arena + offs[6 * u + 2];
+		pk_len[u] = offs[6 * u + 3];
+		data[u] = arena + offs[6 * u + 4];
+		data_len[u] = offs[6 * u + 5];
+	}
+	return falcon_verify_batch(num, sig, sig_len, sig_type,
+		pk, pk_len, data, data_len, results, tmp, tmp_len);
+}
+*/
+import "C"
+import (
+	"runtime"
+	"sync"
+	"unsafe"
+)
+
+// batchChunk is the number of items handed to C in one call
+const batchChunk = C.FALCON_GO_BATCH_CHUNK
+
+// minItemsPerWorker keeps tiny batches from being spread over many
+// goroutines, where scheduling would cost more than it saves
+const minItemsPerWorker = 16
+
+// BatchItem is one (signature, message, public key) triple to verify
+type BatchItem struct {
+	Signature []byte
+	Message   []byte
+	PublicKey []byte
+}
+
+// VerifyBatch verifies all items with the given signature type and returns
+// one error slot per item (nil for a valid signature).
+//
+// The batch is split into contiguous shards, one per worker goroutine (up
+// to GOMAXPROCS), and each worker verifies its shard through
+// falcon_verify_batch with a single scratch arena. Consecutive items with
+// the same public key decode it only once, so grouping items by signer
+// makes verification cheaper.
+func VerifyBatch(items []BatchItem, sigType int) []error {
+	errs := make([]error, len(items))
+	if len(items) == 0 {
+		return errs
+	}
+
+	workers := runtime.GOMAXPROCS(0)
+	if limit := (len(items) + minItemsPerWorker - 1) / minItemsPerWorker; workers > limit {
+		workers = limit
+	}
+
+	if workers == 1 {
+		verifyShard(items, errs, sigType)
+		return errs
+	}
+
+	var wg sync.WaitGroup
+	per := (len(items) + workers - 1) / workers
+	for lo := 0; lo < len(items); lo += per {
+		hi := lo + per
+		if hi > len(items) {
+			hi = len(items)
+		}
+		wg.Add(1)
+		go func(lo, hi int) {
+			defer wg.Done()
+			verifyShard(items[lo:hi], errs[lo:hi], sigType)
+		}(lo, hi)
+	}
+	wg.Wait()
+	return errs
+}
+
+// verifyShard verifies items sequentially, batchChunk items per C call
+func verifyShard(items []BatchItem, errs []error, sigType int) {
+	tmp := make([]byte, tmpSizeVerifyBatch(10))
+	offs := make([]C.size_t, 6*batchChunk)
+	results := make([]C.int, batchChunk)
+	var arena []byte
+
+	for lo := 0; lo < len(items); lo += batchChunk {
+		hi := lo + batchChunk
+		if hi > len(items) {
+			hi = len(items)
+		}
+		chunk := items[lo:hi]
+
+		// Gather the chunk into one pointer-free buffer
+		arena = arena[:0]
+		for i, it := range chunk {
+			offs[6*i+0] = C.size_t(len(arena))
+			offs[6*i+1] = C.size_t(len(it.Signature))
+			arena = append(arena, it.Signature...)
+			offs[6*i+2] = C.size_t(len(arena))
+			offs[6*i+3] = C.size_t(len(it.PublicKey))
+			arena = append(arena, it.PublicKey...)
+			offs[6*i+4] = C.size_t(len(arena))
+			offs[6*i+5] = C.size_t(len(it.Message))
+			arena = append(arena, it.Message...)
+		}
+		if len(arena) == 0 {
+			arena = append(arena, 0)
+		}
+
+		C.falcon_go_verify_batch(
+			C.size_t(len(chunk)),
+			(*C.uint8_t)(unsafe.Pointer(&arena[0])),
+			&offs[0], C.int(sigType), &results[0],
+			unsafe.Pointer(&tmp[0]), C.size_t(len(tmp)),
+		)
+
+		for i := range chunk {
+			if results[i] != 0 {
+				errs[lo+i] = falconError(results[i])
+			}
+		}
+	}
+}
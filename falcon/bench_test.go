@@ -3,8 +3,13 @@
 package falcon
 
 import (
+	"bytes"
 	"fmt"
+	"os"
+	"path/filepath"
+	"runtime"
 	"testing"
+	"time"
 )
 
 // BenchContext holds context for benchmarks, similar to bench_context in C
@@ -44,6 +49,122 @@ func setupBenchContext(b *testing.B, logN uint) *BenchContext {
 	return bc
 }
 
+// speedUnit returns the unit c/speed.c prints for an operation:
+// milliseconds for key generation, microseconds for everything else
+func speedUnit(name string) (string, float64) {
+	if name == "KeyGen" {
+		return "ms/op", 1e6
+	}
+	return "us/op", 1e3
+}
+
+// reportSpeed reports the time per operation since start in the unit
+// c/speed.c uses for the benchmark, so that both outputs can be compared
+// column by column
+func reportSpeed(b *testing.B, name string, start time.Time) {
+	unit, scale := speedUnit(name)
+	b.ReportMetric(float64(time.Since(start).Nanoseconds())/float64(b.N)/scale, unit)
+}
+
+// runOp runs op b.N times, reporting allocations and the c/speed.c unit
+func runOp(b *testing.B, name string, op func() error) {
+	b.ReportAllocs()
+	b.ResetTimer()
+	start := time.Now()
+	for i := 0; i < b.N; i++ {
+		if err := op(); err != nil {
+			b.Fatalf("%s failed: %v", name, err)
+		}
+	}
+	reportSpeed(b, name, start)
+}
+
+// runOpParallel runs op over GOMAXPROCS goroutines; the reported time is
+// wall clock per operation, i.e. the inverse of the aggregate throughput
+func runOpParallel(b *testing.B, name string, op func() error) {
+	b.ReportAllocs()
+	b.ResetTimer()
+	start := time.Now()
+	b.RunParallel(func(pb *testing.PB) {
+		for pb.Next() {
+			if err := op(); err != nil {
+				b.Errorf("%s failed: %v", name, err)
+				return
+			}
+		}
+	})
+	reportSpeed(b, name, start)
+}
+
+// benchOps returns the operations measured by BenchmarkFalcon and
+// BenchmarkFalconParallel, in the column order of c/speed.c (kg, ek, sd,
+// sdc, st, stc, vv, vvc); the CT signature format stands for the
+// constant-time hash-to-point columns
+func benchOps(b *testing.B, bc *BenchContext) []struct {
+	name string
+	op   func() error
+} {
+	msg := []byte("data")
+	signer, err := NewSigner(bc.privKey)
+	if err != nil {
+		b.Fatalf("NewSigner failed: %v", err)
+	}
+	verifier, err := NewVerifier(bc.publicKey)
+	if err != nil {
+		b.Fatalf("NewVerifier failed: %v", err)
+	}
+	sig, err := Sign(msg, bc.privKey, SigCompressed)
+	if err != nil {
+		b.Fatalf("Initial signature failed: %v", err)
+	}
+	sigCT, err := Sign(msg, bc.privKey, SigCT)
+	if err != nil {
+		b.Fatalf("Initial signature failed: %v", err)
+	}
+
+	return []struct {
+		name string
+		op   func() error
+	}{
+		{"KeyGen", func() error {
+			_, err := GenerateKeyPair(bc.logN)
+			return err
+		}},
+		{"ExpandKey", func() error {
+			_, err := NewSigner(bc.privKey)
+			return err
+		}},
+		{"Sign-Compressed", func() error {
+			_, err := Sign(msg, bc.privKey, SigCompressed)
+			return err
+		}},
+		{"Sign-CT", func() error {
+			_, err := Sign(msg, bc.privKey, SigCT)
+			return err
+		}},
+		{"Sign-Tree-Compressed", func() error {
+			_, err := signer.Sign(msg, SigCompressed)
+			return err
+		}},
+		{"Sign-Tree-CT", func() error {
+			_, err := signer.Sign(msg, SigCT)
+			return err
+		}},
+		{"Verify-Compressed", func() error {
+			return Verify(sig, msg, bc.publicKey, SigCompressed)
+		}},
+		{"Verify-CT", func() error {
+			return Verify(sigCT, msg, bc.publicKey, SigCT)
+		}},
+		{"Verifier-Compressed", func() error {
+			return verifier.Verify(sig, msg, SigCompressed)
+		}},
+		{"Verifier-CT", func() error {
+			return verifier.Verify(sigCT, msg, SigCT)
+		}},
+	}
+}
+
 func BenchmarkFalcon(b *testing.B) {
 	// Log which PRNG implementation is being used
 	b.Logf("Using %s PRNG", getPRNGName())
@@ -53,69 +174,315 @@ func BenchmarkFalcon(b *testing.B) {
 		degree := 1 << logN
 		b.Run(fmt.Sprintf("Degree-%d", degree), func(b *testing.B) {
 			bc := setupBenchContext(b, logN)
+			for _, o := range benchOps(b, bc) {
+				o := o
+				b.Run(o.name, func(b *testing.B) {
+					runOp(b, o.name, o.op)
+				})
+			}
+		})
+	}
+}
 
-			// Benchmark key generation
-			b.Run("KeyGen", func(b *testing.B) {
-				for i := 0; i < b.N; i++ {
-					_, err := GenerateKeyPair(logN)
+// BenchmarkFalconParallel runs the same operations from GOMAXPROCS
+// goroutines at once. Sign-Tree serializes on the Signer's lock, so it
+// shows the cost of sharing one Signer rather than the scaling of
+// falcon_sign_tree.
+func BenchmarkFalconParallel(b *testing.B) {
+	for _, logN := range []uint{9, 10} {
+		b.Run(fmt.Sprintf("Degree-%d", 1<<logN), func(b *testing.B) {
+			bc := setupBenchContext(b, logN)
+			for _, o := range benchOps(b, bc) {
+				o := o
+				b.Run(o.name, func(b *testing.B) {
+					runOpParallel(b, o.name, o.op)
+				})
+			}
+		})
+	}
+}
+
+// BenchmarkMessageSize sweeps the message length from 32 bytes to 1 MiB,
+// so that hashing cost (and its share of a signature) shows up as MB/s
+func BenchmarkMessageSize(b *testing.B) {
+	const logN = 9
+	bc := setupBenchContext(b, logN)
+	signer, err := NewSigner(bc.privKey)
+	if err != nil {
+		b.Fatalf("NewSigner failed: %v", err)
+	}
+	verifier, err := NewVerifier(bc.publicKey)
+	if err != nil {
+		b.Fatalf("NewVerifier failed: %v", err)
+	}
+
+	for _, size := range []int{32, 1 << 10, 16 << 10, 256 << 10, 1 << 20} {
+		msg := make([]byte, size)
+		for i := range msg {
+			msg[i] = byte(i)
+		}
+		sig, err := signer.Sign(msg, SigCompressed)
+		if err != nil {
+			b.Fatalf("Initial signature failed: %v", err)
+		}
+
+		b.Run(fmt.Sprintf("Size-%d/Sign-Tree", size), func(b *testing.B) {
+			b.SetBytes(int64(size))
+			runOp(b, "Sign-Tree", func() error {
+				_, err := signer.Sign(msg, SigCompressed)
+				return err
+			})
+		})
+		b.Run(fmt.Sprintf("Size-%d/Verifier", size), func(b *testing.B) {
+			b.SetBytes(int64(size))
+			runOp(b, "Verifier", func() error {
+				return verifier.Verify(sig, msg, SigCompressed)
+			})
+		})
+		b.Run(fmt.Sprintf("Size-%d/VerifyReader", size), func(b *testing.B) {
+			b.SetBytes(int64(size))
+			runOp(b, "VerifyReader", func() error {
+				return verifier.VerifyReader(bytes.NewReader(msg), sig, SigCompressed)
+			})
+		})
+	}
+}
+
+// BenchmarkCgoOverhead measures the fixed cost of crossing into C, with
+// calls that do almost no work on the C side
+func BenchmarkCgoOverhead(b *testing.B) {
+	bc := setupBenchContext(b, 9)
+
+	b.Run("GetLogN", func(b *testing.B) {
+		runOp(b, "GetLogN", func() error {
+			_, err := GetLogN(bc.publicKey)
+			return err
+		})
+	})
+	b.Run("Implementation", func(b *testing.B) {
+		runOp(b, "Implementation", func() error {
+			Implementation()
+			return nil
+		})
+	})
+	b.Run("PRNG-Extract-1", func(b *testing.B) {
+		out := make([]byte, 1)
+		runOp(b, "PRNG-Extract", func() error {
+			bc.rng.Extract(out)
+			return nil
+		})
+	})
+}
+
+// Helper function to print results similar to C implementation
+func PrintBenchmarkResults(result testing.BenchmarkResult, name string) {
+	nsPerOp := result.NsPerOp()
+	var output string
+	if name == "KeyGen" {
+		// Convert to milliseconds for keygen
+		output = fmt.Sprintf("%8.2f", float64(nsPerOp)/1000000.0)
+	} else {
+		// Convert to microseconds for others
+		output = fmt.Sprintf("%8.2f", float64(nsPerOp)/1000.0)
+	}
+	fmt.Printf("%s: %s", name, output)
+}
+
+// To run the benchmark with custom settings, create a main_test.go file
+func Example_benchmarkOutput() {
+	fmt.Println("degree  kg(ms)   sd(us)  sdc(us)   vv(us)  vvc(us)")
+	// The actual benchmarks will be run using 'go test -bench=.'
+}
+
+// BenchmarkVerifyBatch measures batch verification throughput; run it
+// with -cpu 1,2,4,... to see how it scales with GOMAXPROCS
+func BenchmarkVerifyBatch(b *testing.B) {
+	const batchSize = 1024
+	const signers = 16
+
+	for _, logN := range []uint{9, 10} {
+		b.Run(fmt.Sprintf("Degree-%d", 1<<logN), func(b *testing.B) {
+			var keys []*KeyPair
+			for i := 0; i < signers; i++ {
+				kp, err := GenerateKeyPair(logN)
+				if err != nil {
+					b.Fatalf("KeyGen failed: %v", err)
+				}
+				keys = append(keys, kp)
+			}
+
+			items := make([]BatchItem, batchSize)
+			for i := range items {
+				kp := keys[i*signers/batchSize]
+				msg := []byte(fmt.Sprintf("transaction %d", i))
+				sig, err := Sign(msg, kp.PrivateKey, SigCompressed)
+				if err != nil {
+					b.Fatalf("Initial signature failed: %v", err)
+				}
+				items[i] = BatchItem{sig, msg, kp.PublicKey}
+			}
+			b.ResetTimer()
+			start := time.Now()
+
+			for i := 0; i < b.N; i++ {
+				for j, err := range VerifyBatch(items, SigCompressed) {
 					if err != nil {
-						b.Fatalf("KeyGen failed: %v", err)
+						b.Fatalf("Batch item %d failed: %v", j, err)
 					}
 				}
-			})
+			}
+			b.ReportMetric(float64(time.Since(start).Nanoseconds())/float64(b.N*batchSize), "ns/sig")
+		})
+	}
+}
 
-			// Benchmark signing (compressed)
-			b.Run("Sign-Compressed", func(b *testing.B) {
-				msg := []byte("data")
-				for i := 0; i < b.N; i++ {
-					_, err := Sign(msg, bc.privKey, SigCompressed)
-					if err != nil {
-						b.Fatalf("Sign compressed failed: %v", err)
+// BenchmarkAsyncSigner compares one signature per Signer call with
+// requests grouped by an AsyncSigner, from many concurrent callers
+func BenchmarkAsyncSigner(b *testing.B) {
+	kp, err := GenerateKeyPair(9)
+	if err != nil {
+		b.Fatalf("KeyGen failed: %v", err)
+	}
+	signer, err := NewSigner(kp.PrivateKey)
+	if err != nil {
+		b.Fatalf("NewSigner failed: %v", err)
+	}
+	defer signer.Wipe()
+	msg := []byte("transaction")
+
+	b.Run("Signer", func(b *testing.B) {
+		b.RunParallel(func(pb *testing.PB) {
+			for pb.Next() {
+				if _, err := signer.Sign(msg, SigCompressed); err != nil {
+					b.Fatalf("Sign failed: %v", err)
+				}
+			}
+		})
+	})
+	b.Run("AsyncSigner", func(b *testing.B) {
+		as, err := NewAsyncSigner(signer, AsyncSignerConfig{SigType: SigCompressed})
+		if err != nil {
+			b.Fatalf("NewAsyncSigner failed: %v", err)
+		}
+		defer as.Close()
+		b.SetParallelism(16)
+		b.RunParallel(func(pb *testing.PB) {
+			for pb.Next() {
+				if _, err := as.Sign(msg).Wait(); err != nil {
+					b.Fatalf("Sign failed: %v", err)
+				}
+			}
+		})
+	})
+}
+
+// BenchmarkSignerPrecompute measures the online cost of Signer.Sign with
+// and without a precompute queue, for requests spaced out enough that
+// the queue is refilled in between: the timer is stopped until the
+// producer has queued a record and made the next one, so that it does
+// not compete with the timed call on a single CPU
+func BenchmarkSignerPrecompute(b *testing.B) {
+	kp, err := GenerateKeyPair(9)
+	if err != nil {
+		b.Fatalf("KeyGen failed: %v", err)
+	}
+	msg := []byte("transaction")
+
+	for _, pre := range []bool{false, true} {
+		name := "Direct"
+		if pre {
+			name = "Precomputed"
+		}
+		b.Run(name, func(b *testing.B) {
+			signer, err := NewSigner(kp.PrivateKey)
+			if err != nil {
+				b.Fatalf("NewSigner failed: %v", err)
+			}
+			defer signer.Wipe()
+			if pre {
+				if err := signer.StartPrecompute(1); err != nil {
+					b.Fatalf("StartPrecompute failed: %v", err)
+				}
+			}
+			b.ResetTimer()
+			for i := 0; i < b.N; i++ {
+				b.StopTimer()
+				for pre {
+					st := signer.PrecomputeStats()
+					if st.Ready == 1 && st.Made == st.Served+2 {
+						break
 					}
+					runtime.Gosched()
 				}
-			})
+				b.StartTimer()
+				if _, err := signer.Sign(msg, SigCompressed); err != nil {
+					b.Fatalf("Sign failed: %v", err)
+				}
+			}
+		})
+	}
+}
 
-			// Benchmark signing (CT)
-			b.Run("Sign-CT", func(b *testing.B) {
-				msg := []byte("data")
+// BenchmarkZeroAlloc measures SignTo / VerifyWith with caller buffers;
+// both should report 0 allocs/op
+func BenchmarkZeroAlloc(b *testing.B) {
+	for _, logN := range []uint{9, 10} {
+		b.Run(fmt.Sprintf("Degree-%d", 1<<logN), func(b *testing.B) {
+			bc := setupBenchContext(b, logN)
+			msg := []byte("data")
+			buf := bc.sig[:0]
+
+			b.Run("SignTo", func(b *testing.B) {
+				b.ReportAllocs()
 				for i := 0; i < b.N; i++ {
-					_, err := Sign(msg, bc.privKey, SigCT)
-					if err != nil {
-						b.Fatalf("Sign CT failed: %v", err)
+					if _, err := SignTo(buf, msg, bc.privKey, SigCompressed); err != nil {
+						b.Fatalf("SignTo failed: %v", err)
 					}
 				}
 			})
 
-			// Benchmark verification (compressed)
-			b.Run("Verify-Compressed", func(b *testing.B) {
-				msg := []byte("data")
-				sig, err := Sign(msg, bc.privKey, SigCompressed)
+			b.Run("Signer-SignTo", func(b *testing.B) {
+				signer, err := NewSigner(bc.privKey)
 				if err != nil {
-					b.Fatalf("Initial signature failed: %v", err)
+					b.Fatalf("NewSigner failed: %v", err)
 				}
+				b.ReportAllocs()
 				b.ResetTimer()
+				for i := 0; i < b.N; i++ {
+					if _, err := signer.SignTo(buf, msg, SigCompressed); err != nil {
+						b.Fatalf("Signer SignTo failed: %v", err)
+					}
+				}
+			})
+
+			sig, err := Sign(msg, bc.privKey, SigCompressed)
+			if err != nil {
+				b.Fatalf("Initial signature failed: %v", err)
+			}
+			scratch, err := NewScratch(logN)
+			if err != nil {
+				b.Fatalf("NewScratch failed: %v", err)
+			}
 
+			b.Run("VerifyWith", func(b *testing.B) {
+				b.ReportAllocs()
 				for i := 0; i < b.N; i++ {
-					err := Verify(sig, msg, bc.publicKey, SigCompressed)
-					if err != nil {
-						b.Fatalf("Verify compressed failed: %v", err)
+					if err := VerifyWith(scratch, sig, msg, bc.publicKey, SigCompressed); err != nil {
+						b.Fatalf("VerifyWith failed: %v", err)
 					}
 				}
 			})
 
-			// Benchmark verification (CT)
-			b.Run("Verify-CT", func(b *testing.B) {
-				msg := []byte("data")
-				sig, err := Sign(msg, bc.privKey, SigCT)
+			b.Run("Verifier-VerifyWith", func(b *testing.B) {
+				verifier, err := NewVerifier(bc.publicKey)
 				if err != nil {
-					b.Fatalf("Initial signature failed: %v", err)
+					b.Fatalf("NewVerifier failed: %v", err)
 				}
+				b.ReportAllocs()
 				b.ResetTimer()
-
 				for i := 0; i < b.N; i++ {
-					err := Verify(sig, msg, bc.publicKey, SigCT)
-					if err != nil {
-						b.Fatalf("Verify CT failed: %v", err)
+					if err := verifier.VerifyWith(scratch, sig, msg, SigCompressed); err != nil {
+						b.Fatalf("Verifier VerifyWith failed: %v", err)
 					}
 				}
 			})
@@ -123,22 +490,55 @@ func BenchmarkFalcon(b *testing.B) {
 	}
 }
 
-// Helper function to print results similar to C implementation
-func PrintBenchmarkResults(result testing.BenchmarkResult, name string) {
-	nsPerOp := result.NsPerOp()
-	var output string
-	if name == "KeyGen" {
-		// Convert to milliseconds for keygen
-		output = fmt.Sprintf("%8.2f", float64(nsPerOp)/1000000.0)
-	} else {
-		// Convert to microseconds for others
-		output = fmt.Sprintf("%8.2f", float64(nsPerOp)/1000.0)
-	}
-	fmt.Printf("%s: %s", name, output)
-}
+// BenchmarkSignerStartup compares getting Signers for a set of keys by
+// expanding the private keys against opening a key store of the same
+// keys (one op = all keys)
+func BenchmarkSignerStartup(b *testing.B) {
+	const numKeys = 16
+	for _, logN := range []uint{9, 10} {
+		b.Run(fmt.Sprintf("Degree-%d", 1<<logN), func(b *testing.B) {
+			var sks [][]byte
+			for i := 0; i < numKeys; i++ {
+				kp, err := GenerateKeyPair(logN)
+				if err != nil {
+					b.Fatalf("Failed to generate key pair: %v", err)
+				}
+				sks = append(sks, kp.PrivateKey)
+			}
+			var buf bytes.Buffer
+			if err := WriteKeyStore(&buf, sks); err != nil {
+				b.Fatalf("WriteKeyStore failed: %v", err)
+			}
+			path := filepath.Join(b.TempDir(), "keys.fks")
+			if err := os.WriteFile(path, buf.Bytes(), 0600); err != nil {
+				b.Fatal(err)
+			}
 
-// To run the benchmark with custom settings, create a main_test.go file
-func Example_benchmarkOutput() {
-	fmt.Println("degree  kg(ms)   sd(us)  sdc(us)   vv(us)  vvc(us)")
-	// The actual benchmarks will be run using 'go test -bench=.'
+			b.Run("NewSigner", func(b *testing.B) {
+				runOp(b, "NewSigner", func() error {
+					for _, sk := range sks {
+						if _, err := NewSigner(sk); err != nil {
+							return err
+						}
+					}
+					return nil
+				})
+			})
+			b.Run("KeyStore", func(b *testing.B) {
+				runOp(b, "KeyStore", func() error {
+					ks, err := OpenKeyStore(path)
+					if err != nil {
+						return err
+					}
+					defer ks.Close()
+					for i := 0; i < ks.Len(); i++ {
+						if _, err := ks.Signer(i); err != nil {
+							return err
+						}
+					}
+					return nil
+				})
+			})
+		})
+	}
 }
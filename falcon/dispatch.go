@@ -0,0 +1,35 @@
+package falcon
+
+/*
+#include "falcon.h"
+*/
+import "C"
+import "errors"
+
+// Implementations of the floating-point core (key generation, private key
+// expansion and signing)
+const (
+	ImplGeneric = C.FALCON_IMPL_GENERIC // portable C
+	ImplAVX2    = C.FALCON_IMPL_AVX2    // AVX2 and FMA intrinsics
+	ImplNEON    = C.FALCON_IMPL_NEON    // AArch64 NEON intrinsics
+)
+
+// Implementation returns the implementation in use: by default, ImplAVX2
+// on x86 CPUs that support AVX2 and FMA, ImplGeneric otherwise. ImplNEON
+// is used on AArch64 only after SetImplementation(ImplNEON)
+func Implementation() int {
+	return int(C.falcon_get_impl())
+}
+
+// SetImplementation forces the implementation to use. It is meant for
+// tests and benchmarks, and for opting in to ImplNEON, which has not been
+// tested on AArch64 hardware yet. It should be called before the package
+// is used;
+// expanded keys held by existing Signers keep the values computed by the
+// implementation that created them.
+func SetImplementation(impl int) error {
+	if C.falcon_set_impl(C.int(impl)) != 0 {
+		return errors.New("implementation not available")
+	}
+	return nil
+}
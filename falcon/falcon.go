@@ -5,6 +5,8 @@ package falcon
 /*
 #cgo CFLAGS: -I${SRCDIR}/../c
 #cgo LDFLAGS: ${SRCDIR}/../c/codec.o ${SRCDIR}/../c/common.o ${SRCDIR}/../c/falcon.o ${SRCDIR}/../c/fft.o ${SRCDIR}/../c/fpr.o ${SRCDIR}/../c/keygen.o ${SRCDIR}/../c/rng.o ${SRCDIR}/../c/shake.o ${SRCDIR}/../c/sign.o ${SRCDIR}/../c/vrfy.o
+#cgo LDFLAGS: ${SRCDIR}/../c/codec_avx2.o ${SRCDIR}/../c/common_avx2.o ${SRCDIR}/../c/fft_avx2.o ${SRCDIR}/../c/fpr_avx2.o ${SRCDIR}/../c/keygen_avx2.o ${SRCDIR}/../c/rng_avx2.o ${SRCDIR}/../c/shake_avx2.o ${SRCDIR}/../c/sign_avx2.o ${SRCDIR}/../c/vrfy_avx2.o
+#cgo LDFLAGS: -lpthread
 
 #include "falcon.h"
 #include <stdlib.h>
@@ -34,6 +36,10 @@ size_t falcon_tmpsize_keygen(unsigned logn) {
     return FALCON_TMPSIZE_KEYGEN(logn);
 }
 
+size_t falcon_tmpsize_keygen_mt(unsigned logn, unsigned nthreads) {
+    return FALCON_TMPSIZE_KEYGEN_MT(logn, nthreads);
+}
+
 size_t falcon_tmpsize_signdyn(unsigned logn) {
     return FALCON_TMPSIZE_SIGNDYN(logn);
 }
@@ -41,6 +47,46 @@ size_t falcon_tmpsize_signdyn(unsigned logn) {
 size_t falcon_tmpsize_verify(unsigned logn) {
     return FALCON_TMPSIZE_VERIFY(logn);
 }
+
+size_t falcon_tmpsize_signtree(unsigned logn) {
+    return FALCON_TMPSIZE_SIGNTREE(logn);
+}
+
+size_t falcon_tmpsize_expandpriv(unsigned logn) {
+    return FALCON_TMPSIZE_EXPANDPRIV(logn);
+}
+
+size_t falcon_expandedkey_size(unsigned logn) {
+    return FALCON_EXPANDEDKEY_SIZE(logn);
+}
+
+size_t falcon_expandedpubkey_size(unsigned logn) {
+    return FALCON_EXPANDEDPUBKEY_SIZE(logn);
+}
+
+size_t falcon_tmpsize_nttpub(unsigned logn) {
+    return FALCON_TMPSIZE_NTTPUB(logn);
+}
+
+size_t falcon_tmpsize_verifybatch(unsigned logn) {
+    return FALCON_TMPSIZE_VERIFYBATCH(logn);
+}
+
+size_t falcon_stored_expandedkey_size(unsigned logn) {
+    return FALCON_STORED_EXPANDEDKEY_SIZE(logn);
+}
+
+size_t falcon_compactkey_size(unsigned logn, unsigned levels) {
+    return FALCON_COMPACTKEY_SIZE(logn, levels);
+}
+
+size_t falcon_tmpsize_expandcompact(unsigned logn) {
+    return FALCON_TMPSIZE_EXPANDCOMPACT(logn);
+}
+
+size_t falcon_tmpsize_signcompact(unsigned logn) {
+    return FALCON_TMPSIZE_SIGNCOMPACT(logn);
+}
 */
 import "C"
 import (
@@ -66,6 +112,12 @@ const (
 	SigCT         = C.FALCON_SIG_CT
 )
 
+// Public key representations for NTTPublicKey
+const (
+	NTTPubPlain = C.FALCON_NTTPUB_PLAIN // NTT values
+	NTTPubMonty = C.FALCON_NTTPUB_MONTY // NTT values times 2^16 mod q
+)
+
 // Wrapper functions for size calculations
 func privateKeySize(logN uint) int {
 	return int(C.falcon_privkey_size(C.uint(logN)))
@@ -91,6 +143,10 @@ func tmpSizeKeygen(logN uint) int {
 	return int(C.falcon_tmpsize_keygen(C.uint(logN)))
 }
 
+func tmpSizeKeygenMT(logN, threads uint) int {
+	return int(C.falcon_tmpsize_keygen_mt(C.uint(logN), C.uint(threads)))
+}
+
 func tmpSizeSignDyn(logN uint) int {
 	return int(C.falcon_tmpsize_signdyn(C.uint(logN)))
 }
@@ -99,6 +155,70 @@ func tmpSizeVerify(logN uint) int {
 	return int(C.falcon_tmpsize_verify(C.uint(logN)))
 }
 
+func tmpSizeSignTree(logN uint) int {
+	return int(C.falcon_tmpsize_signtree(C.uint(logN)))
+}
+
+func tmpSizeExpandPriv(logN uint) int {
+	return int(C.falcon_tmpsize_expandpriv(C.uint(logN)))
+}
+
+func expandedKeySize(logN uint) int {
+	return int(C.falcon_expandedkey_size(C.uint(logN)))
+}
+
+func storedExpandedKeySize(logN uint) int {
+	return int(C.falcon_stored_expandedkey_size(C.uint(logN)))
+}
+
+func expandedPubKeySize(logN uint) int {
+	return int(C.falcon_expandedpubkey_size(C.uint(logN)))
+}
+
+func compactKeySize(logN, levels uint) int {
+	return int(C.falcon_compactkey_size(C.uint(logN), C.uint(levels)))
+}
+
+func tmpSizeExpandCompact(logN uint) int {
+	return int(C.falcon_tmpsize_expandcompact(C.uint(logN)))
+}
+
+func tmpSizeSignCompact(logN uint) int {
+	return int(C.falcon_tmpsize_signcompact(C.uint(logN)))
+}
+
+func tmpSizeNTTPub(logN uint) int {
+	return int(C.falcon_tmpsize_nttpub(C.uint(logN)))
+}
+
+func tmpSizeVerifyBatch(logN uint) int {
+	return int(C.falcon_tmpsize_verifybatch(C.uint(logN)))
+}
+
+// sigBufferSize returns the signature buffer size needed for the given type
+func sigBufferSize(logN uint, sigType int) (int, error) {
+	switch sigType {
+	case SigCompressed:
+		return sigCompressedMaxSize(logN), nil
+	case SigPadded:
+		return sigPaddedSize(logN), nil
+	case SigCT:
+		return sigCTSize(logN), nil
+	default:
+		return 0, errors.New("invalid signature type")
+	}
+}
+
+// bytesPtr returns a pointer to the first byte of b, or nil if b is empty.
+// Passing its result to C instead of &b[0] also keeps the cgo pointer
+// check from boxing the whole slice, which costs an allocation per call.
+func bytesPtr(b []byte) unsafe.Pointer {
+	if len(b) == 0 {
+		return nil
+	}
+	return unsafe.Pointer(&b[0])
+}
+
 // KeyPair represents a Falcon key pair
 type KeyPair struct {
 	PublicKey  []byte
@@ -111,7 +231,7 @@ func GetLogN(data []byte) (int, error) {
 		return 0, errors.New("empty input data")
 	}
 
-	result := C.falcon_get_logn(unsafe.Pointer(&data[0]), C.size_t(len(data)))
+	result := C.falcon_get_logn(bytesPtr(data), C.size_t(len(data)))
 	if result < 0 {
 		return 0, falconError(result)
 	}
@@ -120,31 +240,44 @@ func GetLogN(data []byte) (int, error) {
 
 // GenerateKeyPair generates a new Falcon key pair for the given degree (logN)
 func GenerateKeyPair(logN uint) (*KeyPair, error) {
+	return GenerateKeyPairThreads(logN, 1)
+}
+
+// GenerateKeyPairThreads generates a new Falcon key pair, splitting the
+// NTRU solve across the given number of threads. The resulting key has
+// the same distribution as GenerateKeyPair; threads = 1 is the serial path
+func GenerateKeyPairThreads(logN, threads uint) (*KeyPair, error) {
 	if logN < 1 || logN > 10 {
 		return nil, errors.New("logN must be between 1 and 10")
 	}
+	if threads < 1 || threads > C.FALCON_KEYGEN_MAX_THREADS {
+		return nil, fmt.Errorf("threads must be between 1 and %d", C.FALCON_KEYGEN_MAX_THREADS)
+	}
 
 	privKeySize := privateKeySize(logN)
 	pubKeySize := publicKeySize(logN)
-	tmpSize := tmpSizeKeygen(logN)
+	tmpSize := tmpSizeKeygenMT(logN, threads)
 
 	privKey := make([]byte, privKeySize)
 	pubKey := make([]byte, pubKeySize)
 	tmp := make([]byte, tmpSize)
 
-	// Initialize PRNG
-	rng := &PRNGContext{}
-	if err := rng.InitFromSystem(); err != nil {
-		return nil, fmt.Errorf("failed to initialize RNG: %w", err)
+	// Take a seeded PRNG from the pool
+	pooled, rng, err := acquireRNG()
+	if err != nil {
+		return nil, err
 	}
+	defer releaseRNG(pooled)
 
-	result := C.falcon_keygen_make(
+	result := C.falcon_keygen_make_mt(
 		&rng.ctx,
 		C.uint(logN),
 		unsafe.Pointer(&privKey[0]), C.size_t(len(privKey)),
 		unsafe.Pointer(&pubKey[0]), C.size_t(len(pubKey)),
 		unsafe.Pointer(&tmp[0]), C.size_t(len(tmp)),
+		C.uint(threads),
 	)
+	wipe(tmp)
 
 	if result != 0 {
 		return nil, falconError(result)
@@ -158,75 +291,12 @@ func GenerateKeyPair(logN uint) (*KeyPair, error) {
 
 // Sign generates a signature for the given message using the private key
 func Sign(message, privateKey []byte, sigType int) ([]byte, error) {
-	logN, err := GetLogN(privateKey)
-	if err != nil {
-		return nil, fmt.Errorf("invalid private key: %w", err)
-	}
-
-	var sigLen C.size_t
-	var sigSize int
-
-	// Calculate maximum buffer size based on signature type
-	switch sigType {
-	case SigCompressed:
-		sigSize = sigCompressedMaxSize(uint(logN))
-	case SigPadded:
-		sigSize = sigPaddedSize(uint(logN))
-	case SigCT:
-		sigSize = sigCTSize(uint(logN))
-	default:
-		return nil, errors.New("invalid signature type")
-	}
-
-	// Create buffers
-	signature := make([]byte, sigSize)
-	sigLen = C.size_t(sigSize)
-	tmpSize := tmpSizeSignDyn(uint(logN))
-	tmp := make([]byte, tmpSize)
-
-	// Initialize PRNG
-	rng := &PRNGContext{}
-	if err := rng.InitFromSystem(); err != nil {
-		return nil, fmt.Errorf("failed to initialize RNG: %w", err)
-	}
-
-	result := C.falcon_sign_dyn(
-		&rng.ctx,
-		unsafe.Pointer(&signature[0]), &sigLen, C.int(sigType),
-		unsafe.Pointer(&privateKey[0]), C.size_t(len(privateKey)),
-		unsafe.Pointer(&message[0]), C.size_t(len(message)),
-		unsafe.Pointer(&tmp[0]), C.size_t(len(tmp)),
-	)
-
-	if result != 0 {
-		return nil, falconError(result)
-	}
-
-	return signature[:sigLen], nil
+	return SignTo(nil, message, privateKey, sigType)
 }
 
 // Verify verifies a signature using the public key
 func Verify(signature, message, publicKey []byte, sigType int) error {
-	logN, err := GetLogN(publicKey)
-	if err != nil {
-		return fmt.Errorf("invalid public key: %w", err)
-	}
-
-	tmpSize := tmpSizeVerify(uint(logN))
-	tmp := make([]byte, tmpSize)
-
-	result := C.falcon_verify(
-		unsafe.Pointer(&signature[0]), C.size_t(len(signature)), C.int(sigType),
-		unsafe.Pointer(&publicKey[0]), C.size_t(len(publicKey)),
-		unsafe.Pointer(&message[0]), C.size_t(len(message)),
-		unsafe.Pointer(&tmp[0]), C.size_t(len(tmp)),
-	)
-
-	if result != 0 {
-		return falconError(result)
-	}
-
-	return nil
+	return VerifyWith(nil, signature, message, publicKey, sigType)
 }
 
 // PRNGContext wraps the C prng_context struct
@@ -248,11 +318,11 @@ func (p *PRNGContext) InitFromSystem() error {
 }
 
 func (p *PRNGContext) InitFromSeed(seed []byte) {
-	C.prng_init_prng_from_seed(&p.ctx, unsafe.Pointer(&seed[0]), C.size_t(len(seed)))
+	C.prng_init_prng_from_seed(&p.ctx, bytesPtr(seed), C.size_t(len(seed)))
 }
 
 func (p *PRNGContext) Inject(data []byte) {
-	C.prng_inject(&p.ctx, unsafe.Pointer(&data[0]), C.size_t(len(data)))
+	C.prng_inject(&p.ctx, bytesPtr(data), C.size_t(len(data)))
 }
 
 func (p *PRNGContext) Flip() {
@@ -260,7 +330,7 @@ func (p *PRNGContext) Flip() {
 }
 
 func (p *PRNGContext) Extract(out []byte) {
-	C.prng_extract(&p.ctx, unsafe.Pointer(&out[0]), C.size_t(len(out)))
+	C.prng_extract(&p.ctx, bytesPtr(out), C.size_t(len(out)))
 }
 
 // Helper function to convert Falcon error codes to Go errors
@@ -3,7 +3,12 @@ package falcon
 import (
 	"bytes"
 	"fmt"
+	"os"
+	"path/filepath"
+	"runtime"
+	"sync"
 	"testing"
+	"time"
 )
 
 func TestFalconSignatureLifecycle(t *testing.T) {
@@ -93,6 +98,34 @@ func TestPRNG(t *testing.T) {
 	t.Logf("Using %s PRNG", getPRNGName())
 }
 
+func TestGenerateKeyPairThreads(t *testing.T) {
+	message := []byte("threaded keygen")
+	for _, logN := range []uint{9, 10} {
+		for _, threads := range []uint{1, 2, 4} {
+			t.Run(fmt.Sprintf("logN=%d/threads=%d", logN, threads), func(t *testing.T) {
+				kp, err := GenerateKeyPairThreads(logN, threads)
+				if err != nil {
+					t.Fatalf("Failed to generate key pair: %v", err)
+				}
+				sig, err := Sign(message, kp.PrivateKey, SigCompressed)
+				if err != nil {
+					t.Fatalf("Failed to sign: %v", err)
+				}
+				if err := Verify(sig, message, kp.PublicKey, SigCompressed); err != nil {
+					t.Fatalf("Failed to verify: %v", err)
+				}
+			})
+		}
+	}
+
+	if _, err := GenerateKeyPairThreads(9, 0); err == nil {
+		t.Error("Expected error for zero threads")
+	}
+	if _, err := GenerateKeyPairThreads(9, 1000); err == nil {
+		t.Error("Expected error for too many threads")
+	}
+}
+
 func TestGetLogN(t *testing.T) {
 	// Generate keys with different logN values
 	testLogNs := []uint{9, 10} // Test Falcon-512 and Falcon-1024
@@ -124,3 +157,1119 @@ func TestGetLogN(t *testing.T) {
 		})
 	}
 }
+
+func TestSigner(t *testing.T) {
+	for _, logN := range []uint{9, 10} {
+		t.Run(fmt.Sprintf("logN=%d", logN), func(t *testing.T) {
+			keyPair, err := GenerateKeyPair(logN)
+			if err != nil {
+				t.Fatalf("Failed to generate key pair: %v", err)
+			}
+
+			signer, err := NewSigner(keyPair.PrivateKey)
+			if err != nil {
+				t.Fatalf("Failed to create signer: %v", err)
+			}
+			if signer.LogN() != logN {
+				t.Fatalf("Wrong signer logN: got %d, want %d", signer.LogN(), logN)
+			}
+
+			message := []byte("Hello, Falcon!")
+			for _, sigType := range []int{SigCompressed, SigPadded, SigCT} {
+				signature, err := signer.Sign(message, sigType)
+				if err != nil {
+					t.Fatalf("Failed to sign message (type %d): %v", sigType, err)
+				}
+				if err := Verify(signature, message, keyPair.PublicKey, sigType); err != nil {
+					t.Fatalf("Signature verification failed (type %d): %v", sigType, err)
+				}
+			}
+
+			signer.Wipe()
+			if _, err := signer.Sign(message, SigCompressed); err == nil {
+				t.Fatal("Signing with a wiped signer should fail")
+			}
+		})
+	}
+
+	if _, err := NewSigner([]byte{0x09}); err == nil {
+		t.Fatal("NewSigner should reject a malformed private key")
+	}
+}
+
+func TestSignerPrecompute(t *testing.T) {
+	keyPair, err := GenerateKeyPair(9)
+	if err != nil {
+		t.Fatalf("Failed to generate key pair: %v", err)
+	}
+	for _, levels := range []uint{0, 3} {
+		t.Run(fmt.Sprintf("levels=%d", levels), func(t *testing.T) {
+			var signer *Signer
+			if levels == 0 {
+				signer, err = NewSigner(keyPair.PrivateKey)
+			} else {
+				signer, err = NewCompactSigner(keyPair.PrivateKey, levels)
+			}
+			if err != nil {
+				t.Fatalf("Failed to create signer: %v", err)
+			}
+			if err := signer.StartPrecompute(0); err == nil {
+				t.Fatal("StartPrecompute should reject a zero depth")
+			}
+			if err := signer.StartPrecompute(4); err != nil {
+				t.Fatalf("StartPrecompute failed: %v", err)
+			}
+
+			// Let the queue fill, then drain it and more
+			deadline := time.Now().Add(5 * time.Second)
+			for signer.PrecomputeStats().Ready < 4 {
+				if time.Now().After(deadline) {
+					t.Fatal("Precompute queue did not fill")
+				}
+				time.Sleep(time.Millisecond)
+			}
+			message := []byte("Hello, Falcon!")
+			nonces := make(map[string]bool)
+			for i := 0; i < 12; i++ {
+				sigType := []int{SigCompressed, SigPadded, SigCT}[i%3]
+				signature, err := signer.Sign(message, sigType)
+				if err != nil {
+					t.Fatalf("Failed to sign message (type %d): %v", sigType, err)
+				}
+				if err := Verify(signature, message, keyPair.PublicKey, sigType); err != nil {
+					t.Fatalf("Signature verification failed (type %d): %v", sigType, err)
+				}
+				nonce := string(signature[1:41])
+				if nonces[nonce] {
+					t.Fatal("Nonce reused")
+				}
+				nonces[nonce] = true
+			}
+			st := signer.PrecomputeStats()
+			if st.Capacity != 4 || st.Served < 4 || st.Served+st.Misses != 12 ||
+				st.Made < st.Served || st.Failures != 0 {
+				t.Fatalf("Unexpected precompute stats: %+v", st)
+			}
+
+			signer.StopPrecompute()
+			if st := signer.PrecomputeStats(); st != (PrecomputeStats{}) {
+				t.Fatalf("Stats after StopPrecompute: %+v", st)
+			}
+			if _, err := signer.Sign(message, SigCompressed); err != nil {
+				t.Fatalf("Failed to sign after StopPrecompute: %v", err)
+			}
+
+			// Wipe stops a running producer
+			if err := signer.StartPrecompute(2); err != nil {
+				t.Fatalf("StartPrecompute failed: %v", err)
+			}
+			signer.Wipe()
+			if st := signer.PrecomputeStats(); st != (PrecomputeStats{}) {
+				t.Fatalf("Stats after Wipe: %+v", st)
+			}
+		})
+	}
+}
+
+func TestCompactSigner(t *testing.T) {
+	for _, logN := range []uint{9, 10} {
+		t.Run(fmt.Sprintf("logN=%d", logN), func(t *testing.T) {
+			keyPair, err := GenerateKeyPair(logN)
+			if err != nil {
+				t.Fatalf("Failed to generate key pair: %v", err)
+			}
+
+			message := []byte("Hello, Falcon!")
+			for _, levels := range []uint{1, logN / 2, logN - 2} {
+				signer, err := NewCompactSigner(keyPair.PrivateKey, levels)
+				if err != nil {
+					t.Fatalf("Failed to create compact signer (levels %d): %v", levels, err)
+				}
+				if len(signer.expKey) >= expandedKeySize(logN) {
+					t.Errorf("Compact key (levels %d) is not smaller: %d bytes", levels, len(signer.expKey))
+				}
+				for _, sigType := range []int{SigCompressed, SigPadded, SigCT} {
+					signature, err := signer.Sign(message, sigType)
+					if err != nil {
+						t.Fatalf("Failed to sign message (levels %d, type %d): %v", levels, sigType, err)
+					}
+					if err := Verify(signature, message, keyPair.PublicKey, sigType); err != nil {
+						t.Fatalf("Signature verification failed (levels %d, type %d): %v", levels, sigType, err)
+					}
+				}
+				signer.Wipe()
+				if _, err := signer.Sign(message, SigCompressed); err == nil {
+					t.Fatal("Signing with a wiped compact signer should fail")
+				}
+			}
+
+			for _, levels := range []uint{0, logN - 1} {
+				if _, err := NewCompactSigner(keyPair.PrivateKey, levels); err == nil {
+					t.Errorf("NewCompactSigner accepted levels = %d", levels)
+				}
+			}
+		})
+	}
+}
+
+func TestVerifier(t *testing.T) {
+	keyPair, err := GenerateKeyPair(9)
+	if err != nil {
+		t.Fatalf("Failed to generate key pair: %v", err)
+	}
+
+	verifier, err := NewVerifier(keyPair.PublicKey)
+	if err != nil {
+		t.Fatalf("Failed to create verifier: %v", err)
+	}
+
+	message := []byte("Hello, Falcon!")
+	for _, sigType := range []int{SigCompressed, SigPadded, SigCT} {
+		signature, err := Sign(message, keyPair.PrivateKey, sigType)
+		if err != nil {
+			t.Fatalf("Failed to sign message (type %d): %v", sigType, err)
+		}
+		if err := verifier.Verify(signature, message, sigType); err != nil {
+			t.Fatalf("Verifier rejected a valid signature (type %d): %v", sigType, err)
+		}
+		if err := verifier.Verify(signature, []byte("Hello, Falcon?"), sigType); err == nil {
+			t.Fatalf("Verifier accepted a signature for another message (type %d)", sigType)
+		}
+	}
+
+	if _, err := NewVerifier(keyPair.PrivateKey); err == nil {
+		t.Fatal("NewVerifier should reject a private key")
+	}
+}
+
+func TestNTTPublicKey(t *testing.T) {
+	keyPair, err := GenerateKeyPair(9)
+	if err != nil {
+		t.Fatalf("Failed to generate key pair: %v", err)
+	}
+
+	message := []byte("Hello, Falcon!")
+	signature, err := Sign(message, keyPair.PrivateKey, SigCompressed)
+	if err != nil {
+		t.Fatalf("Failed to sign message: %v", err)
+	}
+
+	for _, form := range []int{NTTPubPlain, NTTPubMonty} {
+		nttPubKey, err := NTTPublicKey(keyPair.PublicKey, form)
+		if err != nil {
+			t.Fatalf("Failed to convert public key (form %d): %v", form, err)
+		}
+		if len(nttPubKey) != len(keyPair.PublicKey) {
+			t.Fatalf("NTT public key size %d, expected %d", len(nttPubKey), len(keyPair.PublicKey))
+		}
+		if logN, err := GetLogN(nttPubKey); err != nil || logN != 9 {
+			t.Fatalf("GetLogN on NTT public key: %d, %v", logN, err)
+		}
+		if err := Verify(signature, message, nttPubKey, SigCompressed); err != nil {
+			t.Fatalf("NTT public key rejected a valid signature (form %d): %v", form, err)
+		}
+		if err := Verify(signature, []byte("Hello, Falcon?"), nttPubKey, SigCompressed); err == nil {
+			t.Fatalf("NTT public key accepted a signature for another message (form %d)", form)
+		}
+		if err := VerifyReader(bytes.NewReader(message), signature, nttPubKey, SigCompressed); err != nil {
+			t.Fatalf("VerifyReader rejected a valid signature (form %d): %v", form, err)
+		}
+		verifier, err := NewVerifier(nttPubKey)
+		if err != nil {
+			t.Fatalf("Failed to create verifier from NTT public key: %v", err)
+		}
+		if err := verifier.Verify(signature, message, SigCompressed); err != nil {
+			t.Fatalf("Verifier rejected a valid signature (form %d): %v", form, err)
+		}
+		if _, err := NTTPublicKey(nttPubKey, form); err == nil {
+			t.Fatal("NTTPublicKey should reject a key already in NTT form")
+		}
+	}
+
+	if _, err := NTTPublicKey(keyPair.PublicKey, 2); err == nil {
+		t.Fatal("NTTPublicKey should reject an unknown form")
+	}
+}
+
+func TestVerifierCache(t *testing.T) {
+	cache, err := NewVerifierCache(2)
+	if err != nil {
+		t.Fatalf("Failed to create cache: %v", err)
+	}
+
+	message := []byte("Hello, Falcon!")
+	var keys []*KeyPair
+	for i := 0; i < 3; i++ {
+		kp, err := GenerateKeyPair(9)
+		if err != nil {
+			t.Fatalf("Failed to generate key pair: %v", err)
+		}
+		keys = append(keys, kp)
+
+		signature, err := Sign(message, kp.PrivateKey, SigCompressed)
+		if err != nil {
+			t.Fatalf("Failed to sign message: %v", err)
+		}
+		if err := cache.Verify(signature, message, kp.PublicKey, SigCompressed); err != nil {
+			t.Fatalf("Cached verification failed: %v", err)
+		}
+	}
+
+	if cache.Len() != 2 {
+		t.Fatalf("Wrong cache size: got %d, want 2", cache.Len())
+	}
+
+	// The most recent key must still be cached and return the same Verifier
+	v1, err := cache.Get(keys[2].PublicKey)
+	if err != nil {
+		t.Fatalf("Cache lookup failed: %v", err)
+	}
+	v2, err := cache.Get(keys[2].PublicKey)
+	if err != nil {
+		t.Fatalf("Cache lookup failed: %v", err)
+	}
+	if v1 != v2 {
+		t.Fatal("Cache returned distinct Verifiers for the same key")
+	}
+
+	if _, err := NewVerifierCache(0); err == nil {
+		t.Fatal("NewVerifierCache should reject a zero capacity")
+	}
+}
+
+func TestVerifyBatch(t *testing.T) {
+	var keys []*KeyPair
+	for i := 0; i < 3; i++ {
+		kp, err := GenerateKeyPair(9)
+		if err != nil {
+			t.Fatalf("Failed to generate key pair: %v", err)
+		}
+		keys = append(keys, kp)
+	}
+
+	var items []BatchItem
+	for i := 0; i < 200; i++ {
+		kp := keys[i%len(keys)]
+		message := []byte(fmt.Sprintf("message %d", i))
+		signature, err := Sign(message, kp.PrivateKey, SigCompressed)
+		if err != nil {
+			t.Fatalf("Failed to sign message: %v", err)
+		}
+		items = append(items, BatchItem{signature, message, kp.PublicKey})
+	}
+
+	// Corrupt a few items in different ways
+	items[7].Message = []byte("tampered")
+	items[42].PublicKey = keys[(42+1)%len(keys)].PublicKey
+	items[99].Signature = items[99].Signature[:10]
+	items[150].PublicKey = nil
+
+	errs := VerifyBatch(items, SigCompressed)
+	if len(errs) != len(items) {
+		t.Fatalf("Wrong number of results: got %d, want %d", len(errs), len(items))
+	}
+	for i, err := range errs {
+		bad := i == 7 || i == 42 || i == 99 || i == 150
+		if bad && err == nil {
+			t.Errorf("Item %d: invalid signature accepted", i)
+		}
+		if !bad && err != nil {
+			t.Errorf("Item %d: valid signature rejected: %v", i, err)
+		}
+	}
+
+	if errs := VerifyBatch(nil, SigCompressed); len(errs) != 0 {
+		t.Fatal("Empty batch should return no results")
+	}
+}
+
+func TestSignBatch(t *testing.T) {
+	keyPair, err := GenerateKeyPair(9)
+	if err != nil {
+		t.Fatalf("Failed to generate key pair: %v", err)
+	}
+	signer, err := NewSigner(keyPair.PrivateKey)
+	if err != nil {
+		t.Fatalf("Failed to create signer: %v", err)
+	}
+	defer signer.Wipe()
+
+	// More messages than one C call takes, with a reseed in between
+	signer.SetReseedPolicy(ReseedPolicy{MaxUses: 50})
+	var messages [][]byte
+	for i := 0; i < 150; i++ {
+		messages = append(messages, []byte(fmt.Sprintf("message %d", i)))
+	}
+	messages[3] = nil
+
+	for _, sigType := range []int{SigCompressed, SigPadded, SigCT} {
+		sigs, errs := signer.SignBatch(messages, sigType)
+		if len(sigs) != len(messages) || len(errs) != len(messages) {
+			t.Fatalf("Wrong number of results: %d, %d", len(sigs), len(errs))
+		}
+		for i := range messages {
+			if errs[i] != nil {
+				t.Fatalf("Item %d (type %d): %v", i, sigType, errs[i])
+			}
+			if err := Verify(sigs[i], messages[i], keyPair.PublicKey, sigType); err != nil {
+				t.Fatalf("Item %d (type %d): signature rejected: %v", i, sigType, err)
+			}
+		}
+		if bytes.Equal(sigs[0], sigs[len(sigs)-1]) {
+			t.Fatal("Batch signatures should differ")
+		}
+		// Appending to a signature must not overwrite the next one
+		next := append([]byte(nil), sigs[1]...)
+		_ = append(sigs[0], make([]byte, 64)...)
+		if !bytes.Equal(sigs[1], next) {
+			t.Fatal("Batch signatures share capacity")
+		}
+	}
+
+	_, errs := signer.SignBatch(messages[:2], 99)
+	if errs[0] == nil || errs[1] == nil {
+		t.Fatal("SignBatch should reject an invalid signature type")
+	}
+	if sigs, errs := signer.SignBatch(nil, SigCompressed); len(sigs) != 0 || len(errs) != 0 {
+		t.Fatal("Empty batch should return no results")
+	}
+}
+
+func TestAsyncSigner(t *testing.T) {
+	keyPair, err := GenerateKeyPair(9)
+	if err != nil {
+		t.Fatalf("Failed to generate key pair: %v", err)
+	}
+	signer, err := NewSigner(keyPair.PrivateKey)
+	if err != nil {
+		t.Fatalf("Failed to create signer: %v", err)
+	}
+	defer signer.Wipe()
+
+	for _, cfg := range []AsyncSignerConfig{
+		{SigType: SigCompressed},
+		{SigType: SigCT, MaxBatch: 8, MaxDelay: time.Millisecond, Workers: 2},
+	} {
+		as, err := NewAsyncSigner(signer, cfg)
+		if err != nil {
+			t.Fatalf("Failed to create async signer: %v", err)
+		}
+
+		const requests = 300
+		futures := make([]*SignFuture, requests)
+		var wg sync.WaitGroup
+		for g := 0; g < 4; g++ {
+			wg.Add(1)
+			go func(g int) {
+				defer wg.Done()
+				for i := g; i < requests; i += 4 {
+					futures[i] = as.Sign([]byte(fmt.Sprintf("message %d", i)))
+				}
+			}(g)
+		}
+		wg.Wait()
+
+		for i, f := range futures {
+			sig, err := f.Wait()
+			if err != nil {
+				t.Fatalf("Request %d failed: %v", i, err)
+			}
+			if err := Verify(sig, []byte(fmt.Sprintf("message %d", i)), keyPair.PublicKey, cfg.SigType); err != nil {
+				t.Fatalf("Request %d: signature rejected: %v", i, err)
+			}
+		}
+
+		as.Close()
+		as.Close()
+		if _, err := as.Sign([]byte("late")).Wait(); err == nil {
+			t.Fatal("Sign after Close should fail")
+		}
+	}
+
+	// The Signer keeps working after its AsyncSigners are closed
+	sig, err := signer.Sign([]byte("after"), SigCompressed)
+	if err != nil {
+		t.Fatalf("Signer failed after AsyncSigner close: %v", err)
+	}
+	if err := Verify(sig, []byte("after"), keyPair.PublicKey, SigCompressed); err != nil {
+		t.Fatalf("Signature rejected: %v", err)
+	}
+
+	if _, err := NewAsyncSigner(signer, AsyncSignerConfig{SigType: 99}); err == nil {
+		t.Fatal("NewAsyncSigner should reject an invalid signature type")
+	}
+}
+
+func TestReseedingRNG(t *testing.T) {
+	r := &reseedingRNG{policy: ReseedPolicy{MaxUses: 3}}
+	var firsts [][]byte
+	for i := 0; i < 7; i++ {
+		seeded := r.seeded && r.uses < r.policy.MaxUses
+		ctx, err := r.context()
+		if err != nil {
+			t.Fatalf("Failed to get PRNG context: %v", err)
+		}
+		if !seeded {
+			out := make([]byte, 32)
+			ctx.Extract(out)
+			firsts = append(firsts, out)
+		}
+	}
+	// Uses 0, 3 and 6 trigger a (re)seed
+	if len(firsts) != 3 {
+		t.Fatalf("Wrong number of seedings: got %d, want 3", len(firsts))
+	}
+	for i := range firsts {
+		if bytes.Equal(firsts[i], make([]byte, 32)) {
+			t.Errorf("Seeding %d: PRNG output is all zeros", i)
+		}
+		for j := 0; j < i; j++ {
+			if bytes.Equal(firsts[i], firsts[j]) {
+				t.Errorf("Seedings %d and %d produced the same output", j, i)
+			}
+		}
+	}
+
+	// Batches stop at the next reseed
+	r = &reseedingRNG{policy: ReseedPolicy{MaxUses: 3}}
+	for _, want := range []int{3, 3, 2} {
+		max := 5
+		if want == 2 {
+			max = 2
+		}
+		if _, n, err := r.contextBatch(max); err != nil || n != want {
+			t.Fatalf("contextBatch(%d): got %d, want %d (%v)", max, n, want, err)
+		}
+	}
+
+	// Released contexts are rekeyed: the pooled state does not continue
+	// the output stream that was handed out
+	r = &reseedingRNG{policy: ReseedPolicy{MaxUses: 100}}
+	ctx, err := r.context()
+	if err != nil {
+		t.Fatalf("Failed to get PRNG context: %v", err)
+	}
+	before := *ctx
+	releaseRNG(r)
+	want := make([]byte, 48+32)
+	before.Extract(want)
+	got := make([]byte, 32)
+	r.ctx.Extract(got)
+	if !r.seeded || r.uses != 1 {
+		t.Error("Releasing a PRNG context changed its reseed state")
+	}
+	if bytes.Equal(got, want[48:]) || bytes.Equal(got, want[:32]) {
+		t.Error("Released PRNG context was not rekeyed")
+	}
+
+	r = &reseedingRNG{policy: ReseedPolicy{MaxAge: time.Nanosecond}}
+	r.context()
+	seededAt := r.seededAt
+	time.Sleep(time.Millisecond)
+	r.context()
+	if !r.seededAt.After(seededAt) {
+		t.Error("PRNG context was not reseeded after MaxAge")
+	}
+}
+
+func TestSignNonces(t *testing.T) {
+	keyPair, err := GenerateKeyPair(9)
+	if err != nil {
+		t.Fatalf("Failed to generate key pair: %v", err)
+	}
+	signer, err := NewSigner(keyPair.PrivateKey)
+	if err != nil {
+		t.Fatalf("Failed to create signer: %v", err)
+	}
+	signer.SetReseedPolicy(ReseedPolicy{MaxUses: 2})
+
+	message := []byte("same message")
+	seen := make(map[string]bool)
+	for i := 0; i < 8; i++ {
+		var signature []byte
+		if i%2 == 0 {
+			signature, err = Sign(message, keyPair.PrivateKey, SigCompressed)
+		} else {
+			signature, err = signer.Sign(message, SigCompressed)
+		}
+		if err != nil {
+			t.Fatalf("Failed to sign message: %v", err)
+		}
+		if err := Verify(signature, message, keyPair.PublicKey, SigCompressed); err != nil {
+			t.Fatalf("Failed to verify signature: %v", err)
+		}
+		// The 40-byte nonce follows the header byte
+		nonce := string(signature[1:41])
+		if nonce == string(make([]byte, 40)) {
+			t.Fatal("Signature has an all-zero nonce")
+		}
+		if seen[nonce] {
+			t.Fatal("Nonce reused across signatures")
+		}
+		seen[nonce] = true
+	}
+}
+
+func TestStreaming(t *testing.T) {
+	keyPair, err := GenerateKeyPair(9)
+	if err != nil {
+		t.Fatalf("Failed to generate key pair: %v", err)
+	}
+	signer, err := NewSigner(keyPair.PrivateKey)
+	if err != nil {
+		t.Fatalf("Failed to create signer: %v", err)
+	}
+	verifier, err := NewVerifier(keyPair.PublicKey)
+	if err != nil {
+		t.Fatalf("Failed to create verifier: %v", err)
+	}
+
+	// Larger than both the reader buffer and the per-call inject chunk
+	message := make([]byte, 3*hashChunk+12345)
+	for i := range message {
+		message[i] = byte(i * 7)
+	}
+
+	// Streamed signatures verify with the one-shot API, and vice versa
+	signature, err := SignReader(bytes.NewReader(message), keyPair.PrivateKey, SigCompressed)
+	if err != nil {
+		t.Fatalf("SignReader failed: %v", err)
+	}
+	if err := Verify(signature, message, keyPair.PublicKey, SigCompressed); err != nil {
+		t.Errorf("Streamed signature rejected by Verify: %v", err)
+	}
+	signature, err = Sign(message, keyPair.PrivateKey, SigCT)
+	if err != nil {
+		t.Fatalf("Failed to sign message: %v", err)
+	}
+	if err := VerifyReader(bytes.NewReader(message), signature, keyPair.PublicKey, SigCT); err != nil {
+		t.Errorf("VerifyReader rejected signature: %v", err)
+	}
+	if err := verifier.VerifyReader(bytes.NewReader(message), signature, SigCT); err != nil {
+		t.Errorf("Verifier.VerifyReader rejected signature: %v", err)
+	}
+	if err := VerifyReader(bytes.NewReader(message[1:]), signature, keyPair.PublicKey, SigCT); err == nil {
+		t.Error("VerifyReader accepted a signature over different data")
+	}
+
+	// Uneven writes through a Hasher
+	h, err := NewHasher()
+	if err != nil {
+		t.Fatalf("NewHasher failed: %v", err)
+	}
+	for off := 0; off < len(message); {
+		end := off + 1 + off%4099
+		if end > len(message) {
+			end = len(message)
+		}
+		h.Write(message[off:end])
+		off = end
+	}
+	signature, err = signer.SignHasher(h, SigPadded)
+	if err != nil {
+		t.Fatalf("SignHasher failed: %v", err)
+	}
+	if !bytes.Equal(signature[1:1+NonceSize], h.Nonce()) {
+		t.Error("Signature does not carry the Hasher nonce")
+	}
+	if err := verifier.Verify(signature, message, SigPadded); err != nil {
+		t.Errorf("Hasher signature rejected: %v", err)
+	}
+	if _, err := h.Write(message); err == nil {
+		t.Error("Write succeeded on a finished Hasher")
+	}
+	if _, err := signer.SignHasher(h, SigPadded); err == nil {
+		t.Error("SignHasher succeeded on a finished Hasher")
+	}
+
+	// Files, including an empty one
+	dir := t.TempDir()
+	for _, data := range [][]byte{message, nil} {
+		path := dir + "/msg"
+		if err := os.WriteFile(path, data, 0o600); err != nil {
+			t.Fatalf("Failed to write file: %v", err)
+		}
+		signature, err := SignFile(path, keyPair.PrivateKey, SigCompressed)
+		if err != nil {
+			t.Fatalf("SignFile failed: %v", err)
+		}
+		if err := Verify(signature, data, keyPair.PublicKey, SigCompressed); err != nil {
+			t.Errorf("File signature rejected: %v", err)
+		}
+		signature, err = signer.SignFile(path, SigCompressed)
+		if err != nil {
+			t.Fatalf("Signer.SignFile failed: %v", err)
+		}
+		if err := VerifyFile(path, signature, keyPair.PublicKey, SigCompressed); err != nil {
+			t.Errorf("VerifyFile rejected signature: %v", err)
+		}
+	}
+	if _, err := SignFile(dir+"/missing", keyPair.PrivateKey, SigCompressed); err == nil {
+		t.Error("SignFile succeeded on a missing file")
+	}
+}
+
+func TestImplementations(t *testing.T) {
+	orig := Implementation()
+	defer SetImplementation(orig)
+	if orig == ImplNEON {
+		t.Error("NEON implementation selected without SetImplementation")
+	}
+
+	for _, impl := range []int{ImplGeneric, ImplAVX2, ImplNEON} {
+		if err := SetImplementation(impl); err != nil {
+			if impl == ImplGeneric {
+				t.Fatal("Generic implementation not available")
+			}
+			t.Logf("Implementation %d not available on this CPU", impl)
+			continue
+		}
+		if Implementation() != impl {
+			t.Fatalf("Implementation %d not selected", impl)
+		}
+		keyPair, err := GenerateKeyPair(9)
+		if err != nil {
+			t.Fatalf("Failed to generate key pair: %v", err)
+		}
+		message := []byte("dispatch")
+		signature, err := Sign(message, keyPair.PrivateKey, SigCompressed)
+		if err != nil {
+			t.Fatalf("Failed to sign message: %v", err)
+		}
+		if err := Verify(signature, message, keyPair.PublicKey, SigCompressed); err != nil {
+			t.Errorf("Implementation %d: signature rejected: %v", impl, err)
+		}
+		signer, err := NewSigner(keyPair.PrivateKey)
+		if err != nil {
+			t.Fatalf("Failed to create signer: %v", err)
+		}
+		signature, err = signer.Sign(message, SigCT)
+		if err != nil {
+			t.Fatalf("Failed to sign message: %v", err)
+		}
+		if err := Verify(signature, message, keyPair.PublicKey, SigCT); err != nil {
+			t.Errorf("Implementation %d: tree signature rejected: %v", impl, err)
+		}
+	}
+
+	if err := SetImplementation(-1); err == nil {
+		t.Error("Unknown implementation accepted")
+	}
+}
+
+func TestKeyPool(t *testing.T) {
+	if _, err := NewKeyPool(KeyPoolConfig{LogN: []uint{9}}); err == nil {
+		t.Error("Zero capacity accepted")
+	}
+	if _, err := NewKeyPool(KeyPoolConfig{LogN: []uint{9, 9}, Capacity: 1}); err == nil {
+		t.Error("Duplicate degree accepted")
+	}
+
+	pool, err := NewKeyPool(KeyPoolConfig{LogN: []uint{8, 9}, Capacity: 2, Workers: 2})
+	if err != nil {
+		t.Fatalf("Failed to create key pool: %v", err)
+	}
+	defer pool.Close()
+
+	// Wait for the queues to fill
+	deadline := time.Now().Add(30 * time.Second)
+	for _, logN := range []uint{8, 9} {
+		for {
+			s, err := pool.Stats(logN)
+			if err != nil {
+				t.Fatalf("Stats failed: %v", err)
+			}
+			if s.Ready == s.Capacity {
+				break
+			}
+			if time.Now().After(deadline) {
+				t.Fatalf("Pool for logN=%d not filled: %+v", logN, s)
+			}
+			time.Sleep(10 * time.Millisecond)
+		}
+	}
+
+	message := []byte("pooled key")
+	for i := 0; i < 3; i++ {
+		kp, err := pool.Get(9)
+		if err != nil {
+			t.Fatalf("Get failed: %v", err)
+		}
+		signature, err := Sign(message, kp.PrivateKey, SigCompressed)
+		if err != nil {
+			t.Fatalf("Failed to sign with pooled key: %v", err)
+		}
+		if err := Verify(signature, message, kp.PublicKey, SigCompressed); err != nil {
+			t.Errorf("Pooled key signature rejected: %v", err)
+		}
+	}
+	s, _ := pool.Stats(9)
+	if s.Served+s.Misses != 3 || s.Served == 0 {
+		t.Errorf("Unexpected counters: %+v", s)
+	}
+	if s.Generated < 2 || s.RefillRate <= 0 || s.AvgKeygen <= 0 {
+		t.Errorf("Unexpected refill metrics: %+v", s)
+	}
+
+	if _, err := pool.Get(10); err == nil {
+		t.Error("Unconfigured degree accepted")
+	}
+
+	// Close must wipe the queued private keys
+	var queued []*KeyPair
+	q := pool.queues[8]
+	for len(q.ready) > 0 {
+		queued = append(queued, <-q.ready)
+	}
+	for _, kp := range queued {
+		q.ready <- kp
+	}
+	pool.Close()
+	if len(queued) == 0 {
+		t.Fatal("No queued key to check")
+	}
+	for _, kp := range queued {
+		for _, b := range kp.PrivateKey {
+			if b != 0 {
+				t.Fatal("Queued private key not wiped")
+			}
+		}
+	}
+	if _, err := pool.Get(9); err == nil {
+		t.Error("Get succeeded on a closed pool")
+	}
+}
+
+func TestZeroAlloc(t *testing.T) {
+	keyPair, err := GenerateKeyPair(9)
+	if err != nil {
+		t.Fatalf("Failed to generate key pair: %v", err)
+	}
+	message := []byte("no garbage")
+	maxSize, err := SignatureMaxSize(9, SigCompressed)
+	if err != nil {
+		t.Fatalf("SignatureMaxSize failed: %v", err)
+	}
+
+	// SignTo appends to the caller's buffer
+	prefix := []byte("prefix")
+	out, err := SignTo(append([]byte(nil), prefix...), message, keyPair.PrivateKey, SigCompressed)
+	if err != nil {
+		t.Fatalf("SignTo failed: %v", err)
+	}
+	if !bytes.Equal(out[:len(prefix)], prefix) {
+		t.Error("SignTo overwrote the destination prefix")
+	}
+	if err := Verify(out[len(prefix):], message, keyPair.PublicKey, SigCompressed); err != nil {
+		t.Fatalf("SignTo signature rejected: %v", err)
+	}
+
+	// Slabs used for signing go back to the pool wiped
+	slab := newScratch(9)
+	for i := range slab.tmp {
+		slab.tmp[i] = 0xA5
+	}
+	putSignScratch(slab)
+	if !bytes.Equal(slab.tmp, make([]byte, len(slab.tmp))) {
+		t.Error("Signing scratch returned to the pool without being wiped")
+	}
+
+	scratch, err := NewScratch(9)
+	if err != nil {
+		t.Fatalf("NewScratch failed: %v", err)
+	}
+	small, _ := NewScratch(8)
+	if err := VerifyWith(small, out[len(prefix):], message, keyPair.PublicKey, SigCompressed); err == nil {
+		t.Error("Undersized scratch accepted")
+	}
+	verifier, err := NewVerifier(keyPair.PublicKey)
+	if err != nil {
+		t.Fatalf("NewVerifier failed: %v", err)
+	}
+	signer, err := NewSigner(keyPair.PrivateKey)
+	if err != nil {
+		t.Fatalf("NewSigner failed: %v", err)
+	}
+
+	buf := make([]byte, 0, maxSize)
+	var sig []byte
+	checks := []struct {
+		name string
+		fn   func()
+	}{
+		{"SignTo", func() {
+			sig, err = SignTo(buf[:0], message, keyPair.PrivateKey, SigCompressed)
+		}},
+		{"Signer.SignTo", func() {
+			sig, err = signer.SignTo(buf[:0], message, SigCompressed)
+		}},
+		{"VerifyWith", func() {
+			err = VerifyWith(scratch, sig, message, keyPair.PublicKey, SigCompressed)
+		}},
+		{"Verifier.VerifyWith", func() {
+			err = verifier.VerifyWith(scratch, sig, message, SigCompressed)
+		}},
+		{"Verify", func() {
+			err = Verify(sig, message, keyPair.PublicKey, SigCompressed)
+		}},
+	}
+	for _, c := range checks {
+		c.fn()
+		if err != nil {
+			t.Fatalf("%s failed: %v", c.name, err)
+		}
+		if allocs := testing.AllocsPerRun(50, c.fn); allocs != 0 {
+			t.Errorf("%s: %v allocations per call", c.name, allocs)
+		}
+	}
+}
+
+func TestProfile(t *testing.T) {
+	runtime.LockOSThread()
+	defer runtime.UnlockOSThread()
+
+	keyPair, err := GenerateKeyPair(9)
+	if err != nil {
+		t.Fatalf("Failed to generate key pair: %v", err)
+	}
+	ResetProfile()
+	message := []byte("profiled")
+	signature, err := Sign(message, keyPair.PrivateKey, SigCompressed)
+	if err != nil {
+		t.Fatalf("Failed to sign message: %v", err)
+	}
+	if err := Verify(signature, message, keyPair.PublicKey, SigCompressed); err != nil {
+		t.Fatalf("Signature rejected: %v", err)
+	}
+	p := ReadProfile()
+	t.Logf("Profile: %+v", p)
+
+	if p.Unit == "" {
+		// Built without FALCON_PROFILE: the counters must stay at zero
+		if p != (Profile{}) {
+			t.Errorf("Counters set without FALCON_PROFILE: %+v", p)
+		}
+		return
+	}
+	for _, ph := range []int{PhaseHash, PhaseSign, PhaseSample, PhaseNorm,
+		PhaseEncode, PhaseDecode, PhaseVerify} {
+		if p.Count[ph] == 0 || p.Ticks[ph] == 0 {
+			t.Errorf("Phase %d not measured: %+v", ph, p)
+		}
+	}
+	if p.Count[PhaseSample] < p.Count[PhaseSign] {
+		t.Errorf("Fewer attempts than signatures: %+v", p)
+	}
+	ResetProfile()
+	if p := ReadProfile(); p.Count[PhaseSign] != 0 {
+		t.Error("ResetProfile did not clear the counters")
+	}
+}
+
+// recorder is an Observer keeping every sample
+type recorder struct {
+	mu      sync.Mutex
+	samples []float64
+}
+
+func (r *recorder) Observe(v float64) {
+	r.mu.Lock()
+	r.samples = append(r.samples, v)
+	r.mu.Unlock()
+}
+
+func TestSignMetrics(t *testing.T) {
+	keyPair, err := GenerateKeyPair(9)
+	if err != nil {
+		t.Fatalf("Failed to generate key pair: %v", err)
+	}
+	signer, err := NewSigner(keyPair.PrivateKey)
+	if err != nil {
+		t.Fatalf("NewSigner failed: %v", err)
+	}
+	message := []byte("measured")
+
+	m := SignMetrics{
+		Attempts:          &recorder{},
+		SamplerRejections: &recorder{},
+		EncodeRetries:     &recorder{},
+		Latency:           &recorder{},
+	}
+	SetSignMetrics(&m)
+	defer SetSignMetrics(nil)
+
+	signs := []func() ([]byte, error){
+		func() ([]byte, error) { return Sign(message, keyPair.PrivateKey, SigCompressed) },
+		func() ([]byte, error) { return signer.Sign(message, SigPadded) },
+		func() ([]byte, error) { return SignReader(bytes.NewReader(message), keyPair.PrivateKey, SigCT) },
+		func() ([]byte, error) { return signer.SignReader(bytes.NewReader(message), SigCompressed) },
+	}
+	for i, sign := range signs {
+		if _, err := sign(); err != nil {
+			t.Fatalf("Signature %d failed: %v", i, err)
+		}
+	}
+
+	attempts := m.Attempts.(*recorder).samples
+	if len(attempts) != len(signs) {
+		t.Fatalf("Got %d attempt samples, want %d", len(attempts), len(signs))
+	}
+	for _, a := range attempts {
+		if a < 1 {
+			t.Errorf("Attempt count %v below 1", a)
+		}
+	}
+	for name, o := range map[string]Observer{"rejections": m.SamplerRejections,
+		"encode retries": m.EncodeRetries, "latency": m.Latency} {
+		if n := len(o.(*recorder).samples); n != len(signs) {
+			t.Errorf("Got %d %s samples, want %d", n, name, len(signs))
+		}
+	}
+	for _, l := range m.Latency.(*recorder).samples {
+		if l <= 0 {
+			t.Errorf("Non-positive latency %v", l)
+		}
+	}
+	// The sampler rejects a noticeable fraction of its draws
+	var rejections float64
+	for _, r := range m.SamplerRejections.(*recorder).samples {
+		rejections += r
+	}
+	if rejections == 0 {
+		t.Error("No sampler rejection recorded")
+	}
+
+	// Metrics stay allocation-free
+	buf := make([]byte, 0, 1024)
+	if allocs := testing.AllocsPerRun(20, func() {
+		signer.SignTo(buf[:0], message, SigCompressed)
+	}); allocs != 0 {
+		t.Errorf("Signer.SignTo with metrics: %v allocations per call", allocs)
+	}
+
+	SetSignMetrics(nil)
+	if _, err := Sign(message, keyPair.PrivateKey, SigCompressed); err != nil {
+		t.Fatalf("Failed to sign message: %v", err)
+	}
+	if n := len(m.Attempts.(*recorder).samples); n != len(signs)+21 {
+		t.Errorf("Observer fed after SetSignMetrics(nil): %d samples", n)
+	}
+}
+
+func TestKeyStore(t *testing.T) {
+	var keys []*KeyPair
+	for _, logN := range []uint{9, 10, 9} {
+		kp, err := GenerateKeyPair(logN)
+		if err != nil {
+			t.Fatalf("Failed to generate key pair: %v", err)
+		}
+		keys = append(keys, kp)
+	}
+	var buf bytes.Buffer
+	var sks [][]byte
+	for _, kp := range keys {
+		sks = append(sks, kp.PrivateKey)
+	}
+	if err := WriteKeyStore(&buf, sks); err != nil {
+		t.Fatalf("WriteKeyStore failed: %v", err)
+	}
+	path := filepath.Join(t.TempDir(), "keys.fks")
+	if err := os.WriteFile(path, buf.Bytes(), 0600); err != nil {
+		t.Fatal(err)
+	}
+
+	ks, err := OpenKeyStore(path)
+	if err != nil {
+		t.Fatalf("OpenKeyStore failed: %v", err)
+	}
+	if ks.Len() != len(keys) {
+		t.Fatalf("Got %d keys, want %d", ks.Len(), len(keys))
+	}
+	message := []byte("from the store")
+	var signers []*Signer
+	for i, kp := range keys {
+		if logN, _ := ks.LogN(i); logN != uint(kp.PublicKey[0]&0x0F) {
+			t.Errorf("Key %d: degree %d", i, logN)
+		}
+		s, err := ks.Signer(i)
+		if err != nil {
+			t.Fatalf("Signer(%d) failed: %v", i, err)
+		}
+		for _, sigType := range []int{SigCompressed, SigPadded, SigCT} {
+			sig, err := s.Sign(message, sigType)
+			if err != nil {
+				t.Fatalf("Key %d: sign failed: %v", i, err)
+			}
+			if err := Verify(sig, message, kp.PublicKey, sigType); err != nil {
+				t.Errorf("Key %d: stored key signature rejected: %v", i, err)
+			}
+		}
+		sig, err := s.SignReader(bytes.NewReader(message), SigCompressed)
+		if err != nil || Verify(sig, message, kp.PublicKey, SigCompressed) != nil {
+			t.Errorf("Key %d: SignReader failed: %v", i, err)
+		}
+		signers = append(signers, s)
+	}
+	if _, err := ks.Signer(len(keys)); err == nil {
+		t.Error("Out-of-range key accepted")
+	}
+
+	dst := make([]byte, 0, 2048)
+	if allocs := testing.AllocsPerRun(20, func() {
+		signers[0].SignTo(dst[:0], message, SigCompressed)
+	}); allocs != 0 {
+		t.Errorf("Stored key SignTo: %v allocations per call", allocs)
+	}
+
+	// Wipe only drops the mapped key
+	signers[2].Wipe()
+	if _, err := signers[2].Sign(message, SigCompressed); err == nil {
+		t.Error("Wiped stored-key Signer still signs")
+	}
+
+	if err := ks.Close(); err != nil {
+		t.Fatalf("Close failed: %v", err)
+	}
+	if _, err := signers[0].Sign(message, SigCompressed); err == nil {
+		t.Error("Signer works after Close")
+	}
+	if _, err := ks.Signer(0); err == nil {
+		t.Error("Signer returned after Close")
+	}
+
+	// A corrupted tree is caught when the key is first requested, a
+	// corrupted header when the store is opened
+	data := buf.Bytes()
+	first := storedExpandedKeySize(9)
+	data[first+1000] ^= 1
+	if err := os.WriteFile(path, data, 0600); err != nil {
+		t.Fatal(err)
+	}
+	ks, err = OpenKeyStore(path)
+	if err != nil {
+		t.Fatalf("OpenKeyStore failed on a tree corruption: %v", err)
+	}
+	if _, err := ks.Signer(1); err == nil {
+		t.Error("Corrupted key accepted")
+	}
+	if _, err := ks.Signer(0); err != nil {
+		t.Errorf("Intact key rejected: %v", err)
+	}
+	ks.Close()
+	data[first+1000] ^= 1
+
+	data[24] ^= 1
+	if err := os.WriteFile(path, data, 0600); err != nil {
+		t.Fatal(err)
+	}
+	if _, err := OpenKeyStore(path); err == nil {
+		t.Error("Wrong floating-point format tag accepted")
+	}
+	data[24] ^= 1
+	if err := os.WriteFile(path, data[:len(data)-64], 0600); err != nil {
+		t.Fatal(err)
+	}
+	if _, err := OpenKeyStore(path); err == nil {
+		t.Error("Truncated store accepted")
+	}
+}
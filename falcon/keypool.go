@@ -0,0 +1,211 @@
+package falcon
+
+import (
+	"errors"
+	"fmt"
+	"sync"
+	"sync/atomic"
+	"time"
+)
+
+var errKeyPoolClosed = errors.New("key pool closed")
+
+// KeyPoolConfig configures a KeyPool
+type KeyPoolConfig struct {
+	LogN     []uint // degrees to keep keys ready for (e.g. 9 and 10)
+	Capacity int    // ready key pairs kept per degree
+	Workers  int    // background key generation goroutines (default 1)
+}
+
+// KeyPoolStats reports the state of one degree in a KeyPool
+type KeyPoolStats struct {
+	LogN       uint
+	Ready      int           // key pairs currently queued
+	Capacity   int           // maximum number of queued key pairs
+	Generated  uint64        // key pairs generated in the background
+	Served     uint64        // Get calls answered from the queue
+	Misses     uint64        // Get calls that found the queue empty
+	Failures   uint64        // background key generation errors
+	AvgKeygen  time.Duration // mean background key generation time
+	RefillRate float64       // background key pairs per second since creation
+}
+
+// keyQueue holds the ready key pairs and counters for one degree
+type keyQueue struct {
+	logN      uint
+	ready     chan *KeyPair
+	generated atomic.Uint64
+	served    atomic.Uint64
+	misses    atomic.Uint64
+	failures  atomic.Uint64
+	genNanos  atomic.Int64
+}
+
+// KeyPool generates key pairs ahead of time on background goroutines, so
+// that GenerateKeyPair latency (and its long tail, when solve_NTRU
+// rejects (f,g) and restarts) stays off the request path.
+//
+// Each configured degree has a bounded queue of ready key pairs. Every
+// slot of every queue is represented by one refill request; workers take
+// requests, generate a key pair and queue it, and Get turns the slot it
+// empties back into a request. A KeyPool is safe for concurrent use.
+type KeyPool struct {
+	queues  map[uint]*keyQueue
+	need    chan *keyQueue
+	done    chan struct{}
+	wg      sync.WaitGroup
+	start   time.Time
+	closeMu sync.Mutex
+	closed  atomic.Bool
+}
+
+// NewKeyPool creates a KeyPool and starts its workers
+func NewKeyPool(cfg KeyPoolConfig) (*KeyPool, error) {
+	if len(cfg.LogN) == 0 {
+		return nil, errors.New("no degree configured")
+	}
+	if cfg.Capacity < 1 {
+		return nil, errors.New("pool capacity must be positive")
+	}
+	workers := cfg.Workers
+	if workers < 1 {
+		workers = 1
+	}
+
+	p := &KeyPool{
+		queues: make(map[uint]*keyQueue, len(cfg.LogN)),
+		need:   make(chan *keyQueue, len(cfg.LogN)*cfg.Capacity),
+		done:   make(chan struct{}),
+		start:  time.Now(),
+	}
+	for _, logN := range cfg.LogN {
+		if logN < 1 || logN > 10 {
+			return nil, errors.New("logN must be between 1 and 10")
+		}
+		if _, ok := p.queues[logN]; ok {
+			return nil, fmt.Errorf("duplicate degree %d", logN)
+		}
+		p.queues[logN] = &keyQueue{
+			logN:  logN,
+			ready: make(chan *KeyPair, cfg.Capacity),
+		}
+	}
+
+	// Interleave the initial requests so that all degrees fill together
+	for i := 0; i < cfg.Capacity; i++ {
+		for _, logN := range cfg.LogN {
+			p.need <- p.queues[logN]
+		}
+	}
+
+	p.wg.Add(workers)
+	for i := 0; i < workers; i++ {
+		go p.worker()
+	}
+	return p, nil
+}
+
+// worker serves refill requests until the pool is closed
+func (p *KeyPool) worker() {
+	defer p.wg.Done()
+	for {
+		select {
+		case <-p.done:
+			return
+		case q := <-p.need:
+			t := time.Now()
+			kp, err := GenerateKeyPair(q.logN)
+			if err != nil {
+				// Only an OS RNG failure gets here; keep the slot
+				// and retry after a pause.
+				q.failures.Add(1)
+				p.need <- q
+				select {
+				case <-p.done:
+					return
+				case <-time.After(100 * time.Millisecond):
+				}
+				continue
+			}
+			q.genNanos.Add(int64(time.Since(t)))
+			q.generated.Add(1)
+			// Cannot block: the slot was reserved by the request
+			q.ready <- kp
+		}
+	}
+}
+
+// Get returns a key pair for the given degree. A queued key pair is
+// returned immediately; if the queue is empty, one is generated
+// synchronously (and counted as a miss). Each key pair is handed out
+// once and the pool keeps no reference to it.
+func (p *KeyPool) Get(logN uint) (*KeyPair, error) {
+	if p.closed.Load() {
+		return nil, errKeyPoolClosed
+	}
+	q, ok := p.queues[logN]
+	if !ok {
+		return nil, fmt.Errorf("degree %d not configured in pool", logN)
+	}
+	select {
+	case kp := <-q.ready:
+		q.served.Add(1)
+		// Cannot block: at most Capacity requests per queue exist
+		p.need <- q
+		return kp, nil
+	default:
+		q.misses.Add(1)
+		return GenerateKeyPair(logN)
+	}
+}
+
+// Stats returns the fill level and refill metrics for one degree
+func (p *KeyPool) Stats(logN uint) (KeyPoolStats, error) {
+	q, ok := p.queues[logN]
+	if !ok {
+		return KeyPoolStats{}, fmt.Errorf("degree %d not configured in pool", logN)
+	}
+	s := KeyPoolStats{
+		LogN:      logN,
+		Ready:     len(q.ready),
+		Capacity:  cap(q.ready),
+		Generated: q.generated.Load(),
+		Served:    q.served.Load(),
+		Misses:    q.misses.Load(),
+		Failures:  q.failures.Load(),
+	}
+	if s.Generated > 0 {
+		s.AvgKeygen = time.Duration(q.genNanos.Load() / int64(s.Generated))
+	}
+	if elapsed := time.Since(p.start).Seconds(); elapsed > 0 {
+		s.RefillRate = float64(s.Generated) / elapsed
+	}
+	return s, nil
+}
+
+// Close stops the workers and wipes the private keys of all queued key
+// pairs. Key pairs already returned by Get are not affected. Get fails
+// once Close has been called; Close waits for in-progress key
+// generations to finish.
+func (p *KeyPool) Close() {
+	p.closeMu.Lock()
+	defer p.closeMu.Unlock()
+	if p.closed.Load() {
+		return
+	}
+	p.closed.Store(true)
+	close(p.done)
+	p.wg.Wait()
+
+	for _, q := range p.queues {
+		for {
+			select {
+			case kp := <-q.ready:
+				wipe(kp.PrivateKey)
+				continue
+			default:
+			}
+			break
+		}
+	}
+}
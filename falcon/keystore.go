@@ -0,0 +1,184 @@
+package falcon
+
+/*
+#include "falcon.h"
+
+// Check a record header; the key pointer is not needed on the Go side
+static int falcon_open_record(const void *stored, size_t stored_len) {
+    const void *ek;
+    return falcon_open_expanded_key(&ek, stored, stored_len);
+}
+*/
+import "C"
+import (
+	"errors"
+	"fmt"
+	"io"
+	"sync"
+)
+
+var errKeyStoreClosed = errors.New("key store closed")
+
+// WriteKeyStore expands each private key and writes the expanded keys to
+// w as a key store, to be opened with OpenKeyStore. Keys are numbered in
+// the order given.
+//
+// A key store is a sequence of records (falcon_store_expanded_key), each
+// a 64-byte header followed by the ffLDL tree of one key, 64-byte
+// aligned. Records are tied to the byte order and floating-point format
+// of the machine: opening one elsewhere fails rather than producing bad
+// signatures. The file holds expanded private keys and must be
+// protected like the private keys themselves.
+func WriteKeyStore(w io.Writer, privateKeys [][]byte) error {
+	for i, sk := range privateKeys {
+		signer, err := NewSigner(sk)
+		if err != nil {
+			return fmt.Errorf("key %d: %w", i, err)
+		}
+		rec := alignedSlab(storedExpandedKeySize(signer.logN))
+		result := C.falcon_store_expanded_key(
+			bytesPtr(rec), C.size_t(len(rec)), bytesPtr(signer.expKey))
+		signer.Wipe()
+		if result != 0 {
+			wipe(rec)
+			return fmt.Errorf("key %d: %w", i, falconError(result))
+		}
+		_, err = w.Write(rec)
+		wipe(rec)
+		if err != nil {
+			return err
+		}
+	}
+	return nil
+}
+
+// storedKey is one record of a KeyStore
+type storedKey struct {
+	off   int
+	size  int
+	logN  uint
+	once  sync.Once
+	valid error
+}
+
+// KeyStore gives access to expanded private keys saved by WriteKeyStore,
+// without expanding them again. The file is memory-mapped read-only
+// where supported: opening it reads only the record headers, and the
+// pages of a key are loaded when the key is first used.
+//
+// A KeyStore is safe for concurrent use. Signers obtained from it sign
+// directly from the mapping; they fail once the KeyStore is closed.
+type KeyStore struct {
+	data   []byte
+	unmap  func() error
+	keys   []storedKey
+	mu     sync.RWMutex
+	closed bool
+}
+
+// OpenKeyStore maps the key store at path and checks its record headers
+// (format version, degree, floating-point format). Key checksums are
+// checked the first time each key is requested with Signer.
+func OpenKeyStore(path string) (*KeyStore, error) {
+	data, unmap, err := mapFile(path)
+	if err != nil {
+		return nil, err
+	}
+	ks := &KeyStore{data: data, unmap: unmap}
+	for off := 0; off < len(data); {
+		rest := data[off:]
+		r := C.falcon_open_record(bytesPtr(rest), C.size_t(len(rest)))
+		if r < 0 {
+			unmap()
+			return nil, fmt.Errorf("key store record %d at offset %d: %w",
+				len(ks.keys), off, falconError(r))
+		}
+		ks.keys = append(ks.keys, storedKey{
+			off:  off,
+			size: int(r),
+			logN: uint(rest[9]),
+		})
+		off += int(r)
+	}
+	return ks, nil
+}
+
+// Len returns the number of keys in the store
+func (ks *KeyStore) Len() int {
+	return len(ks.keys)
+}
+
+// LogN returns the degree of key i
+func (ks *KeyStore) LogN(i int) (uint, error) {
+	if i < 0 || i >= len(ks.keys) {
+		return 0, fmt.Errorf("key %d out of range", i)
+	}
+	return ks.keys[i].logN, nil
+}
+
+// Signer returns a Signer for key i, signing from the mapped expanded
+// key. The key checksum is verified on the first request for that key.
+// Each call returns a new Signer with its own scratch buffer and PRNG.
+func (ks *KeyStore) Signer(i int) (*Signer, error) {
+	if i < 0 || i >= len(ks.keys) {
+		return nil, fmt.Errorf("key %d out of range", i)
+	}
+	if !ks.acquire() {
+		return nil, errKeyStoreClosed
+	}
+	defer ks.release()
+
+	k := &ks.keys[i]
+	rec := ks.data[k.off : k.off+k.size]
+	k.once.Do(func() {
+		result := C.falcon_check_expanded_key(
+			bytesPtr(rec), C.size_t(len(rec)))
+		if result != 0 {
+			k.valid = fmt.Errorf("key %d: %w", i, falconError(result))
+		}
+	})
+	if k.valid != nil {
+		return nil, k.valid
+	}
+
+	return &Signer{
+		logN:   k.logN,
+		expKey: rec[64:],
+		store:  ks,
+		tmp:    make([]byte, tmpSizeSignTree(k.logN)),
+		rng:    reseedingRNG{policy: currentReseedPolicy()},
+	}, nil
+}
+
+// Close unmaps the key store. Signers obtained from it fail afterwards;
+// Close waits for signatures in progress.
+func (ks *KeyStore) Close() error {
+	ks.mu.Lock()
+	defer ks.mu.Unlock()
+	if ks.closed {
+		return nil
+	}
+	ks.closed = true
+	return ks.unmap()
+}
+
+// acquire keeps the mapping in place until release; it reports false
+// once the store is closed. A nil store (heap-held key) is always
+// available.
+func (ks *KeyStore) acquire() bool {
+	if ks == nil {
+		return true
+	}
+	ks.mu.RLock()
+	if ks.closed {
+		ks.mu.RUnlock()
+		return false
+	}
+	return true
+}
+
+func (ks *KeyStore) release() {
+	if ks != nil {
+		ks.mu.RUnlock()
+	}
+}
@@ -0,0 +1,96 @@
+package falcon
+
+/*
+#include "falcon.h"
+*/
+import "C"
+import (
+	"sync/atomic"
+	"time"
+)
+
+// Observer receives one sample per signature. It is the Observe method of
+// the Prometheus client's Histogram and Summary types (and of
+// HistogramVec.WithLabelValues), so those can be registered directly.
+type Observer interface {
+	Observe(float64)
+}
+
+// SignMetrics holds the observers fed after every successful signature.
+// Nil fields are skipped.
+//
+// Falcon signing is a rejection loop: a candidate vector that is not
+// short enough is discarded and sampled again, and the Gaussian sampler
+// rejects and redraws individual values. These two loops are where the
+// signing latency tail comes from.
+type SignMetrics struct {
+	Attempts          Observer // candidate vectors per signature (1 = no retry)
+	SamplerRejections Observer // Gaussian sampler rejections per signature
+	EncodeRetries     Observer // restarts because a padded signature did not fit
+	Latency           Observer // time spent in the C signing call, in seconds
+}
+
+var signMetrics atomic.Value
+
+func init() {
+	signMetrics.Store((*SignMetrics)(nil))
+}
+
+// SetSignMetrics registers the observers fed by Sign, SignTo, Signer and
+// Hasher signing. A nil m disables metrics; without metrics, signing
+// does not collect the counters at all.
+func SetSignMetrics(m *SignMetrics) {
+	if m != nil {
+		c := *m
+		m = &c
+	}
+	signMetrics.Store(m)
+}
+
+func currentSignMetrics() *SignMetrics {
+	return signMetrics.Load().(*SignMetrics)
+}
+
+// signProbe collects the statistics of one signing call when metrics are
+// registered; stats is nil otherwise, which the C code accepts
+type signProbe struct {
+	m     *SignMetrics
+	stats *C.falcon_sign_stats
+	start time.Time
+}
+
+// startSignProbe prepares a probe that writes its counters into buf,
+// which must outlive the C call (it lives in a Scratch or Signer so that
+// no allocation is made)
+func startSignProbe(buf *C.falcon_sign_stats) signProbe {
+	m := currentSignMetrics()
+	if m == nil {
+		return signProbe{}
+	}
+	return signProbe{m: m, stats: buf, start: time.Now()}
+}
+
+// done feeds the observers after a successful signature
+func (p *signProbe) done() {
+	if p.m == nil {
+		return
+	}
+	p.observe(time.Since(p.start))
+}
+
+// observe feeds the observers with the counters and the given signing
+// time
+func (p *signProbe) observe(elapsed time.Duration) {
+	if p.m.Attempts != nil {
+		p.m.Attempts.Observe(float64(p.stats.attempts))
+	}
+	if p.m.SamplerRejections != nil {
+		p.m.SamplerRejections.Observe(float64(p.stats.sampler_rejections))
+	}
+	if p.m.EncodeRetries != nil {
+		p.m.EncodeRetries.Observe(float64(p.stats.encode_retries))
+	}
+	if p.m.Latency != nil {
+		p.m.Latency.Observe(elapsed.Seconds())
+	}
+}
@@ -0,0 +1,38 @@
+//go:build !(linux || darwin || freebsd || netbsd || openbsd)
+
+package falcon
+
+import (
+	"io"
+	"os"
+)
+
+// hashFile hashes the named file with buffered reads
+func hashFile(h *Hasher, path string) error {
+	f, err := os.Open(path)
+	if err != nil {
+		return err
+	}
+	defer f.Close()
+	return hashFrom(h, f)
+}
+
+// mapFile reads the named file into an aligned buffer; there is nothing
+// to unmap
+func mapFile(path string) ([]byte, func() error, error) {
+	f, err := os.Open(path)
+	if err != nil {
+		return nil, nil, err
+	}
+	defer f.Close()
+
+	fi, err := f.Stat()
+	if err != nil {
+		return nil, nil, err
+	}
+	data := alignedSlab(int(fi.Size()))
+	if _, err := io.ReadFull(f, data); err != nil {
+		return nil, nil, err
+	}
+	return data, func() error { return nil }, nil
+}
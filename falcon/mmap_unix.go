@@ -0,0 +1,70 @@
+//go:build linux || darwin || freebsd || netbsd || openbsd
+
+package falcon
+
+import (
+	"errors"
+	"os"
+	"syscall"
+)
+
+// hashFile hashes the named file through a read-only memory mapping. The
+// Hasher reads the pages in place, so resident memory is bounded by what
+// the kernel keeps cached rather than by the file size.
+func hashFile(h *Hasher, path string) error {
+	f, err := os.Open(path)
+	if err != nil {
+		return err
+	}
+	defer f.Close()
+
+	fi, err := f.Stat()
+	if err != nil {
+		return err
+	}
+	size := fi.Size()
+	if size == 0 {
+		return nil
+	}
+	if !fi.Mode().IsRegular() || size != int64(int(size)) {
+		return hashFrom(h, f)
+	}
+
+	data, err := syscall.Mmap(int(f.Fd()), 0, int(size),
+		syscall.PROT_READ, syscall.MAP_SHARED)
+	if err != nil {
+		return hashFrom(h, f)
+	}
+	defer syscall.Munmap(data)
+
+	_, err = h.Write(data)
+	return err
+}
+
+// mapFile maps the named file read-only. The returned function unmaps it.
+func mapFile(path string) ([]byte, func() error, error) {
+	f, err := os.Open(path)
+	if err != nil {
+		return nil, nil, err
+	}
+	defer f.Close()
+
+	fi, err := f.Stat()
+	if err != nil {
+		return nil, nil, err
+	}
+	size := fi.Size()
+	if size == 0 {
+		return nil, func() error { return nil }, nil
+	}
+	if size != int64(int(size)) {
+		return nil, nil, errors.New("file too large to map")
+	}
+
+	data, err := syscall.Mmap(int(f.Fd()), 0, int(size),
+		syscall.PROT_READ, syscall.MAP_SHARED)
+	if err != nil {
+		return nil, nil, err
+	}
+	return data, func() error { return syscall.Munmap(data) }, nil
+}
@@ -0,0 +1,173 @@
+package falcon
+
+/*
+#include "falcon.h"
+*/
+import "C"
+import (
+	"errors"
+	"sync/atomic"
+	"time"
+)
+
+// PrecomputeStats reports the state of the precompute queue of a Signer
+type PrecomputeStats struct {
+	Ready    int    // records currently queued
+	Capacity int    // maximum number of queued records
+	Made     uint64 // records precomputed in the background
+	Served   uint64 // signatures that started from a queued record
+	Misses   uint64 // signatures that found the queue empty
+	Failures uint64 // background precomputation errors
+}
+
+// presignQueue is a bounded queue of precomputed signing records
+// (falcon_presign_make), filled by one background goroutine with its own
+// PRNG context
+type presignQueue struct {
+	ready    chan *C.falcon_presign
+	free     chan *C.falcon_presign
+	stop     chan struct{}
+	exited   chan struct{}
+	made     atomic.Uint64
+	served   atomic.Uint64
+	misses   atomic.Uint64
+	failures atomic.Uint64
+}
+
+// StartPrecompute starts a background goroutine that keeps up to depth
+// records ready for the Signer. A record holds the nonce and the seeded
+// Gaussian sampler of one signature (see falcon_presign_make); SignTo
+// takes one when available and starts directly with hashing the
+// message, which takes the PRNG and sampler setup off the request path.
+// When the queue is empty, signing proceeds as without precomputation.
+//
+// The producer has its own PRNG context, following the Signer's
+// ReseedPolicy. Each record is used for one signature and cleared;
+// queued records are cleared by StopPrecompute and Wipe. Calling
+// StartPrecompute again replaces the queue. SignBatch and AsyncSigner do
+// not use the queue.
+func (s *Signer) StartPrecompute(depth int) error {
+	if depth < 1 {
+		return errors.New("precompute depth must be positive")
+	}
+	q := &presignQueue{
+		ready:  make(chan *C.falcon_presign, depth),
+		free:   make(chan *C.falcon_presign, depth),
+		stop:   make(chan struct{}),
+		exited: make(chan struct{}),
+	}
+	s.mu.Lock()
+	old := s.pre
+	s.pre = q
+	go q.run(s.logN, reseedingRNG{policy: s.rng.policy})
+	s.mu.Unlock()
+	if old != nil {
+		old.close()
+	}
+	return nil
+}
+
+// StopPrecompute stops the background producer and clears the queued
+// records; it does nothing if precomputation is not running
+func (s *Signer) StopPrecompute() {
+	s.mu.Lock()
+	q := s.pre
+	s.pre = nil
+	s.mu.Unlock()
+	if q != nil {
+		q.close()
+	}
+}
+
+// PrecomputeStats returns the fill level and counters of the precompute
+// queue; all fields are zero if precomputation is not running
+func (s *Signer) PrecomputeStats() PrecomputeStats {
+	s.mu.Lock()
+	q := s.pre
+	s.mu.Unlock()
+	if q == nil {
+		return PrecomputeStats{}
+	}
+	return PrecomputeStats{
+		Ready:    len(q.ready),
+		Capacity: cap(q.ready),
+		Made:     q.made.Load(),
+		Served:   q.served.Load(),
+		Misses:   q.misses.Load(),
+		Failures: q.failures.Load(),
+	}
+}
+
+// run precomputes records until the queue is closed, blocking while the
+// queue is full
+func (q *presignQueue) run(logN uint, rng reseedingRNG) {
+	defer close(q.exited)
+	for {
+		var ps *C.falcon_presign
+		select {
+		case ps = <-q.free:
+		default:
+			ps = new(C.falcon_presign)
+		}
+
+		var result C.int
+		ctx, err := rng.context()
+		if err == nil {
+			result = C.falcon_presign_make(&ctx.ctx, C.unsigned(logN), ps)
+		}
+		if err != nil || result != 0 {
+			// Only an OS RNG failure gets here; retry after a
+			// pause, as KeyPool does
+			q.failures.Add(1)
+			select {
+			case <-q.stop:
+				return
+			case <-time.After(100 * time.Millisecond):
+			}
+			continue
+		}
+		q.made.Add(1)
+
+		select {
+		case q.ready <- ps:
+		case <-q.stop:
+			C.falcon_presign_clear(ps)
+			return
+		}
+	}
+}
+
+// take returns a queued record, or nil if there is none
+func (q *presignQueue) take() *C.falcon_presign {
+	select {
+	case ps := <-q.ready:
+		q.served.Add(1)
+		return ps
+	default:
+		q.misses.Add(1)
+		return nil
+	}
+}
+
+// recycle hands a used (hence cleared) record back to the producer
+func (q *presignQueue) recycle(ps *C.falcon_presign) {
+	select {
+	case q.free <- ps:
+	default:
+	}
+}
+
+// close stops the producer and clears the queued records
+func (q *presignQueue) close() {
+	close(q.stop)
+	<-q.exited
+	for {
+		select {
+		case ps := <-q.ready:
+			C.falcon_presign_clear(ps)
+			continue
+		default:
+		}
+		return
+	}
+}
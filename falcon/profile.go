@@ -0,0 +1,58 @@
+package falcon
+
+/*
+#include "falcon.h"
+*/
+import "C"
+
+// Phases measured by the FALCON_PROFILE counters (see falcon.h)
+const (
+	PhaseHash   = C.FALCON_PROF_HASH   // hash-to-point (sign and verify)
+	PhaseSign   = C.FALCON_PROF_SIGN   // core signing, including retries
+	PhaseSample = C.FALCON_PROF_SAMPLE // ffSampling, per attempt
+	PhaseNorm   = C.FALCON_PROF_NORM   // rounding and norm check, per attempt
+	PhaseEncode = C.FALCON_PROF_ENCODE // signature encoding
+	PhaseDecode = C.FALCON_PROF_DECODE // signature decoding
+	PhaseVerify = C.FALCON_PROF_VERIFY // verify_raw
+	NumPhases   = C.FALCON_PROF_NUM
+)
+
+// Profile holds the per-phase counters of one OS thread. Ticks are CPU
+// cycles when Unit is "cycles" and nanoseconds when it is "ns"; Unit is
+// empty when the C library was built without FALCON_PROFILE.
+type Profile struct {
+	Unit  string
+	Ticks [NumPhases]uint64
+	Count [NumPhases]uint64
+}
+
+// Retries returns the number of signing attempts rejected by the norm
+// check
+func (p *Profile) Retries() uint64 {
+	return p.Count[PhaseSample] - p.Count[PhaseSign]
+}
+
+// ReadProfile returns the counters of the calling OS thread. The counters
+// are per thread, so the goroutine should stay on one thread
+// (runtime.LockOSThread) from ResetProfile to ReadProfile.
+func ReadProfile() Profile {
+	var prof C.falcon_profile
+	var p Profile
+
+	switch C.falcon_profile_get(&prof) {
+	case C.FALCON_PROF_UNIT_CYCLES:
+		p.Unit = "cycles"
+	case C.FALCON_PROF_UNIT_NS:
+		p.Unit = "ns"
+	}
+	for i := 0; i < NumPhases; i++ {
+		p.Ticks[i] = uint64(prof.ticks[i])
+		p.Count[i] = uint64(prof.count[i])
+	}
+	return p
+}
+
+// ResetProfile clears the counters of the calling OS thread
+func ResetProfile() {
+	C.falcon_profile_reset()
+}
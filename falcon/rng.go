@@ -0,0 +1,137 @@
+package falcon
+
+import (
+	"fmt"
+	"sync"
+	"sync/atomic"
+	"time"
+)
+
+// ReseedPolicy controls how often a long-lived PRNG context is reseeded
+// from the operating system RNG.
+//
+// Security model: every PRNG context is seeded with 48 bytes from the OS
+// RNG (getentropy or /dev/urandom) and then produces a SHAKE256 (or
+// Keccak256 counter mode) output stream; nonces and sampler seeds for
+// successive operations are consecutive chunks of that stream. As long
+// as the context state stays secret, these outputs are as good as fresh
+// OS randomness. An attacker who reads the context state from process
+// memory can, however, recompute every output produced since the last
+// reseed and predict every output until the next one. Reseeding bounds
+// that window; it does not protect against an attacker who can read the
+// memory of a process holding the private key itself.
+//
+// A zero field disables the corresponding trigger. MaxUses = 1 reseeds
+// for every operation, which matches the behaviour of a fresh context per
+// call.
+type ReseedPolicy struct {
+	MaxUses uint64        // reseed after this many operations
+	MaxAge  time.Duration // reseed once the seed is this old
+}
+
+// DefaultReseedPolicy is the policy in effect until SetReseedPolicy is
+// called
+var DefaultReseedPolicy = ReseedPolicy{
+	MaxUses: 1 << 16,
+	MaxAge:  time.Minute,
+}
+
+var reseedPolicy atomic.Value
+
+func init() {
+	reseedPolicy.Store(DefaultReseedPolicy)
+}
+
+// SetReseedPolicy sets the reseed policy used by the pooled PRNG contexts
+// behind Sign and GenerateKeyPair, and by Signers created afterwards
+func SetReseedPolicy(p ReseedPolicy) {
+	reseedPolicy.Store(p)
+}
+
+func currentReseedPolicy() ReseedPolicy {
+	return reseedPolicy.Load().(ReseedPolicy)
+}
+
+// reseedingRNG is a PRNG context that reseeds itself from the OS RNG
+// according to a ReseedPolicy. It is not safe for concurrent use.
+type reseedingRNG struct {
+	ctx      PRNGContext
+	policy   ReseedPolicy
+	uses     uint64
+	seededAt time.Time
+	seeded   bool
+	rekey    [48]byte // seed buffer for releaseRNG, kept here so as not to allocate
+}
+
+// context returns the PRNG context to use for the next operation,
+// reseeding it first if the policy says so
+func (r *reseedingRNG) context() (*PRNGContext, error) {
+	if !r.seeded ||
+		(r.policy.MaxUses != 0 && r.uses >= r.policy.MaxUses) ||
+		(r.policy.MaxAge != 0 && time.Since(r.seededAt) >= r.policy.MaxAge) {
+		r.seeded = false
+		if err := r.ctx.InitFromSystem(); err != nil {
+			return nil, fmt.Errorf("failed to initialize RNG: %w", err)
+		}
+		r.uses = 0
+		r.seededAt = time.Now()
+		r.seeded = true
+	}
+	r.uses++
+	return &r.ctx, nil
+}
+
+// contextBatch is context for up to max operations in a row: it returns
+// the PRNG context and the number n of operations (1 to max) the policy
+// allows before the next reseed, and counts them all as uses
+func (r *reseedingRNG) contextBatch(max int) (*PRNGContext, int, error) {
+	ctx, err := r.context()
+	if err != nil {
+		return nil, 0, err
+	}
+	n := max
+	if r.policy.MaxUses != 0 && uint64(n) > r.policy.MaxUses-r.uses+1 {
+		n = int(r.policy.MaxUses - r.uses + 1)
+	}
+	r.uses += uint64(n - 1)
+	return ctx, n, nil
+}
+
+// rngPool holds seeded PRNG contexts shared by Sign and GenerateKeyPair,
+// so that the OS RNG is only hit when a context is created or reseeded
+var rngPool = sync.Pool{
+	New: func() interface{} {
+		return &reseedingRNG{}
+	},
+}
+
+// acquireRNG takes a PRNG context from the pool; the returned
+// reseedingRNG must be handed back with releaseRNG
+func acquireRNG() (*reseedingRNG, *PRNGContext, error) {
+	r := rngPool.Get().(*reseedingRNG)
+	r.policy = currentReseedPolicy()
+	ctx, err := r.context()
+	if err != nil {
+		releaseRNG(r)
+		return nil, nil, err
+	}
+	return r, ctx, nil
+}
+
+// releaseRNG returns r to the pool. The pool may drop contexts without
+// clearing them, and the Keccak state would give back the nonces and
+// sampler seeds drawn since the last reseed, so the context is first
+// rekeyed from its own output (or cleared, if it is not seeded): the
+// pooled state only determines outputs that have not been used yet.
+// The reseed policy still counts uses and age from the last OS seed.
+func releaseRNG(r *reseedingRNG) {
+	if r.seeded {
+		r.ctx.Extract(r.rekey[:])
+		r.ctx = PRNGContext{}
+		r.ctx.InitFromSeed(r.rekey[:])
+		wipe(r.rekey[:])
+	} else {
+		r.ctx = PRNGContext{}
+	}
+	rngPool.Put(r)
+}
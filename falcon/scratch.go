@@ -0,0 +1,210 @@
+package falcon
+
+/*
+#include "falcon.h"
+*/
+import "C"
+import (
+	"errors"
+	"fmt"
+	"sync"
+	"unsafe"
+)
+
+// slabAlign is the alignment of scratch slabs; it matches the cache line
+// size, so that the C code never shares a line of its temporary area
+// with unrelated Go data
+const slabAlign = 64
+
+var errScratchTooSmall = errors.New("scratch buffer too small for key degree")
+
+// Scratch is a reusable temporary area for signing and verification.
+// Passing one to VerifyWith (or reusing a pooled one, as SignTo does)
+// avoids allocating the C temporary buffer on every call. A Scratch
+// sized for a given degree also serves every smaller degree. It is not
+// safe for concurrent use.
+type Scratch struct {
+	logN   uint
+	tmp    []byte
+	sigLen C.size_t
+	stats  C.falcon_sign_stats
+}
+
+// NewScratch allocates a Scratch for keys of degree up to logN
+func NewScratch(logN uint) (*Scratch, error) {
+	if logN < 1 || logN > 10 {
+		return nil, errors.New("logN must be between 1 and 10")
+	}
+	return newScratch(logN), nil
+}
+
+func newScratch(logN uint) *Scratch {
+	size := tmpSizeSignDyn(logN)
+	if v := tmpSizeVerify(logN); v > size {
+		size = v
+	}
+	return &Scratch{logN: logN, tmp: alignedSlab(size)}
+}
+
+// alignedSlab returns an n-byte slice starting on a slabAlign boundary.
+// The Go heap does not move objects, so the alignment is kept.
+func alignedSlab(n int) []byte {
+	buf := make([]byte, n+slabAlign-1)
+	off := -int(uintptr(unsafe.Pointer(&buf[0]))) & (slabAlign - 1)
+	return buf[off : off+n : off+n]
+}
+
+// scratchPools holds one pool of Scratch slabs per degree
+var scratchPools [11]sync.Pool
+
+func init() {
+	for logN := range scratchPools {
+		logN := uint(logN)
+		scratchPools[logN].New = func() interface{} {
+			return newScratch(logN)
+		}
+	}
+}
+
+func getScratch(logN uint) *Scratch {
+	return scratchPools[logN].Get().(*Scratch)
+}
+
+func putScratch(s *Scratch) {
+	scratchPools[s.logN].Put(s)
+}
+
+// putSignScratch returns a slab used for signing to the pool. Signing
+// leaves the private key and its LDL tree in the slab, and the pool is
+// shared with verification and may drop slabs without clearing them, so
+// the slab is wiped first.
+func putSignScratch(s *Scratch) {
+	wipe(s.tmp)
+	putScratch(s)
+}
+
+// grow returns dst with room for at least n more bytes
+func grow(dst []byte, n int) []byte {
+	if cap(dst)-len(dst) >= n {
+		return dst
+	}
+	out := make([]byte, len(dst), len(dst)+n)
+	copy(out, dst)
+	return out
+}
+
+// SignTo signs the message with the private key and appends the
+// signature to dst. The temporary area comes from a pool, so no
+// allocation is made when dst has enough spare capacity (see
+// SignatureMaxSize).
+func SignTo(dst, message, privateKey []byte, sigType int) ([]byte, error) {
+	logN, err := GetLogN(privateKey)
+	if err != nil {
+		return dst, fmt.Errorf("invalid private key: %w", err)
+	}
+	sigSize, err := sigBufferSize(uint(logN), sigType)
+	if err != nil {
+		return dst, err
+	}
+
+	out := grow(dst, sigSize)
+	scratch := getScratch(uint(logN))
+	defer putSignScratch(scratch)
+
+	pooled, rng, err := acquireRNG()
+	if err != nil {
+		return dst, err
+	}
+	defer releaseRNG(pooled)
+
+	scratch.sigLen = C.size_t(sigSize)
+	probe := startSignProbe(&scratch.stats)
+	result := C.falcon_sign_dyn_ex(
+		&rng.ctx,
+		bytesPtr(out[len(out):cap(out)]), &scratch.sigLen, C.int(sigType),
+		bytesPtr(privateKey), C.size_t(len(privateKey)),
+		bytesPtr(message), C.size_t(len(message)),
+		bytesPtr(scratch.tmp), C.size_t(len(scratch.tmp)),
+		probe.stats,
+	)
+
+	if result != 0 {
+		return dst, falconError(result)
+	}
+	probe.done()
+
+	return out[:len(out)+int(scratch.sigLen)], nil
+}
+
+// SignatureMaxSize returns the largest signature of the given type for
+// keys of degree logN, i.e. the spare capacity SignTo needs to avoid
+// allocating
+func SignatureMaxSize(logN uint, sigType int) (int, error) {
+	if logN < 1 || logN > 10 {
+		return 0, errors.New("logN must be between 1 and 10")
+	}
+	return sigBufferSize(logN, sigType)
+}
+
+// VerifyWith verifies a signature using the public key and the given
+// Scratch for temporary storage. A nil scratch takes one from a pool.
+// The public key may also be in NTT representation (see NTTPublicKey)
+func VerifyWith(scratch *Scratch, signature, message, publicKey []byte, sigType int) error {
+	logN, err := GetLogN(publicKey)
+	if err != nil {
+		return fmt.Errorf("invalid public key: %w", err)
+	}
+	if scratch == nil {
+		scratch = getScratch(uint(logN))
+		defer putScratch(scratch)
+	} else if scratch.logN < uint(logN) {
+		return errScratchTooSmall
+	}
+
+	var result C.int
+	if isNTTPublicKey(publicKey) {
+		result = C.falcon_verify_ntt_pubkey(
+			bytesPtr(signature), C.size_t(len(signature)), C.int(sigType),
+			bytesPtr(publicKey), C.size_t(len(publicKey)),
+			bytesPtr(message), C.size_t(len(message)),
+			bytesPtr(scratch.tmp), C.size_t(len(scratch.tmp)),
+		)
+	} else {
+		result = C.falcon_verify(
+			bytesPtr(signature), C.size_t(len(signature)), C.int(sigType),
+			bytesPtr(publicKey), C.size_t(len(publicKey)),
+			bytesPtr(message), C.size_t(len(message)),
+			bytesPtr(scratch.tmp), C.size_t(len(scratch.tmp)),
+		)
+	}
+
+	if result != 0 {
+		return falconError(result)
+	}
+
+	return nil
+}
+
+// VerifyWith verifies a signature over the given message using the given
+// Scratch for temporary storage. A nil scratch takes one from a pool.
+func (v *Verifier) VerifyWith(scratch *Scratch, signature, message []byte, sigType int) error {
+	if scratch == nil {
+		scratch = getScratch(v.logN)
+		defer putScratch(scratch)
+	} else if scratch.logN < v.logN {
+		return errScratchTooSmall
+	}
+
+	result := C.falcon_verify_expanded(
+		bytesPtr(signature), C.size_t(len(signature)), C.int(sigType),
+		bytesPtr(v.expPubKey),
+		bytesPtr(message), C.size_t(len(message)),
+		bytesPtr(scratch.tmp), C.size_t(len(scratch.tmp)),
+	)
+
+	if result != 0 {
+		return falconError(result)
+	}
+
+	return nil
+}
@@ -0,0 +1,207 @@
+package falcon
+
+/*
+#include "falcon.h"
+*/
+import "C"
+import (
+	"fmt"
+	"sync"
+	"unsafe"
+)
+
+// Signer signs messages with an expanded private key.
+//
+// The private key is expanded once (falcon_expand_privkey) when the Signer
+// is created; every signature then goes through falcon_sign_tree, which
+// skips the per-signature reconstruction of the ffLDL tree done by Sign.
+// A Signer is safe for concurrent use; concurrent calls are serialized
+// because they share the same scratch buffer and PRNG context.
+//
+// Each Signer owns a PRNG context that is seeded once from the OS RNG and
+// reseeded according to its ReseedPolicy (see ReseedPolicy for the
+// security model).
+type Signer struct {
+	logN   uint
+	expKey []byte
+	mu     sync.Mutex
+	tmp    []byte
+	sigLen C.size_t
+	stats  C.falcon_sign_stats
+	rng    reseedingRNG
+	store  *KeyStore // owner of expKey when mapped from a key store
+	batch  *signBatchBuffers
+	pre    *presignQueue // see StartPrecompute
+}
+
+// NewSigner expands the given private key and returns a Signer for it
+func NewSigner(privateKey []byte) (*Signer, error) {
+	return newSigner(privateKey, 0)
+}
+
+// NewCompactSigner returns a Signer for the given private key, expanded
+// into a compact expanded key (falcon_expand_privkey_compact) that keeps
+// only levels upper levels of the ffLDL tree, from 1 to logN-2; the
+// subtrees below are rebuilt for each signature. Fewer levels make a
+// smaller key and slower signatures; for Falcon-1024 the key takes 28 kB
+// (levels = 1) to 84 kB (levels = 8), against 120 kB for NewSigner.
+// Signatures are the same as with NewSigner for the same PRNG state.
+func NewCompactSigner(privateKey []byte, levels uint) (*Signer, error) {
+	if levels == 0 {
+		return nil, falconError(C.FALCON_ERR_BADARG)
+	}
+	return newSigner(privateKey, levels)
+}
+
+// newSigner expands the private key into a full expanded key (levels = 0)
+// or a compact one
+func newSigner(privateKey []byte, levels uint) (*Signer, error) {
+	logN, err := GetLogN(privateKey)
+	if err != nil {
+		return nil, fmt.Errorf("invalid private key: %w", err)
+	}
+	if levels > 0 && levels+2 > uint(logN) {
+		return nil, falconError(C.FALCON_ERR_BADARG)
+	}
+
+	var expKey, tmp []byte
+	var result C.int
+	if levels == 0 {
+		expKey = make([]byte, expandedKeySize(uint(logN)))
+		tmp = make([]byte, tmpSizeExpandPriv(uint(logN)))
+		result = C.falcon_expand_privkey(
+			unsafe.Pointer(&expKey[0]), C.size_t(len(expKey)),
+			unsafe.Pointer(&privateKey[0]), C.size_t(len(privateKey)),
+			unsafe.Pointer(&tmp[0]), C.size_t(len(tmp)),
+		)
+	} else {
+		expKey = make([]byte, compactKeySize(uint(logN), levels))
+		tmp = make([]byte, tmpSizeExpandCompact(uint(logN)))
+		result = C.falcon_expand_privkey_compact(
+			unsafe.Pointer(&expKey[0]), C.size_t(len(expKey)),
+			C.unsigned(levels),
+			unsafe.Pointer(&privateKey[0]), C.size_t(len(privateKey)),
+			unsafe.Pointer(&tmp[0]), C.size_t(len(tmp)),
+		)
+	}
+	wipe(tmp)
+
+	if result != 0 {
+		return nil, falconError(result)
+	}
+
+	tmpLen := tmpSizeSignTree(uint(logN))
+	if levels > 0 {
+		tmpLen = tmpSizeSignCompact(uint(logN))
+	}
+	return &Signer{
+		logN:   uint(logN),
+		expKey: expKey,
+		tmp:    make([]byte, tmpLen),
+		rng:    reseedingRNG{policy: currentReseedPolicy()},
+	}, nil
+}
+
+// SetReseedPolicy changes how often the Signer reseeds its PRNG context
+func (s *Signer) SetReseedPolicy(p ReseedPolicy) {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	s.rng.policy = p
+}
+
+// LogN returns the Falcon degree (logN) of the signing key
+func (s *Signer) LogN() uint {
+	return s.logN
+}
+
+// Sign generates a signature for the given message
+func (s *Signer) Sign(message []byte, sigType int) ([]byte, error) {
+	return s.SignTo(nil, message, sigType)
+}
+
+// SignTo signs the message and appends the signature to dst. No
+// allocation is made when dst has enough spare capacity (see
+// SignatureMaxSize).
+func (s *Signer) SignTo(dst, message []byte, sigType int) ([]byte, error) {
+	sigSize, err := sigBufferSize(s.logN, sigType)
+	if err != nil {
+		return dst, err
+	}
+	out := grow(dst, sigSize)
+
+	s.mu.Lock()
+	rng, err := s.rng.context()
+	if err != nil {
+		s.mu.Unlock()
+		return dst, err
+	}
+	if !s.store.acquire() {
+		s.mu.Unlock()
+		return dst, errKeyStoreClosed
+	}
+	s.sigLen = C.size_t(sigSize)
+	var ps *C.falcon_presign
+	if s.pre != nil {
+		ps = s.pre.take()
+	}
+	probe := startSignProbe(&s.stats)
+	var result C.int
+	if ps != nil {
+		// The PRNG context is only used if a second attempt is needed
+		result = C.falcon_sign_tree_pre(
+			&rng.ctx, ps,
+			bytesPtr(out[len(out):cap(out)]), &s.sigLen, C.int(sigType),
+			bytesPtr(s.expKey),
+			bytesPtr(message), C.size_t(len(message)),
+			bytesPtr(s.tmp), C.size_t(len(s.tmp)),
+			probe.stats,
+		)
+		s.pre.recycle(ps)
+	} else {
+		result = C.falcon_sign_tree_ex(
+			&rng.ctx,
+			bytesPtr(out[len(out):cap(out)]), &s.sigLen, C.int(sigType),
+			bytesPtr(s.expKey),
+			bytesPtr(message), C.size_t(len(message)),
+			bytesPtr(s.tmp), C.size_t(len(s.tmp)),
+			probe.stats,
+		)
+	}
+	s.store.release()
+	sigLen := int(s.sigLen)
+	if result == 0 {
+		probe.done()
+	}
+	s.mu.Unlock()
+
+	if result != 0 {
+		return dst, falconError(result)
+	}
+
+	return out[:len(out)+sigLen], nil
+}
+
+// Wipe clears the expanded private key and scratch buffer, and stops
+// precomputation (see StartPrecompute). The Signer must not be used
+// afterwards. A Signer from a KeyStore only drops its reference to the
+// mapped key, which is read-only.
+func (s *Signer) Wipe() {
+	s.StopPrecompute()
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	if s.store != nil {
+		// A zero degree byte makes further signing fail
+		s.expKey = make([]byte, 1)
+		s.store = nil
+	}
+	wipe(s.expKey)
+	wipe(s.tmp)
+	s.rng = reseedingRNG{policy: s.rng.policy}
+}
+
+// wipe overwrites a buffer holding secret material with zeros
+func wipe(b []byte) {
+	for i := range b {
+		b[i] = 0
+	}
+}
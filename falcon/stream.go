@@ -0,0 +1,338 @@
+package falcon
+
+/*
+#include "falcon.h"
+*/
+import "C"
+import (
+	"errors"
+	"fmt"
+	"io"
+	"unsafe"
+)
+
+// NonceSize is the length in bytes of the nonce hashed before the message
+const NonceSize = 40
+
+// hashChunk caps the number of bytes injected per cgo call, so that one
+// large Write does not pin the goroutine in C for the whole buffer
+const hashChunk = 64 << 10
+
+// readerBufferSize is the read buffer used by SignReader and VerifyReader
+const readerBufferSize = 8 << 10
+
+var errHasherDone = errors.New("hasher already finished")
+
+// Hasher hashes a message incrementally for signing or verification, over
+// the streamed C API (falcon_sign_start / falcon_verify_start). Written
+// data is injected into the hash context directly from the caller's
+// buffer; memory use does not depend on the message length.
+//
+// A Hasher is created for one operation, fed with Write, and consumed by
+// exactly one of its finishing methods. It is not safe for concurrent use.
+type Hasher struct {
+	ctx   PRNGContext
+	nonce [NonceSize]byte
+	done  bool
+}
+
+// NewHasher returns a Hasher for signing. A fresh random nonce is drawn
+// and hashed first; the message is then supplied with Write.
+func NewHasher() (*Hasher, error) {
+	pooled, rng, err := acquireRNG()
+	if err != nil {
+		return nil, err
+	}
+	defer releaseRNG(pooled)
+
+	h := &Hasher{}
+	C.falcon_sign_start(&rng.ctx, unsafe.Pointer(&h.nonce[0]), &h.ctx.ctx)
+	return h, nil
+}
+
+// NewVerifyHasher returns a Hasher for verifying the given signature. The
+// nonce is taken from the signature; the message is then supplied with
+// Write.
+func NewVerifyHasher(signature []byte) (*Hasher, error) {
+	h := &Hasher{}
+	result := C.falcon_verify_start(&h.ctx.ctx,
+		bytesPtr(signature), C.size_t(len(signature)))
+	if result != 0 {
+		return nil, falconError(result)
+	}
+	copy(h.nonce[:], signature[1:1+NonceSize])
+	return h, nil
+}
+
+// Write hashes more message data. It never returns an error unless the
+// Hasher was already finished.
+func (h *Hasher) Write(p []byte) (int, error) {
+	if h.done {
+		return 0, errHasherDone
+	}
+	n := len(p)
+	for len(p) > 0 {
+		chunk := len(p)
+		if chunk > hashChunk {
+			chunk = hashChunk
+		}
+		C.prng_inject(&h.ctx.ctx, bytesPtr(p[:chunk]), C.size_t(chunk))
+		p = p[chunk:]
+	}
+	return n, nil
+}
+
+// Nonce returns the nonce hashed ahead of the message
+func (h *Hasher) Nonce() []byte {
+	return append([]byte(nil), h.nonce[:]...)
+}
+
+// Sign finishes the Hasher and signs the hashed message with the private
+// key (falcon_sign_dyn_finish)
+func (h *Hasher) Sign(privateKey []byte, sigType int) ([]byte, error) {
+	if h.done {
+		return nil, errHasherDone
+	}
+	logN, err := GetLogN(privateKey)
+	if err != nil {
+		return nil, fmt.Errorf("invalid private key: %w", err)
+	}
+	sigSize, err := sigBufferSize(uint(logN), sigType)
+	if err != nil {
+		return nil, err
+	}
+
+	signature := make([]byte, sigSize)
+	sigLen := C.size_t(sigSize)
+	scratch := getScratch(uint(logN))
+	defer putSignScratch(scratch)
+
+	pooled, rng, err := acquireRNG()
+	if err != nil {
+		return nil, err
+	}
+	defer releaseRNG(pooled)
+
+	h.done = true
+	probe := startSignProbe(&scratch.stats)
+	result := C.falcon_sign_dyn_finish_ex(
+		&rng.ctx,
+		unsafe.Pointer(&signature[0]), &sigLen, C.int(sigType),
+		unsafe.Pointer(&privateKey[0]), C.size_t(len(privateKey)),
+		&h.ctx.ctx, unsafe.Pointer(&h.nonce[0]),
+		unsafe.Pointer(&scratch.tmp[0]), C.size_t(len(scratch.tmp)),
+		probe.stats,
+	)
+
+	if result != 0 {
+		return nil, falconError(result)
+	}
+	probe.done()
+
+	return signature[:sigLen], nil
+}
+
+// Verify finishes the Hasher and verifies the signature over the hashed
+// message (falcon_verify_finish). The signature must be the one the
+// Hasher was created with. The public key may be in NTT representation.
+func (h *Hasher) Verify(signature, publicKey []byte, sigType int) error {
+	if h.done {
+		return errHasherDone
+	}
+	logN, err := GetLogN(publicKey)
+	if err != nil {
+		return fmt.Errorf("invalid public key: %w", err)
+	}
+
+	scratch := getScratch(uint(logN))
+	defer putScratch(scratch)
+
+	h.done = true
+	var result C.int
+	if isNTTPublicKey(publicKey) {
+		result = C.falcon_verify_ntt_pubkey_finish(
+			bytesPtr(signature), C.size_t(len(signature)), C.int(sigType),
+			unsafe.Pointer(&publicKey[0]), C.size_t(len(publicKey)),
+			&h.ctx.ctx,
+			unsafe.Pointer(&scratch.tmp[0]), C.size_t(len(scratch.tmp)),
+		)
+	} else {
+		result = C.falcon_verify_finish(
+			bytesPtr(signature), C.size_t(len(signature)), C.int(sigType),
+			unsafe.Pointer(&publicKey[0]), C.size_t(len(publicKey)),
+			&h.ctx.ctx,
+			unsafe.Pointer(&scratch.tmp[0]), C.size_t(len(scratch.tmp)),
+		)
+	}
+
+	if result != 0 {
+		return falconError(result)
+	}
+
+	return nil
+}
+
+// SignHasher finishes the Hasher and signs the hashed message with the
+// Signer's expanded key (falcon_sign_tree_finish)
+func (s *Signer) SignHasher(h *Hasher, sigType int) ([]byte, error) {
+	if h.done {
+		return nil, errHasherDone
+	}
+	sigSize, err := sigBufferSize(s.logN, sigType)
+	if err != nil {
+		return nil, err
+	}
+
+	signature := make([]byte, sigSize)
+	sigLen := C.size_t(sigSize)
+
+	s.mu.Lock()
+	rng, err := s.rng.context()
+	if err != nil {
+		s.mu.Unlock()
+		return nil, err
+	}
+	if !s.store.acquire() {
+		s.mu.Unlock()
+		return nil, errKeyStoreClosed
+	}
+	h.done = true
+	probe := startSignProbe(&s.stats)
+	result := C.falcon_sign_tree_finish_ex(
+		&rng.ctx,
+		unsafe.Pointer(&signature[0]), &sigLen, C.int(sigType),
+		unsafe.Pointer(&s.expKey[0]),
+		&h.ctx.ctx, unsafe.Pointer(&h.nonce[0]),
+		unsafe.Pointer(&s.tmp[0]), C.size_t(len(s.tmp)),
+		probe.stats,
+	)
+	s.store.release()
+	if result == 0 {
+		probe.done()
+	}
+	s.mu.Unlock()
+
+	if result != 0 {
+		return nil, falconError(result)
+	}
+
+	return signature[:sigLen], nil
+}
+
+// VerifyHasher finishes the Hasher and verifies the signature over the
+// hashed message with the Verifier's expanded key
+// (falcon_verify_expanded_finish)
+func (v *Verifier) VerifyHasher(h *Hasher, signature []byte, sigType int) error {
+	if h.done {
+		return errHasherDone
+	}
+	scratch := getScratch(v.logN)
+	defer putScratch(scratch)
+
+	h.done = true
+	result := C.falcon_verify_expanded_finish(
+		bytesPtr(signature), C.size_t(len(signature)), C.int(sigType),
+		unsafe.Pointer(&v.expPubKey[0]),
+		&h.ctx.ctx,
+		unsafe.Pointer(&scratch.tmp[0]), C.size_t(len(scratch.tmp)),
+	)
+
+	if result != 0 {
+		return falconError(result)
+	}
+
+	return nil
+}
+
+// hashFrom copies r into h with a fixed-size buffer
+func hashFrom(h *Hasher, r io.Reader) error {
+	buf := make([]byte, readerBufferSize)
+	_, err := io.CopyBuffer(h, r, buf)
+	return err
+}
+
+// SignReader signs the message read from r until EOF with the private key
+func SignReader(r io.Reader, privateKey []byte, sigType int) ([]byte, error) {
+	h, err := NewHasher()
+	if err != nil {
+		return nil, err
+	}
+	if err := hashFrom(h, r); err != nil {
+		return nil, err
+	}
+	return h.Sign(privateKey, sigType)
+}
+
+// VerifyReader verifies a signature over the message read from r until EOF
+func VerifyReader(r io.Reader, signature, publicKey []byte, sigType int) error {
+	h, err := NewVerifyHasher(signature)
+	if err != nil {
+		return err
+	}
+	if err := hashFrom(h, r); err != nil {
+		return err
+	}
+	return h.Verify(signature, publicKey, sigType)
+}
+
+// SignReader signs the message read from r until EOF
+func (s *Signer) SignReader(r io.Reader, sigType int) ([]byte, error) {
+	h, err := NewHasher()
+	if err != nil {
+		return nil, err
+	}
+	if err := hashFrom(h, r); err != nil {
+		return nil, err
+	}
+	return s.SignHasher(h, sigType)
+}
+
+// VerifyReader verifies a signature over the message read from r until EOF
+func (v *Verifier) VerifyReader(r io.Reader, signature []byte, sigType int) error {
+	h, err := NewVerifyHasher(signature)
+	if err != nil {
+		return err
+	}
+	if err := hashFrom(h, r); err != nil {
+		return err
+	}
+	return v.VerifyHasher(h, signature, sigType)
+}
+
+// SignFile signs the contents of the named file with the private key. On
+// platforms that support it the file is memory-mapped and hashed in place;
+// it must not be truncated while it is being signed.
+func SignFile(path string, privateKey []byte, sigType int) ([]byte, error) {
+	h, err := NewHasher()
+	if err != nil {
+		return nil, err
+	}
+	if err := hashFile(h, path); err != nil {
+		return nil, err
+	}
+	return h.Sign(privateKey, sigType)
+}
+
+// VerifyFile verifies a signature over the contents of the named file
+func VerifyFile(path string, signature, publicKey []byte, sigType int) error {
+	h, err := NewVerifyHasher(signature)
+	if err != nil {
+		return err
+	}
+	if err := hashFile(h, path); err != nil {
+		return err
+	}
+	return h.Verify(signature, publicKey, sigType)
+}
+
+// SignFile signs the contents of the named file
+func (s *Signer) SignFile(path string, sigType int) ([]byte, error) {
+	h, err := NewHasher()
+	if err != nil {
+		return nil, err
+	}
+	if err := hashFile(h, path); err != nil {
+		return nil, err
+	}
+	return s.SignHasher(h, sigType)
+}
@@ -0,0 +1,168 @@
+package falcon
+
+/*
+#include "falcon.h"
+*/
+import "C"
+import (
+	"container/list"
+	"errors"
+	"fmt"
+	"sync"
+	"unsafe"
+)
+
+// Verifier verifies signatures against a single public key.
+//
+// The public key is decoded and converted to NTT form once, when the
+// Verifier is created (falcon_expand_pubkey); each verification then goes
+// through falcon_verify_expanded and skips that conversion. A Verifier is
+// read-only after creation and safe for concurrent use.
+type Verifier struct {
+	logN      uint
+	publicKey []byte
+	expPubKey []byte
+}
+
+// NewVerifier decodes the given public key and returns a Verifier for it
+func NewVerifier(publicKey []byte) (*Verifier, error) {
+	logN, err := GetLogN(publicKey)
+	if err != nil {
+		return nil, fmt.Errorf("invalid public key: %w", err)
+	}
+
+	expPubKey := make([]byte, expandedPubKeySize(uint(logN)))
+	result := C.falcon_expand_pubkey(
+		unsafe.Pointer(&expPubKey[0]), C.size_t(len(expPubKey)),
+		unsafe.Pointer(&publicKey[0]), C.size_t(len(publicKey)),
+	)
+	if result != 0 {
+		return nil, falconError(result)
+	}
+
+	return &Verifier{
+		logN:      uint(logN),
+		publicKey: append([]byte(nil), publicKey...),
+		expPubKey: expPubKey,
+	}, nil
+}
+
+// NTTPublicKey converts an encoded public key to NTT representation, in
+// the given form (NTTPubPlain or NTTPubMonty). The result has the same
+// size as the public key and is accepted by Verify, VerifyWith and
+// NewVerifier; external verifiers can use it to skip the NTT of the key
+// (falcon_encode_ntt_pubkey)
+func NTTPublicKey(publicKey []byte, form int) ([]byte, error) {
+	logN, err := GetLogN(publicKey)
+	if err != nil {
+		return nil, fmt.Errorf("invalid public key: %w", err)
+	}
+
+	nttPubKey := make([]byte, publicKeySize(uint(logN)))
+	tmp := make([]byte, tmpSizeNTTPub(uint(logN)))
+	result := C.falcon_encode_ntt_pubkey(
+		unsafe.Pointer(&nttPubKey[0]), C.size_t(len(nttPubKey)),
+		C.int(form),
+		unsafe.Pointer(&publicKey[0]), C.size_t(len(publicKey)),
+		unsafe.Pointer(&tmp[0]), C.size_t(len(tmp)),
+	)
+	if result != 0 {
+		return nil, falconError(result)
+	}
+	return nttPubKey, nil
+}
+
+// isNTTPublicKey tells whether an encoded public key is in NTT
+// representation, from its header byte
+func isNTTPublicKey(publicKey []byte) bool {
+	return len(publicKey) > 0 && (publicKey[0]>>4 == 1+NTTPubPlain || publicKey[0]>>4 == 1+NTTPubMonty)
+}
+
+// LogN returns the Falcon degree (logN) of the public key
+func (v *Verifier) LogN() uint {
+	return v.logN
+}
+
+// PublicKey returns the encoded public key of the Verifier
+func (v *Verifier) PublicKey() []byte {
+	return append([]byte(nil), v.publicKey...)
+}
+
+// Verify verifies a signature over the given message
+func (v *Verifier) Verify(signature, message []byte, sigType int) error {
+	return v.VerifyWith(nil, signature, message, sigType)
+}
+
+// VerifierCache is a bounded LRU cache of Verifiers keyed by encoded
+// public key. It is meant for deployments that verify signatures from
+// many signers, where keeping one Verifier per key is not practical.
+// A VerifierCache is safe for concurrent use.
+type VerifierCache struct {
+	capacity int
+	mu       sync.Mutex
+	order    *list.List
+	entries  map[string]*list.Element
+}
+
+// NewVerifierCache creates a cache holding at most capacity Verifiers
+func NewVerifierCache(capacity int) (*VerifierCache, error) {
+	if capacity < 1 {
+		return nil, errors.New("cache capacity must be positive")
+	}
+	return &VerifierCache{
+		capacity: capacity,
+		order:    list.New(),
+		entries:  make(map[string]*list.Element),
+	}, nil
+}
+
+// Get returns the Verifier for the given public key, creating it (and
+// evicting the least recently used entry if the cache is full) if needed
+func (c *VerifierCache) Get(publicKey []byte) (*Verifier, error) {
+	key := string(publicKey)
+
+	c.mu.Lock()
+	if elem, ok := c.entries[key]; ok {
+		c.order.MoveToFront(elem)
+		c.mu.Unlock()
+		return elem.Value.(*Verifier), nil
+	}
+	c.mu.Unlock()
+
+	// Decode outside the lock; a concurrent miss on the same key only
+	// costs a redundant decode.
+	v, err := NewVerifier(publicKey)
+	if err != nil {
+		return nil, err
+	}
+
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	if elem, ok := c.entries[key]; ok {
+		c.order.MoveToFront(elem)
+		return elem.Value.(*Verifier), nil
+	}
+	c.entries[key] = c.order.PushFront(v)
+	if c.order.Len() > c.capacity {
+		oldest := c.order.Back()
+		c.order.Remove(oldest)
+		delete(c.entries, string(oldest.Value.(*Verifier).publicKey))
+	}
+	return v, nil
+}
+
+// Verify verifies a signature using the cached Verifier for publicKey
+func (c *VerifierCache) Verify(signature, message, publicKey []byte, sigType int) error {
+	v, err := c.Get(publicKey)
+	if err != nil {
+		return err
+	}
+	return v.Verify(signature, message, sigType)
+}
+
+// Len returns the number of Verifiers currently held in the cache
+func (c *VerifierCache) Len() int {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	return c.order.Len()
+}